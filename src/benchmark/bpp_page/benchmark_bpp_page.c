@@ -0,0 +1,254 @@
+/******************************************************************************/
+/**
+@file		benchmark_bpp_page.c
+@author		IonDB Project Contributors
+@brief		Compares the depth and lookup latency of B+ trees across sector sizes.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+/* For clock_gettime. */
+#define _XOPEN_SOURCE 700
+
+#include <time.h>
+#include "../../dictionary/bpp_tree/bpp_tree.h"
+
+/**
+@brief		The number of keys loaded unless another is given on the
+			command line.
+*/
+#define BENCHMARK_BPP_PAGE_KEYS			10000000L
+
+/**
+@brief		The number of random lookups timed at each sector size.
+*/
+#define BENCHMARK_BPP_PAGE_LOOKUPS		200000
+
+/**
+@brief		How full the bulk load leaves each node, in percent.
+*/
+#define BENCHMARK_BPP_PAGE_FILL			75
+
+/**
+@brief		The index file each sector size is benchmarked in, in turn.
+*/
+#define BENCHMARK_BPP_PAGE_FILE			"page.bpt"
+
+/**
+@brief		The keys supplied to a bulk load.
+*/
+typedef struct {
+	/**> The next key to supply. */
+	long	next;
+	/**> The number of keys to supply. */
+	long	count;
+} benchmark_bpp_page_stream_t;
+
+/**
+@brief		Supplies the keys 0, 1, ... count - 1, each recording its own
+			value as its address.
+*/
+static ion_bpp_bool_t
+benchmark_bpp_page_next(
+	void						*context,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	benchmark_bpp_page_stream_t *stream = context;
+	int							value;
+
+	if (stream->next == stream->count) {
+		return boolean_false;
+	}
+
+	value	= (int) stream->next++;
+	memcpy(key, &value, sizeof(int));
+	*rec	= value;
+
+	return boolean_true;
+}
+
+/**
+@brief		Returns the nanoseconds on a monotonic clock.
+*/
+static long
+benchmark_bpp_page_now_ns(
+	void
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+@brief		Orders latencies for the percentiles.
+*/
+static int
+benchmark_bpp_page_compare_latency(
+	const void	*a,
+	const void	*b
+) {
+	long	first	= *(const long *) a;
+	long	second	= *(const long *) b;
+
+	return (first > second) - (first < second);
+}
+
+/**
+@brief		Loads a tree of @p keys keys with one sector size, then times
+			random lookups in it.
+*/
+static void
+benchmark_bpp_page_size(
+	int		sector_size,
+	long	keys,
+	long	*latencies
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	benchmark_bpp_page_stream_t stream;
+	unsigned long				state = 1;
+	long						start_ns;
+	long						load_ns;
+	long						total_ns;
+	long						size;
+	int							reads;
+	int							key;
+	int							i;
+	FILE						*file;
+
+	info.iName		= BENCHMARK_BPP_PAGE_FILE;
+	info.keySize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = sector_size;
+	info.comp		= dictionary_switch_compare(key_type_numeric_signed, sizeof(int));
+	info.prefixed	= boolean_false;
+	info.valueSize	= 0;
+
+	ion_fremove(BENCHMARK_BPP_PAGE_FILE);
+
+	if (bErrOk != b_open(info, &tree)) {
+		printf("%7d  cannot open\n", sector_size);
+		return;
+	}
+
+	stream.next		= 0;
+	stream.count	= keys;
+	maxHeight		= 0;
+	start_ns		= benchmark_bpp_page_now_ns();
+
+	if (bErrOk != b_bulk_load(tree, benchmark_bpp_page_next, &stream, BENCHMARK_BPP_PAGE_FILL)) {
+		printf("%7d  bulk load failed\n", sector_size);
+		b_close(tree);
+		ion_fremove(BENCHMARK_BPP_PAGE_FILE);
+		return;
+	}
+
+	load_ns		= benchmark_bpp_page_now_ns() - start_ns;
+	b_close(tree);
+	b_open(info, &tree);
+
+	reads		= nSectorReads;
+	total_ns	= 0;
+
+	for (i = 0; i < BENCHMARK_BPP_PAGE_LOOKUPS; i++) {
+		state		= state * 6364136223846793005UL + 1442695040888963407UL;
+		key			= (int) ((state >> 17) % keys);
+		start_ns	= benchmark_bpp_page_now_ns();
+
+		if ((bErrOk != b_get(tree, &key, &rec)) || (rec != key)) {
+			printf("%7d  lookup of %d failed\n", sector_size, key);
+			break;
+		}
+
+		latencies[i]	= benchmark_bpp_page_now_ns() - start_ns;
+		total_ns		+= latencies[i];
+	}
+
+	reads = nSectorReads - reads;
+	b_close(tree);
+
+	file = fopen(BENCHMARK_BPP_PAGE_FILE, "rb");
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fclose(file);
+	ion_fremove(BENCHMARK_BPP_PAGE_FILE);
+
+	if (0 == i) {
+		return;
+	}
+
+	qsort(latencies, i, sizeof(long), benchmark_bpp_page_compare_latency);
+
+	printf("%7d  %5d  %7.2f  %9.1f  %8ld  %8ld  %8ld  %10.1f\n", sector_size, maxHeight + 1, load_ns / 1e9, size / 1048576.0, total_ns / i, latencies[i / 2], latencies[i * 99 / 100], (double) reads * sector_size / i);
+}
+
+int
+main(
+	int		argc,
+	char	**argv
+) {
+	static const int	sector_sizes[] = { 256, 4096, 8192, 16384, 32768, 65536 };
+	long				keys = BENCHMARK_BPP_PAGE_KEYS;
+	long				*latencies;
+	int					i;
+
+#if !defined(NDEBUG)
+	printf("note: configure with -DCMAKE_BUILD_TYPE=Release for representative timings\n\n");
+#endif
+
+	if (argc > 1) {
+		keys = atol(argv[1]);
+	}
+
+	if ((keys < 1) || (keys > 0x7FFFFFFFL)) {
+		fprintf(stderr, "usage: %s [keys]\n", argv[0]);
+		return 1;
+	}
+
+	latencies = malloc(BENCHMARK_BPP_PAGE_LOOKUPS * sizeof(long));
+
+	if (NULL == latencies) {
+		return 1;
+	}
+
+	printf("%ld int keys bulk loaded %d%% full, %d random lookups per sector size\n\n", keys, BENCHMARK_BPP_PAGE_FILL, BENCHMARK_BPP_PAGE_LOOKUPS);
+	printf("%7s  %5s  %7s  %9s  %8s  %8s  %8s  %10s\n", "sector", "depth", "load s", "file MiB", "mean ns", "p50 ns", "p99 ns", "bytes/get");
+
+	for (i = 0; i < (int) (sizeof(sector_sizes) / sizeof(sector_sizes[0])); i++) {
+		benchmark_bpp_page_size(sector_sizes[i], keys, latencies);
+	}
+
+	free(latencies);
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+/******************************************************************************/
+/**
+@file		benchmark_compare.c
+@author		IonDB Project Contributors
+@brief		Times the byte-wise key comparators against the width specialized ones.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+#include <time.h>
+#include "../../dictionary/dictionary.h"
+#include "../../dictionary/bpp_tree/bpp_tree_handler.h"
+
+/**
+@brief		How many keys each comparator benchmark draws its pairs from.
+*/
+#define BENCHMARK_COMPARE_KEYS			4096
+
+/**
+@brief		How many comparisons each comparator benchmark times.
+*/
+#define BENCHMARK_COMPARE_ROUNDS		(1L << 24)
+
+/**
+@brief		How many records the B+ tree benchmark inserts and looks up.
+*/
+#define BENCHMARK_COMPARE_RECORDS		50000
+
+/**
+@brief		Keeps the compiler from discarding the comparison results.
+*/
+static volatile long benchmark_compare_sink;
+
+/**
+@brief		Returns the seconds elapsed since @p start.
+*/
+static double
+benchmark_compare_elapsed(
+	clock_t start
+) {
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+@brief		Times a comparator over pseudo random pairs of keys.
+@return		Nanoseconds per comparison.
+*/
+static double
+benchmark_compare_time(
+	ion_dictionary_compare_t	compare,
+	ion_byte_t					*keys,
+	ion_key_size_t				key_size
+) {
+	clock_t rounds_start	= clock();
+	long	sum				= 0;
+	long	i;
+
+	for (i = 0; i < BENCHMARK_COMPARE_ROUNDS; i++) {
+		sum += compare(keys + (i % BENCHMARK_COMPARE_KEYS) * key_size, keys + ((i * 7 + 3) % BENCHMARK_COMPARE_KEYS) * key_size, key_size);
+	}
+
+	benchmark_compare_sink = sum;
+
+	return benchmark_compare_elapsed(rounds_start) * 1e9 / BENCHMARK_COMPARE_ROUNDS;
+}
+
+/**
+@brief		Times the byte-wise and width specialized comparators for one
+			key type and size.
+*/
+static void
+benchmark_compare_width(
+	ion_key_type_t	key_type,
+	ion_key_size_t	key_size
+) {
+	ion_byte_t					*keys = malloc(BENCHMARK_COMPARE_KEYS * key_size);
+	ion_dictionary_compare_t	generic;
+	double						generic_ns;
+	double						specialized_ns;
+	int							i;
+
+	if (NULL == keys) {
+		return;
+	}
+
+	/* Like sequential identifiers, the keys only differ in their low bytes. */
+	memset(keys, 0, BENCHMARK_COMPARE_KEYS * key_size);
+
+	for (i = 0; i < BENCHMARK_COMPARE_KEYS; i++) {
+		int low = rand();
+
+		memcpy(keys + i * key_size, &low, key_size < 2 ? key_size : key_size / 2);
+	}
+
+	generic			= key_type_numeric_signed == key_type ? dictionary_compare_signed_value : dictionary_compare_unsigned_value;
+	generic_ns		= benchmark_compare_time(generic, keys, key_size);
+	specialized_ns	= benchmark_compare_time(dictionary_switch_compare(key_type, key_size), keys, key_size);
+
+	printf("%-8s %d bytes  %8.2f ns  %8.2f ns  %6.2fx\n", key_type_numeric_signed == key_type ? "signed" : "unsigned", key_size, generic_ns, specialized_ns, generic_ns / specialized_ns);
+
+	free(keys);
+}
+
+/**
+@brief		Times looking up records in a B+ tree whose binary searches use
+			a given comparator.
+@return		Seconds taken by the lookups.
+*/
+static double
+benchmark_compare_bpp_tree(
+	ion_dictionary_compare_t compare
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	clock_t						start;
+	int							key;
+	int							value;
+	long						i;
+
+	bpptree_init(&handler);
+
+	/* Bypass dictionary_create, which would bind the specialized comparator. */
+	if (err_ok != handler.create_dictionary(1, key_type_numeric_signed, sizeof(int), sizeof(int), 0, compare, &handler, &dictionary)) {
+		return 0;
+	}
+
+	dictionary.lock				= NULL;
+	dictionary.wal				= NULL;
+	dictionary.status			= ion_dictionary_status_ok;
+	dictionary.instance->id		= 1;
+
+	for (i = 0; i < BENCHMARK_COMPARE_RECORDS; i++) {
+		key		= (int) ((i * 7919) % BENCHMARK_COMPARE_RECORDS);
+		value	= (int) i;
+		dictionary_insert(&dictionary, &key, &value);
+	}
+
+	start = clock();
+
+	for (i = 0; i < BENCHMARK_COMPARE_RECORDS * 10L; i++) {
+		key = (int) ((i * 104729) % BENCHMARK_COMPARE_RECORDS);
+		dictionary_get(&dictionary, &key, &value);
+	}
+
+	benchmark_compare_sink = value;
+
+	double elapsed = benchmark_compare_elapsed(start);
+
+	dictionary_delete_dictionary(&dictionary);
+
+	return elapsed;
+}
+
+int
+main(
+	void
+) {
+	double	generic_s;
+	double	specialized_s;
+
+#if !defined(NDEBUG)
+	printf("note: configure with -DCMAKE_BUILD_TYPE=Release for representative timings\n\n");
+#endif
+
+	srand(1);
+
+	printf("%-8s %-7s  %11s  %11s  %7s\n", "type", "size", "byte-wise", "by width", "speedup");
+	benchmark_compare_width(key_type_numeric_signed, 1);
+	benchmark_compare_width(key_type_numeric_unsigned, 1);
+	benchmark_compare_width(key_type_numeric_signed, 2);
+	benchmark_compare_width(key_type_numeric_unsigned, 2);
+	benchmark_compare_width(key_type_numeric_signed, 4);
+	benchmark_compare_width(key_type_numeric_unsigned, 4);
+	benchmark_compare_width(key_type_numeric_signed, 8);
+	benchmark_compare_width(key_type_numeric_unsigned, 8);
+
+	generic_s		= benchmark_compare_bpp_tree(dictionary_compare_signed_value);
+	specialized_s	= benchmark_compare_bpp_tree(dictionary_switch_compare(key_type_numeric_signed, sizeof(int)));
+
+	printf("\nB+ tree, %ld gets over %d int keys: byte-wise %.3f s, by width %.3f s, %.2fx\n", BENCHMARK_COMPARE_RECORDS * 10L, BENCHMARK_COMPARE_RECORDS, generic_s, specialized_s, generic_s / specialized_s);
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/******************************************************************************/
+/**
+@file		benchmark_lh_distribution.c
+@author		IonDB Project Contributors
+@brief		Compares how linear hash functions spread structured keys over buckets.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+/* For clock_gettime. */
+#define _XOPEN_SOURCE 700
+
+#include <time.h>
+#include "../../dictionary/linear_hash/linear_hash.h"
+
+/**
+@brief		The number of records inserted into each table unless another is
+			given on the command line.
+*/
+#define BENCHMARK_LH_DISTRIBUTION_RECORDS 20000
+
+/**
+@brief		The largest key of the workloads, in bytes.
+*/
+#define BENCHMARK_LH_DISTRIBUTION_KEY_SIZE 16
+
+/**
+@brief		Writes the @p i th key of a workload to @p key.
+*/
+typedef void (*benchmark_lh_distribution_key_t)(
+	ion_byte_t	*key,
+	int			i
+);
+
+/**
+@brief		A kind of structured key.
+*/
+typedef struct {
+	/**> What the keys are. */
+	const char						*name;
+	/**> The size of the keys in bytes. */
+	ion_key_size_t					key_size;
+	/**> Makes the keys. */
+	benchmark_lh_distribution_key_t make;
+} benchmark_lh_distribution_workload_t;
+
+/**
+@brief		Seconds since the epoch, a reading a minute.
+*/
+static void
+benchmark_lh_distribution_timestamp(
+	ion_byte_t	*key,
+	int			i
+) {
+	uint32_t timestamp = 1700000000UL + 60UL * (uint32_t) i;
+
+	memcpy(key, &timestamp, sizeof(timestamp));
+}
+
+/**
+@brief		Milliseconds since the epoch, a reading every 250 ms.
+*/
+static void
+benchmark_lh_distribution_timestamp_ms(
+	ion_byte_t	*key,
+	int			i
+) {
+	int64_t timestamp = 1700000000000LL + 250LL * i;
+
+	memcpy(key, &timestamp, sizeof(timestamp));
+}
+
+/**
+@brief		MAC addresses of one vendor, assigned in order.
+*/
+static void
+benchmark_lh_distribution_mac(
+	ion_byte_t	*key,
+	int			i
+) {
+	key[0]	= 0x00;
+	key[1]	= 0x1A;
+	key[2]	= 0x2B;
+	key[3]	= (ion_byte_t) (i >> 16);
+	key[4]	= (ion_byte_t) (i >> 8);
+	key[5]	= (ion_byte_t) i;
+}
+
+/**
+@brief		Names sharing a prefix, numbered in order.
+*/
+static void
+benchmark_lh_distribution_name(
+	ion_byte_t	*key,
+	int			i
+) {
+	char name[BENCHMARK_LH_DISTRIBUTION_KEY_SIZE + 1];
+
+	snprintf(name, sizeof(name), "sensor-%09d", i);
+	memcpy(key, name, BENCHMARK_LH_DISTRIBUTION_KEY_SIZE);
+}
+
+/**
+@brief		Returns the nanoseconds on a monotonic clock.
+*/
+static long
+benchmark_lh_distribution_now_ns(
+	void
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+@brief		Fills a table with one workload using one hash, then times
+			lookups of every key and prints how the records are spread.
+*/
+static void
+benchmark_lh_distribution_run(
+	benchmark_lh_distribution_workload_t	*workload,
+	linear_hash_hash_t						hash,
+	int										records
+) {
+	linear_hash_table_t linear_hash;
+	ion_byte_t			key[BENCHMARK_LH_DISTRIBUTION_KEY_SIZE];
+	int					value;
+	long				start_ns;
+	long				insert_ns;
+	long				get_ns;
+	int					i;
+
+	if (err_ok != linear_hash_init_hash(1, -1, key_type_numeric_unsigned, workload->key_size, sizeof(int), 4, 85, 4, hash, ION_LINEAR_HASH_SEED, &linear_hash)) {
+		printf("%s: cannot create the table\n", workload->name);
+		return;
+	}
+
+	/* the keys hold zero bytes, so they are compared as whole unsigned values */
+	linear_hash.super.compare	= dictionary_switch_compare(key_type_numeric_unsigned, workload->key_size);
+	start_ns					= benchmark_lh_distribution_now_ns();
+
+	for (i = 0; i < records; i++) {
+		workload->make(key, i);
+
+		if (err_ok != linear_hash_insert(key, (ion_byte_t *) &i, insert_hash_to_bucket(key, &linear_hash), &linear_hash).error) {
+			printf("%s: insert %d failed\n", workload->name, i);
+			break;
+		}
+	}
+
+	insert_ns	= benchmark_lh_distribution_now_ns() - start_ns;
+	start_ns	= benchmark_lh_distribution_now_ns();
+
+	for (i = 0; i < records; i++) {
+		workload->make(key, i);
+
+		if ((err_ok != linear_hash_get(key, (ion_byte_t *) &value, &linear_hash).error) || (value != i)) {
+			printf("%s: lookup %d failed\n", workload->name, i);
+			break;
+		}
+	}
+
+	get_ns = benchmark_lh_distribution_now_ns() - start_ns;
+
+	printf("%s, %s hash: %.0f ns per insert, %.0f ns per get\n", workload->name, linear_hash_hash_polynomial == hash ? "polynomial" : "wyhash", (double) insert_ns / records, (double) get_ns / records);
+	print_linear_hash_distribution(&linear_hash);
+	printf("\n");
+
+	linear_hash_destroy(&linear_hash);
+}
+
+int
+main(
+	int		argc,
+	char	**argv
+) {
+	static benchmark_lh_distribution_workload_t workloads[] = {
+		{ "4 byte timestamps", sizeof(uint32_t), benchmark_lh_distribution_timestamp }, { "8 byte timestamps", sizeof(int64_t), benchmark_lh_distribution_timestamp_ms }, { "MAC addresses", 6, benchmark_lh_distribution_mac }, { "16 byte names", BENCHMARK_LH_DISTRIBUTION_KEY_SIZE, benchmark_lh_distribution_name }
+	};
+	int records = BENCHMARK_LH_DISTRIBUTION_RECORDS;
+	int i;
+
+#if !defined(NDEBUG)
+	printf("note: configure with -DCMAKE_BUILD_TYPE=Release for representative timings\n\n");
+#endif
+
+	if (argc > 1) {
+		records = atoi(argv[1]);
+	}
+
+	if (records < 1) {
+		fprintf(stderr, "usage: %s [records]\n", argv[0]);
+		return 1;
+	}
+
+	for (i = 0; i < (int) (sizeof(workloads) / sizeof(workloads[0])); i++) {
+		benchmark_lh_distribution_run(&workloads[i], linear_hash_hash_polynomial, records);
+		benchmark_lh_distribution_run(&workloads[i], linear_hash_hash_wyhash, records);
+	}
+
+	return 0;
+}
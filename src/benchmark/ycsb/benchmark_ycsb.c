@@ -0,0 +1,781 @@
+/******************************************************************************/
+/**
+@file		benchmark_ycsb.c
+@author		IonDB Project Contributors
+@brief		YCSB style workloads run against every dictionary implementation, reporting JSON.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+/* For clock_gettime, fork and getrusage. */
+#define _XOPEN_SOURCE 700
+
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../../dictionary/dictionary.h"
+#include "../../dictionary/bpp_tree/bpp_tree_handler.h"
+#include "../../dictionary/flat_file/flat_file_dictionary_handler.h"
+#include "../../dictionary/linear_hash/linear_hash_handler.h"
+#include "../../dictionary/open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+#include "../../dictionary/open_address_hash/open_address_hash_dictionary_handler.h"
+#include "../../dictionary/sharded/sharded_handler.h"
+#include "../../dictionary/skip_list/skip_list_handler.h"
+
+/**
+@brief		The identifier every benchmarked dictionary is created with.
+*/
+#define BENCHMARK_YCSB_ID				1
+
+/**
+@brief		The skew of the Zipfian key distribution, as used by YCSB.
+*/
+#define BENCHMARK_YCSB_ZIPFIAN_THETA	0.99
+
+/**
+@brief		How to pick the keys of a workload.
+*/
+typedef enum {
+	benchmark_ycsb_uniform, benchmark_ycsb_zipfian
+} benchmark_ycsb_distribution_e;
+
+/**
+@brief		A dictionary implementation to benchmark.
+*/
+typedef struct {
+	/**> The name reported in the results. */
+	const char *name;
+	/**> Binds the implementation to a handler. */
+	void (*init)(
+		ion_dictionary_handler_t *handler
+	);
+	/**> Whether the dictionary is sized by the records it must hold,
+		 rather than by an implementation specific parameter. */
+	ion_boolean_t	sized_by_records;
+	/**> The implementation specific dictionary size otherwise. */
+	int				size;
+} benchmark_ycsb_dictionary_t;
+
+/**
+@brief		A mix of operations, in percent.
+*/
+typedef struct {
+	/**> The name reported in the results. */
+	const char	*name;
+	/**> The share of gets. */
+	int			read;
+	/**> The share of updates. */
+	int			update;
+	/**> The share of inserts of new keys. */
+	int			insert;
+	/**> The share of short range scans. */
+	int			scan;
+} benchmark_ycsb_workload_t;
+
+/**
+@brief		The settings of a benchmark run.
+*/
+typedef struct {
+	/**> The number of records loaded before the workloads run. */
+	int								records;
+	/**> The number of operations of each workload. */
+	int								operations;
+	/**> The size of the values in bytes. */
+	int								value_size;
+	/**> The most records a scan reads. */
+	int								scan_length;
+	/**> How the keys of the workloads are picked. */
+	benchmark_ycsb_distribution_e	distribution;
+	/**> Seeds the random choices, so runs can be repeated. */
+	uint64_t						seed;
+} benchmark_ycsb_config_t;
+
+/**
+@brief		The measurements of one workload against one dictionary.
+*/
+typedef struct {
+	/**> The name of the workload. */
+	const char	*workload;
+	/**> Why the workload couldn't run, or NULL if it did. */
+	const char	*skipped;
+	/**> The number of operations run. */
+	int			operations;
+	/**> The number of operations that failed. */
+	int			errors;
+	/**> The wall clock time of the workload. */
+	double		seconds;
+	/**> The median operation latency. */
+	long		p50_ns;
+	/**> The 99th percentile operation latency. */
+	long		p99_ns;
+	/**> The 99.9th percentile operation latency. */
+	long		p999_ns;
+	/**> The bytes read through system calls, or -1 if unknown. */
+	long		bytes_read;
+	/**> The bytes written through system calls, or -1 if unknown. */
+	long		bytes_written;
+	/**> The peak resident set size of the process so far. */
+	long		peak_rss_kib;
+} benchmark_ycsb_result_t;
+
+/**
+@brief		Draws keys following a Zipfian distribution, as described by
+			Gray et al. in "Quickly Generating Billion-Record Synthetic
+			Databases".
+*/
+typedef struct {
+	/**> The number of distinct items. */
+	long	items;
+	/**> The distribution's skew. */
+	double	theta;
+	/**> 1 / (1 - theta). */
+	double	alpha;
+	/**> The zeta constant of all items. */
+	double	zetan;
+	/**> Precomputed from the two first zeta constants. */
+	double	eta;
+} benchmark_ycsb_zipfian_t;
+
+static const benchmark_ycsb_dictionary_t benchmark_ycsb_dictionaries[] = {
+	{ "bpp_tree", bpptree_init, boolean_false, -1 },
+	{ "flat_file", ffdict_init, boolean_false, 16 },
+	{ "linear_hash", linear_hash_dict_init, boolean_true, 0 },
+	{ "open_address_file_hash", oafdict_init, boolean_true, 0 },
+	{ "open_address_hash", oadict_init, boolean_true, 0 },
+	{ "sharded", shdict_init, boolean_false, -1 },
+	{ "skip_list", sldict_init, boolean_false, 16 },
+};
+
+/**
+@brief		The YCSB core workloads that apply to a key-value store: B is
+			read heavy, A update heavy and E scan heavy.
+*/
+static const benchmark_ycsb_workload_t benchmark_ycsb_workloads[] = {
+	{ "read_heavy", 95, 5, 0, 0 }, { "update_heavy", 50, 50, 0, 0 }, { "scan", 0, 0, 5, 95 },
+};
+
+#define BENCHMARK_YCSB_DICTIONARIES		(int) (sizeof(benchmark_ycsb_dictionaries) / sizeof(benchmark_ycsb_dictionaries[0]))
+#define BENCHMARK_YCSB_WORKLOADS		(int) (sizeof(benchmark_ycsb_workloads) / sizeof(benchmark_ycsb_workloads[0]))
+
+/**
+@brief		Returns the next number of a splitmix64 sequence.
+*/
+static uint64_t
+benchmark_ycsb_random(
+	uint64_t *state
+) {
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+	z	= (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z	= (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+@brief		Returns a random number in [0, 1).
+*/
+static double
+benchmark_ycsb_random_unit(
+	uint64_t *state
+) {
+	return (benchmark_ycsb_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+@brief		Scatters the ranks of a distribution over the key space, so the
+			popular keys aren't neighbours.
+*/
+static uint64_t
+benchmark_ycsb_scramble(
+	uint64_t rank
+) {
+	uint64_t	hash = 14695981039346656037ULL;
+	int			i;
+
+	for (i = 0; i < 8; i++) {
+		hash	^= (rank >> (i * 8)) & 0xFF;
+		hash	*= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/**
+@brief		Prepares to draw Zipfian ranks out of @p items.
+*/
+static void
+benchmark_ycsb_zipfian_init(
+	benchmark_ycsb_zipfian_t	*zipfian,
+	long						items,
+	double						theta
+) {
+	double	zeta2	= 1.0 + pow(0.5, theta);
+	long	i;
+
+	zipfian->items	= items;
+	zipfian->theta	= theta;
+	zipfian->alpha	= 1.0 / (1.0 - theta);
+	zipfian->zetan	= 0;
+
+	for (i = 1; i <= items; i++) {
+		zipfian->zetan += 1.0 / pow((double) i, theta);
+	}
+
+	zipfian->eta = (1.0 - pow(2.0 / items, 1.0 - theta)) / (1.0 - zeta2 / zipfian->zetan);
+}
+
+/**
+@brief		Draws a Zipfian rank, 0 being the most popular.
+*/
+static long
+benchmark_ycsb_zipfian_next(
+	benchmark_ycsb_zipfian_t	*zipfian,
+	uint64_t					*state
+) {
+	double	u	= benchmark_ycsb_random_unit(state);
+	double	uz	= u * zipfian->zetan;
+	long	rank;
+
+	if (uz < 1.0) {
+		return 0;
+	}
+
+	if (uz < 1.0 + pow(0.5, zipfian->theta)) {
+		return 1;
+	}
+
+	rank = (long) (zipfian->items * pow(zipfian->eta * u - zipfian->eta + 1.0, zipfian->alpha));
+
+	return rank < zipfian->items ? rank : zipfian->items - 1;
+}
+
+/**
+@brief		Picks the key of the next operation among the loaded records.
+*/
+static int
+benchmark_ycsb_next_key(
+	benchmark_ycsb_config_t		*config,
+	benchmark_ycsb_zipfian_t	*zipfian,
+	uint64_t					*state
+) {
+	if (benchmark_ycsb_zipfian == config->distribution) {
+		return (int) (benchmark_ycsb_scramble(benchmark_ycsb_zipfian_next(zipfian, state)) % config->records);
+	}
+
+	return (int) (benchmark_ycsb_random(state) % config->records);
+}
+
+/**
+@brief		Returns the nanoseconds on a monotonic clock.
+*/
+static long
+benchmark_ycsb_now_ns(
+	void
+) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+/**
+@brief		Reads the bytes this process has passed to read and write
+			system calls so far.
+@return		@ref boolean_false if the kernel doesn't report them.
+*/
+static ion_boolean_t
+benchmark_ycsb_io(
+	long	*read,
+	long	*written
+) {
+	char	line[128];
+	FILE	*io = fopen("/proc/self/io", "r");
+	int		found = 0;
+
+	if (NULL == io) {
+		return boolean_false;
+	}
+
+	while (NULL != fgets(line, sizeof(line), io)) {
+		found	+= 1 == sscanf(line, "rchar: %ld", read);
+		found	+= 1 == sscanf(line, "wchar: %ld", written);
+	}
+
+	fclose(io);
+	return 2 == found;
+}
+
+/**
+@brief		Orders latencies for the percentiles.
+*/
+static int
+benchmark_ycsb_compare_latency(
+	const void	*a,
+	const void	*b
+) {
+	long	first	= *(const long *) a;
+	long	second	= *(const long *) b;
+
+	return (first > second) - (first < second);
+}
+
+/**
+@brief		Fills in the latency percentiles, throughput inputs, I/O and
+			memory use of a finished workload.
+*/
+static void
+benchmark_ycsb_finish(
+	benchmark_ycsb_result_t *result,
+	long					*latencies,
+	long					start_ns,
+	long					read_before,
+	long					written_before,
+	ion_boolean_t			io_known
+) {
+	struct rusage	usage;
+	long			read;
+	long			written;
+
+	result->seconds = (benchmark_ycsb_now_ns() - start_ns) / 1e9;
+
+	if (benchmark_ycsb_io(&read, &written) && io_known) {
+		result->bytes_read		= read - read_before;
+		result->bytes_written	= written - written_before;
+	}
+	else {
+		result->bytes_read		= -1;
+		result->bytes_written	= -1;
+	}
+
+	if (0 < result->operations) {
+		qsort(latencies, result->operations, sizeof(long), benchmark_ycsb_compare_latency);
+		result->p50_ns	= latencies[(long) result->operations * 50 / 100];
+		result->p99_ns	= latencies[(long) result->operations * 99 / 100];
+		result->p999_ns = latencies[(long) result->operations * 999 / 1000];
+	}
+
+	getrusage(RUSAGE_SELF, &usage);
+	result->peak_rss_kib = usage.ru_maxrss;
+}
+
+/**
+@brief		Scans up to @p length records from @p key onwards.
+@return		The error of opening the cursor.
+*/
+static ion_err_t
+benchmark_ycsb_scan(
+	ion_dictionary_t	*dictionary,
+	int					key,
+	int					length,
+	ion_byte_t			*value
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					last	= key + length - 1;
+	int					found;
+	ion_err_t			err;
+
+	dictionary_build_predicate(&predicate, predicate_range, &key, &last);
+	err = dictionary_find(dictionary, &predicate, &cursor);
+
+	if (err_ok != err) {
+		if (NULL != cursor) {
+			cursor->destroy(&cursor);
+		}
+
+		return err;
+	}
+
+	record.key		= &found;
+	record.value	= value;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {}
+
+	cursor->destroy(&cursor);
+
+	return err_ok;
+}
+
+/**
+@brief		Inserts the records, in random order, into an empty dictionary.
+*/
+static void
+benchmark_ycsb_load(
+	benchmark_ycsb_config_t *config,
+	ion_dictionary_t		*dictionary,
+	ion_byte_t				*value,
+	long					*latencies,
+	benchmark_ycsb_result_t *result
+) {
+	uint64_t		state = config->seed;
+	long			read_before;
+	long			written_before;
+	ion_boolean_t	io_known;
+	int				*keys;
+	int				swap;
+	int				i;
+	int				j;
+	long			start_ns;
+	long			op_ns;
+
+	memset(result, 0, sizeof(*result));
+	result->workload = "load";
+	keys = malloc(config->records * sizeof(int));
+
+	if (NULL == keys) {
+		result->skipped = "out of memory";
+		return;
+	}
+
+	for (i = 0; i < config->records; i++) {
+		keys[i] = i;
+	}
+
+	for (i = config->records - 1; i > 0; i--) {
+		j		= (int) (benchmark_ycsb_random(&state) % (i + 1));
+		swap	= keys[i];
+		keys[i] = keys[j];
+		keys[j] = swap;
+	}
+
+	io_known	= benchmark_ycsb_io(&read_before, &written_before);
+	start_ns	= benchmark_ycsb_now_ns();
+
+	for (i = 0; i < config->records; i++) {
+		memcpy(value, &keys[i], sizeof(int));
+		op_ns = benchmark_ycsb_now_ns();
+
+		if (err_ok != dictionary_insert(dictionary, &keys[i], value).error) {
+			result->errors++;
+		}
+
+		latencies[result->operations++] = benchmark_ycsb_now_ns() - op_ns;
+	}
+
+	benchmark_ycsb_finish(result, latencies, start_ns, read_before, written_before, io_known);
+	free(keys);
+}
+
+/**
+@brief		Runs a mix of operations over the loaded records.
+*/
+static void
+benchmark_ycsb_run(
+	benchmark_ycsb_config_t				*config,
+	const benchmark_ycsb_workload_t		*workload,
+	ion_dictionary_t					*dictionary,
+	ion_byte_t							*value,
+	long								*latencies,
+	benchmark_ycsb_result_t				*result
+) {
+	benchmark_ycsb_zipfian_t	zipfian;
+	uint64_t					state = config->seed ^ benchmark_ycsb_scramble((uint64_t) (workload - benchmark_ycsb_workloads) + 1);
+	long						read_before;
+	long						written_before;
+	ion_boolean_t				io_known;
+	int							next_insert;
+	int							dice;
+	int							key;
+	int							i;
+	long						start_ns;
+	long						op_ns;
+	ion_err_t					err;
+
+	memset(result, 0, sizeof(*result));
+	result->workload = workload->name;
+
+	if (0 < workload->scan) {
+		/* Some implementations have no cursors at all; probe the rest once, */
+		/* outside the measurements. */
+		err = NULL == dictionary->handler->find ? err_not_implemented : benchmark_ycsb_scan(dictionary, 0, 1, value);
+
+		if (err_ok != err) {
+			result->skipped = err_not_implemented == err ? "find not implemented" : "find failed";
+			return;
+		}
+	}
+
+	if (benchmark_ycsb_zipfian == config->distribution) {
+		benchmark_ycsb_zipfian_init(&zipfian, config->records, BENCHMARK_YCSB_ZIPFIAN_THETA);
+	}
+
+	/* New keys go past the loaded ones; the workloads run in turn, */
+	/* so start past any a previous workload inserted. */
+	next_insert = config->records + (int) (workload - benchmark_ycsb_workloads) * config->operations;
+	io_known	= benchmark_ycsb_io(&read_before, &written_before);
+	start_ns	= benchmark_ycsb_now_ns();
+
+	for (i = 0; i < config->operations; i++) {
+		dice	= (int) (benchmark_ycsb_random(&state) % 100);
+		key		= benchmark_ycsb_next_key(config, &zipfian, &state);
+		op_ns	= benchmark_ycsb_now_ns();
+
+		if (dice < workload->read) {
+			err = dictionary_get(dictionary, &key, value).error;
+		}
+		else if (dice < workload->read + workload->update) {
+			memcpy(value, &i, sizeof(int));
+			err = dictionary_update(dictionary, &key, value).error;
+		}
+		else if (dice < workload->read + workload->update + workload->insert) {
+			key = next_insert++;
+			memcpy(value, &key, sizeof(int));
+			err = dictionary_insert(dictionary, &key, value).error;
+		}
+		else {
+			err = benchmark_ycsb_scan(dictionary, key, 1 + (int) (benchmark_ycsb_random(&state) % config->scan_length), value);
+		}
+
+		latencies[result->operations++] = benchmark_ycsb_now_ns() - op_ns;
+
+		if (err_ok != err) {
+			result->errors++;
+		}
+	}
+
+	benchmark_ycsb_finish(result, latencies, start_ns, read_before, written_before, io_known);
+}
+
+/**
+@brief		Prints the results of one dictionary as JSON objects.
+*/
+static void
+benchmark_ycsb_print(
+	const char				*dictionary,
+	benchmark_ycsb_result_t *results,
+	int						count,
+	ion_boolean_t			first
+) {
+	benchmark_ycsb_result_t *result;
+	int						i;
+
+	for (i = 0; i < count; i++) {
+		result = &results[i];
+		printf("%s\n    {\"dictionary\": \"%s\", \"workload\": \"%s\", ", first && 0 == i ? "" : ",", dictionary, result->workload);
+
+		if (NULL != result->skipped) {
+			printf("\"skipped\": \"%s\"}", result->skipped);
+			continue;
+		}
+
+		printf("\"operations\": %d, \"errors\": %d, \"seconds\": %.6f, \"throughput\": %.1f, ", result->operations, result->errors, result->seconds, result->seconds > 0 ? result->operations / result->seconds : 0);
+		printf("\"latency_ns\": {\"p50\": %ld, \"p99\": %ld, \"p999\": %ld}, ", result->p50_ns, result->p99_ns, result->p999_ns);
+		printf("\"bytes_read\": %ld, \"bytes_written\": %ld, \"peak_rss_kib\": %ld}", result->bytes_read, result->bytes_written, result->peak_rss_kib);
+	}
+}
+
+/**
+@brief		Loads one dictionary and runs every workload against it.
+*/
+static void
+benchmark_ycsb_dictionary(
+	benchmark_ycsb_config_t				*config,
+	const benchmark_ycsb_dictionary_t	*type,
+	ion_boolean_t						first
+) {
+	benchmark_ycsb_result_t		results[1 + BENCHMARK_YCSB_WORKLOADS];
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_size_t		size;
+	ion_byte_t					*value;
+	long						*latencies;
+	int							longest;
+	int							i;
+
+	memset(results, 0, sizeof(results));
+	longest		= config->records > config->operations ? config->records : config->operations;
+	value		= calloc(1, config->value_size);
+	latencies	= malloc(longest * sizeof(long));
+
+	/* Fixed capacity tables need room for every insert of every workload. */
+	size		= type->sized_by_records ? 2 * (config->records + BENCHMARK_YCSB_WORKLOADS * config->operations) : type->size;
+
+	type->init(&handler);
+
+	if ((NULL == value) || (NULL == latencies) || (err_ok != dictionary_create(&handler, &dictionary, BENCHMARK_YCSB_ID, key_type_numeric_signed, sizeof(int), config->value_size, size))) {
+		results[0].workload = "load";
+		results[0].skipped	= "create failed";
+		benchmark_ycsb_print(type->name, results, 1, first);
+		free(value);
+		free(latencies);
+		return;
+	}
+
+	benchmark_ycsb_load(config, &dictionary, value, latencies, &results[0]);
+
+	for (i = 0; i < BENCHMARK_YCSB_WORKLOADS; i++) {
+		benchmark_ycsb_run(config, &benchmark_ycsb_workloads[i], &dictionary, value, latencies, &results[1 + i]);
+	}
+
+	dictionary_delete_dictionary(&dictionary);
+	benchmark_ycsb_print(type->name, results, 1 + BENCHMARK_YCSB_WORKLOADS, first);
+	free(value);
+	free(latencies);
+}
+
+/**
+@brief		Prints how to run the benchmark.
+*/
+static void
+benchmark_ycsb_usage(
+	const char *program
+) {
+	int i;
+
+	fprintf(stderr, "usage: %s [--records n] [--operations n] [--value-size bytes] [--scan-length n]\n", program);
+	fprintf(stderr, "       [--distribution uniform|zipfian] [--seed n] [--dictionary name]...\n");
+	fprintf(stderr, "dictionaries:");
+
+	for (i = 0; i < BENCHMARK_YCSB_DICTIONARIES; i++) {
+		fprintf(stderr, " %s", benchmark_ycsb_dictionaries[i].name);
+	}
+
+	fprintf(stderr, "\n");
+}
+
+int
+main(
+	int		argc,
+	char	**argv
+) {
+	benchmark_ycsb_config_t config;
+	ion_boolean_t			selected[BENCHMARK_YCSB_DICTIONARIES];
+	ion_boolean_t			any		= boolean_false;
+	ion_boolean_t			first	= boolean_true;
+	pid_t					child;
+	int						status;
+	int						i;
+	int						j;
+
+	config.records		= 10000;
+	config.operations	= 10000;
+	config.value_size	= 16;
+	config.scan_length	= 100;
+	config.distribution = benchmark_ycsb_zipfian;
+	config.seed			= 1;
+	memset(selected, 0, sizeof(selected));
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 == argc) {
+			benchmark_ycsb_usage(argv[0]);
+			return 1;
+		}
+
+		if (0 == strcmp(argv[i], "--records")) {
+			config.records = atoi(argv[++i]);
+		}
+		else if (0 == strcmp(argv[i], "--operations")) {
+			config.operations = atoi(argv[++i]);
+		}
+		else if (0 == strcmp(argv[i], "--value-size")) {
+			config.value_size = atoi(argv[++i]);
+		}
+		else if (0 == strcmp(argv[i], "--scan-length")) {
+			config.scan_length = atoi(argv[++i]);
+		}
+		else if (0 == strcmp(argv[i], "--seed")) {
+			config.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (0 == strcmp(argv[i], "--distribution")) {
+			i++;
+
+			if (0 == strcmp(argv[i], "uniform")) {
+				config.distribution = benchmark_ycsb_uniform;
+			}
+			else if (0 == strcmp(argv[i], "zipfian")) {
+				config.distribution = benchmark_ycsb_zipfian;
+			}
+			else {
+				benchmark_ycsb_usage(argv[0]);
+				return 1;
+			}
+		}
+		else if (0 == strcmp(argv[i], "--dictionary")) {
+			i++;
+
+			for (j = 0; j < BENCHMARK_YCSB_DICTIONARIES && 0 != strcmp(argv[i], benchmark_ycsb_dictionaries[j].name); j++) {}
+
+			if (BENCHMARK_YCSB_DICTIONARIES == j) {
+				benchmark_ycsb_usage(argv[0]);
+				return 1;
+			}
+
+			selected[j] = boolean_true;
+			any			= boolean_true;
+		}
+		else {
+			benchmark_ycsb_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if ((config.records < 1) || (config.operations < 1) || (config.value_size < (int) sizeof(int)) || (config.scan_length < 1)) {
+		benchmark_ycsb_usage(argv[0]);
+		return 1;
+	}
+
+	printf("{\"benchmark\": \"ycsb\", \"records\": %d, \"operations\": %d, \"value_size\": %d, \"scan_length\": %d, ", config.records, config.operations, config.value_size, config.scan_length);
+	printf("\"distribution\": \"%s\", \"seed\": %llu, ", benchmark_ycsb_zipfian == config.distribution ? "zipfian" : "uniform", (unsigned long long) config.seed);
+#if defined(NDEBUG)
+	printf("\"build\": \"release\", \"results\": [");
+#else
+	printf("\"build\": \"debug\", \"results\": [");
+#endif
+
+	/* Each dictionary runs in its own process, so the peak RSS and I/O */
+	/* counters of one don't include those of another. */
+	for (i = 0; i < BENCHMARK_YCSB_DICTIONARIES; i++) {
+		if (any && !selected[i]) {
+			continue;
+		}
+
+		fflush(stdout);
+		child = fork();
+
+		if (0 == child) {
+			benchmark_ycsb_dictionary(&config, &benchmark_ycsb_dictionaries[i], first);
+			fflush(stdout);
+			_exit(0);
+		}
+
+		if ((-1 == child) || (-1 == waitpid(child, &status, 0)) || !WIFEXITED(status) || (0 != WEXITSTATUS(status))) {
+			printf("%s\n    {\"dictionary\": \"%s\", \"workload\": \"load\", \"skipped\": \"crashed\"}", first ? "" : ",", benchmark_ycsb_dictionaries[i].name);
+		}
+
+		first = boolean_false;
+	}
+
+	printf("\n]}\n");
+
+	return 0;
+}
@@ -38,9 +38,71 @@
 #if !defined(CURSOR_H)
 #define CURSOR_H
 
+#include <string.h>
+
+/**
+@brief		The number of records fetched at a time when a cursor is iterated
+			with @ref Cursor::begin and @ref Cursor::end.
+*/
+#if !defined(ION_CURSOR_BATCH_SIZE)
+#define ION_CURSOR_BATCH_SIZE 16
+#endif
+
 template<typename K, typename V>
 class Cursor {
 public:
+/**
+@brief		A key/value pair returned when iterating over a cursor.
+*/
+struct Entry {
+	K	key;
+	V	value;
+};
+
+/**
+@brief		Forward iterator over the records of a cursor, so that results
+			can be visited with a range-based for loop:
+			@code
+			for (auto entry : *cursor) { ... }
+			@endcode
+			Records are fetched @ref ION_CURSOR_BATCH_SIZE at a time through
+			@ref dictionary_next_batch. An iterator should not be mixed with
+			calls to @ref Cursor::next on the same cursor.
+*/
+class Iterator {
+public:
+Iterator(
+	Cursor<K, V> *owner
+) : owner(owner) {}
+
+Entry
+operator*(
+) const {
+	return owner->batchEntry();
+}
+
+Iterator &
+operator++(
+) {
+	if (!owner->batchAdvance()) {
+		owner = NULL;
+	}
+
+	return *this;
+}
+
+bool
+operator!=(
+	const Iterator &other
+) const {
+	return owner != other.owner;
+}
+
+private:
+
+Cursor<K, V> *owner;
+};
+
 Cursor(
 	ion_dictionary_t	*dictionary,
 	ion_predicate_t		*predicate
@@ -49,6 +111,9 @@ Cursor(
 	dictionary_find(dictionary, predicate, &cursor);
 	record.key			= malloc(dictionary->instance->record.key_size);
 	record.value		= malloc(dictionary->instance->record.value_size);
+	batch				= NULL;
+	batch_count			= 0;
+	batch_position		= 0;
 }
 
 ~Cursor(
@@ -56,6 +121,27 @@ Cursor(
 	cursor->destroy(&cursor);
 	free(record.key);
 	free(record.value);
+	free(batch);
+}
+
+Iterator
+begin(
+) {
+	if (NULL == batch) {
+		batch = (ion_byte_t *) malloc(ION_CURSOR_BATCH_SIZE * (dictionary->instance->record.key_size + dictionary->instance->record.value_size));
+
+		if ((NULL == batch) || !batchFill()) {
+			return end();
+		}
+	}
+
+	return Iterator(batch_position < batch_count ? this : NULL);
+}
+
+Iterator
+end(
+) {
+	return Iterator(NULL);
 }
 
 bool
@@ -89,6 +175,39 @@ private:
 ion_dictionary_t	*dictionary;
 ion_dict_cursor_t	*cursor;
 ion_record_t		record;
+ion_byte_t			*batch;
+ion_result_count_t	batch_count;
+ion_result_count_t	batch_position;
+
+bool
+batchFill(
+) {
+	batch_position = 0;
+
+	return cs_cursor_active == dictionary_next_batch(cursor, batch, ION_CURSOR_BATCH_SIZE, &batch_count);
+}
+
+bool
+batchAdvance(
+) {
+	if (++batch_position < batch_count) {
+		return true;
+	}
+
+	return batchFill();
+}
+
+Entry
+batchEntry(
+) {
+	Entry		entry;
+	ion_byte_t	*row = batch + batch_position * (dictionary->instance->record.key_size + dictionary->instance->record.value_size);
+
+	memcpy(&entry.key, row, sizeof(K));
+	memcpy(&entry.value, row + dictionary->instance->record.key_size, sizeof(V));
+
+	return entry;
+}
 };
 
 #endif
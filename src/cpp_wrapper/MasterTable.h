@@ -46,6 +46,7 @@
 #include "OpenAddressHash.h"
 #include "SkipList.h"
 #include "LinearHash.h"
+#include "Sharded.h"
 
 class MasterTable {
 public:
@@ -349,6 +350,12 @@ initializeDictionary(
 			break;
 		}
 
+		case dictionary_type_sharded_t: {
+			dictionary = new Sharded<K, V>(id, key_type, key_size, value_size, dictionary_size);
+
+			break;
+		}
+
 		case dictionary_type_error_t: {
 			dictionary				= new SkipList<K, V>(id, key_type, key_size, value_size, dictionary_size);
 			dictionary->dict.status = ion_dictionary_status_error;
@@ -0,0 +1,89 @@
+/******************************************************************************/
+/**
+@file		Sharded.h
+@author		IonDB Project Contributors
+@brief		The C++ implementation of a sharded dictionary.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+#ifndef PROJECT_SHARDED_H
+#define PROJECT_SHARDED_H
+
+#include "Dictionary.h"
+#include "../key_value/kv_system.h"
+#include "../dictionary/sharded/sharded_handler.h"
+
+template<typename K, typename V>
+class Sharded:public Dictionary<K, V> {
+public:
+/**
+@brief		Registers a specific sharded dictionary instance.
+
+@details	Registers functions for dictionary.
+
+@param		id
+				A unique identifier important for use of the dictionary through
+				the master table. If the dictionary is being created without
+				the master table, this identifier can be 0.
+@param		key_type
+				The type of keys to be stored in the dictionary.
+@param		key_size
+				The size of keys to be stored in the dictionary.
+@param	  value_size
+				The size of the values to be stored in the dictionary.
+@param	  dictionary_size
+				The size desired for each shard.
+@param		child_type
+				The implementation backing each shard.
+@param		num_shards
+				The number of shards to split the keys over.
+*/
+Sharded(
+	ion_dictionary_id_t		id,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	ion_dictionary_size_t	dictionary_size,
+	ion_dictionary_type_t	child_type = ION_SHARDED_DEFAULT_CHILD_TYPE,
+	int						num_shards = ION_SHARDED_DEFAULT_SHARDS
+) {
+	shdict_init(&this->handler);
+
+	this->key_type		= key_type;
+	this->key_size		= key_size;
+	this->value_size	= value_size;
+	this->dict_size		= dictionary_size;
+
+	shdict_create(&this->handler, &this->dict, id, key_type, key_size, value_size, dictionary_size, child_type, num_shards);
+}
+};
+
+#endif /* PROJECT_SHARDED_H */
@@ -0,0 +1,488 @@
+/******************************************************************************/
+/**
+@file		bpp_buffer_pool.c
+@author		IonDB Project Contributors
+@brief		A node cache shared by every open B+ tree, evicting by 2Q.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+/* Needed for pthread mutexes under -std=c99. */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "bpp_buffer_pool.h"
+
+#if !defined(ARDUINO)
+#include <pthread.h>
+#endif
+
+/**
+@brief		The queues of the 2Q policy.
+*/
+typedef enum {
+	bpp_pool_in, bpp_pool_main, bpp_pool_out
+} ion_bpp_pool_queue_e;
+
+/**
+@brief		A node held by the pool, or the ghost of one recently dropped.
+*/
+typedef struct bpp_pool_entry {
+	/**> The tree the node belongs to. */
+	const void				*owner;
+	/**> The address of the node in the tree. */
+	long					adr;
+	/**> The size of the node in bytes. */
+	int						size;
+	/**> The queue the entry is on. */
+	ion_bpp_pool_queue_e	queue;
+	/**> The node image, or NULL for a ghost. */
+	char					*data;
+	/**> The next entry toward the tail of the queue. */
+	struct bpp_pool_entry	*next;
+	/**> The next entry toward the head of the queue. */
+	struct bpp_pool_entry	*prev;
+	/**> The next entry in the same hash bucket. */
+	struct bpp_pool_entry	*chain;
+} ion_bpp_pool_entry_t;
+
+/**
+@brief		A queue of entries, the most recent at the head.
+*/
+typedef struct {
+	/**> Sentinel linking the head and tail. */
+	ion_bpp_pool_entry_t	ends;
+	/**> The bytes of node images on the queue. */
+	size_t					bytes;
+	/**> The number of entries on the queue. */
+	unsigned long			count;
+} ion_bpp_pool_list_t;
+
+/**
+@brief		The pool shared by every open tree.
+*/
+static struct {
+	/**> The entries, hashed by owner and address. */
+	ion_bpp_pool_entry_t	**buckets;
+	/**> The number of hash buckets, a power of two. */
+	unsigned long			bucket_count;
+	/**> The queues, indexed by @ref ion_bpp_pool_queue_e. */
+	ion_bpp_pool_list_t		lists[3];
+	/**> The counters. */
+	ion_bpp_pool_stats_t	stats;
+#if !defined(ARDUINO)
+	/**> Guards the pool, which trees on several threads share. */
+	pthread_mutex_t			mutex;
+#endif
+} bpp_pool = {
+	.stats = {
+		.budget = ION_BPP_POOL_BYTES
+	},
+#if !defined(ARDUINO)
+	.mutex	= PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/**
+@brief		Takes the pool's lock.
+*/
+static void
+bpp_pool_lock(
+	void
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_lock(&bpp_pool.mutex);
+#endif
+}
+
+/**
+@brief		Releases the pool's lock.
+*/
+static void
+bpp_pool_unlock(
+	void
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_unlock(&bpp_pool.mutex);
+#endif
+}
+
+/**
+@brief		Returns the hash bucket of a node.
+*/
+static unsigned long
+bpp_pool_bucket(
+	const void	*owner,
+	long		adr
+) {
+	uint64_t hash = ((uint64_t) (uintptr_t) owner ^ (uint64_t) adr) * 0x9E3779B97F4A7C15ULL;
+
+	return (unsigned long) (hash >> 32) & (bpp_pool.bucket_count - 1);
+}
+
+/**
+@brief		Returns the entry of a node, or NULL if the pool has none.
+*/
+static ion_bpp_pool_entry_t *
+bpp_pool_find(
+	const void	*owner,
+	long		adr
+) {
+	ion_bpp_pool_entry_t *entry;
+
+	if (0 == bpp_pool.bucket_count) {
+		return NULL;
+	}
+
+	for (entry = bpp_pool.buckets[bpp_pool_bucket(owner, adr)]; NULL != entry; entry = entry->chain) {
+		if ((entry->owner == owner) && (entry->adr == adr)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Takes an entry off its queue.
+*/
+static void
+bpp_pool_unlink(
+	ion_bpp_pool_entry_t *entry
+) {
+	ion_bpp_pool_list_t *list = &bpp_pool.lists[entry->queue];
+
+	entry->prev->next	= entry->next;
+	entry->next->prev	= entry->prev;
+	list->count--;
+
+	if (NULL != entry->data) {
+		list->bytes			-= entry->size;
+		bpp_pool.stats.bytes -= entry->size;
+	}
+}
+
+/**
+@brief		Puts an entry at the head of a queue.
+*/
+static void
+bpp_pool_push(
+	ion_bpp_pool_entry_t	*entry,
+	ion_bpp_pool_queue_e	queue
+) {
+	ion_bpp_pool_list_t *list = &bpp_pool.lists[queue];
+
+	/* an empty queue's sentinel is linked lazily */
+	if (NULL == list->ends.next) {
+		list->ends.next = &list->ends;
+		list->ends.prev = &list->ends;
+	}
+
+	entry->queue		= queue;
+	entry->prev			= &list->ends;
+	entry->next			= list->ends.next;
+	entry->next->prev	= entry;
+	list->ends.next		= entry;
+	list->count++;
+
+	if (NULL != entry->data) {
+		list->bytes			+= entry->size;
+		bpp_pool.stats.bytes += entry->size;
+	}
+}
+
+/**
+@brief		Returns the tail of a queue, or NULL if it is empty.
+*/
+static ion_bpp_pool_entry_t *
+bpp_pool_tail(
+	ion_bpp_pool_queue_e queue
+) {
+	ion_bpp_pool_list_t *list = &bpp_pool.lists[queue];
+
+	return 0 == list->count ? NULL : list->ends.prev;
+}
+
+/**
+@brief		Takes an entry off its queue and out of the hash table, and
+			frees it.
+*/
+static void
+bpp_pool_remove(
+	ion_bpp_pool_entry_t *entry
+) {
+	ion_bpp_pool_entry_t **link = &bpp_pool.buckets[bpp_pool_bucket(entry->owner, entry->adr)];
+
+	while (*link != entry) {
+		link = &(*link)->chain;
+	}
+
+	*link = entry->chain;
+	bpp_pool_unlink(entry);
+	free(entry->data);
+	free(entry);
+}
+
+/**
+@brief		Doubles the hash table once it holds twice as many entries as
+			buckets. A failed allocation leaves the chains longer.
+*/
+static void
+bpp_pool_grow(
+	void
+) {
+	ion_bpp_pool_entry_t	**old		= bpp_pool.buckets;
+	unsigned long			old_count	= bpp_pool.bucket_count;
+	unsigned long			entries		= bpp_pool.lists[bpp_pool_in].count + bpp_pool.lists[bpp_pool_main].count + bpp_pool.lists[bpp_pool_out].count;
+	ion_bpp_pool_entry_t	*entry;
+	ion_bpp_pool_entry_t	*chain;
+	unsigned long			i;
+	unsigned long			bucket;
+
+	if ((0 != old_count) && (entries < 2 * old_count)) {
+		return;
+	}
+
+	bpp_pool.buckets = calloc(0 == old_count ? 256 : 2 * old_count, sizeof(ion_bpp_pool_entry_t *));
+
+	if (NULL == bpp_pool.buckets) {
+		bpp_pool.buckets = old;
+		return;
+	}
+
+	bpp_pool.bucket_count = 0 == old_count ? 256 : 2 * old_count;
+
+	for (i = 0; i < old_count; i++) {
+		for (entry = old[i]; NULL != entry; entry = chain) {
+			chain						= entry->chain;
+			bucket						= bpp_pool_bucket(entry->owner, entry->adr);
+			entry->chain				= bpp_pool.buckets[bucket];
+			bpp_pool.buckets[bucket]	= entry;
+		}
+	}
+
+	free(old);
+}
+
+/**
+@brief		Drops nodes until the pool fits its budget, and forgets the
+			oldest ghosts once there are more than half as many as nodes.
+*/
+static void
+bpp_pool_evict(
+	void
+) {
+	size_t					in_budget = bpp_pool.stats.budget / 100 * ION_BPP_POOL_IN_PERCENT;
+	ion_bpp_pool_entry_t	*victim;
+	unsigned long			ghosts;
+
+	while (bpp_pool.stats.bytes > bpp_pool.stats.budget) {
+		bpp_pool.stats.evictions++;
+
+		if ((bpp_pool.lists[bpp_pool_in].bytes > in_budget) || (0 == bpp_pool.lists[bpp_pool_main].count)) {
+			/* leave a ghost, so a second read promotes the node */
+			victim = bpp_pool_tail(bpp_pool_in);
+			bpp_pool_unlink(victim);
+			free(victim->data);
+			victim->data = NULL;
+			bpp_pool_push(victim, bpp_pool_out);
+		}
+		else {
+			bpp_pool_remove(bpp_pool_tail(bpp_pool_main));
+		}
+	}
+
+	ghosts = (bpp_pool.lists[bpp_pool_in].count + bpp_pool.lists[bpp_pool_main].count) / 2;
+
+	while (bpp_pool.lists[bpp_pool_out].count > ghosts) {
+		bpp_pool_remove(bpp_pool_tail(bpp_pool_out));
+	}
+}
+
+void
+bpp_pool_set_budget(
+	size_t bytes
+) {
+	bpp_pool_lock();
+	bpp_pool.stats.budget = bytes;
+	bpp_pool_evict();
+	bpp_pool_unlock();
+}
+
+void
+bpp_pool_get_stats(
+	ion_bpp_pool_stats_t *stats
+) {
+	bpp_pool_lock();
+	*stats			= bpp_pool.stats;
+	stats->in_bytes = bpp_pool.lists[bpp_pool_in].bytes;
+	bpp_pool_unlock();
+}
+
+void
+bpp_pool_reset_stats(
+	void
+) {
+	bpp_pool_lock();
+	bpp_pool.stats.hits			= 0;
+	bpp_pool.stats.misses		= 0;
+	bpp_pool.stats.ghost_hits	= 0;
+	bpp_pool.stats.evictions	= 0;
+	bpp_pool_unlock();
+}
+
+ion_boolean_t
+bpp_pool_read(
+	const void	*owner,
+	long		adr,
+	int			size,
+	void		*node
+) {
+	ion_bpp_pool_entry_t	*entry;
+	ion_boolean_t			hit = boolean_false;
+
+	bpp_pool_lock();
+
+	if (0 == bpp_pool.stats.budget) {
+		bpp_pool_unlock();
+		return boolean_false;
+	}
+
+	entry = bpp_pool_find(owner, adr);
+
+	if ((NULL != entry) && (NULL != entry->data) && (entry->size == size)) {
+		memcpy(node, entry->data, size);
+		hit = boolean_true;
+		bpp_pool.stats.hits++;
+
+		/* nodes read once stay in FIFO order */
+		if (bpp_pool_main == entry->queue) {
+			bpp_pool_unlink(entry);
+			bpp_pool_push(entry, bpp_pool_main);
+		}
+	}
+	else {
+		bpp_pool.stats.misses++;
+
+		if ((NULL != entry) && (NULL == entry->data)) {
+			bpp_pool.stats.ghost_hits++;
+		}
+	}
+
+	bpp_pool_unlock();
+	return hit;
+}
+
+void
+bpp_pool_write(
+	const void	*owner,
+	long		adr,
+	int			size,
+	const void	*node
+) {
+	ion_bpp_pool_entry_t	*entry;
+	ion_bpp_pool_queue_e	queue;
+	unsigned long			bucket;
+
+	bpp_pool_lock();
+	entry = bpp_pool_find(owner, adr);
+
+	if ((NULL != entry) && (NULL != entry->data) && (entry->size == size)) {
+		/* a rewrite keeps the node's place in the FIFO queue */
+		memcpy(entry->data, node, size);
+
+		if (bpp_pool_main == entry->queue) {
+			bpp_pool_unlink(entry);
+			bpp_pool_push(entry, bpp_pool_main);
+		}
+
+		bpp_pool_unlock();
+		return;
+	}
+
+	/* a ghost comes back to the main queue */
+	queue = bpp_pool_in;
+
+	if (NULL != entry) {
+		queue = NULL == entry->data ? bpp_pool_main : entry->queue;
+		bpp_pool_remove(entry);
+	}
+
+	if ((size_t) size > bpp_pool.stats.budget / 4) {
+		bpp_pool_unlock();
+		return;
+	}
+
+	bpp_pool_grow();
+	entry = malloc(sizeof(ion_bpp_pool_entry_t));
+
+	if ((NULL == entry) || (0 == bpp_pool.bucket_count) || (NULL == (entry->data = malloc(size)))) {
+		free(entry);
+		bpp_pool_unlock();
+		return;
+	}
+
+	entry->owner				= owner;
+	entry->adr					= adr;
+	entry->size					= size;
+	bucket						= bpp_pool_bucket(owner, adr);
+	entry->chain				= bpp_pool.buckets[bucket];
+	bpp_pool.buckets[bucket]	= entry;
+	memcpy(entry->data, node, size);
+	bpp_pool_push(entry, queue);
+	bpp_pool_evict();
+	bpp_pool_unlock();
+}
+
+void
+bpp_pool_forget(
+	const void *owner
+) {
+	ion_bpp_pool_entry_t	*entry;
+	ion_bpp_pool_entry_t	*chain;
+	unsigned long			i;
+
+	bpp_pool_lock();
+
+	for (i = 0; i < bpp_pool.bucket_count; i++) {
+		for (entry = bpp_pool.buckets[i]; NULL != entry; entry = chain) {
+			chain = entry->chain;
+
+			if (entry->owner == owner) {
+				bpp_pool_remove(entry);
+			}
+		}
+	}
+
+	bpp_pool_unlock();
+}
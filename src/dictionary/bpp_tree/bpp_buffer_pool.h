@@ -0,0 +1,183 @@
+/******************************************************************************/
+/**
+@file		bpp_buffer_pool.h
+@author		IonDB Project Contributors
+@brief		A node cache shared by every open B+ tree.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+#if !defined(ION_BPP_BUFFER_POOL_H_)
+#define ION_BPP_BUFFER_POOL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../key_value/kv_system.h"
+
+/**
+@brief		The bytes of node images the pool may hold, shared by every open
+			B+ tree, until changed with @ref bpp_pool_set_budget.
+
+@details	Zero turns the pool off, leaving each tree with only its own
+			handful of working buffers.
+*/
+#if !defined(ION_BPP_POOL_BYTES)
+#if defined(ARDUINO)
+#define ION_BPP_POOL_BYTES 0
+#else
+#define ION_BPP_POOL_BYTES (16L * 1024 * 1024)
+#endif
+#endif
+
+/**
+@brief		The share of the budget, in percent, given to nodes read once.
+
+@details	The pool follows the 2Q policy. A node enters a FIFO queue of
+			this size when it is first read. Nodes pushed out of that queue
+			leave a ghost entry behind. Reading a node again while its
+			ghost is remembered moves it to the main LRU queue, which holds
+			the rest of the budget. A long scan only cycles through the
+			FIFO queue, so the nodes that are read over and over, such as
+			internal nodes, stay in the main queue.
+*/
+#if !defined(ION_BPP_POOL_IN_PERCENT)
+#define ION_BPP_POOL_IN_PERCENT 25
+#endif
+
+/**
+@brief		The counters of the shared pool.
+*/
+typedef struct {
+	/**> Node reads served from the pool. */
+	unsigned long	hits;
+	/**> Node reads that had to go to the file. */
+	unsigned long	misses;
+	/**> Misses on nodes whose ghost was remembered; they join the main
+		 queue. */
+	unsigned long	ghost_hits;
+	/**> Nodes dropped to stay within the budget. */
+	unsigned long	evictions;
+	/**> Bytes of node images held now. */
+	size_t			bytes;
+	/**> Bytes of node images held in the FIFO queue now. */
+	size_t			in_bytes;
+	/**> The current budget. */
+	size_t			budget;
+} ion_bpp_pool_stats_t;
+
+/**
+@brief		Changes the bytes of node images the pool may hold, dropping
+			nodes until it fits.
+@param		bytes
+				The new budget. Zero turns the pool off.
+*/
+void
+bpp_pool_set_budget(
+	size_t bytes
+);
+
+/**
+@brief		Copies the counters of the pool.
+@param		stats
+				Where to copy them.
+*/
+void
+bpp_pool_get_stats(
+	ion_bpp_pool_stats_t *stats
+);
+
+/**
+@brief		Zeroes the hit, miss and eviction counters of the pool.
+*/
+void
+bpp_pool_reset_stats(
+	void
+);
+
+/**
+@brief		Copies a node out of the pool, if the pool holds it.
+@param		owner
+				The tree the node belongs to.
+@param		adr
+				The address of the node in the tree.
+@param		size
+				The size of the node in bytes.
+@param		node
+				Where to copy the node.
+@returns	@c boolean_true on a hit.
+*/
+ion_boolean_t
+bpp_pool_read(
+	const void	*owner,
+	long		adr,
+	int			size,
+	void		*node
+);
+
+/**
+@brief		Puts a node just read from, or written to, a tree's file into
+			the pool.
+@param		owner
+				The tree the node belongs to.
+@param		adr
+				The address of the node in the tree.
+@param		size
+				The size of the node in bytes.
+@param		node
+				The node to copy into the pool.
+*/
+void
+bpp_pool_write(
+	const void	*owner,
+	long		adr,
+	int			size,
+	const void	*node
+);
+
+/**
+@brief		Drops every node of a tree from the pool, such as when the tree
+			is closed.
+@param		owner
+				The tree whose nodes to drop.
+*/
+void
+bpp_pool_forget(
+	const void *owner
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_BPP_BUFFER_POOL_H_ */
@@ -34,6 +34,8 @@
 /******************************************************************************/
 
 #include "bpp_tree.h"
+#include "bpp_buffer_pool.h"
+#include "../../file/ion_readahead.h"
 
 /*************
  * internals *
@@ -57,7 +59,10 @@
  *
  *	A LRR (least-recently-read) buffering scheme for nodes is used to
  *	simplify storage management, and, assuming some locality of reference,
- *	improve performance.
+ *	improve performance.  These few buffers are the working set of one
+ *	operation; behind them, nodes are cached by a pool shared by all open
+ *	trees (see bpp_buffer_pool.h), whose 2Q policy keeps frequently read
+ *	nodes resident through long scans.
  *
  *	To simplify matters, both internal nodes and leafs contain the
  *	same fields.
@@ -70,11 +75,12 @@
 #define bAdr(p)		*(ion_bpp_address_t *) (p)
 #define eAdr(p)		*(ion_bpp_external_address_t *) (p)
 
-/* based on k = &[key,rec,childGE] */
+/* based on k = &[key,value,rec,childGE] */
 #define childLT(k)	bAdr((char *) k - sizeof(ion_bpp_address_t))
 #define key(k)		(k)
-#define rec(k)		eAdr((char *) (k) + h->keySize)
-#define childGE(k)	bAdr((char *) (k) + h->keySize + sizeof(ion_bpp_external_address_t))
+#define val(k)		((char *) (k) + h->keySize)
+#define rec(k)		eAdr((char *) (k) + h->keySize + h->valueSize)
+#define childGE(k)	bAdr((char *) (k) + h->keySize + h->valueSize + sizeof(ion_bpp_external_address_t))
 
 /* based on b = &ion_bpp_buffer_t */
 #define leaf(b)		b->p->leaf
@@ -87,6 +93,7 @@
 
 /* shortcuts */
 #define ks(ct)		((ct) * h->ks)
+#define sign(cc)	(((cc) > 0) - ((cc) < 0))	/* compare routines may return any magnitude */
 
 typedef char ion_bpp_key_t;	/* keys entries are treated as char arrays */
 
@@ -103,7 +110,7 @@ typedef struct {
 	ion_bpp_address_t	prev;			/* prev node in sequence (leaf) */
 	ion_bpp_address_t	next;			/* next node in sequence (leaf) */
 	ion_bpp_address_t	childLT;		/* child LT first key */
-	/* ct occurrences of [key,rec,childGE] */
+	/* ct occurrences of [key,value,rec,childGE] */
 	ion_bpp_key_t		fkey;			/* first occurrence */
 } ion_bpp_node_t;
 
@@ -117,12 +124,51 @@ typedef struct ion_bpp_buffer_tag {
 	ion_bpp_bool_t				modified;	/* true if buffer modified */
 } ion_bpp_buffer_t;
 
+/* first bytes of an index file, in a sector of their own */
+typedef struct {
+	uint32_t	magic;		/* ION_BPP_MAGIC */
+	uint32_t	sectorSize;	/* size of sector on disk */
+	uint32_t	keySize;	/* length, in bytes, of key */
+	uint32_t	prefixed;	/* true if nodes are packed on disk */
+	uint32_t	valueSize;	/* length, in bytes, of inline values */
+	uint32_t	closed;		/* true if the fields below are current */
+	int64_t		freeList;	/* first node of the free list, 0 if none */
+	int64_t		endAdr;		/* address past the last node */
+	int64_t		freeRec;	/* the caller's free record, see b_free_rec */
+} ion_bpp_file_header_t;
+
+/* a view of the tree as it was when pinned, see b_snapshot */
+typedef struct ion_bpp_snap_tag {
+	struct ion_bpp_snap_tag *next;		/* next snapshot of the same tree */
+	ion_bpp_address_t		endAdr;		/* nodes from here on are newer */
+	ion_bpp_address_t		*saved;		/* [node, copy] pairs, by node */
+	int						savedCt;	/* pairs in saved */
+	int						savedRoom;	/* pairs saved has room for */
+	ion_bpp_bool_t			lost;		/* true if a node couldn't be kept */
+	ion_bpp_node_t			*node;		/* node last read, room for the root */
+	int						cur;		/* current key in node */
+	ion_readahead_t			*ahead;		/* leaves queued ahead of a scan */
+	ion_bpp_bool_t			noAhead;	/* true if ahead couldn't be opened */
+} ion_bpp_snap_t;
+
+/* "IBP+"; a headerless file starts with the root's leaf and ct bits, */
+/* whose high bytes are always zero */
+#define ION_BPP_MAGIC 0x2B504249UL
+
 /* one node for each open handle */
 typedef struct ion_bpp_h_node_tag {
 	ion_file_handle_t		fp;		/* idx file */
 	int						keySize;/* key length */
+	int						valueSize;	/* length of the value stored after each key */
 	ion_bpp_bool_t			dupKeys;/* true if duplicate keys */
 	int						sectorSize;	/* block size for idx records */
+	int						nodeSize;	/* bytes in a node, a whole number of sectors */
+	ion_bpp_address_t		base;		/* file offset of node address 0, past the header */
+	ion_bpp_bool_t			prefixed;	/* true if nodes are packed on disk */
+	char					*image;		/* packed node image, room for the root */
+	ion_bpp_key_t			*sep;		/* separator entry staged by a bulk load */
+	ion_bpp_key_t			*lastKey;	/* last key of the previous bulk loaded leaf */
+	ion_bpp_key_t			*trial;		/* candidate when shortening a separator */
 	ion_bpp_comparison_t	comp;			/* pointer to compare routine */
 	ion_bpp_buffer_t		root;			/* root of b-tree, room for 3 sets */
 	ion_bpp_buffer_t		bufList;		/* head of buf list */
@@ -134,8 +180,36 @@ typedef struct ion_bpp_h_node_tag {
 	unsigned int			maxCt;	/* minimum # keys in node */
 	int						ks;	/* sizeof key entry */
 	ion_bpp_address_t		nextFreeAdr;/* next free b-tree record address */
+	ion_bpp_address_t		freeList;	/* first released node, 0 if none */
+	ion_bpp_external_address_t	freeRec;/* kept for the caller, see b_free_rec */
+	ion_bpp_snap_t			*snapshots;	/* pinned snapshots, newest first */
+	ion_bpp_node_t			*copy;		/* node being kept for snapshots */
 } ion_bpp_h_node_t;
 
+/* most levels a bulk load can build, ample given a fanout of at least 4 */
+#define ION_BPP_BULK_MAX_HEIGHT 16
+
+/* one level of a bulk load */
+typedef struct {
+	ion_bpp_key_t		*items;		/* staged [key,rec,childGE] entries */
+	int					count;		/* number of staged entries */
+	int					target;		/* entries per node at the fill factor */
+	int					minCt;		/* fewest entries a node may be left with */
+	ion_bpp_bool_t		written;	/* true once a node has been written */
+	ion_bpp_address_t	adr;		/* address reserved for the first staged node */
+	ion_bpp_address_t	prev;		/* address of the last node written */
+} ion_bpp_bulk_level_t;
+
+ION_BPP_THREAD_LOCAL int maxHeight;
+ION_BPP_THREAD_LOCAL int nNodesIns;
+ION_BPP_THREAD_LOCAL int nNodesDel;
+ION_BPP_THREAD_LOCAL int nKeysIns;
+ION_BPP_THREAD_LOCAL int nKeysDel;
+ION_BPP_THREAD_LOCAL int nDiskReads;
+ION_BPP_THREAD_LOCAL int nDiskWrites;
+ION_BPP_THREAD_LOCAL int nSectorReads;
+ION_BPP_THREAD_LOCAL int bErrLineNo;
+
 #define error(rc) lineError(__LINE__, rc)
 
 static ion_bpp_err_t
@@ -152,18 +226,357 @@ lineError(
 	return rc;
 }
 
+static int
+findSaved(
+	ion_bpp_snap_t		*s,
+	ion_bpp_address_t	adr
+) {
+	int lb;		/* lower-bound of binary search */
+	int ub;		/* upper-bound of binary search */
+	int m;		/* midpoint of search */
+
+	/* returns the first pair for adr or a later node */
+	lb	= 0;
+	ub	= s->savedCt;
+
+	while (lb < ub) {
+		m = (lb + ub) / 2;
+
+		if (s->saved[2 * m] < adr) {
+			lb = m + 1;
+		}
+		else {
+			ub = m;
+		}
+	}
+
+	return lb;
+}
+
+static ion_bpp_bool_t
+isSaved(
+	ion_bpp_snap_t		*s,
+	ion_bpp_address_t	adr
+) {
+	int i = findSaved(s, adr);
+
+	return (i < s->savedCt) && (s->saved[2 * i] == adr);
+}
+
+static void
+addSaved(
+	ion_bpp_snap_t		*s,
+	ion_bpp_address_t	adr,
+	ion_bpp_address_t	copy
+) {
+	ion_bpp_address_t	*grown;
+	int					room;
+	int					i;
+
+	if (s->savedCt == s->savedRoom) {
+		room	= s->savedRoom ? 2 * s->savedRoom : 16;
+		grown	= realloc(s->saved, 2 * room * sizeof(ion_bpp_address_t));
+
+		if (NULL == grown) {
+			/* the snapshot can no longer tell which nodes it may read */
+			s->lost = boolean_true;
+			return;
+		}
+
+		s->saved		= grown;
+		s->savedRoom	= room;
+	}
+
+	i = findSaved(s, adr);
+	memmove(s->saved + 2 * (i + 1), s->saved + 2 * i, 2 * (s->savedCt - i) * sizeof(ion_bpp_address_t));
+	s->saved[2 * i]		= adr;
+	s->saved[2 * i + 1] = copy;
+	s->savedCt++;
+}
+
 static ion_bpp_address_t
 allocAdr(
 	ion_bpp_handle_t handle
 ) {
 	ion_bpp_h_node_t	*h = handle;
 	ion_bpp_address_t	adr;
+	ion_bpp_address_t	next;
+	ion_bpp_snap_t		*s;
+
+	/* reuse released nodes first; each links to the next in its first bytes */
+	if (h->freeList) {
+		adr = h->freeList;
+
+		if ((err_ok != ion_fread_at(h->fp, h->base + adr, sizeof(ion_bpp_address_t), (ion_byte_t *) &next)) || (next < 0) || (next % h->nodeSize) || ((next > 0) && (next < 3 * h->nodeSize)) || (next >= h->nextFreeAdr)) {
+			/* drop a damaged list rather than hand out a node in use */
+			next = 0;
+		}
+
+		h->freeList = next;
+
+		/* a released node is not part of any snapshot, so mark it */
+		/* as having nothing to keep */
+		for (s = h->snapshots; s; s = s->next) {
+			if (!isSaved(s, adr)) {
+				addSaved(s, adr, 0);
+			}
+		}
+
+		return adr;
+	}
 
 	adr				= h->nextFreeAdr;
-	h->nextFreeAdr	+= h->sectorSize;
+	h->nextFreeAdr	+= h->nodeSize;
 	return adr;
 }
 
+static void
+dropAhead(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr,
+	int					len
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_snap_t		*s;
+
+	/* leaves read ahead for a scan are stale once their place is written */
+	for (s = h->snapshots; s; s = s->next) {
+		ion_readahead_drop(s->ahead, h->base + adr, len);
+	}
+}
+
+static ion_bpp_err_t
+releaseAdr(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	/* link the node onto the free list, straight on disk */
+	dropAhead(handle, adr, sizeof(ion_bpp_address_t));
+
+	if (err_ok != ion_fwrite_at(h->fp, h->base + adr, sizeof(ion_bpp_address_t), (ion_byte_t *) &h->freeList)) {
+		return error(bErrIO);
+	}
+
+	h->freeList = adr;
+	return bErrOk;
+}
+
+static void
+preserve(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr
+);
+
+static ion_bpp_err_t
+freeAdr(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf
+) {
+	ion_bpp_err_t rc;	/* return code */
+
+	/*
+	 * input:
+	 *   buf					buffer of a node no longer in the tree
+	 * notes:
+	 *   The link is written straight to disk, and the buffer dropped
+	 *   so it can't be flushed over the link.
+	*/
+	preserve(handle, buf->adr);
+
+	if ((rc = releaseAdr(handle, buf->adr)) != 0) {
+		return rc;
+	}
+
+	buf->valid		= boolean_false;
+	buf->modified	= boolean_false;
+	return bErrOk;
+}
+
+static int
+packNode(
+	ion_bpp_handle_t	handle,
+	ion_bpp_node_t		*node,
+	char				*image
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_key_t		*fk;	/* first key */
+	ion_bpp_key_t		*k;
+	char				*out;
+	uint32_t			len;	/* bytes packed */
+	int					plen;	/* length of common prefix */
+	int					klen;	/* length of key less trailing zeros */
+	int					i;
+	int					j;
+
+	/*
+	 * input:
+	 *   node				   node to pack
+	 * output:
+	 *   image				  packed node, padded to a whole sector
+	 * returns:
+	 *   length of image
+	 * notes:
+	 *   The image is the node header, the packed length, the common
+	 *   prefix as [length,bytes], then per key [length,suffix] with the
+	 *   trailing zero bytes dropped, followed by the record address in
+	 *   leaves and the GE child in internal nodes. Internal nodes only
+	 *   need record addresses to order duplicate keys.
+	*/
+	fk		= &node->fkey;
+	plen	= node->ct ? h->keySize : 0;
+
+	for (i = 1; i < node->ct && plen; i++) {
+		k = fk + ks(i);
+
+		for (j = 0; j < plen && fk[j] == k[j]; j++) {}
+
+		plen = j;
+	}
+
+	memcpy(image, node, fk - (char *) node);
+	out		= image + (fk - (char *) node) + sizeof(uint32_t);
+	*out++	= (char) plen;
+	memcpy(out, fk, plen);
+	out		+= plen;
+
+	for (i = 0; i < node->ct; i++) {
+		k = fk + ks(i);
+
+		for (klen = h->keySize; klen > plen && 0 == k[klen - 1]; klen--) {}
+
+		*out++	= (char) (klen - plen);
+		memcpy(out, k + plen, klen - plen);
+		out		+= klen - plen;
+
+		if (node->leaf || h->dupKeys) {
+			memcpy(out, &rec(k), sizeof(ion_bpp_external_address_t));
+			out += sizeof(ion_bpp_external_address_t);
+		}
+
+		if (!node->leaf) {
+			memcpy(out, &childGE(k), sizeof(ion_bpp_address_t));
+			out += sizeof(ion_bpp_address_t);
+		}
+	}
+
+	len = out - image;
+	memcpy(image + (fk - (char *) node), &len, sizeof(uint32_t));
+
+	/* pad to a whole sector */
+	while ((out - image) % h->sectorSize) {
+		*out++ = 0;
+	}
+
+	return out - image;
+}
+
+static ion_bpp_err_t
+unpackNode(
+	ion_bpp_handle_t	handle,
+	char				*image,
+	int					room,
+	ion_bpp_node_t		*node
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_key_t		*k;
+	char				*prefix;
+	char				*in;
+	uint32_t			len;	/* bytes packed */
+	int					plen;	/* length of common prefix */
+	int					slen;	/* length of key suffix */
+	int					i;
+
+	/*
+	 * input:
+	 *   image				  packed node read from disk
+	 *   room				   bytes available for the node
+	 * output:
+	 *   node				   unpacked node
+	*/
+	k		= &node->fkey;
+	in		= image + (k - (char *) node);
+	memcpy(node, image, k - (char *) node);
+	memcpy(&len, in, sizeof(uint32_t));
+	in		+= sizeof(uint32_t);
+	plen	= (unsigned char) *in++;
+	prefix	= in;
+	in		+= plen;
+
+	if ((plen > h->keySize) || ((char *) node + room < k + ks(node->ct))) {
+		return error(bErrIO);
+	}
+
+	for (i = 0; i < node->ct; i++, k += ks(1)) {
+		slen = (unsigned char) *in++;
+
+		if (plen + slen > h->keySize) {
+			return error(bErrIO);
+		}
+
+		memcpy(k, prefix, plen);
+		memcpy(k + plen, in, slen);
+		memset(k + plen + slen, 0, h->keySize - plen - slen);
+		in			+= slen;
+		rec(k)		= 0;
+		childGE(k)	= 0;
+
+		if (node->leaf || h->dupKeys) {
+			memcpy(&rec(k), in, sizeof(ion_bpp_external_address_t));
+			in += sizeof(ion_bpp_external_address_t);
+		}
+
+		if (!node->leaf) {
+			memcpy(&childGE(k), in, sizeof(ion_bpp_address_t));
+			in += sizeof(ion_bpp_address_t);
+		}
+	}
+
+	if (in - image != (long) len) {
+		return error(bErrIO);
+	}
+
+	return bErrOk;
+}
+
+static void
+shortenSep(
+	ion_bpp_handle_t	handle,
+	ion_bpp_key_t		*sep,
+	ion_bpp_key_t		*prev
+) {
+	ion_bpp_h_node_t	*h = handle;
+	int					len;
+
+	/*
+	 * input:
+	 *   sep					separator, the first key of a node
+	 *   prev				   last key of the node before it
+	 * output:
+	 *   sep					fewest leading bytes of sep, zero filled,
+	 *						  that still sort after prev
+	 * notes:
+	 *   Each candidate is checked with the compare routine, so keys
+	 *   that don't sort bytewise are left whole.
+	*/
+	if (!h->prefixed || h->dupKeys) {
+		return;
+	}
+
+	for (len = 0; len < h->keySize && sep[len] == prev[len]; len++) {}
+
+	for (len++; len < h->keySize; len++) {
+		memcpy(h->trial, sep, len);
+		memset(h->trial + len, 0, h->keySize - len);
+
+		if ((h->comp(prev, h->trial, (ion_key_size_t) (h->keySize)) < 0) && (h->comp(h->trial, sep, (ion_key_size_t) (h->keySize)) <= 0)) {
+			memcpy(sep, h->trial, h->keySize);
+			return;
+		}
+	}
+}
+
 static ion_bpp_err_t
 flush(
 	ion_bpp_handle_t	handle,
@@ -171,21 +584,37 @@ flush(
 ) {
 	ion_bpp_h_node_t	*h = handle;
 	int					len;/* number of bytes to write */
+	char				*image;		/* bytes to write */
 	ion_err_t			err;
 
+	/* snapshots keep the node as it was before it is overwritten */
+	preserve(handle, buf->adr);
+
 	/* flush buffer to disk */
-	len = h->sectorSize;
+	len		= h->nodeSize;
+	image	= p(buf);
 
 	if (buf->adr == 0) {
 		len *= 3;	/* root */
 	}
 
-	err = ion_fwrite_at(h->fp, buf->adr, len, (ion_byte_t *) buf->p);
+	if (h->prefixed) {
+		len		= packNode(handle, buf->p, h->image);
+		image	= h->image;
+	}
+
+	dropAhead(handle, buf->adr, len);
+	err = ion_fwrite_at(h->fp, h->base + buf->adr, len, (ion_byte_t *) image);
 
 	if (err_ok != err) {
 		return error(bErrIO);
 	}
 
+	/* the root is always resident; other nodes are written through */
+	if (buf->adr != 0) {
+		bpp_pool_write(h, buf->adr, h->nodeSize, buf->p);
+	}
+
 #if 0
 	/* flush buffer to disk */
 	len = 1;
@@ -325,6 +754,136 @@ writeDisk(
 	return bErrOk;
 }
 
+static ion_bpp_err_t
+readPacked(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr,
+	int					room,
+	ion_bpp_node_t		*node
+) {
+	ion_bpp_h_node_t	*h = handle;
+	uint32_t			len;	/* bytes packed */
+	int					more;	/* bytes left to read */
+	char				*image;	/* packed node */
+
+	/* a mapped index is unpacked in place */
+	image = (char *) ion_fmap_at(h->fp, h->base + adr, h->sectorSize);
+
+	if (NULL == image) {
+		image = h->image;
+
+		if (err_ok != ion_fread_at(h->fp, h->base + adr, h->sectorSize, (ion_byte_t *) image)) {
+			return error(bErrIO);
+		}
+	}
+
+	memcpy(&len, image + (&node->fkey - (char *) node), sizeof(uint32_t));
+	nSectorReads++;
+
+	if (len > (uint32_t) room) {
+		return error(bErrIO);
+	}
+
+	more = ((len + h->sectorSize - 1) / h->sectorSize - 1) * h->sectorSize;
+
+	if (more > 0) {
+		if (image != h->image) {
+			image = (char *) ion_fmap_at(h->fp, h->base + adr, h->sectorSize + more);
+
+			if (NULL == image) {
+				return error(bErrIO);
+			}
+		}
+		else if (err_ok != ion_fread_at(h->fp, h->base + adr + h->sectorSize, more, (ion_byte_t *) image + h->sectorSize)) {
+			return error(bErrIO);
+		}
+
+		nSectorReads += more / h->sectorSize;
+	}
+
+	return unpackNode(handle, image, room, node);
+}
+
+static ion_bpp_err_t
+readImage(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr,
+	int					len,
+	ion_bpp_node_t		*node
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	/* read a node from its place on disk, bypassing the buffers */
+	if (h->prefixed) {
+		/* the first sector holds the packed length */
+		return readPacked(handle, adr, len, node);
+	}
+
+	if (err_ok != ion_fread_at(h->fp, h->base + adr, len, (ion_byte_t *) node)) {
+		return error(bErrIO);
+	}
+
+	nSectorReads += len / h->sectorSize;
+	return bErrOk;
+}
+
+static void
+preserve(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_snap_t		*s;
+	ion_bpp_address_t	copy;
+	ion_bpp_bool_t		read;	/* true once the node is in h->copy */
+	int					len;
+
+	/*
+	 * input:
+	 *   adr					node about to be overwritten or released
+	 * notes:
+	 *   Each snapshot still reading the node from its place is given
+	 *   a copy, unpacked, in a node of its own. Until then the node on
+	 *   disk is as it was when the snapshot was pinned, as pinning
+	 *   flushes every buffer. A snapshot that can't be given its copy
+	 *   is marked lost rather than failing the write.
+	*/
+	read	= boolean_false;
+	len		= adr == 0 ? 3 * h->nodeSize : h->nodeSize;
+
+	for (s = h->snapshots; s; s = s->next) {
+		if ((adr >= s->endAdr) || s->lost || isSaved(s, adr)) {
+			continue;
+		}
+
+		if (!read) {
+			if (((adr == 0) || !bpp_pool_read(h, adr, h->nodeSize, h->copy)) && (bErrOk != readImage(handle, adr, len, h->copy))) {
+				s->lost = boolean_true;
+				continue;
+			}
+
+			read = boolean_true;
+		}
+
+		/* the root is copied to three nodes past the end */
+		if (adr == 0) {
+			copy			= h->nextFreeAdr;
+			h->nextFreeAdr	+= len;
+		}
+		else {
+			copy = allocAdr(handle);
+		}
+
+		dropAhead(handle, copy, len);
+
+		if (err_ok != ion_fwrite_at(h->fp, h->base + copy, len, (ion_byte_t *) h->copy)) {
+			s->lost = boolean_true;
+		}
+
+		addSaved(s, adr, copy);
+	}
+}
+
 static ion_bpp_err_t
 readDisk(
 	ion_bpp_handle_t	handle,
@@ -341,17 +900,23 @@ readDisk(
 		return rc;
 	}
 
-	if (!buf->valid) {
-		len = h->sectorSize;
+	if (!buf->valid && (adr != 0) && bpp_pool_read(h, adr, h->nodeSize, buf->p)) {
+		buf->modified	= boolean_false;
+		buf->valid		= boolean_true;
+	}
+	else if (!buf->valid) {
+		len = h->nodeSize;
 
 		if (adr == 0) {
 			len *= 3;	/* root */
 		}
 
-		ion_err_t err = ion_fread_at(h->fp, adr, len, (ion_byte_t *) buf->p);
+		if ((rc = readImage(handle, adr, len, buf->p)) != 0) {
+			return rc;
+		}
 
-		if (err_ok != err) {
-			return error(bErrIO);
+		if (adr != 0) {
+			bpp_pool_write(h, adr, h->nodeSize, buf->p);
 		}
 
 		buf->modified	= boolean_false;
@@ -492,7 +1057,7 @@ search(
 				}
 			}
 			else {
-				return cc;
+				return sign(cc);
 			}
 		}
 	}
@@ -518,7 +1083,7 @@ search(
 			cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
 		}
 
-		return cc;
+		return sign(cc);
 	}
 
 	if (MODE_FGEQ == mode) {
@@ -530,11 +1095,11 @@ search(
 			cc		= h->comp(key, key(*mkey), (ion_key_size_t) (h->keySize));
 		}
 
-		return cc;
+		return sign(cc);
 	}
 
 	/* didn't find key */
-	return cc;
+	return sign(cc);
 }
 
 static ion_bpp_err_t
@@ -654,6 +1219,11 @@ scatter(
 			}
 
 			next(tmp[iu - 1]) = next(tmp[iu]);
+
+			if ((rc = freeAdr(handle, tmp[iu])) != 0) {
+				return rc;
+			}
+
 			nNodesDel++;
 		}
 		else {
@@ -735,6 +1305,7 @@ scatter(
 			}
 			else {
 				memcpy(pkey, gkey, ks(1));
+				shortenSep(handle, key(pkey), key(gkey - ks(1)));
 				childGE(pkey)	= tmp[i]->adr;
 				pkey			+= ks(1);
 			}
@@ -794,7 +1365,7 @@ gatherRoot(
 	/* gather root to gbuf */
 	root		= &h->root;
 	gbuf		= &h->gbuf;
-	memcpy(p(gbuf), root->p, 3 * h->sectorSize);
+	memcpy(p(gbuf), root->p, 3 * h->nodeSize);
 	leaf(gbuf)	= leaf(root);
 	ct(root)	= 0;
 	return bErrOk;
@@ -883,46 +1454,329 @@ gather(
 	return bErrOk;
 }
 
-ion_bpp_err_t
-b_open(
-	ion_bpp_open_t		info,
-	ion_bpp_handle_t	*handle
+static void
+bulkFill(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf,
+	ion_bpp_bool_t		isLeaf,
+	ion_bpp_key_t		*items,
+	int					n
 ) {
-	ion_bpp_h_node_t	*h;
-	ion_bpp_err_t		rc;			/* return code */
-	int					bufCt;	/* number of tmp buffers */
-	ion_bpp_buffer_t	*buf;				/* buffer */
-	int					maxCt;	/* maximum number of keys in a node */
-	ion_bpp_buffer_t	*root;
-	int					i;
-	ion_bpp_node_t		*p;
+	ion_bpp_h_node_t *h = handle;
 
-	if ((info.sectorSize < sizeof(ion_bpp_h_node_t)) || (0 != info.sectorSize % 4)) {
+	/* lay out n staged entries as a node */
+	leaf(buf) = isLeaf;
+
+	if (isLeaf) {
+		ct(buf) = n;
+
+		if (n) {
+			memcpy(fkey(buf), items, ks(n));
+		}
+	}
+	else {
+		/* first entry only supplies the LT pointer */
+		ct(buf)				= n - 1;
+		childLT(fkey(buf))	= childGE(items);
+		memcpy(fkey(buf), items + ks(1), ks(n - 1));
+	}
+}
+
+static ion_bpp_err_t
+bulkPush(
+	ion_bpp_handle_t		handle,
+	ion_bpp_bulk_level_t	*levels,
+	int						level,
+	ion_bpp_key_t			*item,
+	ion_bpp_address_t		child
+);
+
+static ion_bpp_err_t
+bulkWrite(
+	ion_bpp_handle_t		handle,
+	ion_bpp_bulk_level_t	*levels,
+	int						level,
+	int						n,
+	ion_bpp_bool_t			last
+) {
+	ion_bpp_h_node_t		*h = handle;
+	ion_bpp_bulk_level_t	*lv;
+	ion_bpp_buffer_t		*buf;
+	ion_bpp_address_t		adr;
+	ion_bpp_address_t		nextAdr;
+	ion_bpp_key_t			*sep;	/* separator for the parent */
+	ion_bpp_err_t			rc;	/* return code */
+
+	/*
+	 * input:
+	 *   levels				 bulk load levels
+	 *   level				  level to write from
+	 *   n					  number of staged entries to write
+	 *   last				   true if no node follows this one
+	 * notes:
+	 *   Writes the first n staged entries as one node, then adds
+	 *   the node to its parent level. The gather buffer is free
+	 *   during a bulk load, so it holds the node image.
+	*/
+	lv	= &levels[level];
+	buf = &h->gbuf;
+
+	if (0 == lv->adr) {
+		lv->adr = allocAdr(handle);
+	}
+
+	adr		= lv->adr;
+	nextAdr = last ? 0 : allocAdr(handle);
+	memset(buf->p, 0, h->nodeSize);
+	bulkFill(handle, buf, 0 == level, lv->items, n);
+
+	if (0 == level) {
+		prev(buf)	= lv->prev;
+		next(buf)	= nextAdr;
+	}
+
+	buf->adr = adr;
+
+	if ((rc = flush(handle, buf)) != 0) {
+		return rc;
+	}
+
+	nNodesIns++;
+
+	/* first entry becomes the separator in the parent */
+	sep = lv->items;
+
+	if (h->prefixed && (0 == level)) {
+		if (lv->written) {
+			sep = h->sep;
+			memcpy(sep, lv->items, ks(1));
+			shortenSep(handle, key(sep), h->lastKey);
+		}
+
+		memcpy(h->lastKey, key(lv->items + ks(n - 1)), h->keySize);
+	}
+
+	lv->written = boolean_true;
+	lv->prev	= adr;
+	lv->adr		= nextAdr;
+
+	if ((rc = bulkPush(handle, levels, level + 1, sep, adr)) != 0) {
+		return rc;
+	}
+
+	lv->count -= n;
+	memmove(lv->items, lv->items + ks(n), ks(lv->count));
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+bulkPush(
+	ion_bpp_handle_t		handle,
+	ion_bpp_bulk_level_t	*levels,
+	int						level,
+	ion_bpp_key_t			*item,
+	ion_bpp_address_t		child
+) {
+	ion_bpp_h_node_t		*h = handle;
+	ion_bpp_bulk_level_t	*lv;
+	ion_bpp_key_t			*slot;
+	ion_bpp_err_t			rc;	/* return code */
+
+	if (ION_BPP_BULK_MAX_HEIGHT == level) {
+		return error(bErrMemory);
+	}
+
+	lv = &levels[level];
+
+	if ((NULL == lv->items) && ((lv->items = malloc(ks(3 * lv->target))) == NULL)) {
+		return error(bErrMemory);
+	}
+
+	/* keep two full nodes staged, so the last nodes */
+	/* of the level can still be rebalanced at the end */
+	if (lv->count == 3 * lv->target) {
+		if ((rc = bulkWrite(handle, levels, level, lv->target, boolean_false)) != 0) {
+			return rc;
+		}
+	}
+
+	slot			= lv->items + ks(lv->count);
+	memcpy(slot, item, ks(1));
+	childGE(slot)	= child;
+	lv->count++;
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+writeHeader(
+	ion_bpp_handle_t	handle,
+	ion_bpp_bool_t		closed
+) {
+	ion_bpp_h_node_t		*h = handle;
+	ion_bpp_file_header_t	header;
+
+	/*
+	 * input:
+	 *   closed				 true once the tree is flushed for closing
+	 * notes:
+	 *   The free lists and end of the tree are only recorded on close.
+	 *   An open file is marked as such, so after a crash they start out
+	 *   empty: released nodes are leaked rather than handed out twice.
+	*/
+	memset(&header, 0, sizeof(header));
+	header.magic		= ION_BPP_MAGIC;
+	header.sectorSize	= h->sectorSize;
+	header.keySize		= h->keySize;
+	header.prefixed		= h->prefixed;
+	header.valueSize	= h->valueSize;
+	header.closed		= closed;
+
+	if (closed) {
+		header.freeList = h->freeList;
+		header.endAdr	= h->nextFreeAdr;
+		header.freeRec	= h->freeRec;
+	}
+
+	if (err_ok != ion_fwrite_at(h->fp, 0, sizeof(header), (ion_byte_t *) &header)) {
+		return error(bErrIO);
+	}
+
+	return bErrOk;
+}
+
+static ion_bpp_bool_t
+readHeader(
+	char					*name,
+	ion_bpp_file_header_t	*header
+) {
+	/* read the header of an existing index file, if it has one */
+	ion_file_handle_t	fp;
+	ion_err_t			err;
+
+	fp = ion_fopen(name);
+
+#if defined(ARDUINO)
+
+	if (NULL == fp.file) {
+#else
+
+	if (NULL == fp) {
+#endif
+		return boolean_false;
+	}
+
+	err = ion_fread_at(fp, 0, sizeof(ion_bpp_file_header_t), (ion_byte_t *) header);
+	ion_fclose(fp);
+
+	return (err_ok == err) && (ION_BPP_MAGIC == header->magic);
+}
+
+ion_bpp_err_t
+b_open(
+	ion_bpp_open_t		info,
+	ion_bpp_handle_t	*handle
+) {
+	ion_bpp_h_node_t	*h;
+	ion_bpp_err_t		rc;			/* return code */
+	int					bufCt;	/* number of tmp buffers */
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	int					maxCt;	/* maximum number of keys in a node */
+	int					nodeSize;	/* bytes in a node */
+	int					packCt;		/* most keys that pack into a node */
+	int					extra;		/* bytes needed by a prefixed tree */
+	ion_bpp_buffer_t	*root;
+	int					i;
+	ion_bpp_node_t		*p;
+	ion_bpp_file_header_t	header;	/* settings the file was created with */
+	ion_bpp_bool_t		headed;		/* true unless the file predates headers */
+	size_t				align;		/* alignment of node buffers */
+
+	headed = boolean_true;
+
+	if (ion_fexists(info.iName)) {
+		headed = readHeader(info.iName, &header);
+
+		if (headed) {
+			if (header.keySize != (uint32_t) info.keySize) {
+				return bErrIO;
+			}
+
+			/* headers written before values were inlined read 0 here */
+			if ((0 != header.valueSize) && (header.valueSize != (uint32_t) info.valueSize)) {
+				return bErrIO;
+			}
+
+			info.sectorSize = header.sectorSize;
+			info.prefixed	= (ion_bpp_bool_t) header.prefixed;
+			info.valueSize	= header.valueSize;
+		}
+		else {
+			info.valueSize = 0;
+		}
+	}
+
+	/* packed nodes have no room for values */
+	if (info.prefixed || (info.valueSize < 0)) {
+		info.valueSize = 0;
+	}
+
+	/* the header takes a sector of its own */
+	if ((info.sectorSize < sizeof(ion_bpp_file_header_t)) || (info.sectorSize > ION_BPP_MAX_SECTOR_SIZE) || (0 != info.sectorSize % 4)) {
+		return bErrSectorSize;
+	}
+
+	if (info.prefixed && (info.keySize > 255)) {
 		return bErrSectorSize;
 	}
 
 	/* determine sizes and offsets */
-	/* leaf/n, prev, next, [childLT,key,rec]... childGE */
+	/* leaf/n, prev, next, [childLT,key,value,rec]... childGE */
 	/* ensure that there are at least 3 children/parent for gather/scatter */
-	maxCt	= info.sectorSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t));
-	maxCt	/= sizeof(ion_bpp_address_t) + info.keySize + sizeof(ion_bpp_external_address_t);
+	nodeSize	= info.prefixed ? ION_BPP_PREFIX_NODE_SECTORS * info.sectorSize : info.sectorSize;
+	maxCt		= nodeSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t));
+	maxCt		/= sizeof(ion_bpp_address_t) + info.keySize + info.valueSize + sizeof(ion_bpp_external_address_t);
+	extra		= 0;
+
+	if (info.prefixed) {
+		/* a node must pack even if its keys share nothing: header, */
+		/* length, prefix, then [length,key,rec or childGE] per key */
+		packCt	= nodeSize - (sizeof(ion_bpp_node_t) - sizeof(ion_bpp_key_t)) - sizeof(uint32_t) - 1 - info.keySize;
+		packCt	/= 1 + info.keySize + (info.dupKeys ? sizeof(ion_bpp_external_address_t) + sizeof(ion_bpp_address_t) : sizeof(ion_bpp_address_t));
+
+		if (packCt < maxCt) {
+			maxCt = packCt;
+		}
+
+		/* packed image of the root, a trial separator, a separator */
+		/* entry and the last key of a leaf for bulk loads */
+		extra = 3 * nodeSize + 2 * info.keySize + sizeof(ion_bpp_address_t) + info.keySize + sizeof(ion_bpp_external_address_t);
+	}
 
 	if (maxCt < 6) {
 		return bErrSectorSize;
 	}
 
+	/* a full root holds 3 * maxCt keys in a 15 bit count */
+	if (maxCt > 0x7FFF / 3) {
+		maxCt = 0x7FFF / 3;
+	}
+
 	/* copy parms to ion_bpp_h_node_t */
 	if ((h = calloc(1, sizeof(ion_bpp_h_node_t))) == NULL) {
 		return error(bErrMemory);
 	}
 
 	h->keySize		= info.keySize;
+	h->valueSize	= info.valueSize;
 	h->dupKeys		= info.dupKeys;
 	h->sectorSize	= info.sectorSize;
+	h->nodeSize		= nodeSize;
+	h->base			= headed ? h->sectorSize : 0;
+	h->prefixed		= info.prefixed;
 	h->comp			= info.comp;
 
-	/* childLT, key, rec */
-	h->ks			= sizeof(ion_bpp_address_t) + h->keySize + sizeof(ion_bpp_external_address_t);
+	/* childLT, key, value, rec */
+	h->ks			= sizeof(ion_bpp_address_t) + h->keySize + h->valueSize + sizeof(ion_bpp_external_address_t);
 	h->maxCt		= maxCt;
 
 	/* Allocate buflist.
@@ -943,20 +1797,25 @@ b_open(
 	/*
 	 * Allocate bufs.
 	 * We need space for the following:
-	 *  - bufCt buffers, of size sectorSize
-	 *  - 1 buffer for root, of size 3*sectorSize
-	 *  - 1 buffer for gbuf, size 3*sectorsize + 2 extra keys
+	 *  - bufCt buffers, of size nodeSize
+	 *  - 1 buffer for root, of size 3*nodeSize
+	 *  - 1 buffer for gbuf, size 3*nodeSize + 2 extra keys
 	 *	to allow for LT pointers in last 2 nodes when gathering 3 full nodes
+	 *  - scratch space of a prefixed tree
+	 * Each buffer starts aligned, so nodes of a whole number of pages
+	 * occupy whole pages.
 	*/
-	if ((h->malloc2 = malloc((bufCt + 6) * h->sectorSize + 2 * h->ks)) == NULL) {
-		return error(bErrMemory);
+	align = ION_BPP_BUFFER_ALIGNMENT;
+
+	while (0 != h->nodeSize % align) {
+		align /= 2;
 	}
 
-	for (i = 0; i < (bufCt + 6) * h->sectorSize + 2 * h->ks; i++) {
-		((char *) h->malloc2)[i] = 0;
+	if ((h->malloc2 = calloc(1, (bufCt + 6) * h->nodeSize + 2 * h->ks + extra + align - 1)) == NULL) {
+		return error(bErrMemory);
 	}
 
-	p				= h->malloc2;
+	p				= (ion_bpp_node_t *) ((char *) h->malloc2 + (align - (uintptr_t) h->malloc2 % align) % align);
 
 	/* initialize buflist */
 	h->bufList.next = buf;
@@ -968,7 +1827,7 @@ b_open(
 		buf->modified	= boolean_false;
 		buf->valid		= boolean_false;
 		buf->p			= p;
-		p				= (ion_bpp_node_t *) ((char *) p + h->sectorSize);
+		p				= (ion_bpp_node_t *) ((char *) p + h->nodeSize);
 		buf++;
 	}
 
@@ -978,11 +1837,20 @@ b_open(
 	/* initialize root */
 	root					= &h->root;
 	root->p					= p;
-	p						= (ion_bpp_node_t *) ((char *) p + 3 * h->sectorSize);
+	p						= (ion_bpp_node_t *) ((char *) p + 3 * h->nodeSize);
 	h->gbuf.p				= p;/* done last to include extra 2 keys */
 
+	if (h->prefixed) {
+		h->image	= (char *) p + 3 * h->nodeSize + 2 * h->ks;
+		h->trial	= h->image + 3 * h->nodeSize;
+		h->lastKey	= h->trial + h->keySize;
+		h->sep		= h->lastKey + h->keySize;
+	}
+
 	h->curBuf				= NULL;
 	h->curKey				= NULL;
+	h->freeList				= 0;
+	h->freeRec				= -1;
 
 	/* initialize root */
 	if (ion_fexists(info.iName)) {
@@ -1000,6 +1868,22 @@ b_open(
 		if ((h->nextFreeAdr = ion_ftell(h->fp)) == -1) {
 			return error(bErrIO);
 		}
+
+		/* a packed node may not fill its last sectors */
+		h->nextFreeAdr = (h->nextFreeAdr - h->base + h->nodeSize - 1) / h->nodeSize * h->nodeSize;
+
+		if (headed) {
+			/* the free lists are only current if the file was closed */
+			if (header.closed && (header.endAdr >= 3 * h->nodeSize) && (header.endAdr <= h->nextFreeAdr) && (0 == header.endAdr % h->nodeSize) && (0 == header.freeList % h->nodeSize) && ((0 == header.freeList) || (header.freeList >= 3 * h->nodeSize)) && (header.freeList < header.endAdr)) {
+				h->freeList		= (ion_bpp_address_t) header.freeList;
+				h->freeRec		= (ion_bpp_external_address_t) header.freeRec;
+				h->nextFreeAdr	= (ion_bpp_address_t) header.endAdr;
+			}
+
+			if ((rc = writeHeader(h, boolean_false)) != 0) {
+				return rc;
+			}
+		}
 	}
 
 #if defined(ARDUINO)
@@ -1007,10 +1891,14 @@ b_open(
 #else
 	else if (NULL != (h->fp = ion_fopen(info.iName))) {
 #endif
-		/* initialize root */
-		memset(root->p, 0, 3 * h->sectorSize);
+		/* record the settings, then initialize root */
+		if ((rc = writeHeader(h, boolean_false)) != 0) {
+			return rc;
+		}
+
+		memset(root->p, 0, 3 * h->nodeSize);
 		leaf(root)		= 1;
-		h->nextFreeAdr	= 3 * h->sectorSize;
+		h->nextFreeAdr	= 3 * h->nodeSize;
 		root->modified	= 1;
 		flushAll(h);
 	}
@@ -1024,6 +1912,35 @@ b_open(
 	return bErrOk;
 }
 
+ion_bpp_err_t
+b_sync(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_err_t rc;			/* return code */
+
+	if ((rc = flushAll(handle)) != 0) {
+		return rc;
+	}
+
+	if (err_ok != ion_fsync(((ion_bpp_h_node_t *) handle)->fp)) {
+		return error(bErrIO);
+	}
+
+	return bErrOk;
+}
+
+ion_bpp_err_t
+b_hold(
+	ion_bpp_handle_t		handle,
+	ion_file_writeback_t	*writeback
+) {
+	if (err_ok != ion_fhold(((ion_bpp_h_node_t *) handle)->fp, writeback)) {
+		return error(bErrIO);
+	}
+
+	return bErrOk;
+}
+
 ion_bpp_err_t
 b_close(
 	ion_bpp_handle_t handle
@@ -1042,10 +1959,20 @@ b_close(
 
 	if (h->fp) {
 #endif
-		flushAll(handle);
+		while (h->snapshots) {
+			b_release(handle, h->snapshots);
+		}
+
+		if ((bErrOk == flushAll(handle)) && h->base) {
+			writeHeader(handle, boolean_true);
+		}
+
 		ion_fclose(h->fp);
 	}
 
+	bpp_pool_forget(h);
+	free(h->copy);
+
 	if (h->malloc2) {
 		free(h->malloc2);
 	}
@@ -1075,13 +2002,15 @@ b_get(
 	/* find key, and return address */
 	while (1) {
 		if (leaf(buf)) {
+			h->curBuf = buf;
+
 			if (search(handle, buf, key, 0, &mkey, MODE_FIRST) == 0) {
 				*rec		= rec(mkey);
-				h->curBuf	= buf;
 				h->curKey	= mkey;
 				return bErrOk;
 			}
 			else {
+				h->curKey = fkey(buf);
 				return bErrKeyNotFound;
 			}
 		}
@@ -1100,6 +2029,84 @@ b_get(
 	}
 }
 
+ion_bpp_err_t
+b_get_nearby(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_key_t		*mkey;			/* matched key */
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	int					cc;				/* condition code */
+
+	ion_bpp_h_node_t *h = handle;
+
+	/* leaves partition the key space, so a key that lies within the */
+	/* leaf the last lookup ended on can only be in that leaf */
+	buf = h->curBuf;
+
+	if ((NULL != buf) && buf->valid && leaf(buf) && (ct(buf) > 0)) {
+		cc = h->comp(key, key(fkey(buf)), (ion_key_size_t) (h->keySize));
+
+		/* with duplicates, a run equal to fkey may have started in the previous leaf */
+		if (((cc > 0) || ((cc == 0) && !h->dupKeys)) && (h->comp(key, key(lkey(buf)), (ion_key_size_t) (h->keySize)) <= 0)) {
+			if (search(handle, buf, key, 0, &mkey, MODE_FIRST) == 0) {
+				*rec		= rec(mkey);
+				h->curKey	= mkey;
+				return bErrOk;
+			}
+
+			return bErrKeyNotFound;
+		}
+	}
+
+	return b_get(handle, key, rec);
+}
+
+int
+b_value_size(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	return h->valueSize;
+}
+
+ion_bpp_err_t
+b_current_value(
+	ion_bpp_handle_t	handle,
+	void				*value
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	if ((NULL == h->curBuf) || (NULL == h->curKey) || (0 == h->valueSize)) {
+		return bErrKeyNotFound;
+	}
+
+	memcpy(value, val(h->curKey), h->valueSize);
+	return bErrOk;
+}
+
+ion_bpp_external_address_t
+b_free_rec(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	return h->freeRec;
+}
+
+ion_bpp_err_t
+b_set_free_rec(
+	ion_bpp_handle_t			handle,
+	ion_bpp_external_address_t	rec
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	h->freeRec = rec;
+	return bErrOk;
+}
+
 ion_bpp_err_t
 b_find_first_greater_or_equal(
 	ion_bpp_handle_t			handle,
@@ -1232,8 +2239,8 @@ b_insert(
 				memmove(mkey + ks(1), mkey, len);
 			}
 
-			/* insert new key */
-			memcpy(key(mkey), key, h->keySize);
+			/* insert new key, and its value */
+			memcpy(key(mkey), key, h->keySize + h->valueSize);
 			rec(mkey)		= rec;
 			childGE(mkey)	= 0;
 			ct(buf)++;
@@ -1242,8 +2249,9 @@ b_insert(
 				return rc;
 			}
 
-			/* if new key is first key, then fixup lastGE key */
-			if (!keyOff && lastLTvalid) {
+			/* if new key is first key, then fixup lastGE key; */
+			/* shortened separators already sort below it */
+			if (!keyOff && lastLTvalid && (!h->prefixed || h->dupKeys)) {
 				ion_bpp_buffer_t	*tbuf;
 				ion_bpp_key_t		*tkey;
 
@@ -1251,8 +2259,7 @@ b_insert(
 					return rc;
 				}
 
-				/* tkey = fkey(tbuf) + lastGEkey; */
-				tkey		= fkey(tbuf);
+				tkey		= fkey(tbuf) + lastGEkey;
 				memcpy(key(tkey), key, h->keySize);
 				rec(tkey)	= rec;
 
@@ -1384,8 +2391,14 @@ b_update(
 					break;
 			}
 
-			/* update key */
+			/* update key, and its value */
+			memcpy(val(mkey), val(key), h->valueSize);
 			rec(mkey) = rec;
+
+			if ((rc = writeDisk(buf)) != 0) {
+				return rc;
+			}
+
 			break;
 		}
 		else {
@@ -1438,36 +2451,176 @@ b_update(
 }
 
 ion_bpp_err_t
-b_delete(
-	ion_bpp_handle_t			handle,
-	void						*key,
-	ion_bpp_external_address_t	*rec
+b_bulk_load(
+	ion_bpp_handle_t	handle,
+	ion_bpp_stream_t	stream,
+	void				*context,
+	int					fill
 ) {
-	int					rc;		/* return code */
-	ion_bpp_key_t		*mkey;			/* match key */
-	int					len;	/* length to shift */
-	int					cc;		/* condition code */
-	ion_bpp_buffer_t	*buf;				/* buffer */
-	ion_bpp_buffer_t	*tmp[4];
-	unsigned int		keyOff;
-	ion_bpp_bool_t		lastGEvalid;		/* true if GE branch taken */
-	ion_bpp_bool_t		lastLTvalid;		/* true if LT branch taken after GE branch */
-	ion_bpp_address_t	lastGE;			/* last childGE traversed */
-	unsigned int		lastGEkey;	/* last childGE key traversed */
-	ion_bpp_buffer_t	*root;
-	ion_bpp_buffer_t	*gbuf;
+	ion_bpp_err_t				rc;		/* return code */
+	ion_bpp_buffer_t			*root;
+	ion_bpp_bulk_level_t		levels[ION_BPP_BULK_MAX_HEIGHT];
+	ion_bpp_bulk_level_t		*lv;
+	ion_bpp_key_t				*item;	/* entry read from the stream */
+	ion_bpp_key_t				*last;	/* last entry staged in a leaf */
+	ion_bpp_external_address_t	rec;	/* record address read from the stream */
+	int							level;
+	int							cc;		/* condition code */
+	int							n[3];	/* sizes of the last nodes of a level */
+	int							i;
 
 	ion_bpp_h_node_t *h = handle;
 
-	root		= &h->root;
-	gbuf		= &h->gbuf;
-	lastGEvalid = boolean_false;
-	lastLTvalid = boolean_false;
+	root = &h->root;
 
-	buf			= root;
+	if (!leaf(root) || (0 != ct(root))) {
+		return bErrNotEmpty;
+	}
 
-	while (1) {
-		if (leaf(buf)) {
+	if (fill > 100) {
+		fill = 100;
+	}
+
+	/* a node must stay above half full, or a delete could empty it */
+	/* without a gather. Internal targets count children, and stop */
+	/* short of maxCt keys so three staged nodes always fit the root. */
+	memset(levels, 0, sizeof(levels));
+
+	for (level = 0; level < ION_BPP_BULK_MAX_HEIGHT; level++) {
+		lv			= &levels[level];
+		lv->target	= (int) (h->maxCt * fill / 100);
+		lv->minCt	= (0 == level) ? (int) (h->maxCt / 2) : (int) (h->maxCt / 2 + 1);
+
+		if (lv->target < lv->minCt) {
+			lv->target = lv->minCt;
+		}
+
+		if (lv->target > (int) h->maxCt) {
+			lv->target = h->maxCt;
+		}
+	}
+
+	if ((item = calloc(1, h->ks)) == NULL) {
+		return error(bErrMemory);
+	}
+
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+	rc			= bErrOk;
+
+	/* stage the leaf level; each full node is written once, */
+	/* and feeds its first key up to the level above */
+	while (stream(context, key(item), &rec)) {
+		lv = &levels[0];
+
+		if (0 != lv->count) {
+			last	= lv->items + ks(lv->count - 1);
+			cc		= h->comp(key(item), key(last), (ion_key_size_t) (h->keySize));
+
+			if ((0 == cc) && !h->dupKeys) {
+				rc = bErrDupKeys;
+				goto cleanup;
+			}
+
+			if ((cc < 0) || ((0 == cc) && (rec <= rec(last)))) {
+				rc = bErrKeyOrder;
+				goto cleanup;
+			}
+		}
+
+		rec(item) = rec;
+
+		if ((rc = bulkPush(handle, levels, 0, item, 0)) != 0) {
+			goto cleanup;
+		}
+
+		nKeysIns++;
+	}
+
+	/* close off each level from the bottom up. The last node is */
+	/* merged with, or evened out against, the full node before it */
+	for (level = 0; levels[level].written; level++) {
+		lv		= &levels[level];
+		n[0]	= lv->target;
+		n[1]	= lv->target;
+		n[2]	= lv->count - 2 * lv->target;
+
+		if (n[2] < lv->minCt) {
+			n[2] += n[1];
+
+			if (n[2] < 2 * lv->minCt) {
+				n[1]	= n[2];
+				n[2]	= 0;
+			}
+			else {
+				n[1]	= n[2] / 2;
+				n[2]	-= n[1];
+			}
+		}
+
+		for (i = 0; i < 3 && n[i]; i++) {
+			if ((rc = bulkWrite(handle, levels, level, n[i], (2 == i) || (0 == n[i + 1]))) != 0) {
+				goto cleanup;
+			}
+		}
+	}
+
+	/* the first level that never filled three nodes becomes the root */
+	lv = &levels[level];
+	memset(root->p, 0, 3 * h->nodeSize);
+	bulkFill(handle, root, 0 == level, lv->items, lv->count);
+	root->modified = boolean_true;
+
+	if ((rc = flush(handle, root)) != 0) {
+		goto cleanup;
+	}
+
+	if (level > maxHeight) {
+		maxHeight = level;
+	}
+
+cleanup:
+
+	for (level = 0; level < ION_BPP_BULK_MAX_HEIGHT; level++) {
+		free(levels[level].items);
+	}
+
+	free(item);
+	return rc;
+}
+
+ion_bpp_err_t
+b_delete(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	int					rc;		/* return code */
+	ion_bpp_key_t		*mkey;			/* match key */
+	int					len;	/* length to shift */
+	int					cc;		/* condition code */
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	ion_bpp_buffer_t	*tmp[4];
+	unsigned int		keyOff;
+	ion_bpp_bool_t		lastGEvalid;		/* true if GE branch taken */
+	ion_bpp_bool_t		lastLTvalid;		/* true if LT branch taken after GE branch */
+	ion_bpp_address_t	lastGE;			/* last childGE traversed */
+	unsigned int		lastGEkey;	/* last childGE key traversed */
+	ion_bpp_buffer_t	*root;
+	ion_bpp_buffer_t	*gbuf;
+	int					i;
+
+	ion_bpp_h_node_t *h = handle;
+
+	root		= &h->root;
+	gbuf		= &h->gbuf;
+	lastGEvalid = boolean_false;
+	lastLTvalid = boolean_false;
+
+	buf			= root;
+
+	while (1) {
+		if (leaf(buf)) {
 			/* set mkey to point to deletion point */
 			if (search(handle, buf, key, *rec, &mkey, MODE_MATCH) == 0) {
 				*rec = rec(mkey);
@@ -1538,6 +2691,13 @@ b_delete(
 				if ((buf == root) && (ct(root) == 2) && (ct(gbuf) < (3 * (3 * h->maxCt)) / 4)) {
 					/* collapse tree by one level */
 					scatterRoot(handle);
+
+					for (i = 0; i < 3; i++) {
+						if ((rc = freeAdr(handle, tmp[i])) != 0) {
+							return rc;
+						}
+					}
+
 					nNodesDel += 3;
 					continue;
 				}
@@ -1751,3 +2911,642 @@ b_find_prev_key(
 	h->curKey	= pkey;
 	return bErrOk;
 }
+
+ion_bpp_err_t
+b_snapshot(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snapshot_t	*snapshot
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_snap_t		*s;
+	ion_bpp_err_t		rc;			/* return code */
+
+	/* from here on the nodes on disk are the snapshot's */
+	if ((rc = flushAll(handle)) != 0) {
+		return rc;
+	}
+
+	if ((NULL == h->copy) && (NULL == (h->copy = malloc(3 * h->nodeSize)))) {
+		return error(bErrMemory);
+	}
+
+	if ((s = calloc(1, sizeof(ion_bpp_snap_t))) == NULL) {
+		return error(bErrMemory);
+	}
+
+	if ((s->node = malloc(3 * h->nodeSize)) == NULL) {
+		free(s);
+		return error(bErrMemory);
+	}
+
+	s->endAdr		= h->nextFreeAdr;
+	s->next			= h->snapshots;
+	h->snapshots	= s;
+	*snapshot		= s;
+	return bErrOk;
+}
+
+ion_bpp_err_t
+b_release(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snapshot_t	snapshot
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_snap_t		*s = snapshot;
+	ion_bpp_snap_t		**link;
+	ion_bpp_address_t	copy;
+	ion_bpp_err_t		rc;			/* return code */
+	ion_bpp_err_t		result;
+	int					i;
+
+	for (link = &h->snapshots; *link != s; link = &(*link)->next) {}
+
+	*link	= s->next;
+	result	= bErrOk;
+
+	/* the copies go back on the free list; no other snapshot reads them */
+	for (i = 0; i < s->savedCt; i++) {
+		copy = s->saved[2 * i + 1];
+
+		if (0 == copy) {
+			continue;
+		}
+
+		if (((rc = releaseAdr(handle, copy)) != 0) || ((0 == s->saved[2 * i]) && (((rc = releaseAdr(handle, copy + h->nodeSize)) != 0) || ((rc = releaseAdr(handle, copy + 2 * h->nodeSize)) != 0)))) {
+			result = rc;
+		}
+	}
+
+	ion_readahead_close(s->ahead);
+	free(s->saved);
+	free(s->node);
+	free(s);
+	return result;
+}
+
+static ion_bpp_bool_t
+takeAhead(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snap_t		*s,
+	ion_bpp_address_t	adr,
+	int					len,
+	ion_bpp_bool_t		packed
+) {
+	ion_bpp_h_node_t *h = handle;
+
+	/*
+	 * input:
+	 *   adr					where the node lies, in its place or a copy
+	 *   packed				 whether it lies packed, as in its place in a
+	 *						 prefixed index; copies are kept unpacked
+	 * output:
+	 *   s->node				the node, if snapAhead read it ahead
+	*/
+	if (NULL == s->ahead) {
+		return boolean_false;
+	}
+
+	if (!packed) {
+		return ion_readahead_take(s->ahead, h->base + adr, len, (ion_byte_t *) s->node);
+	}
+
+	return ion_readahead_take(s->ahead, h->base + adr, len, (ion_byte_t *) h->image) && (bErrOk == unpackNode(handle, h->image, len, s->node));
+}
+
+static ion_bpp_err_t
+readSnap(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snap_t		*s,
+	ion_bpp_address_t	adr
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_address_t	copy;
+	int					len;
+	int					i;
+
+	/* read a node as the snapshot sees it into s->node */
+	if (s->lost) {
+		return error(bErrIO);
+	}
+
+	len = adr == 0 ? 3 * h->nodeSize : h->nodeSize;
+	i	= findSaved(s, adr);
+
+	if ((i < s->savedCt) && (s->saved[2 * i] == adr)) {
+		copy = s->saved[2 * i + 1];
+
+		/* a node the snapshot never held */
+		if (0 == copy) {
+			return error(bErrIO);
+		}
+
+		nSectorReads	+= len / h->sectorSize;
+		nDiskReads++;
+
+		if (!takeAhead(handle, s, copy, len, boolean_false) && (err_ok != ion_fread_at(h->fp, h->base + copy, len, (ion_byte_t *) s->node))) {
+			return error(bErrIO);
+		}
+
+		return bErrOk;
+	}
+
+	if ((adr != 0) && bpp_pool_read(h, adr, h->nodeSize, s->node)) {
+		return bErrOk;
+	}
+
+	nDiskReads++;
+
+	/* the pool, which may be newer than the file, is checked first */
+	if ((adr != 0) && takeAhead(handle, s, adr, len, h->prefixed)) {
+		return bErrOk;
+	}
+
+	return readImage(handle, adr, len, s->node);
+}
+
+static void
+snapAhead(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snap_t		*s
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_node_t		node;			/* header of a leaf read ahead */
+	ion_bpp_address_t	adr;
+	ion_file_offset_t	offset;
+	ion_byte_t			*image;
+	int					i;
+	int					j;
+
+	/*
+	 * notes:
+	 *   Called once a scan steps to the leaf in s->node. The leaves
+	 *   after it are queued as far as those already landed tell where
+	 *   the chain goes, so each step queues about one more. readSnap
+	 *   takes each leaf from the readahead once the scan reaches it,
+	 *   so it is read only once. Writing a node's place drops any read
+	 *   of it, so a leaf is only taken as the snapshot sees it; one
+	 *   peeked at after a writer moved it only misdirects the
+	 *   readahead, never the scan.
+	*/
+	if ((ION_BPP_READAHEAD <= 0) || s->noAhead) {
+		return;
+	}
+
+	if ((NULL == s->ahead) && (NULL == (s->ahead = ion_readahead_open(h->fp, 2 * ION_BPP_READAHEAD, h->nodeSize)))) {
+		s->noAhead = boolean_true;
+		return;
+	}
+
+	adr = s->node->next;
+
+	for (i = 0; i < ION_BPP_READAHEAD && adr; i++) {
+		j		= findSaved(s, adr);
+		offset	= h->base + ((j < s->savedCt) && (s->saved[2 * j] == adr) && s->saved[2 * j + 1] ? s->saved[2 * j + 1] : adr);
+
+		if (err_ok != ion_readahead_queue(s->ahead, offset)) {
+			return;
+		}
+
+		if (NULL == (image = ion_readahead_peek(s->ahead, offset, sizeof(ion_bpp_node_t)))) {
+			return;
+		}
+
+		memcpy(&node, image, sizeof(ion_bpp_node_t));
+
+		if (!node.leaf) {
+			return;
+		}
+
+		adr = node.next;
+	}
+}
+
+static ion_bpp_err_t
+snapKey(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snap_t				*s,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	snap;				/* buffer over s->node */
+	ion_bpp_buffer_t	*buf = &snap;
+	ion_bpp_key_t		*k;
+	ion_bpp_err_t		rc;			/* return code */
+
+	/* move past the end of empty or finished leaves, then return the key */
+	buf->p = s->node;
+
+	while (s->cur >= (int) ct(buf)) {
+		if (!next(buf)) {
+			return bErrKeyNotFound;
+		}
+
+		if ((rc = readSnap(handle, s, next(buf))) != 0) {
+			return rc;
+		}
+
+		snapAhead(handle, s);
+		s->cur = 0;
+	}
+
+	k = fkey(buf) + ks(s->cur);
+	memcpy(key, key(k), h->keySize);
+	*rec = rec(k);
+	return bErrOk;
+}
+
+ion_bpp_err_t
+b_snapshot_find_first_greater_or_equal(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snapshot_t			snapshot,
+	void						*key,
+	void						*mkey,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_snap_t		*s = snapshot;
+	ion_bpp_buffer_t	snap;				/* buffer over s->node */
+	ion_bpp_buffer_t	*buf = &snap;
+	ion_bpp_key_t		*lgeqkey;			/* matched key */
+	ion_bpp_err_t		rc;			/* return code */
+	int					cc;
+
+	if ((rc = readSnap(handle, s, 0)) != 0) {
+		return rc;
+	}
+
+	buf->p = s->node;
+
+	while (!leaf(buf)) {
+		cc = search(handle, buf, key, 0, &lgeqkey, MODE_LLEQ);
+
+		if ((rc = readSnap(handle, s, cc < 0 ? childLT(lgeqkey) : childGE(lgeqkey))) != 0) {
+			return rc;
+		}
+	}
+
+	cc		= search(handle, buf, key, 0, &lgeqkey, MODE_LLEQ);
+	s->cur	= (lgeqkey - fkey(buf)) / h->ks;
+
+	if ((cc > 0) || (0 == ct(buf))) {
+		s->cur++;
+	}
+
+	return snapKey(handle, s, mkey, rec);
+}
+
+ion_bpp_err_t
+b_snapshot_find_first_key(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snapshot_t			snapshot,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_snap_t		*s = snapshot;
+	ion_bpp_buffer_t	snap;				/* buffer over s->node */
+	ion_bpp_buffer_t	*buf = &snap;
+	ion_bpp_err_t		rc;			/* return code */
+
+	if ((rc = readSnap(handle, s, 0)) != 0) {
+		return rc;
+	}
+
+	buf->p = s->node;
+
+	while (!leaf(buf)) {
+		if ((rc = readSnap(handle, s, childLT(fkey(buf)))) != 0) {
+			return rc;
+		}
+	}
+
+	s->cur = 0;
+	return snapKey(handle, s, key, rec);
+}
+
+ion_bpp_err_t
+b_snapshot_find_next_key(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snapshot_t			snapshot,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_snap_t *s = snapshot;
+
+	s->cur++;
+	return snapKey(handle, s, key, rec);
+}
+
+ion_bpp_err_t
+b_snapshot_current_value(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snapshot_t	snapshot,
+	void				*value
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_snap_t		*s = snapshot;
+	ion_bpp_buffer_t	snap;				/* buffer over s->node */
+	ion_bpp_buffer_t	*buf = &snap;
+
+	buf->p = s->node;
+
+	if ((0 == h->valueSize) || (s->cur >= (int) ct(buf))) {
+		return bErrKeyNotFound;
+	}
+
+	memcpy(value, val(fkey(buf) + ks(s->cur)), h->valueSize);
+	return bErrOk;
+}
+
+static ion_bpp_err_t
+findParent(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	adr,
+	ion_bpp_address_t	*parent
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	ion_bpp_key_t		*key;			/* first key of the node */
+	ion_bpp_key_t		*mkey;			/* matched key */
+	ion_bpp_address_t	child;
+	ion_bpp_err_t		rc;			/* return code */
+
+	/*
+	 * input:
+	 *   adr					address of a node
+	 * output:
+	 *   parent				 address of the node pointing at it
+	 * returns:
+	 *   bErrOk				 node is in the tree
+	 *   bErrKeyNotFound		node is released, or was leaked
+	 * notes:
+	 *   Descends from the root with the first key of the node, which
+	 *   leads through its parent whatever level the node is on.
+	*/
+	if ((readDisk(handle, adr, &buf) != 0) || (ct(buf) == 0) || (ct(buf) > h->maxCt)) {
+		return bErrKeyNotFound;
+	}
+
+	/* the gather buffer is only used within inserts and deletes */
+	key = (char *) h->gbuf.p;
+	memcpy(key, fkey(buf), h->ks);
+	buf = &h->root;
+
+	while (!leaf(buf)) {
+		if (search(handle, buf, key, rec(key), &mkey, MODE_MATCH) < 0) {
+			child = childLT(mkey);
+		}
+		else {
+			child = childGE(mkey);
+		}
+
+		if (child == adr) {
+			*parent = buf->adr;
+			return bErrOk;
+		}
+
+		if ((rc = readDisk(handle, child, &buf)) != 0) {
+			return rc;
+		}
+	}
+
+	return bErrKeyNotFound;
+}
+
+static ion_bpp_address_t
+swapAdr(
+	ion_bpp_address_t	adr,
+	ion_bpp_address_t	a,
+	ion_bpp_address_t	b
+) {
+	return (adr == a) ? b : ((adr == b) ? a : adr);
+}
+
+static void
+relabel(
+	ion_bpp_handle_t	handle,
+	ion_bpp_buffer_t	*buf,
+	ion_bpp_address_t	a,
+	ion_bpp_address_t	b
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_key_t		*k;
+	int					i;
+
+	/* point the links of a node at a to b, and at b to a */
+	if (leaf(buf)) {
+		prev(buf)	= swapAdr(prev(buf), a, b);
+		next(buf)	= swapAdr(next(buf), a, b);
+		return;
+	}
+
+	k			= fkey(buf);
+	childLT(k)	= swapAdr(childLT(k), a, b);
+
+	for (i = 0; i < ct(buf); i++, k += ks(1)) {
+		childGE(k) = swapAdr(childGE(k), a, b);
+	}
+}
+
+static ion_bpp_err_t
+swapNodes(
+	ion_bpp_handle_t	handle,
+	ion_bpp_address_t	a,
+	ion_bpp_address_t	b
+) {
+	ion_bpp_buffer_t	*bufA;
+	ion_bpp_buffer_t	*bufB;
+	ion_bpp_buffer_t	*buf;
+	ion_bpp_address_t	refs[6];	/* parents and leaf neighbours */
+	ion_bpp_address_t	parent;
+	ion_bpp_bool_t		bInTree;
+	ion_bpp_err_t		rc;			/* return code */
+	int					refCt;
+	int					i;
+	int					j;
+
+	/*
+	 * input:
+	 *   a					  node in the tree
+	 *   b					  any other node
+	 * notes:
+	 *   Swaps the two nodes, then relinks the nodes pointing at them.
+	 *   If b isn't in the tree, a simply moves there.
+	*/
+	refCt = 0;
+
+	if ((rc = findParent(handle, a, &parent)) != 0) {
+		return (bErrKeyNotFound == rc) ? error(bErrIO) : rc;
+	}
+
+	refs[refCt++] = parent;
+
+	if ((rc = readDisk(handle, a, &buf)) != 0) {
+		return rc;
+	}
+
+	/* leaf links of 0 mean none, the root is never a neighbour */
+	if (leaf(buf)) {
+		refs[refCt]		= prev(buf);
+		refCt			+= 0 != prev(buf);
+		refs[refCt]		= next(buf);
+		refCt			+= 0 != next(buf);
+	}
+
+	rc		= findParent(handle, b, &parent);
+	bInTree = bErrOk == rc;
+
+	if (bInTree) {
+		refs[refCt++] = parent;
+
+		if ((rc = readDisk(handle, b, &bufB)) != 0) {
+			return rc;
+		}
+
+		if (leaf(bufB)) {
+			refs[refCt]		= prev(bufB);
+			refCt			+= 0 != prev(bufB);
+			refs[refCt]		= next(bufB);
+			refCt			+= 0 != next(bufB);
+		}
+	}
+	else if (bErrKeyNotFound != rc) {
+		return rc;
+	}
+	else {
+		/* drop any copy of b, as a's buffer takes its place */
+		if ((rc = assignBuf(handle, b, &bufB)) != 0) {
+			return rc;
+		}
+
+		bufB->valid		= boolean_false;
+		bufB->modified	= boolean_false;
+	}
+
+	/* swap the buffers' addresses; both are flushed to their new places */
+	if ((rc = readDisk(handle, a, &bufA)) != 0) {
+		return rc;
+	}
+
+	bufA->adr = b;
+	relabel(handle, bufA, a, b);
+
+	if ((rc = writeDisk(bufA)) != 0) {
+		return rc;
+	}
+
+	if (bInTree) {
+		bufB->adr = a;
+		relabel(handle, bufB, a, b);
+
+		if ((rc = writeDisk(bufB)) != 0) {
+			return rc;
+		}
+	}
+
+	for (i = 0; i < refCt; i++) {
+		if ((refs[i] == a) || (refs[i] == b)) {
+			continue;
+		}
+
+		for (j = 0; j < i && refs[j] != refs[i]; j++) {}
+
+		if (j < i) {
+			continue;
+		}
+
+		if ((rc = readDisk(handle, refs[i], &buf)) != 0) {
+			return rc;
+		}
+
+		relabel(handle, buf, a, b);
+
+		if ((rc = writeDisk(buf)) != 0) {
+			return rc;
+		}
+	}
+
+	return bErrOk;
+}
+
+ion_bpp_err_t
+b_compact(
+	ion_bpp_handle_t handle
+) {
+	ion_bpp_h_node_t	*h = handle;
+	ion_bpp_buffer_t	*buf;				/* buffer */
+	ion_bpp_address_t	adr;
+	ion_bpp_address_t	slot;	/* where the next node goes */
+	ion_bpp_address_t	end;	/* nodes from here on are done */
+	ion_bpp_address_t	parent;
+	ion_bpp_err_t		rc;			/* return code */
+
+	/* moving nodes would pull them from under the snapshots */
+	if (h->snapshots) {
+		return bErrBusy;
+	}
+
+	/* released nodes are found again below, along with any leaked */
+	h->freeList = 0;
+	h->curBuf	= NULL;
+	h->curKey	= NULL;
+
+	/* find the first leaf */
+	adr = 0;
+	buf = &h->root;
+
+	while (!leaf(buf)) {
+		adr = childLT(fkey(buf));
+
+		if ((rc = readDisk(handle, adr, &buf)) != 0) {
+			return rc;
+		}
+	}
+
+	/* move the leaves, in key order, to the front of the file */
+	slot = 3 * h->nodeSize;
+
+	while (adr) {
+		if ((adr != slot) && ((rc = swapNodes(handle, adr, slot)) != 0)) {
+			return rc;
+		}
+
+		if ((rc = readDisk(handle, slot, &buf)) != 0) {
+			return rc;
+		}
+
+		adr		= next(buf);
+		slot	+= h->nodeSize;
+	}
+
+	/* fill the holes after them with the internal nodes from the end */
+	end = h->nextFreeAdr;
+
+	while (slot < end) {
+		if ((rc = findParent(handle, slot, &parent)) == bErrOk) {
+			slot += h->nodeSize;
+			continue;
+		}
+		else if (bErrKeyNotFound != rc) {
+			return rc;
+		}
+
+		end -= h->nodeSize;
+
+		if (end > slot) {
+			if ((rc = findParent(handle, end, &parent)) == bErrOk) {
+				if ((rc = swapNodes(handle, end, slot)) != 0) {
+					return rc;
+				}
+
+				slot += h->nodeSize;
+			}
+			else if (bErrKeyNotFound != rc) {
+				return rc;
+			}
+		}
+	}
+
+	h->nextFreeAdr = slot;
+	return flushAll(handle);
+}
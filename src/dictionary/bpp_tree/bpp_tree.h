@@ -76,27 +76,76 @@ typedef char (*ion_bpp_comparison_t)(
  * implementation independent *
  ******************************/
 
-/* statistics */
-int maxHeight;	/* maximum height attained */
-int nNodesIns;	/* number of nodes inserted */
-int nNodesDel;	/* number of nodes deleted */
-int nKeysIns;	/* number of keys inserted */
-int nKeysDel;	/* number of keys deleted */
-int nDiskReads;	/* number of disk reads */
-int nDiskWrites;/* number of disk writes */
+/* statistics are kept per thread, as sharded dictionaries work on several trees at once */
+#if !defined(ARDUINO) && defined(__GNUC__)
+#define ION_BPP_THREAD_LOCAL __thread
+#else
+#define ION_BPP_THREAD_LOCAL
+#endif
+
+extern ION_BPP_THREAD_LOCAL int maxHeight;	/* maximum height attained */
+extern ION_BPP_THREAD_LOCAL int nNodesIns;	/* number of nodes inserted */
+extern ION_BPP_THREAD_LOCAL int nNodesDel;	/* number of nodes deleted */
+extern ION_BPP_THREAD_LOCAL int nKeysIns;	/* number of keys inserted */
+extern ION_BPP_THREAD_LOCAL int nKeysDel;	/* number of keys deleted */
+extern ION_BPP_THREAD_LOCAL int nDiskReads;	/* number of disk reads */
+extern ION_BPP_THREAD_LOCAL int nDiskWrites;/* number of disk writes */
+extern ION_BPP_THREAD_LOCAL int nSectorReads;	/* number of sectors read */
 
 /* line number for last IO or memory error */
-int bErrLineNo;
+extern ION_BPP_THREAD_LOCAL int bErrLineNo;
 
 typedef ion_boolean_e ion_bpp_bool_t;
 
 /* typedef enum {false, true} bool; */
 typedef enum ION_BPP_ERR {
-	bErrOk, bErrKeyNotFound, bErrDupKeys, bErrSectorSize, bErrFileNotOpen, bErrFileExists, bErrIO, bErrMemory
+	bErrOk, bErrKeyNotFound, bErrDupKeys, bErrSectorSize, bErrFileNotOpen, bErrFileExists, bErrIO, bErrMemory, bErrNotEmpty, bErrKeyOrder, bErrBusy
 } ion_bpp_err_t;
 
 typedef void *ion_bpp_handle_t;
 
+typedef void *ion_bpp_snapshot_t;
+
+/* sectors spanned by a node of a prefixed tree. Only the sectors a */
+/* packed node fills are read, so this sets fan-out, not read size */
+#if !defined(ION_BPP_PREFIX_NODE_SECTORS)
+#define ION_BPP_PREFIX_NODE_SECTORS 4
+#endif
+
+/* largest sector size b_open accepts */
+#if !defined(ION_BPP_MAX_SECTOR_SIZE)
+#define ION_BPP_MAX_SECTOR_SIZE 65536
+#endif
+
+/* leaves a snapshot scan keeps queued ahead of the one it is on, */
+/* read together so a cold scan doesn't wait on each leaf in turn */
+#if !defined(ION_BPP_READAHEAD)
+#if defined(ARDUINO)
+#define ION_BPP_READAHEAD 0
+#else
+#define ION_BPP_READAHEAD 8
+#endif
+#endif
+
+/* node buffers start on a multiple of this many bytes, or of the */
+/* largest power of two dividing the node size if that is smaller */
+#if !defined(ION_BPP_BUFFER_ALIGNMENT)
+#if defined(ARDUINO)
+#define ION_BPP_BUFFER_ALIGNMENT 4
+#else
+#define ION_BPP_BUFFER_ALIGNMENT 4096
+#endif
+#endif
+
+/* supply the next key and record address of a bulk load,
+ * and return false once there are none left
+*/
+typedef ion_bpp_bool_t (*ion_bpp_stream_t)(
+	void						*context,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+);
+
 typedef struct {
 	/* info for bOpen() */
 	char					*iName;	/* name of index file */
@@ -104,6 +153,8 @@ typedef struct {
 	ion_bpp_bool_t			dupKeys;		/* true if duplicate keys allowed */
 	size_t					sectorSize;	/* size of sector on disk */
 	ion_bpp_comparison_t	comp;			/* pointer to compare function */
+	ion_bpp_bool_t			prefixed;		/* true to pack nodes on disk, see b_open */
+	int						valueSize;		/* bytes of value stored with each key, see b_open */
 } ion_bpp_open_t;
 
 /***********************
@@ -123,8 +174,33 @@ b_open(
  * returns:
  *   bErrOk				 open was successful
  *   bErrMemory			 insufficient memory
- *   bErrSectorSize		 sector size too small or not 0 mod 4
+ *   bErrSectorSize		 sector size too small, too large or not 0 mod 4
  *   bErrFileNotOpen		unable to open index file
+ *   bErrIO				 file written with another key or value size
+ * notes:
+ *   A new index file starts with a header sector recording the
+ *   sector size, whether nodes are prefixed and the value size, and an
+ *   existing one is opened with the settings of its header rather than
+ *   those of info. Files written before the header existed are opened
+ *   with info, but without values.
+ *
+ *   With a nonzero valueSize, each key is stored with valueSize bytes
+ *   of value, which follow the key in the buffers passed to b_insert,
+ *   b_update and a bulk load stream, and are read back with
+ *   b_current_value. Internal nodes carry the bytes too, so fan-out
+ *   drops as for a longer key. Prefixed trees store no values.
+ *
+ *   A prefixed tree gives each node ION_BPP_PREFIX_NODE_SECTORS
+ *   sectors, but writes it packed: the prefix common to its keys is
+ *   stored once, trailing zero bytes of keys are dropped, and fields
+ *   a node never reads are left out. Separators promoted from leaves
+ *   are cut to the fewest leading bytes that still divide the leaves.
+ *   A read fetches only the sectors the packed node fills, so with
+ *   string keys a lookup reads about one sector per level of a tree
+ *   with several times the fan-out. Keys may be at most 255 bytes. *
+ *   Nodes emptied by deletes go on a free list that later inserts
+ *   draw from. The list is kept in the file header when the tree is
+ *   closed; a file not closed cleanly leaks the nodes instead.
 */
 
 ion_bpp_err_t
@@ -139,6 +215,34 @@ b_close(
  *   bErrOk				 file closed, resources deleted
 */
 
+ion_bpp_err_t
+b_sync(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   writeback			 the files to write back with, or NULL
+ *						 to let writes through
+ * returns:
+ *   bErrOk				 the index file holds its writes in memory
+ *						 until they are written back, or lets them through
+*/
+
+ion_bpp_err_t
+b_hold(
+	ion_bpp_handle_t		handle,
+	ion_file_writeback_t	*writeback
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   bErrOk				 changed nodes written through to storage
+*/
+
 ion_bpp_err_t
 b_insert(
 	ion_bpp_handle_t			handle,
@@ -149,7 +253,7 @@ b_insert(
 /*
  * input:
  *   handle				 handle returned by bOpen
- *   key					key to insert
+ *   key					key to insert, followed by its value
  *   rec					record address
  * returns:
  *   bErrOk				 operation successful
@@ -172,7 +276,7 @@ b_update(
 /*
  * input:
  *   handle				 handle returned by bOpen
- *   key					key to update
+ *   key					key to update, followed by its value
  *   rec					record address
  * returns:
  *   bErrOk				 operation successful
@@ -185,6 +289,34 @@ b_update(
  *   nodes to generate a "unique" key.
 */
 
+ion_bpp_err_t
+b_bulk_load(
+	ion_bpp_handle_t	handle,
+	ion_bpp_stream_t	stream,
+	void				*context,
+	int					fill
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   stream				 called for each key, in ascending order
+ *   context				passed through to stream
+ *   fill				   percentage of each node to fill
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrNotEmpty		   tree already holds keys
+ *   bErrDupKeys			duplicate keys (and info.dupKeys = false)
+ *   bErrKeyOrder		   keys not in ascending order
+ * notes:
+ *   Builds the tree bottom-up, writing each node exactly once
+ *   rather than splitting nodes as keys arrive. Nodes are kept
+ *   at least half full whatever the fill, so later inserts and
+ *   deletes rebalance as usual. With dupKeys, duplicate keys
+ *   must arrive in ascending record address order. If loading
+ *   fails, the tree is left empty.
+*/
+
 ion_bpp_err_t
 b_delete(
 	ion_bpp_handle_t			handle,
@@ -224,6 +356,65 @@ b_get(
  * returns:
  *   bErrOk				 operation successful
  *   bErrKeyNotFound		key not found
+ * notes:
+ *   The current position is left on the leaf searched, even
+ *   if the key is not found.
+*/
+
+ion_bpp_err_t
+b_get_nearby(
+	ion_bpp_handle_t			handle,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   key					key to find
+ * output:
+ *   rec					record address
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		key not found
+ * notes:
+ *   Same as b_get, but first checks the leaf the previous b_get
+ *   or b_get_nearby ended on, and only descends from the root if
+ *   the key lies outside it. Keys looked up in ascending order
+ *   search each leaf once. The tree must not be modified between
+ *   the two calls.
+*/
+
+int
+b_value_size(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   bytes of value stored with each key, 0 if none
+*/
+
+ion_bpp_err_t
+b_current_value(
+	ion_bpp_handle_t	handle,
+	void				*value
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   value				  value stored with the key last found
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no current key, or tree stores no values
+ * notes:
+ *   The current key is the one returned by the last successful
+ *   b_get, b_get_nearby or b_find_ call. The tree must not be
+ *   modified in between.
 */
 
 ion_bpp_err_t
@@ -299,6 +490,177 @@ b_find_next_key(
  *   bErrKeyNotFound		key not found
 */
 
+ion_bpp_err_t
+b_snapshot(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snapshot_t	*snapshot
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * output:
+ *   snapshot			   view of the tree as it is now
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrMemory			 insufficient memory
+ * notes:
+ *   While any snapshot is pinned the tree copies on write: before a
+ *   node is first overwritten or released, each snapshot is given a
+ *   copy of it in a node of its own, so the snapshot keeps reading
+ *   the tree as it was. A snapshot has its own position, so the
+ *   b_snapshot_ calls may be interleaved with any other call on the
+ *   handle. The copies are released with the snapshot.
+*/
+
+ion_bpp_err_t
+b_release(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snapshot_t	snapshot
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   snapshot			   snapshot returned by b_snapshot
+ * returns:
+ *   bErrOk				 snapshot released
+ * notes:
+ *   b_close releases any snapshot still pinned.
+*/
+
+ion_bpp_err_t
+b_snapshot_find_first_greater_or_equal(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snapshot_t			snapshot,
+	void						*key,
+	void						*mkey,
+	ion_bpp_external_address_t	*rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   snapshot			   snapshot returned by b_snapshot
+ *   key					key to find
+ * output:
+ *   mkey				   least key greater than or equal to key
+ *   rec					record address of mkey
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no such key in the snapshot
+ *   bErrIO				 the snapshot lost a node, see b_snapshot
+*/
+
+ion_bpp_err_t
+b_snapshot_find_first_key(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snapshot_t			snapshot,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   snapshot			   snapshot returned by b_snapshot
+ * output:
+ *   key					first key in the snapshot
+ *   rec					record address
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		snapshot is empty
+ *   bErrIO				 the snapshot lost a node, see b_snapshot
+*/
+
+ion_bpp_err_t
+b_snapshot_find_next_key(
+	ion_bpp_handle_t			handle,
+	ion_bpp_snapshot_t			snapshot,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   snapshot			   snapshot positioned by a b_snapshot_find_ call
+ * output:
+ *   key					key after the snapshot's current key
+ *   rec					record address
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no more keys
+ *   bErrIO				 the snapshot lost a node, see b_snapshot
+*/
+
+ion_bpp_err_t
+b_snapshot_current_value(
+	ion_bpp_handle_t	handle,
+	ion_bpp_snapshot_t	snapshot,
+	void				*value
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   snapshot			   snapshot positioned by a b_snapshot_find_ call
+ * output:
+ *   value				  value stored with the snapshot's current key
+ * returns:
+ *   bErrOk				 operation successful
+ *   bErrKeyNotFound		no current key, or tree stores no values
+*/
+
+ion_bpp_err_t
+b_compact(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   bErrOk				 operation successful
+ * notes:
+ *   Moves the leaves, in key order, to the front of the file and
+ *   packs the internal nodes after them, so that scans read nodes
+ *   in file order. Freed and leaked nodes are dropped and later
+ *   nodes are written from the new end of the tree. The file itself
+ *   does not shrink. Cursors must not be open across the call.
+ *   Returns bErrBusy, moving nothing, while a snapshot is pinned.
+*/
+
+ion_bpp_external_address_t
+b_free_rec(
+	ion_bpp_handle_t handle
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ * returns:
+ *   record address given to b_set_free_rec before the tree was last
+ *   closed, or -1 if none
+*/
+
+ion_bpp_err_t
+b_set_free_rec(
+	ion_bpp_handle_t			handle,
+	ion_bpp_external_address_t	rec
+);
+
+/*
+ * input:
+ *   handle				 handle returned by bOpen
+ *   rec					record address to keep
+ * returns:
+ *   bErrOk				 operation successful
+ * notes:
+ *   Keeps one record address, such as the head of the caller's list
+ *   of free records, in the file header. It is written by b_close.
+*/
+
 #if defined(__cplusplus)
 }
 #endif
@@ -36,6 +36,15 @@
 
 #include "bpp_tree_handler.h"
 
+/**
+@brief		The first bytes of a posting file.
+*/
+typedef struct {
+	uint32_t	values;	/**< Values each block holds. */
+	uint32_t	closed;	/**< True if @p free is current. */
+	int64_t		free;	/**< First block of the free list, -1 if none. */
+} ion_bpp_posting_header_t;
+
 void
 bpptree_get_filename(
 	ion_dictionary_id_t id,
@@ -45,11 +54,136 @@ bpptree_get_filename(
 }
 
 /**
-@brief		Creates an instance of a dictionary.
+@brief		Takes a tree's reading lock.
+@details	Readers may share the dictionary lock, but every read moves the
+			tree's node buffers, current key and block buffer, so they take
+			turns with them.
+@param		bpptree
+				The tree to lock.
+*/
+static void
+bpptree_lock_reading(
+	ion_bpptree_t *bpptree
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_lock(&bpptree->reading);
+#else
+	UNUSED(bpptree);
+#endif
+}
 
-@details	Creates as instance of a dictionary given a @p key_size and
-			@p value_size, in bytes. The @p dictionary_size parameter is
-			not used for this implementation, as there is no size bound.
+/**
+@brief		Releases the lock taken with @ref bpptree_lock_reading.
+@param		bpptree
+				The tree to unlock.
+*/
+static void
+bpptree_unlock_reading(
+	ion_bpptree_t *bpptree
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_unlock(&bpptree->reading);
+#else
+	UNUSED(bpptree);
+#endif
+}
+
+/**
+@brief		Writes the header of the posting file.
+
+@details	The free list is only recorded once the tree is closed. An open
+			file is marked as such, so after a crash the free list starts
+			out empty: freed blocks are leaked rather than handed out twice.
+@param		bpptree
+				The tree the posting file belongs to.
+@param		closed
+				@c boolean_true if the tree is being closed.
+@return		The resulting status of the write.
+*/
+static ion_err_t
+bpptree_write_postings(
+	ion_bpptree_t	*bpptree,
+	ion_boolean_t	closed
+) {
+	ion_bpp_posting_header_t header;
+
+	memset(&header, 0, sizeof(header));
+	header.values	= bpptree->posting_values;
+	header.closed	= closed;
+	header.free		= closed ? bpptree->postings.next_empty : ION_FILE_NULL;
+
+	return ion_fwrite_at(bpptree->postings.file_handle, 0, sizeof(header), (ion_byte_t *) &header);
+}
+
+/**
+@brief		Opens the posting file of a dictionary, picking up its block
+			size and free list where they were left.
+
+@param		bpptree
+				The tree to open the posting file of.
+@param		id
+				ID of the dictionary.
+@param		value_size
+				The size of the values in bytes.
+@return		The resulting status of the open.
+*/
+static ion_err_t
+bpptree_open_postings(
+	ion_bpptree_t		*bpptree,
+	ion_dictionary_id_t id,
+	ion_value_size_t	value_size
+) {
+	ion_bpp_posting_header_t	header;
+	ion_boolean_t				exists;
+	char						posting_filename[ION_MAX_FILENAME_LENGTH];
+
+	if (dictionary_get_filename(id, "pst", posting_filename) >= ION_MAX_FILENAME_LENGTH) {
+		return err_uninitialized;
+	}
+
+	exists							= ion_fexists(posting_filename);
+	bpptree->postings.file_handle	= ion_fopen(posting_filename);
+
+	if (!exists || (err_ok != ion_fread_at(bpptree->postings.file_handle, 0, sizeof(header), (ion_byte_t *) &header)) || (2 > header.values)) {
+		header.values	= (ION_BPP_POSTING_BLOCK_SIZE - sizeof(ion_file_offset_t) - sizeof(uint32_t)) / value_size;
+		header.free		= ION_FILE_NULL;
+
+		if (2 > header.values) {
+			header.values = 2;
+		}
+	}
+	else if (!header.closed) {
+		header.free = ION_FILE_NULL;
+	}
+
+	bpptree->posting_values			= header.values;
+	bpptree->posting_size			= sizeof(ion_file_offset_t) + sizeof(uint32_t) + header.values * value_size;
+	bpptree->postings.next_empty	= (ion_file_offset_t) header.free;
+	bpptree->block					= malloc(bpptree->posting_size + value_size);
+
+	if (NULL == bpptree->block) {
+		ion_fclose(bpptree->postings.file_handle);
+		return err_out_of_memory;
+	}
+
+	bpptree->moving = bpptree->block + bpptree->posting_size;
+
+	if (err_ok != bpptree_write_postings(bpptree, boolean_false)) {
+		free(bpptree->block);
+		ion_fclose(bpptree->postings.file_handle);
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Creates or opens the index, value and posting files of a
+			dictionary.
+
+@details	A new index is given sectors of @p sector_size bytes, and holds
+			values of at most @ref ION_BPP_INLINE_VALUE_SIZE bytes; an
+			existing one keeps the settings in its header.
 @param		id
 				ID of a dictionary that's given to us.
 @param		key_type
@@ -58,30 +192,27 @@ bpptree_get_filename(
 				The size of the key in bytes.
 @param		value_size
 				The size of the value in bytes.
-@param		dictionary_size
-				The size of the hashmap in discrete units
+@param		sector_size
+				The sector size of a new index in bytes.
 @param		compare
 				Function pointer for the comparison function for the dictionary.
 @param		handler
-				 THe handler for the specific dictionary being created.
+				The handler for the specific dictionary being created.
 @param		dictionary
-				 The pointer declared by the caller that will reference
-				 the instance of the dictionary created.
+				The dictionary instance to fill in.
 @return		The status of the creation of the dictionary.
 */
-ion_err_t
-bpptree_create_dictionary(
+static ion_err_t
+bpptree_create_tree(
 	ion_dictionary_id_t			id,
 	ion_key_type_t				key_type,
 	ion_key_size_t				key_size,
 	ion_value_size_t			value_size,
-	ion_dictionary_size_t		dictionary_size,
+	int							sector_size,
 	ion_dictionary_compare_t	compare,
 	ion_dictionary_handler_t	*handler,
 	ion_dictionary_t			*dictionary
 ) {
-	UNUSED(dictionary_size);
-
 /*	if (key_size != sizeof(int)) {
 		return err_invalid_initial_size;
 	}*/
@@ -100,8 +231,6 @@ bpptree_create_dictionary(
 	bpptree_get_filename(id, value_filename);
 	bpptree->values.file_handle = ion_fopen(value_filename);
 
-	bpptree->values.next_empty	= ION_FILE_NULL;
-
 	char addr_filename[ION_MAX_FILENAME_LENGTH];
 
 	int actual_filename_length = dictionary_get_filename(id, "bpt", addr_filename);
@@ -113,15 +242,57 @@ bpptree_create_dictionary(
 	info.iName		= addr_filename;
 	info.keySize	= key_size;
 	info.dupKeys	= boolean_false;
-	info.sectorSize = 256;
+	info.sectorSize = sector_size;
 	info.comp		= compare;
+	info.prefixed	= ION_BPP_PREFIX_COMPRESSION && ((key_type_char_array == key_type) || (key_type_null_terminated_string == key_type));
+	info.valueSize	= value_size <= ION_BPP_INLINE_VALUE_SIZE ? value_size : 0;
 
 	ion_bpp_err_t bErr = b_open(info, &(bpptree->tree));
 
+	/* long keys may leave too few entries per node to add values */
+	if ((bErrSectorSize == bErr) && (0 != info.valueSize)) {
+		info.valueSize	= 0;
+		bErr			= b_open(info, &(bpptree->tree));
+	}
+
 	if (bErrOk != bErr) {
 		return err_uninitialized;
 	}
 
+	/* pick up the value file's free list where it was left */
+	bpptree->values.next_empty = b_free_rec(bpptree->tree);
+
+	bpptree->entry			= NULL;
+	bpptree->snapshots		= 0;
+	bpptree->retired		= NULL;
+	bpptree->retired_count	= 0;
+	bpptree->retired_room	= 0;
+
+	if (0 != b_value_size(bpptree->tree)) {
+		bpptree->entry = malloc(key_size + value_size);
+
+		if (NULL == bpptree->entry) {
+			b_close(bpptree->tree);
+			ion_fclose(bpptree->values.file_handle);
+			free(bpptree);
+			return err_out_of_memory;
+		}
+	}
+
+	ion_err_t err = bpptree_open_postings(bpptree, id, value_size);
+
+	if (err_ok != err) {
+		b_close(bpptree->tree);
+		ion_fclose(bpptree->values.file_handle);
+		free(bpptree->entry);
+		free(bpptree);
+		return err;
+	}
+
+#if !defined(ARDUINO)
+	pthread_mutex_init(&bpptree->reading, NULL);
+#endif
+
 	if (NULL == handler) {
 		return err_uninitialized;
 	}
@@ -138,55 +309,1197 @@ bpptree_create_dictionary(
 }
 
 /**
-@brief		Inserts a @p key and @p value into the dictionary.
+@brief		Creates an instance of a dictionary.
 
-@param	  dictionary
-				The dictionary instance to insert the value into.
-@param	  key
-				The key to use.
-@param	  value
-				The value to use.
-@return		The status on the insertion of the record.
+@details	Creates as instance of a dictionary given a @p key_size and
+			@p value_size, in bytes. The @p dictionary_size parameter is
+			not used for this implementation, as there is no size bound.
+			New trees get sectors of @ref ION_BPP_SECTOR_SIZE bytes.
+@param		id
+				ID of a dictionary that's given to us.
+@param		key_type
+				The key category given to us.
+@param		key_size
+				The size of the key in bytes.
+@param		value_size
+				The size of the value in bytes.
+@param		dictionary_size
+				The size of the hashmap in discrete units
+@param		compare
+				Function pointer for the comparison function for the dictionary.
+@param		handler
+				 THe handler for the specific dictionary being created.
+@param		dictionary
+				 The pointer declared by the caller that will reference
+				 the instance of the dictionary created.
+@return		The status of the creation of the dictionary.
 */
-ion_status_t
-bpptree_insert(
-	ion_dictionary_t	*dictionary,
-	ion_key_t			key,
-	ion_value_t			value
+ion_err_t
+bpptree_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
 ) {
-	ion_bpptree_t		*bpptree;
-	ion_bpp_err_t		bErr;
-	ion_err_t			err;
-	ion_file_offset_t	offset;
+	UNUSED(dictionary_size);
 
-	bpptree = (ion_bpptree_t *) dictionary->instance;
+	return bpptree_create_tree(id, key_type, key_size, value_size, ION_BPP_SECTOR_SIZE, compare, handler, dictionary);
+}
+
+ion_err_t
+bpptree_create(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	int							sector_size
+) {
+	ion_err_t err;
+
+	dictionary->lock	= NULL;
+	dictionary->wal		= NULL;
+	err					= bpptree_create_tree(id, key_type, key_size, value_size, sector_size, dictionary_switch_compare(key_type, key_size), handler, dictionary);
+
+	if (err_ok == err) {
+		dictionary->instance->id	= id;
+		dictionary->status			= ion_dictionary_status_ok;
+	}
+	else {
+		dictionary->status = ion_dictionary_status_error;
+	}
+
+	return err;
+}
+
+/**
+@brief		Lays out a key and its value the way the index stores them.
+
+@param		bpptree
+				The tree the entry is for.
+@param		key
+				The key of the entry.
+@param		value
+				The value of the entry.
+@return		@p key followed by @p value if values are inline, otherwise
+			@p key alone.
+*/
+static ion_key_t
+bpptree_entry(
+	ion_bpptree_t	*bpptree,
+	ion_key_t		key,
+	ion_value_t		value
+) {
+	if (NULL == bpptree->entry) {
+		return key;
+	}
+
+	memcpy(bpptree->entry, key, bpptree->super.record.key_size);
+	memcpy(bpptree->entry + bpptree->super.record.key_size, value, bpptree->super.record.value_size);
+
+	return bpptree->entry;
+}
+
+/**
+@brief		Reads a block of a posting list.
+
+@param		bpptree
+				The tree the posting list belongs to.
+@param		offset
+				The offset of the block in the posting file.
+@param		block
+				Room for a block, set to the one read.
+@return		The resulting status of the read.
+*/
+static ion_err_t
+bpptree_posting_read(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	offset,
+	ion_byte_t			*block
+) {
+	return ion_fread_at(bpptree->postings.file_handle, offset, bpptree->posting_size, block);
+}
+
+/**
+@brief		Returns the number of values a block of a posting list holds.
+*/
+static uint32_t
+bpptree_posting_count(
+	ion_byte_t *block
+) {
+	uint32_t count;
+
+	memcpy(&count, block + sizeof(ion_file_offset_t), sizeof(count));
+	return count;
+}
+
+/**
+@brief		Returns the @p i th value of a block of a posting list.
+*/
+static ion_byte_t *
+bpptree_posting_value(
+	ion_bpptree_t	*bpptree,
+	ion_byte_t		*block,
+	uint32_t		i
+) {
+	return block + sizeof(ion_file_offset_t) + sizeof(uint32_t) + i * bpptree->super.record.value_size;
+}
+
+/**
+@brief		Writes the block staged in the tree's block buffer.
+
+@param		bpptree
+				The tree the posting list belongs to.
+@param		count
+				The number of values in the block.
+@param		offset
+				Where the block was read from, or @ref ION_FILE_NULL for
+				a new block.
+@param		next
+				The offset of the head block of the list. A new block is
+				put in front of it, and @p next set to the new block.
+@return		The resulting status of the write.
+*/
+static ion_err_t
+bpptree_posting_write(
+	ion_bpptree_t		*bpptree,
+	uint32_t			count,
+	ion_file_offset_t	offset,
+	ion_file_offset_t	*next
+) {
+	memcpy(bpptree->block + sizeof(ion_file_offset_t), &count, sizeof(count));
+
+	if (ION_FILE_NULL != offset) {
+		return ion_fwrite_at(bpptree->postings.file_handle, offset, bpptree->posting_size, bpptree->block);
+	}
+
+	return lfb_put(&(bpptree->postings), bpptree->block + sizeof(ion_file_offset_t), bpptree->posting_size - sizeof(ion_file_offset_t), *next, next);
+}
+
+/**
+@brief		Appends values to a posting list.
+
+@details	Values fill the head block of the list in place, then go to new
+			blocks put in front of it, so that the newest values come first.
+			While cursors are open the head block is left alone, as they may
+			still read it.
+@param		bpptree
+				The tree the posting list belongs to.
+@param		head
+				The record address of the list, or @ref ION_FILE_NULL to
+				start a new one. Set to the record address of the list.
+@param		first
+				A value to append ahead of @p values, or @c NULL.
+@param		values
+				The values to append, oldest first.
+@param		count
+				The number of values in @p values. At least one value must
+				be appended.
+@return		The resulting status of the append.
+*/
+static ion_err_t
+bpptree_posting_append(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	*head,
+	ion_value_t			first,
+	ion_value_t			*values,
+	ion_result_count_t	count
+) {
+	ion_file_offset_t	offset;
+	ion_file_offset_t	next;
+	ion_err_t			error;
+	ion_boolean_t		dirty;
+	uint32_t			held;
+	ion_result_count_t	i;
 
+	next	= ION_FILE_NULL == *head ? ION_FILE_NULL : ION_BPP_POSTING(*head);
 	offset	= ION_FILE_NULL;
-	bErr	= b_get(bpptree->tree, key, &offset);
+	held	= 0;
+	dirty	= boolean_false;
 
-	if (bErrKeyNotFound == bErr) {
-		offset = ION_FILE_NULL;
+	if ((ION_FILE_NULL != next) && (0 == bpptree->snapshots)) {
+		error = bpptree_posting_read(bpptree, next, bpptree->block);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		offset	= next;
+		held	= bpptree_posting_count(bpptree->block);
 	}
 
-	err = lfb_put(&(bpptree->values), (ion_byte_t *) value, bpptree->super.record.value_size, offset, &offset);
+	for (i = NULL == first ? 0 : -1; i < count; i++) {
+		if (held == (uint32_t) bpptree->posting_values) {
+			if (dirty) {
+				error = bpptree_posting_write(bpptree, held, offset, &next);
 
-	if (err_ok == err) {
-		if (bErrKeyNotFound == bErr) {
-			bErr = b_insert(bpptree->tree, key, offset);
+				if (err_ok != error) {
+					return error;
+				}
+			}
+
+			offset	= ION_FILE_NULL;
+			held	= 0;
 		}
-		else {
-			bErr = b_update(bpptree->tree, key, offset);
+
+		memcpy(bpptree_posting_value(bpptree, bpptree->block, held++), 0 > i ? first : values[i], bpptree->super.record.value_size);
+		dirty = boolean_true;
+	}
+
+	error = bpptree_posting_write(bpptree, held, offset, &next);
+
+	if (err_ok == error) {
+		*head = ION_BPP_POSTING(next);
+	}
+
+	return error;
+}
+
+/**
+@brief		Reads the value of the key the index was last positioned on.
+
+@param		bpptree
+				The tree to read from.
+@param		offset
+				The record address of the key.
+@param		value
+				Set to the value, the newest of the key if it has several.
+@return		The resulting status of the read.
+*/
+static ion_err_t
+bpptree_read_value(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	offset,
+	ion_value_t			value
+) {
+	ion_file_offset_t	next;
+	ion_err_t			error;
+
+	if (ION_BPP_VALUE_INLINE == offset) {
+		return bErrOk == b_current_value(bpptree->tree, value) ? err_ok : err_file_read_error;
+	}
+
+	if (ION_BPP_IS_POSTING(offset)) {
+		error = bpptree_posting_read(bpptree, ION_BPP_POSTING(offset), bpptree->block);
+
+		if (err_ok == error) {
+			memcpy(value, bpptree_posting_value(bpptree, bpptree->block, bpptree_posting_count(bpptree->block) - 1), bpptree->super.record.value_size);
+		}
+
+		return error;
+	}
+
+	return lfb_get(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &next);
+}
+
+/**
+@brief		Counts the values of a key.
+
+@param		bpptree
+				The tree the values belong to.
+@param		offset
+				The record address of the key, a chain of the value file or
+				a posting list.
+@param		count
+				Incremented once for each value.
+@return		The resulting status of the reads.
+*/
+static ion_err_t
+bpptree_chain_length(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	offset,
+	ion_result_count_t	*count
+) {
+	ion_err_t error;
+
+	if (ION_BPP_IS_POSTING(offset)) {
+		/* the next offset and count lead each block */
+		for (offset = ION_BPP_POSTING(offset); ION_FILE_NULL != offset; memcpy(&offset, bpptree->block, sizeof(offset))) {
+			error = ion_fread_at(bpptree->postings.file_handle, offset, sizeof(ion_file_offset_t) + sizeof(uint32_t), bpptree->block);
+
+			if (err_ok != error) {
+				return error;
+			}
+
+			*count += bpptree_posting_count(bpptree->block);
+		}
+
+		return err_ok;
+	}
+
+	while (ION_FILE_NULL != offset) {
+		error = ion_fread_at(bpptree->values.file_handle, offset, sizeof(ion_file_offset_t), (ion_byte_t *) &offset);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		(*count)++;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Frees every value of a key, a block at a time for a posting
+			list.
+
+@param		bpptree
+				The tree the values belong to.
+@param		offset
+				The record address of the key, a chain of the value file or
+				a posting list.
+@param		count
+				Incremented once for each value, if not @c NULL.
+@return		The resulting status of the deletion.
+*/
+static ion_err_t
+bpptree_free_values(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	offset,
+	ion_result_count_t	*count
+) {
+	ion_file_offset_t	next;
+	ion_err_t			error;
+
+	if (!ION_BPP_IS_POSTING(offset)) {
+		return lfb_delete_all(&(bpptree->values), offset, count);
+	}
+
+	for (offset = ION_BPP_POSTING(offset); ION_FILE_NULL != offset; offset = next) {
+		error = ion_fread_at(bpptree->postings.file_handle, offset, sizeof(ion_file_offset_t) + sizeof(uint32_t), bpptree->block);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		memcpy(&next, bpptree->block, sizeof(next));
+		error = lfb_delete(&(bpptree->postings), offset);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		if (NULL != count) {
+			*count += bpptree_posting_count(bpptree->block);
 		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Sets every value of a key, a block at a time for a posting
+			list.
+
+@param		bpptree
+				The tree the values belong to.
+@param		offset
+				The record address of the key, a chain of the value file or
+				a posting list.
+@param		value
+				The new value.
+@param		count
+				Incremented once for each value.
+@return		The resulting status of the update.
+*/
+static ion_err_t
+bpptree_update_values(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	offset,
+	ion_value_t			value,
+	ion_result_count_t	*count
+) {
+	ion_err_t	error;
+	uint32_t	held;
+	uint32_t	i;
+
+	if (!ION_BPP_IS_POSTING(offset)) {
+		return lfb_update_all(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, count);
+	}
+
+	for (offset = ION_BPP_POSTING(offset); ION_FILE_NULL != offset; memcpy(&offset, bpptree->block, sizeof(offset))) {
+		error = bpptree_posting_read(bpptree, offset, bpptree->block);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		held = bpptree_posting_count(bpptree->block);
+
+		for (i = 0; i < held; i++) {
+			memcpy(bpptree_posting_value(bpptree, bpptree->block, i), value, bpptree->super.record.value_size);
+		}
+
+		error = ion_fwrite_at(bpptree->postings.file_handle, offset, bpptree->posting_size, bpptree->block);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		*count += held;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Sets aside the values of a key that open cursors may still be
+			reading, to be freed once they are all destroyed.
+
+@param		bpptree
+				The tree the values belong to.
+@param		offset
+				The record address of the key, a chain of the value file or
+				a posting list.
+@return		The resulting status. If there is no room to set the values
+			aside, they are leaked rather than freed under a cursor.
+*/
+static ion_err_t
+bpptree_retire(
+	ion_bpptree_t		*bpptree,
+	ion_file_offset_t	offset
+) {
+	ion_file_offset_t	*grown;
+	int					room;
+
+	if (bpptree->retired_count == bpptree->retired_room) {
+		room	= 0 == bpptree->retired_room ? 16 : 2 * bpptree->retired_room;
+		grown	= realloc(bpptree->retired, room * sizeof(ion_file_offset_t));
+
+		if (NULL == grown) {
+			return err_out_of_memory;
+		}
+
+		bpptree->retired		= grown;
+		bpptree->retired_room	= room;
+	}
+
+	bpptree->retired[bpptree->retired_count++] = offset;
+	return err_ok;
+}
+
+/**
+@brief		Frees the values set aside by @ref bpptree_retire.
+
+@param		bpptree
+				The tree, with no cursors open.
+*/
+static void
+bpptree_free_retired(
+	ion_bpptree_t *bpptree
+) {
+	int i;
+
+	for (i = 0; i < bpptree->retired_count; i++) {
+		bpptree_free_values(bpptree, bpptree->retired[i], NULL);
+	}
+
+	bpptree->retired_count = 0;
+}
+
+/**
+@brief		Releases the snapshot of a cursor, freeing the retired values
+			once no cursor is left open.
+
+@param		bpptree
+				The tree the cursor was open on.
+@param		snapshot
+				The cursor's snapshot.
+*/
+static void
+bpptree_release(
+	ion_bpptree_t		*bpptree,
+	ion_bpp_snapshot_t	snapshot
+) {
+	b_release(bpptree->tree, snapshot);
+
+	if (0 == --bpptree->snapshots) {
+		bpptree_free_retired(bpptree);
+	}
+}
+
+/**
+@brief		Updates every value of a key by writing new values, leaving
+			the old ones to the cursors open on the tree.
+
+@param		bpptree
+				The tree to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@param		offset
+				The record address of the key's current values.
+@return		The status of the update.
+*/
+static ion_status_t
+bpptree_update_copy(
+	ion_bpptree_t		*bpptree,
+	ion_key_t			key,
+	ion_value_t			value,
+	ion_file_offset_t	offset
+) {
+	ion_file_offset_t	head	= ION_FILE_NULL;
+	ion_result_count_t	count	= 0;
+	ion_result_count_t	left;
+	uint32_t			held;
+	uint32_t			i;
+
+	if (err_ok != bpptree_chain_length(bpptree, offset, &count)) {
+		return ION_STATUS_ERROR(err_file_read_error);
+	}
+
+	if (ION_BPP_IS_POSTING(offset)) {
+		for (i = 0; i < (uint32_t) bpptree->posting_values; i++) {
+			memcpy(bpptree_posting_value(bpptree, bpptree->block, i), value, bpptree->super.record.value_size);
+		}
+
+		for (left = count; 0 < left; left -= held) {
+			held = left < bpptree->posting_values ? left : bpptree->posting_values;
+
+			if (err_ok != bpptree_posting_write(bpptree, held, ION_FILE_NULL, &head)) {
+				return ION_STATUS_ERROR(err_unable_to_insert);
+			}
+		}
+
+		head = ION_BPP_POSTING(head);
+	}
+	else {
+		for (left = 0; left < count; left++) {
+			if (err_ok != lfb_put(&(bpptree->values), (ion_byte_t *) value, bpptree->super.record.value_size, head, &head)) {
+				return ION_STATUS_ERROR(err_unable_to_insert);
+			}
+		}
+	}
+
+	if (bErrOk != b_update(bpptree->tree, bpptree_entry(bpptree, key, value), head)) {
+		return ION_STATUS_ERROR(err_unable_to_insert);
+	}
+
+	bpptree_retire(bpptree, offset);
+
+	return ION_STATUS_OK(count);
+}
+
+/**
+@brief		Adds values to a key that is in the index.
+
+@details	A key's second value moves its first, from the index or the
+			value file, into a new posting list, and later values are
+			appended to it. Chains left in the value file by trees written
+			before posting lists are extended as they always were.
+@param		bpptree
+				The tree, positioned on the key by a lookup.
+@param		key
+				The key to add values to.
+@param		offset
+				The record address of the key.
+@param		values
+				The values to add, oldest first.
+@param		count
+				The number of values in @p values.
+@return		The resulting status of the insertion.
+*/
+static ion_err_t
+bpptree_add_values(
+	ion_bpptree_t		*bpptree,
+	ion_key_t			key,
+	ion_file_offset_t	offset,
+	ion_value_t			*values,
+	ion_result_count_t	count
+) {
+	ion_file_offset_t	head;
+	ion_file_offset_t	next;
+	ion_value_t			first;
+	ion_err_t			error;
+	ion_result_count_t	i;
+
+	head	= offset;
+	first	= NULL;
+
+	if (ION_BPP_VALUE_INLINE == offset) {
+		if (bErrOk != b_current_value(bpptree->tree, bpptree->moving)) {
+			return err_file_read_error;
+		}
+
+		head	= ION_FILE_NULL;
+		first	= bpptree->moving;
+	}
+	else if (!ION_BPP_IS_POSTING(offset)) {
+		error = lfb_get(&(bpptree->values), offset, bpptree->super.record.value_size, bpptree->moving, &next);
+
+		if (err_ok != error) {
+			return error;
+		}
+
+		if (ION_FILE_NULL == next) {
+			head	= ION_FILE_NULL;
+			first	= bpptree->moving;
+		}
+	}
+
+	if ((NULL != first) || ION_BPP_IS_POSTING(offset)) {
+		error = bpptree_posting_append(bpptree, &head, first, values, count);
+	}
+	else {
+		for (i = 0, error = err_ok; (err_ok == error) && (i < count); i++) {
+			error = lfb_put(&(bpptree->values), (ion_byte_t *) values[i], bpptree->super.record.value_size, head, &head);
+		}
+	}
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	if ((head != offset) && (bErrOk != b_update(bpptree->tree, bpptree_entry(bpptree, key, values[count - 1]), head))) {
+		return err_unable_to_insert;
+	}
+
+	/* the first value moved out of the value file */
+	if ((NULL != first) && (ION_BPP_VALUE_INLINE != offset)) {
+		return 0 < bpptree->snapshots ? bpptree_retire(bpptree, offset) : lfb_delete(&(bpptree->values), offset);
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Inserts a @p key and @p value into the dictionary.
+
+@param	  dictionary
+				The dictionary instance to insert the value into.
+@param	  key
+				The key to use.
+@param	  value
+				The value to use.
+@return		The status on the insertion of the record.
+*/
+ion_status_t
+bpptree_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	ion_bpptree_t		*bpptree;
+	ion_bpp_err_t		bErr;
+	ion_err_t			err;
+	ion_file_offset_t	offset;
+
+	bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	offset	= ION_FILE_NULL;
+	bErr	= b_get(bpptree->tree, key, &offset);
+
+	if (bErrKeyNotFound != bErr) {
+		if (err_ok != bpptree_add_values(bpptree, key, offset, &value, 1)) {
+			return ION_STATUS_ERROR(err_unable_to_insert);
+		}
+
+		return ION_STATUS_OK(1);
+	}
+
+	if (NULL != bpptree->entry) {
+		bErr = b_insert(bpptree->tree, bpptree_entry(bpptree, key, value), ION_BPP_VALUE_INLINE);
+	}
+	else {
+		err		= lfb_put(&(bpptree->values), (ion_byte_t *) value, bpptree->super.record.value_size, ION_FILE_NULL, &offset);
+		bErr	= err_ok == err ? b_insert(bpptree->tree, key, offset) : bErrIO;
+	}
+
+	if (bErrOk != bErr) {
+		return ION_STATUS_ERROR(err_unable_to_insert);
+	}
+
+	return ION_STATUS_OK(1);
+}
+
+/**
+@brief		Inserts a batch of records into the dictionary.
+
+@details	Records are applied in key order so that consecutive index
+			updates land on the same leaf while it is still buffered. Values
+			that cannot reuse a free slot in the value file are staged and
+			appended @ref ION_BPP_BATCH_RECORDS at a time with a single write,
+			rather than one seek and write per record. The values of a run
+			of records with the same key are appended to its posting list
+			together.
+@param		dictionary
+				The dictionary instance to insert the records into.
+@param		records
+				The records to insert.
+@param		count
+				The number of records in @p records.
+@return		The status on the insertion of the records.
+*/
+ion_status_t
+bpptree_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+) {
+	ion_bpptree_t		*bpptree;
+	ion_bpp_err_t		bErr;
+	ion_err_t			err;
+	ion_status_t		status;
+	ion_file_offset_t	offset;
+	ion_file_offset_t	stage_start;
+	ion_result_count_t	*order;
+	ion_result_count_t	staged;
+	ion_result_count_t	ahead;
+	ion_result_count_t	i;
+	ion_record_t		*record;
+	ion_value_t			*run;
+	ion_byte_t			*stage;
+	ion_boolean_t		reused;
+	unsigned int		slot_size;
+
+	if (count <= 0) {
+		return ION_STATUS_OK(0);
+	}
+
+	bpptree		= (ion_bpptree_t *) dictionary->instance;
+	status		= ION_STATUS_OK(0);
+	slot_size	= sizeof(ion_file_offset_t) + bpptree->super.record.value_size;
+	order		= malloc(sizeof(ion_result_count_t) * count);
+	run			= malloc(sizeof(ion_value_t) * count);
+	stage		= malloc(slot_size * ION_BPP_BATCH_RECORDS);
+
+	if ((NULL == order) || (NULL == run) || (NULL == stage)) {
+		free(order);
+		free(run);
+		free(stage);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	err = dictionary_order_keys(dictionary->instance, &records[0].key, sizeof(ion_record_t), count, order);
+
+	staged		= 0;
+	stage_start = ION_FILE_NULL;
+
+	if (err_ok != err) {
+		status.error = err;
+		goto cleanup;
+	}
+
+	for (i = 0; i < count; i += ahead) {
+		record = &records[order[i]];
+
+		for (ahead = 0; (i + ahead < count) && ((0 == ahead) || (0 == bpptree->super.compare(records[order[i + ahead]].key, record->key, bpptree->super.record.key_size))); ahead++) {
+			run[ahead] = records[order[i + ahead]].value;
+		}
+
+		offset	= ION_FILE_NULL;
+		bErr	= b_get(bpptree->tree, record->key, &offset);
+
+		if (bErrKeyNotFound != bErr) {
+			/* the key's values may be read from the value file, and moved out of it */
+			if (0 != staged) {
+				err = ion_fwrite_at(bpptree->values.file_handle, stage_start, staged * slot_size, stage);
+
+				if (err_ok != err) {
+					staged			= 0;
+					status.error	= err_unable_to_insert;
+					goto cleanup;
+				}
+
+				status.count	+= staged;
+				staged			= 0;
+			}
+
+			if (err_ok != bpptree_add_values(bpptree, record->key, offset, run, ahead)) {
+				status.error = err_unable_to_insert;
+				goto cleanup;
+			}
+
+			status.count += ahead;
+			continue;
+		}
+
+		offset = ION_FILE_NULL;
+
+		if (1 < ahead) {
+			if ((err_ok != bpptree_posting_append(bpptree, &offset, NULL, run, ahead)) || (bErrOk != b_insert(bpptree->tree, bpptree_entry(bpptree, record->key, run[ahead - 1]), offset))) {
+				status.error = err_unable_to_insert;
+				goto cleanup;
+			}
+
+			status.count += ahead;
+			continue;
+		}
+
+		if (NULL != bpptree->entry) {
+			if (bErrOk != b_insert(bpptree->tree, bpptree_entry(bpptree, record->key, record->value), ION_BPP_VALUE_INLINE)) {
+				status.error = err_unable_to_insert;
+				goto cleanup;
+			}
+
+			status.count++;
+			continue;
+		}
+
+		/* Freed slots are scattered through the file, so they are reused one at a time. Once they
+		   run out every remaining value is appended, and those appends are contiguous. */
+		reused = ION_FILE_NULL != bpptree->values.next_empty;
+
+		if (reused) {
+			err = lfb_put(&(bpptree->values), (ion_byte_t *) record->value, bpptree->super.record.value_size, offset, &offset);
+
+			if (err_ok != err) {
+				status.error = err_unable_to_insert;
+				goto cleanup;
+			}
+		}
+		else {
+			if (0 == staged) {
+				stage_start = ion_fend(bpptree->values.file_handle);
+			}
+
+			memcpy(stage + staged * slot_size, &offset, sizeof(ion_file_offset_t));
+			memcpy(stage + staged * slot_size + sizeof(ion_file_offset_t), record->value, bpptree->super.record.value_size);
+			offset = stage_start + staged * slot_size;
+			staged++;
+		}
+
+		if (bErrOk != b_insert(bpptree->tree, record->key, offset)) {
+			if (!reused) {
+				staged--;
+			}
+
+			status.error = err_unable_to_insert;
+			goto cleanup;
+		}
+
+		if (reused) {
+			status.count++;
+		}
+		else if (ION_BPP_BATCH_RECORDS == staged) {
+			err = ion_fwrite_at(bpptree->values.file_handle, stage_start, staged * slot_size, stage);
+
+			if (err_ok != err) {
+				staged			= 0;
+				status.error	= err_unable_to_insert;
+				goto cleanup;
+			}
+
+			status.count	+= staged;
+			staged			= 0;
+		}
+	}
+
+cleanup:
+
+	if (0 != staged) {
+		err = ion_fwrite_at(bpptree->values.file_handle, stage_start, staged * slot_size, stage);
+
+		if (err_ok == err) {
+			status.count += staged;
+		}
+		else {
+			status.error = err_unable_to_insert;
+		}
+	}
+
+	free(order);
+	free(run);
+	free(stage);
+
+	return status;
+}
+
+/**
+@brief		State of a bulk load, shared with the index stream.
+*/
+typedef struct {
+	ion_bpptree_t			*bpptree;		/**< Dictionary being loaded. */
+	ion_bpp_record_stream_t stream;			/**< Caller's record stream. */
+	void					*context;		/**< Caller's stream context. */
+	ion_byte_t				*key;			/**< Key of the next index entry, then its first value. */
+	ion_boolean_t			pending;		/**< True if @p key holds an entry. */
+	ion_byte_t				*stage;			/**< Values waiting to be appended. */
+	ion_file_offset_t		stage_start;	/**< Where the staged values go in the value file. */
+	int						staged;			/**< Number of staged values. */
+	ion_result_count_t		count;			/**< Number of records read. */
+	ion_err_t				error;			/**< First error hit while staging values. */
+} ion_bpp_bulk_load_t;
+
+/**
+@brief		Appends the values staged by a bulk load to the value file.
+
+@param		load
+				The bulk load whose values to write.
+@return		The resulting status of the write.
+*/
+static ion_err_t
+bpptree_bulk_flush(
+	ion_bpp_bulk_load_t *load
+) {
+	ion_err_t		err;
+	unsigned int	slot_size;
+
+	if (0 == load->staged) {
+		return err_ok;
+	}
+
+	slot_size		= sizeof(ion_file_offset_t) + load->bpptree->super.record.value_size;
+	err				= ion_fwrite_at(load->bpptree->values.file_handle, load->stage_start, load->staged * slot_size, load->stage);
+	load->staged	= 0;
+
+	return err;
+}
+
+/**
+@brief		Stages a value of a bulk load, in the layout the value file uses.
+
+@details	Values are laid out back to back past the end of the value file,
+			and written @ref ION_BPP_BATCH_RECORDS at a time.
+@param		load
+				The bulk load to stage the value in.
+@param		value
+				The value to stage.
+@param		next
+				The offset of the next value with the same key, if any.
+@param		offset
+				Set to the offset the value will be written at.
+@return		The resulting status of staging the value.
+*/
+static ion_err_t
+bpptree_bulk_stage(
+	ion_bpp_bulk_load_t *load,
+	ion_value_t			value,
+	ion_file_offset_t	next,
+	ion_file_offset_t	*offset
+) {
+	ion_err_t		err;
+	ion_byte_t		*slot;
+	unsigned int	slot_size;
+
+	slot_size = sizeof(ion_file_offset_t) + load->bpptree->super.record.value_size;
+
+	if (ION_BPP_BATCH_RECORDS == load->staged) {
+		err = bpptree_bulk_flush(load);
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+	if (0 == load->staged) {
+		load->stage_start = ion_fend(load->bpptree->values.file_handle);
+	}
+
+	slot	= load->stage + load->staged * slot_size;
+	memcpy(slot, &next, sizeof(ion_file_offset_t));
+	memcpy(slot + sizeof(ion_file_offset_t), value, load->bpptree->super.record.value_size);
+	*offset = load->stage_start + load->staged * slot_size;
+	load->staged++;
+
+	return err_ok;
+}
+
+/**
+@brief		Starts the index entry of a bulk load for a new key.
+
+@param		load
+				The bulk load.
+@param		record
+				The first record with the key.
+*/
+static void
+bpptree_bulk_begin(
+	ion_bpp_bulk_load_t *load,
+	ion_record_t		*record
+) {
+	ion_key_size_t key_size = load->bpptree->super.record.key_size;
+
+	memcpy(load->key, record->key, key_size);
+	memcpy(load->key + key_size, record->value, load->bpptree->super.record.value_size);
+}
+
+/**
+@brief		Supplies the next index entry of a bulk load to the tree.
+
+@details	Reads records from the caller's stream until the key changes, so
+			the values of a run of equal keys are packed into a posting list
+			behind a single index entry, written a full block at a time, as
+			@ref bpptree_insert would leave them. A key with a single value
+			keeps it inline if values are, and stages it otherwise.
+@param		context
+				The bulk load.
+@param		key
+				Set to the key of the index entry, then its value if inline.
+@param		rec
+				Set to the offset of the first value of the key.
+@return		@c boolean_true if an entry was supplied.
+*/
+static ion_bpp_bool_t
+bpptree_bulk_next(
+	void						*context,
+	void						*key,
+	ion_bpp_external_address_t	*rec
+) {
+	ion_bpp_bulk_load_t *load;
+	ion_bpptree_t		*bpptree;
+	ion_record_t		record;
+	ion_key_size_t		key_size;
+	ion_value_size_t	value_size;
+	ion_file_offset_t	head;
+	uint32_t			held;
+
+	load = (ion_bpp_bulk_load_t *) context;
+
+	if (!load->pending) {
+		return boolean_false;
+	}
+
+	bpptree		= load->bpptree;
+	key_size	= bpptree->super.record.key_size;
+	value_size	= bpptree->super.record.value_size;
+	memcpy(key, load->key, key_size + (NULL != bpptree->entry ? value_size : 0));
+	memcpy(bpptree_posting_value(bpptree, bpptree->block, 0), load->key + key_size, value_size);
+	*rec	= ION_FILE_NULL;
+	head	= ION_FILE_NULL;
+	held	= 1;
+
+	while ((load->pending = load->stream(load->context, &record))) {
+		load->count++;
+
+		if (0 != bpptree->super.compare(record.key, key, key_size)) {
+			break;
+		}
+
+		if (held == (uint32_t) bpptree->posting_values) {
+			load->error = bpptree_posting_write(bpptree, held, ION_FILE_NULL, &head);
+			held		= 0;
+
+			if (err_ok != load->error) {
+				load->pending = boolean_false;
+				return boolean_true;
+			}
+		}
+
+		memcpy(bpptree_posting_value(bpptree, bpptree->block, held++), record.value, value_size);
+	}
+
+	if ((1 < held) || (ION_FILE_NULL != head)) {
+		load->error = bpptree_posting_write(bpptree, held, ION_FILE_NULL, &head);
+		*rec		= ION_BPP_POSTING(head);
+	}
+	else if (NULL != bpptree->entry) {
+		*rec = ION_BPP_VALUE_INLINE;
+	}
+	else {
+		load->error = bpptree_bulk_stage(load, bpptree_posting_value(bpptree, bpptree->block, 0), ION_FILE_NULL, rec);
+	}
+
+	if (err_ok != load->error) {
+		load->pending = boolean_false;
+	}
+	else if (load->pending) {
+		bpptree_bulk_begin(load, &record);
+	}
+
+	return boolean_true;
+}
+
+ion_status_t
+bpptree_bulk_load(
+	ion_dictionary_t		*dictionary,
+	ion_bpp_record_stream_t stream,
+	void					*context,
+	int						fill_factor
+) {
+	ion_bpp_bulk_load_t load;
+	ion_record_t		record;
+	ion_bpp_err_t		bErr;
+	ion_err_t			err;
+
+	load.bpptree	= (ion_bpptree_t *) dictionary->instance;
+	load.stream		= stream;
+	load.context	= context;
+	load.staged		= 0;
+	load.count		= 0;
+	load.error		= err_ok;
+	load.key		= malloc(load.bpptree->super.record.key_size + load.bpptree->super.record.value_size);
+	load.stage		= malloc((sizeof(ion_file_offset_t) + load.bpptree->super.record.value_size) * ION_BPP_BATCH_RECORDS);
+
+	if ((NULL == load.key) || (NULL == load.stage)) {
+		free(load.key);
+		free(load.stage);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	if ((load.pending = stream(context, &record))) {
+		load.count++;
+		bpptree_bulk_begin(&load, &record);
+	}
+
+	if (err_ok == load.error) {
+		bErr = b_bulk_load(load.bpptree->tree, bpptree_bulk_next, &load, fill_factor);
+	}
+	else {
+		bErr = bErrOk;
+	}
+
+	err = bpptree_bulk_flush(&load);
+
+	free(load.key);
+	free(load.stage);
+
+	switch (bErr) {
+		case bErrOk:
+			break;
+
+		case bErrKeyOrder:
+			return ION_STATUS_ERROR(err_sorted_order_violation);
+
+		case bErrDupKeys:
+			return ION_STATUS_ERROR(err_duplicate_key);
+
+		case bErrMemory:
+			return ION_STATUS_ERROR(err_out_of_memory);
+
+		case bErrIO:
+			return ION_STATUS_ERROR(err_file_write_error);
+
+		default:
+			return ION_STATUS_ERROR(err_unable_to_insert);
+	}
+
+	if (err_ok != load.error) {
+		return ION_STATUS_ERROR(load.error);
+	}
+
+	if (err_ok != err) {
+		return ION_STATUS_ERROR(err_file_write_error);
+	}
+
+	return ION_STATUS_OK(load.count);
+}
 
-		if (bErrOk != bErr) {
-			return ION_STATUS_ERROR(err_unable_to_insert);
-		}
+ion_err_t
+bpptree_compact(
+	ion_dictionary_t *dictionary
+) {
+	ion_bpptree_t	*bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_bpp_err_t	err;
 
-		return ION_STATUS_OK(1);
+	err = b_compact(bpptree->tree);
+
+	if (bErrBusy == err) {
+		return err_cursor_open;
 	}
-	else {
-		return ION_STATUS_ERROR(err_unable_to_insert);
+
+	if (bErrOk != err) {
+		return err_file_write_error;
 	}
+
+	return err_ok;
 }
 
 /**
@@ -221,19 +1534,15 @@ bpptree_get(
 ) {
 	ion_bpptree_t		*bpptree;
 	ion_file_offset_t	offset;
-	ion_file_offset_t	next;
 	ion_bpp_err_t		bErr;
 	ion_err_t			err;
 
 	bpptree = (ion_bpptree_t *) dictionary->instance;
 
+	bpptree_lock_reading(bpptree);
 	bErr	= b_get(bpptree->tree, key, &offset);
-
-	if (bErrOk != bErr) {
-		return ION_STATUS_ERROR(err_item_not_found);
-	}
-
-	err = lfb_get(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &next);
+	err		= bErrOk == bErr ? bpptree_read_value(bpptree, offset, value) : err_item_not_found;
+	bpptree_unlock_reading(bpptree);
 
 	if (err_ok == err) {
 		return ION_STATUS_OK(1);
@@ -242,6 +1551,96 @@ bpptree_get(
 	return ION_STATUS_ERROR(err);
 }
 
+/**
+@brief		Retrieves the values for many keys at once.
+
+@details	The keys are looked up in ascending order, so each leaf is
+			searched once for all of the keys that fall within it, rather
+			than re-descending the tree for every key.
+@param		dictionary
+				The instance of the dictionary to query.
+@param		keys
+				The keys to retrieve values for.
+@param		count
+				The number of keys in @p keys.
+@param		values
+				The locations to copy each value into, one per key.
+@param		statuses
+				The status of each lookup, one per key.
+@return		The status of the lookups. The count is the number of keys
+			found.
+*/
+ion_status_t
+bpptree_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	ion_bpptree_t		*bpptree;
+	ion_file_offset_t	offset;
+	ion_bpp_err_t		bErr;
+	ion_err_t			err;
+	ion_status_t		status;
+	ion_result_count_t	*order;
+	ion_result_count_t	i;
+	ion_result_count_t	idx;
+
+	if (count <= 0) {
+		return ION_STATUS_OK(0);
+	}
+
+	bpptree = (ion_bpptree_t *) dictionary->instance;
+	status	= ION_STATUS_OK(0);
+	order	= malloc(sizeof(ion_result_count_t) * count);
+
+	if (NULL == order) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	err = dictionary_order_keys(dictionary->instance, keys, sizeof(ion_key_t), count, order);
+
+	if (err_ok != err) {
+		free(order);
+		return ION_STATUS_ERROR(err);
+	}
+
+	bpptree_lock_reading(bpptree);
+
+	for (i = 0; i < count; i++) {
+		idx = order[i];
+
+		if (0 == i) {
+			bErr = b_get(bpptree->tree, keys[idx], &offset);
+		}
+		else {
+			bErr = b_get_nearby(bpptree->tree, keys[idx], &offset);
+		}
+
+		if (bErrOk != bErr) {
+			statuses[idx] = ION_STATUS_ERROR(err_item_not_found);
+			continue;
+		}
+
+		err = bpptree_read_value(bpptree, offset, values[idx]);
+
+		if (err_ok != err) {
+			statuses[idx]	= ION_STATUS_ERROR(err);
+			status.error	= err;
+			continue;
+		}
+
+		statuses[idx] = ION_STATUS_OK(1);
+		status.count++;
+	}
+
+	bpptree_unlock_reading(bpptree);
+	free(order);
+
+	return status;
+}
+
 /**
 @brief		Deletes the @p key and associated value from the dictionary
 			instance.
@@ -268,11 +1667,19 @@ bpptree_delete(
 
 	bErr	= b_delete(bpptree->tree, key, &offset);
 
-	if (bErrKeyNotFound != bErr) {
-		status.error = lfb_delete_all(&(bpptree->values), offset, &(status.count));
+	if (bErrKeyNotFound == bErr) {
+		status.error = err_item_not_found;
+	}
+	else if (ION_BPP_VALUE_INLINE == offset) {
+		status.error	= err_ok;
+		status.count	= 1;
+	}
+	else if (0 < bpptree->snapshots) {
+		status.error = bpptree_chain_length(bpptree, offset, &(status.count));
+		bpptree_retire(bpptree, offset);
 	}
 	else {
-		status.error = err_item_not_found;
+		status.error = bpptree_free_values(bpptree, offset, &(status.count));
 	}
 
 	return status;
@@ -294,8 +1701,22 @@ bpptree_close_dictionary(
 	ion_bpp_err_t	bErr;
 
 	bpptree					= (ion_bpptree_t *) dictionary->instance;
+	bpptree_free_retired(bpptree);
+	b_set_free_rec(bpptree->tree, bpptree->values.next_empty);
 	bErr					= b_close(bpptree->tree);
 	ion_fclose(bpptree->values.file_handle);
+
+	if (err_ok != bpptree_write_postings(bpptree, boolean_true)) {
+		bErr = bErrIO;
+	}
+
+	ion_fclose(bpptree->postings.file_handle);
+	free(bpptree->block);
+	free(bpptree->retired);
+	free(bpptree->entry);
+#if !defined(ARDUINO)
+	pthread_mutex_destroy(&bpptree->reading);
+#endif
 	free(dictionary->instance);
 	dictionary->instance	= NULL;
 
@@ -306,6 +1727,62 @@ bpptree_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief			Writes a BppTree instance of a dictionary through to storage.
+
+@param			dictionary
+					A pointer to the specific dictionary instance to sync.
+
+@return			The status of syncing the dictionary.
+ */
+ion_err_t
+bpptree_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_bpptree_t *bpptree = (ion_bpptree_t *) dictionary->instance;
+
+	if ((bErrOk != b_sync(bpptree->tree)) || (err_ok != ion_fsync(bpptree->values.file_handle)) || (err_ok != ion_fsync(bpptree->postings.file_handle))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief			Holds the writes of a BppTree instance of a dictionary in memory
+				until they are written back, or lets them through again.
+
+@param			dictionary
+					A pointer to the specific dictionary instance.
+@param			writeback
+					The files to write back with, or NULL to let writes
+					through.
+
+@return			The status of holding or letting through the writes.
+ */
+ion_err_t
+bpptree_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+) {
+	ion_bpptree_t	*bpptree	= (ion_bpptree_t *) dictionary->instance;
+	ion_err_t		error		= err_ok;
+
+	if (bErrOk != b_hold(bpptree->tree, writeback)) {
+		error = err_file_write_error;
+	}
+
+	if ((err_ok == error) && (err_ok != ion_fhold(bpptree->values.file_handle, writeback))) {
+		error = err_file_write_error;
+	}
+
+	if ((err_ok == error) && (err_ok != ion_fhold(bpptree->postings.file_handle, writeback))) {
+		error = err_file_write_error;
+	}
+
+	return error;
+}
+
 /**
 @brief	  Deletes an instance of the dictionary and associated data.
 
@@ -321,11 +1798,13 @@ bpptree_delete_dictionary(
 
 	char	addr_filename[ION_MAX_FILENAME_LENGTH];
 	char	value_filename[ION_MAX_FILENAME_LENGTH];
+	char	posting_filename[ION_MAX_FILENAME_LENGTH];
 
 	int actual_addr_filename_length		= dictionary_get_filename(dictionary->instance->id, "bpt", addr_filename);
 	int actual_value_filename_length	= dictionary_get_filename(dictionary->instance->id, "val", value_filename);
+	int actual_posting_filename_length	= dictionary_get_filename(dictionary->instance->id, "pst", posting_filename);
 
-	if ((actual_addr_filename_length >= ION_MAX_FILENAME_LENGTH) || (actual_value_filename_length >= ION_MAX_FILENAME_LENGTH)) {
+	if ((actual_addr_filename_length >= ION_MAX_FILENAME_LENGTH) || (actual_value_filename_length >= ION_MAX_FILENAME_LENGTH) || (actual_posting_filename_length >= ION_MAX_FILENAME_LENGTH)) {
 		return err_dictionary_destruction_error;
 	}
 
@@ -337,6 +1816,7 @@ bpptree_delete_dictionary(
 
 	ion_fremove(addr_filename);
 	ion_fremove(value_filename);
+	ion_fremove(posting_filename);
 
 	return err_ok;
 }
@@ -354,16 +1834,19 @@ bpptree_destroy_dictionary(
 ) {
 	char	addr_filename[ION_MAX_FILENAME_LENGTH];
 	char	value_filename[ION_MAX_FILENAME_LENGTH];
+	char	posting_filename[ION_MAX_FILENAME_LENGTH];
 
 	int actual_addr_filename_length		= dictionary_get_filename(id, "bpt", addr_filename);
 	int actual_value_filename_length	= dictionary_get_filename(id, "val", value_filename);
+	int actual_posting_filename_length	= dictionary_get_filename(id, "pst", posting_filename);
 
-	if ((actual_addr_filename_length >= ION_MAX_FILENAME_LENGTH) || (actual_value_filename_length >= ION_MAX_FILENAME_LENGTH)) {
+	if ((actual_addr_filename_length >= ION_MAX_FILENAME_LENGTH) || (actual_value_filename_length >= ION_MAX_FILENAME_LENGTH) || (actual_posting_filename_length >= ION_MAX_FILENAME_LENGTH)) {
 		return err_dictionary_destruction_error;
 	}
 
 	ion_fremove(addr_filename);
 	ion_fremove(value_filename);
+	ion_fremove(posting_filename);
 
 	return err_ok;
 }
@@ -398,8 +1881,18 @@ bpptree_update(
 
 	bErr	= b_get(bpptree->tree, key, &offset);
 
-	if (bErrKeyNotFound != bErr) {
-		lfb_update_all(&(bpptree->values), offset, bpptree->super.record.value_size, (ion_byte_t *) value, &count);
+	if ((bErrKeyNotFound != bErr) && (ION_BPP_VALUE_INLINE == offset)) {
+		if (bErrOk != b_update(bpptree->tree, bpptree_entry(bpptree, key, value), offset)) {
+			return ION_STATUS_ERROR(err_unable_to_insert);
+		}
+
+		count = 1;
+	}
+	else if ((bErrKeyNotFound != bErr) && (0 < bpptree->snapshots)) {
+		return bpptree_update_copy(bpptree, key, value, offset);
+	}
+	else if (bErrKeyNotFound != bErr) {
+		bpptree_update_values(bpptree, offset, value, &count);
 	}
 	else {
 		return bpptree_insert(dictionary, key, value);
@@ -408,6 +1901,166 @@ bpptree_update(
 	return ION_STATUS_OK(count);
 }
 
+/**
+@brief		Copies the inline value of the key a cursor was just moved to,
+			so that lookups made before the value is read can't disturb it.
+
+@param		bCursor
+				The cursor that was moved.
+@param		bpptree
+				The tree the cursor is over.
+*/
+static void
+bpptree_cursor_load(
+	ion_bpp_cursor_t	*bCursor,
+	ion_bpptree_t		*bpptree
+) {
+	if (ION_BPP_VALUE_INLINE == bCursor->offset) {
+		b_snapshot_current_value(bpptree->tree, bCursor->snapshot, bCursor->cur_value);
+	}
+}
+
+/**
+@brief		Tells whether a cursor's snapshot was moved onto a key.
+
+@param		cursor
+				The cursor that was moved.
+@param		bErr
+				The result of the move.
+@return		@ref boolean_true if the move succeeded. Otherwise
+			@ref boolean_false, with the cursor's status set to
+			@ref cs_possible_data_inconsistency if the snapshot could
+			not be read.
+*/
+static ion_boolean_t
+bpptree_cursor_moved(
+	ion_dict_cursor_t	*cursor,
+	ion_bpp_err_t		bErr
+) {
+	if ((bErrOk != bErr) && (bErrKeyNotFound != bErr)) {
+		cursor->status = cs_possible_data_inconsistency;
+	}
+
+	return bErrOk == bErr;
+}
+
+/**
+@brief		Reads the value a cursor is on, and moves it onto the next
+			value of the key, if any.
+
+@param		bCursor
+				The cursor to read from.
+@param		bpptree
+				The tree the cursor is over.
+@param		value
+				Set to the value.
+*/
+static void
+bpptree_cursor_value(
+	ion_bpp_cursor_t	*bCursor,
+	ion_bpptree_t		*bpptree,
+	ion_value_t			value
+) {
+	if (ION_BPP_VALUE_INLINE == bCursor->offset) {
+		memcpy(value, bCursor->cur_value, bpptree->super.record.value_size);
+		bCursor->offset = ION_FILE_NULL;
+		return;
+	}
+
+	if (ION_BPP_IS_POSTING(bCursor->offset)) {
+		/* a block is read once, and its values returned newest first */
+		if (0 == bCursor->held) {
+			if (err_ok == bpptree_posting_read(bpptree, ION_BPP_POSTING(bCursor->offset), bCursor->block)) {
+				bCursor->held = bpptree_posting_count(bCursor->block);
+			}
+
+			if (0 == bCursor->held) {
+				bCursor->offset = ION_FILE_NULL;
+				return;
+			}
+		}
+
+		bCursor->held--;
+		memcpy(value, bpptree_posting_value(bpptree, bCursor->block, bCursor->held), bpptree->super.record.value_size);
+
+		if (0 == bCursor->held) {
+			memcpy(&bCursor->offset, bCursor->block, sizeof(ion_file_offset_t));
+			bCursor->offset = ION_FILE_NULL == bCursor->offset ? ION_FILE_NULL : ION_BPP_POSTING(bCursor->offset);
+		}
+
+		return;
+	}
+
+	lfb_get(&(bpptree->values), bCursor->offset, bpptree->super.record.value_size, value, &bCursor->offset);
+}
+
+/**
+@brief		Moves an active cursor onto the value following the one
+			last returned, fetching the next key once the values of
+			the current key are exhausted.
+@param		cursor
+				The active cursor to advance.
+@return		@ref boolean_true if the cursor is positioned on a value
+			that satisfies its predicate, @ref boolean_false otherwise.
+*/
+static ion_boolean_t
+bpptree_advance_cursor(
+	ion_dict_cursor_t *cursor
+) {
+	ion_bpp_cursor_t	*bCursor	= (ion_bpp_cursor_t *) cursor;
+	ion_bpptree_t		*bpptree	= (ion_bpptree_t *) cursor->dictionary->instance;
+	ion_boolean_t		is_valid	= boolean_true;
+
+	switch (cursor->predicate->type) {
+		case predicate_equality: {
+			if (-1 == bCursor->offset) {
+				/* End of results, we can quit */
+				is_valid = boolean_false;
+			}
+
+			break;
+		}
+
+		case predicate_range: {
+			/*do b_find_next_key then test_predicate */
+			if (-1 == bCursor->offset) {
+				ion_bpp_err_t bErr = b_snapshot_find_next_key(bpptree->tree, bCursor->snapshot, bCursor->cur_key, &bCursor->offset);
+
+				if (!bpptree_cursor_moved(cursor, bErr) || (boolean_false == test_predicate(cursor, bCursor->cur_key))) {
+					is_valid = boolean_false;
+				}
+				else {
+					bpptree_cursor_load(bCursor, bpptree);
+				}
+			}
+
+			break;
+		}
+
+		case predicate_all_records: {
+			if (-1 == bCursor->offset) {
+				ion_bpp_err_t bErr = b_snapshot_find_next_key(bpptree->tree, bCursor->snapshot, bCursor->cur_key, &bCursor->offset);
+
+				if (!bpptree_cursor_moved(cursor, bErr)) {
+					is_valid = boolean_false;
+				}
+				else {
+					bpptree_cursor_load(bCursor, bpptree);
+				}
+			}
+
+			break;
+		}
+
+		case predicate_predicate: {
+			break;
+		}
+			/*No default since we can assume the predicate is valid. */
+	}
+
+	return is_valid;
+}
+
 /**
 @brief		Next function to query and retrieve the next
 			<K,V> that stratifies the predicate of the cursor.
@@ -420,8 +2073,8 @@ bpptree_update(
 				by the user.
 @return		The status of the cursor.
 */
-ion_cursor_status_t
-bpptree_next(
+static ion_cursor_status_t
+bpptree_next_record(
 	ion_dict_cursor_t	*cursor,
 	ion_record_t		*record
 ) {
@@ -436,51 +2089,11 @@ bpptree_next(
 	}
 	else if ((cursor->status == cs_cursor_initialized) || (cursor->status == cs_cursor_active)) {
 		if (cursor->status == cs_cursor_active) {
-			ion_boolean_t is_valid = boolean_true;
-
-			switch (cursor->predicate->type) {
-				case predicate_equality: {
-					if (-1 == bCursor->offset) {
-						/* End of results, we can quit */
-						is_valid = boolean_false;
-					}
-
-					break;
-				}
-
-				case predicate_range: {
-					/*do b_find_next_key then test_predicate */
-					if (-1 == bCursor->offset) {
-						ion_bpp_err_t bErr = b_find_next_key(bpptree->tree, bCursor->cur_key, &bCursor->offset);
-
-						if ((bErrOk != bErr) || (boolean_false == test_predicate(cursor, bCursor->cur_key))) {
-							is_valid = boolean_false;
-						}
-					}
-
-					break;
-				}
-
-				case predicate_all_records: {
-					if (-1 == bCursor->offset) {
-						ion_bpp_err_t bErr = b_find_next_key(bpptree->tree, bCursor->cur_key, &bCursor->offset);
-
-						if (bErrOk != bErr) {
-							is_valid = boolean_false;
-						}
-					}
-
-					break;
-				}
-
-				case predicate_predicate: {
-					break;
+			if (boolean_false == bpptree_advance_cursor(cursor)) {
+				if (cursor->status == cs_cursor_active) {
+					cursor->status = cs_end_of_results;
 				}
-					/*No default since we can assume the predicate is valid. */
-			}
 
-			if (boolean_false == is_valid) {
-				cursor->status = cs_end_of_results;
 				return cursor->status;
 			}
 		}
@@ -493,13 +2106,89 @@ bpptree_next(
 		memcpy(record->key, bCursor->cur_key, cursor->dictionary->instance->record.key_size);
 
 		/* Get value */
-		lfb_get(&(bpptree->values), bCursor->offset, cursor->dictionary->instance->record.value_size, record->value, &bCursor->offset);
+		bpptree_cursor_value(bCursor, bpptree, record->value);
 		return cursor->status;
 	}
 
 	return cs_invalid_cursor;
 }
 
+ion_cursor_status_t
+bpptree_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_bpptree_t		*bpptree = (ion_bpptree_t *) cursor->dictionary->instance;
+	ion_cursor_status_t status;
+
+	bpptree_lock_reading(bpptree);
+	status = bpptree_next_record(cursor, record);
+	bpptree_unlock_reading(bpptree);
+
+	return status;
+}
+
+/**
+@brief		Copies the next records that satisfy the predicate of the
+			cursor into a buffer, walking the leaf chain of the tree
+			directly rather than returning one record per call.
+@param		cursor
+				The cursor to iterate over the results.
+@param		buffer
+				Room for @p capacity rows, each a key followed by
+				its value.
+@param		capacity
+				The most records to copy.
+@param		count
+				Set to the number of records copied.
+@return		@ref cs_cursor_active if any records were copied,
+			otherwise the status of the cursor.
+*/
+ion_cursor_status_t
+bpptree_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			*buffer,
+	ion_result_count_t	capacity,
+	ion_result_count_t	*count
+) {
+	ion_bpp_cursor_t	*bCursor	= (ion_bpp_cursor_t *) cursor;
+	ion_bpptree_t		*bpptree	= (ion_bpptree_t *) cursor->dictionary->instance;
+	ion_key_size_t		key_size	= bpptree->super.record.key_size;
+	ion_value_size_t	value_size	= bpptree->super.record.value_size;
+	ion_byte_t			*row		= buffer;
+
+	*count = 0;
+
+	if ((cursor->status != cs_cursor_initialized) && (cursor->status != cs_cursor_active)) {
+		return cursor->status;
+	}
+
+	bpptree_lock_reading(bpptree);
+
+	while (*count < capacity) {
+		if (cursor->status == cs_cursor_initialized) {
+			cursor->status = cs_cursor_active;
+		}
+		else if (boolean_false == bpptree_advance_cursor(cursor)) {
+			if (cursor->status == cs_cursor_active) {
+				cursor->status = cs_end_of_results;
+			}
+
+			break;
+		}
+
+		memcpy(row, bCursor->cur_key, key_size);
+		bpptree_cursor_value(bCursor, bpptree, row + key_size);
+
+		row += key_size + value_size;
+		(*count)++;
+	}
+
+	bpptree_unlock_reading(bpptree);
+
+	return 0 < *count ? cs_cursor_active : cursor->status;
+}
+
 /**
 @brief		Destroys the cursor.
 
@@ -516,6 +2205,7 @@ void
 bpptree_destroy_cursor(
 	ion_dict_cursor_t **cursor
 ) {
+	bpptree_release((ion_bpptree_t *) (*cursor)->dictionary->instance, ((ion_bpp_cursor_t *) (*cursor))->snapshot);
 	(*cursor)->predicate->destroy(&(*cursor)->predicate);
 	free(((ion_bpp_cursor_t *) (*cursor))->cur_key);
 	free((*cursor));
@@ -540,8 +2230,8 @@ bpptree_destroy_cursor(
 @return		The status of the operation.
 */
 
-ion_err_t
-bpptree_find(
+static ion_err_t
+bpptree_find_first(
 	ion_dictionary_t	*dictionary,
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
@@ -557,7 +2247,11 @@ bpptree_find(
 
 	ion_bpp_cursor_t *bCursor = (ion_bpp_cursor_t *) (*cursor);
 
-	bCursor->cur_key = malloc(key_size);
+	/* room for an inline value after the key, then for a block of a posting list */
+	bCursor->cur_key	= malloc(key_size + (NULL != bpptree->entry ? dictionary->instance->record.value_size : 0) + bpptree->posting_size);
+	bCursor->cur_value	= (ion_byte_t *) bCursor->cur_key + key_size;
+	bCursor->block		= (ion_byte_t *) bCursor->cur_value + (NULL != bpptree->entry ? dictionary->instance->record.value_size : 0);
+	bCursor->held		= 0;
 
 	if (NULL == bCursor->cur_key) {
 		free(bCursor);
@@ -569,6 +2263,8 @@ bpptree_find(
 
 	(*cursor)->destroy		= bpptree_destroy_cursor;
 	(*cursor)->next			= bpptree_next;
+	(*cursor)->next_batch	= bpptree_next_batch;
+	(*cursor)->next_ref		= NULL;
 
 	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
 
@@ -578,6 +2274,16 @@ bpptree_find(
 		return err_out_of_memory;
 	}
 
+	/* the cursor reads the tree as it is now, whatever is written later */
+	if (bErrOk != b_snapshot(bpptree->tree, &bCursor->snapshot)) {
+		free((*cursor)->predicate);
+		free(bCursor->cur_key);
+		free(*cursor);
+		return err_out_of_memory;
+	}
+
+	bpptree->snapshots++;
+
 	(*cursor)->predicate->type		= predicate->type;
 	(*cursor)->predicate->destroy	= predicate->destroy;
 
@@ -588,6 +2294,7 @@ bpptree_find(
 			(*cursor)->predicate->statement.equality.equality_value = malloc(key_size);
 
 			if (NULL == (*cursor)->predicate->statement.equality.equality_value) {
+				bpptree_release(bpptree, bCursor->snapshot);
 				free((*cursor)->predicate);
 				free(bCursor->cur_key);
 				free(*cursor);
@@ -596,16 +2303,15 @@ bpptree_find(
 
 			memcpy((*cursor)->predicate->statement.equality.equality_value, target_key, key_size);
 
-			memcpy(bCursor->cur_key, target_key, key_size);
+			ion_bpp_err_t err = b_snapshot_find_first_greater_or_equal(bpptree->tree, bCursor->snapshot, target_key, bCursor->cur_key, &bCursor->offset);
 
-			ion_bpp_err_t err = b_get(bpptree->tree, target_key, &bCursor->offset);
-
-			if (bErrOk != err) {
+			if ((bErrOk != err) || (0 != bpptree->super.compare(bCursor->cur_key, target_key, key_size))) {
 				/* If this happens, that means the target key doesn't exist */
 				(*cursor)->status = cs_end_of_results;
 				return err_ok;
 			}
 			else {
+				bpptree_cursor_load(bCursor, bpptree);
 				(*cursor)->status = cs_cursor_initialized;
 				return err_ok;
 			}
@@ -617,6 +2323,7 @@ bpptree_find(
 			(*cursor)->predicate->statement.range.lower_bound = malloc(key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.lower_bound) {
+				bpptree_release(bpptree, bCursor->snapshot);
 				free((*cursor)->predicate);
 				free(bCursor->cur_key);
 				free(*cursor);
@@ -628,6 +2335,7 @@ bpptree_find(
 			(*cursor)->predicate->statement.range.upper_bound = malloc(key_size);
 
 			if (NULL == (*cursor)->predicate->statement.range.upper_bound) {
+				bpptree_release(bpptree, bCursor->snapshot);
 				free((*cursor)->predicate->statement.range.lower_bound);
 				free((*cursor)->predicate);
 				free(bCursor->cur_key);
@@ -638,14 +2346,15 @@ bpptree_find(
 			memcpy((*cursor)->predicate->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
 
 			/* We search for the FGEQ of the Lower bound. */
-			b_find_first_greater_or_equal(bpptree->tree, (*cursor)->predicate->statement.range.lower_bound, bCursor->cur_key, &bCursor->offset);
+			ion_bpp_err_t err = b_snapshot_find_first_greater_or_equal(bpptree->tree, bCursor->snapshot, (*cursor)->predicate->statement.range.lower_bound, bCursor->cur_key, &bCursor->offset);
 
 			/* If the key returned doesn't satisfy the predicate, we can exit */
-			if (boolean_false == test_predicate(*cursor, bCursor->cur_key)) {
+			if ((bErrOk != err) || (boolean_false == test_predicate(*cursor, bCursor->cur_key))) {
 				(*cursor)->status = cs_end_of_results;
 				return err_ok;
 			}
 			else {
+				bpptree_cursor_load(bCursor, bpptree);
 				(*cursor)->status = cs_cursor_initialized;
 				return err_ok;
 			}
@@ -657,13 +2366,16 @@ bpptree_find(
 			ion_bpp_err_t err;
 
 			/* We search for first key in B++ tree. */
-			err					= b_find_first_key(bpptree->tree, bCursor->cur_key, &bCursor->offset);
+			err					= b_snapshot_find_first_key(bpptree->tree, bCursor->snapshot, bCursor->cur_key, &bCursor->offset);
 
 			(*cursor)->status	= cs_cursor_initialized;
 
 			if (bErrOk != err) {
 				(*cursor)->status = cs_end_of_results;
 			}
+			else {
+				bpptree_cursor_load(bCursor, bpptree);
+			}
 
 			return err_ok;
 			break;
@@ -674,6 +2386,7 @@ bpptree_find(
 		}
 
 		default: {
+			bpptree_release(bpptree, bCursor->snapshot);
 			return err_invalid_predicate;
 			break;
 		}
@@ -682,6 +2395,22 @@ bpptree_find(
 	return err_ok;
 }
 
+ion_err_t
+bpptree_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_bpptree_t	*bpptree = (ion_bpptree_t *) dictionary->instance;
+	ion_err_t		err;
+
+	bpptree_lock_reading(bpptree);
+	err = bpptree_find_first(dictionary, predicate, cursor);
+	bpptree_unlock_reading(bpptree);
+
+	return err;
+}
+
 /**
 @brief			Opens a specific BppTree instance of a dictionary.
 
@@ -712,8 +2441,11 @@ bpptree_init(
 	ion_dictionary_handler_t *handler
 ) {
 	handler->insert				= bpptree_insert;
+	handler->insert_batch		= bpptree_insert_batch;
 	handler->create_dictionary	= bpptree_create_dictionary;
 	handler->get				= bpptree_get;
+	handler->get_many			= bpptree_get_many;
+	handler->get_ref			= NULL;
 	handler->update				= bpptree_update;
 	handler->find				= bpptree_find;
 	handler->remove				= bpptree_delete;
@@ -721,4 +2453,8 @@ bpptree_init(
 	handler->destroy_dictionary = bpptree_destroy_dictionary;
 	handler->open_dictionary	= bpptree_open_dictionary;
 	handler->close_dictionary	= bpptree_close_dictionary;
+	handler->sync				= bpptree_sync_dictionary;
+	handler->hold				= bpptree_hold_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_true;
 }
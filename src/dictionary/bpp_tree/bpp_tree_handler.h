@@ -46,17 +46,150 @@ extern "C" {
 #include "../../key_value/kv_system.h"
 #include "../../file/linked_file_bag.h"
 #include "bpp_tree.h"
+#include "bpp_buffer_pool.h"
+
+/**
+@brief		The number of values staged in memory by a batch insert before
+			they are appended to the value file in a single write.
+*/
+#if !defined(ION_BPP_BATCH_RECORDS)
+#define ION_BPP_BATCH_RECORDS 32
+#endif
+
+/**
+@brief		When non-zero, B+ trees with string keys are created with packed,
+			prefix compressed nodes. See @ref b_open.
+
+@details	The setting is kept in the index file, so a tree is always
+			reopened with the setting it was created with.
+*/
+#if !defined(ION_BPP_PREFIX_COMPRESSION)
+#define ION_BPP_PREFIX_COMPRESSION 0
+#endif
+
+/**
+@brief		The sector size, in bytes, of B+ trees created through
+			@ref dictionary_create.
+
+@details	@ref bpptree_create picks another size for a new tree. Nodes
+			are one sector, so this sets the size of each
+			read, and with it the fan-out and depth of the tree: SD cards
+			favour small sectors, while on a host a page of 4 KiB or more
+			makes for far fewer and larger reads. The size is kept in the
+			header of the index file, so a tree is always reopened with the
+			size it was created with.
+*/
+#if !defined(ION_BPP_SECTOR_SIZE)
+#if defined(ARDUINO)
+#define ION_BPP_SECTOR_SIZE 256
+#else
+#define ION_BPP_SECTOR_SIZE 4096
+#endif
+#endif
+
+/**
+@brief		Values of at most this many bytes are stored in the index,
+			after their key, rather than in the value file.
+
+@details	A lookup or cursor step then costs one read rather than two.
+			Values ride in internal nodes too, so the threshold trades
+			fan-out for those reads. Keys with more than one value keep
+			them in the posting file, see @ref ION_BPP_POSTING_BLOCK_SIZE,
+			and trees with prefix compressed nodes keep theirs in the value
+			file. The setting is kept in the index file, so a tree is
+			always reopened with the layout it was created with.
+*/
+#if !defined(ION_BPP_INLINE_VALUE_SIZE)
+#if defined(ARDUINO)
+#define ION_BPP_INLINE_VALUE_SIZE 16
+#else
+#define ION_BPP_INLINE_VALUE_SIZE 32
+#endif
+#endif
+
+/**
+@brief		The record address of a key whose value is stored inline.
+*/
+#define ION_BPP_VALUE_INLINE (-2)
+
+/**
+@brief		The size, in bytes, of the blocks that pack the values of a key
+			with more than one value.
+
+@details	A key's second value moves its values to the posting file,
+			where they are kept in a list of blocks, each holding as many
+			values as fit. Reading, updating or deleting every value of the
+			key then costs a read per block rather than one per value. The
+			number of values a block holds is kept in the posting file, so
+			a tree is always reopened with the blocks it was created with.
+*/
+#if !defined(ION_BPP_POSTING_BLOCK_SIZE)
+#if defined(ARDUINO)
+#define ION_BPP_POSTING_BLOCK_SIZE 64
+#else
+#define ION_BPP_POSTING_BLOCK_SIZE 512
+#endif
+#endif
+
+/**
+@brief		Converts between the offset of a posting list in the posting
+			file and the record address the index keeps for it.
+
+@details	Posting lists are addressed below @ref ION_BPP_VALUE_INLINE, so
+			they can't be mistaken for a value in the value file. The
+			mapping is its own inverse.
+*/
+#define ION_BPP_POSTING(offset) (-3 - (offset))
+
+/**
+@brief		Tells whether a record address is that of a posting list.
+*/
+#define ION_BPP_IS_POSTING(rec) ((rec) <= -3)
 
 typedef struct bplusplustree {
 	ion_dictionary_parent_t super;
 	ion_bpp_handle_t		tree;
 	ion_lfb_t				values;
+	ion_lfb_t				postings;	/**< Blocks of the values of keys with several. */
+	int						posting_values;	/**< Values each block holds. */
+	unsigned int			posting_size;	/**< Bytes in a block, with its next offset. */
+	ion_byte_t				*block;	/**< A block being read or written. */
+	ion_byte_t				*moving;/**< A value being moved into a block. */
+	ion_byte_t				*entry;	/**< A key and its inline value, NULL if values aren't inline. */
+	int						snapshots;	/**< Cursors open, each pinning a snapshot. */
+	ion_file_offset_t		*retired;	/**< Value chains replaced or deleted
+											 while cursors were open, freed
+											 once the last is destroyed. */
+	int						retired_count;	/**< Chains in @p retired. */
+	int						retired_room;	/**< Chains @p retired has room for. */
+#if !defined(ARDUINO)
+	pthread_mutex_t			reading;/**< Held by a reader, since readers sharing
+										 the dictionary lock move the same node
+										 buffers and current key. */
+#endif
 } ion_bpptree_t;
 
+/**
+@brief		Supplies the records of a bulk load.
+
+@details	Points the key and value of @p record at the next record, in
+			ascending key order. They must stay valid until the next call.
+@return		@c boolean_true if a record was supplied, @c boolean_false once
+			there are none left.
+*/
+typedef ion_boolean_t (*ion_bpp_record_stream_t)(
+	void			*context,
+	ion_record_t	*record
+);
+
 typedef struct {
 	ion_dict_cursor_t	super;		/**< Supertype of cursor		*/
 	ion_key_t			cur_key;/**< Current key we're visiting */
+	ion_value_t			cur_value;	/**< Inline value of the current key */
 	ion_file_offset_t	offset;		/**< offset in LFB; holds value */
+	ion_byte_t			*block;		/**< Block of the posting list being read. */
+	int					held;		/**< Values of @p block not yet returned. */
+	ion_bpp_snapshot_t	snapshot;	/**< The view of the tree the cursor reads. */
 } ion_bpp_cursor_t;
 
 /**
@@ -74,6 +207,88 @@ bpptree_init(
 	ion_dictionary_handler_t *handler
 );
 
+/**
+@brief		Creates a B+ tree dictionary with a chosen sector size.
+
+@details	Works like @ref dictionary_create, which creates trees with
+			sectors of @ref ION_BPP_SECTOR_SIZE bytes. The size is kept in
+			the index file, so the tree is reopened with it by
+			@ref dictionary_open or @ref dictionary_create alike.
+
+@param		handler
+				A handler bound with @ref bpptree_init.
+@param		dictionary
+				The dictionary to create.
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to store.
+@param		key_size
+				The size of the keys in bytes.
+@param		value_size
+				The size of the values in bytes.
+@param		sector_size
+				The size of a node in bytes, a multiple of 4 up to
+				@ref ION_BPP_MAX_SECTOR_SIZE. Ignored if the tree exists.
+@return		The resulting error condition. @ref err_uninitialized if the
+			sector size can't hold enough keys of @p key_size.
+*/
+ion_err_t
+bpptree_create(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	int							sector_size
+);
+
+/**
+@brief		Loads an empty B+ tree dictionary from a stream of records.
+
+@details	Records must arrive in ascending key order. The index is built
+			bottom-up, writing each node once, instead of inserting the
+			records one at a time. Records with equal keys are kept as
+			duplicates, just as repeated inserts would keep them.
+
+@param		dictionary
+				The empty dictionary instance to load.
+@param		stream
+				Supplies the records.
+@param		context
+				Passed through to @p stream.
+@param		fill_factor
+				The percentage of each index node to fill. Nodes are never
+				left less than half full.
+@return		The status of the load. The count is the number of records
+			loaded.
+*/
+ion_status_t
+bpptree_bulk_load(
+	ion_dictionary_t		*dictionary,
+	ion_bpp_record_stream_t stream,
+	void					*context,
+	int						fill_factor
+);
+
+/**
+@brief		Rewrites the index of a B+ tree dictionary in key order.
+@details	The leaves are moved to the front of the index file in key
+			order, so that cursors read it sequentially, and the nodes
+			freed by deletes are dropped. Cursors read a snapshot that
+			pins the old layout, so compaction is refused with
+			@ref err_cursor_open while any is open.
+
+@param		dictionary
+				The dictionary instance to compact.
+@return		The status of the compaction.
+*/
+ion_err_t
+bpptree_compact(
+	ion_dictionary_t *dictionary
+);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -34,9 +34,545 @@
 */
 /******************************************************************************/
 
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+/* Needed for pthread_rwlock_t under -std=c99. */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "dictionary.h"
 #include "flat_file/flat_file_dictionary_handler.h"
 
+#if !defined(ARDUINO)
+#include <pthread.h>
+
+struct dictionary_lock {
+	pthread_rwlock_t rwlock;
+	/**< Held shared by readers and exclusively by writers. */
+	void (*destroy_cursor)(
+		ion_dict_cursor_t **
+	);
+	/**< The implementation's cursor destructor. Cursors hold the lock
+		 until they are destroyed, so their destructor is wrapped. */
+};
+#endif
+
+/**
+@brief		Takes the lock of a dictionary in concurrent mode for a read.
+@details	The lock is shared if the implementation's reads leave it
+			untouched, and exclusive otherwise.
+@param		lock
+				The lock to take, or NULL if the dictionary is not in
+				concurrent mode.
+@param		shared
+				Whether the lock may be shared with other readers.
+*/
+static void
+dictionary_lock_read(
+	ion_dictionary_lock_t	*lock,
+	ion_boolean_t			shared
+) {
+#if !defined(ARDUINO)
+
+	if (NULL == lock) {
+		return;
+	}
+
+	if (shared) {
+		pthread_rwlock_rdlock(&lock->rwlock);
+	}
+	else {
+		pthread_rwlock_wrlock(&lock->rwlock);
+	}
+
+#else
+	UNUSED(lock);
+	UNUSED(shared);
+#endif
+}
+
+/**
+@brief		Takes the lock of a dictionary in concurrent mode for a write.
+@param		lock
+				The lock to take, or NULL if the dictionary is not in
+				concurrent mode.
+*/
+static void
+dictionary_lock_write(
+	ion_dictionary_lock_t *lock
+) {
+#if !defined(ARDUINO)
+
+	if (NULL != lock) {
+		pthread_rwlock_wrlock(&lock->rwlock);
+	}
+
+#else
+	UNUSED(lock);
+#endif
+}
+
+/**
+@brief		Takes the lock of a dictionary in concurrent mode for a write, if
+			no other thread holds it.
+@param		lock
+				The lock to take, or NULL if the dictionary is not in
+				concurrent mode.
+@return		Whether the lock was taken, always true for NULL.
+*/
+static ion_boolean_t
+dictionary_try_lock_write(
+	ion_dictionary_lock_t *lock
+) {
+#if !defined(ARDUINO)
+	return (NULL == lock) || (0 == pthread_rwlock_trywrlock(&lock->rwlock));
+#else
+	UNUSED(lock);
+	return boolean_true;
+#endif
+}
+
+/**
+@brief		Releases a lock taken with @ref dictionary_lock_read or
+			@ref dictionary_lock_write.
+@param		lock
+				The lock to release, or NULL if the dictionary is not in
+				concurrent mode.
+*/
+static void
+dictionary_unlock(
+	ion_dictionary_lock_t *lock
+) {
+#if !defined(ARDUINO)
+
+	if (NULL != lock) {
+		pthread_rwlock_unlock(&lock->rwlock);
+	}
+
+#else
+	UNUSED(lock);
+#endif
+}
+
+/**
+@brief		Destroys a cursor made in concurrent mode, releasing the lock it
+			held on its dictionary.
+@param		cursor
+				The cursor to destroy.
+*/
+static void
+dictionary_destroy_locked_cursor(
+	ion_dict_cursor_t **cursor
+) {
+#if !defined(ARDUINO)
+	ion_dictionary_lock_t *lock = (*cursor)->dictionary->lock;
+
+	lock->destroy_cursor(cursor);
+	dictionary_unlock(lock);
+#else
+	UNUSED(cursor);
+#endif
+}
+
+#if !defined(ARDUINO)
+
+/**
+@brief		A cursor over a snapshot made in concurrent mode, which takes
+			the lock of its dictionary only while it runs.
+*/
+typedef struct {
+	ion_dict_cursor_t	super;	/**< Supertype of cursor. */
+	ion_dict_cursor_t	*inner;	/**< The implementation's cursor. */
+} ion_dict_snapshot_cursor_t;
+
+/**
+@brief		Fetches the next record of a snapshot cursor under the lock.
+*/
+static ion_cursor_status_t
+dictionary_snapshot_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_dict_cursor_t *inner = ((ion_dict_snapshot_cursor_t *) cursor)->inner;
+
+	dictionary_lock_read(cursor->dictionary->lock, cursor->dictionary->handler->shared_reads);
+	inner->next(inner, record);
+	cursor->status = inner->status;
+	dictionary_unlock(cursor->dictionary->lock);
+
+	return cursor->status;
+}
+
+/**
+@brief		Fetches the next batch of records of a snapshot cursor under the
+			lock.
+*/
+static ion_cursor_status_t
+dictionary_snapshot_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			*buffer,
+	ion_result_count_t	capacity,
+	ion_result_count_t	*count
+) {
+	ion_dict_cursor_t	*inner = ((ion_dict_snapshot_cursor_t *) cursor)->inner;
+	ion_cursor_status_t status;
+
+	dictionary_lock_read(cursor->dictionary->lock, cursor->dictionary->handler->shared_reads);
+	status			= dictionary_next_batch(inner, buffer, capacity, count);
+	cursor->status	= inner->status;
+	dictionary_unlock(cursor->dictionary->lock);
+
+	return status;
+}
+
+/**
+@brief		Destroys a snapshot cursor under the lock, as releasing the
+			snapshot changes the implementation's state.
+*/
+static void
+dictionary_snapshot_destroy(
+	ion_dict_cursor_t **cursor
+) {
+	ion_dict_snapshot_cursor_t	*wrapper	= (ion_dict_snapshot_cursor_t *) *cursor;
+	ion_dictionary_lock_t		*lock		= (*cursor)->dictionary->lock;
+
+	dictionary_lock_write(lock);
+	wrapper->inner->destroy(&wrapper->inner);
+	dictionary_unlock(lock);
+	free(wrapper);
+	*cursor = NULL;
+}
+
+/**
+@brief		Wraps a cursor over a snapshot made in concurrent mode, so that
+			it takes the lock only while it runs.
+@param		cursor
+				The implementation's cursor, replaced by the wrapper. It is
+				destroyed if the wrapper can't be made.
+@return		The status of wrapping the cursor.
+*/
+static ion_err_t
+dictionary_wrap_snapshot_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_dict_snapshot_cursor_t *wrapper = malloc(sizeof(ion_dict_snapshot_cursor_t));
+
+	if (NULL == wrapper) {
+		(*cursor)->destroy(cursor);
+		return err_out_of_memory;
+	}
+
+	wrapper->super				= **cursor;
+	wrapper->inner				= *cursor;
+	wrapper->super.next			= dictionary_snapshot_next;
+	wrapper->super.next_batch	= dictionary_snapshot_next_batch;
+	wrapper->super.next_ref		= NULL;
+	wrapper->super.destroy		= dictionary_snapshot_destroy;
+	*cursor						= &wrapper->super;
+
+	return err_ok;
+}
+
+#endif
+
+ion_err_t
+dictionary_enable_concurrency(
+	ion_dictionary_t *dictionary
+) {
+#if !defined(ARDUINO)
+	ion_dictionary_lock_t *lock;
+
+	if (NULL != dictionary->lock) {
+		return err_ok;
+	}
+
+	lock = malloc(sizeof(ion_dictionary_lock_t));
+
+	if (NULL == lock) {
+		return err_out_of_memory;
+	}
+
+	if (0 != pthread_rwlock_init(&lock->rwlock, NULL)) {
+		free(lock);
+		return err_uninitialized;
+	}
+
+	lock->destroy_cursor	= NULL;
+	dictionary->lock		= lock;
+
+	return err_ok;
+#else
+	UNUSED(dictionary);
+	return err_not_implemented;
+#endif
+}
+
+/**
+@brief		Leaves concurrent mode, freeing the lock of a dictionary.
+@param		dictionary
+				The dictionary whose lock to free. No other thread may be
+				using it.
+*/
+static void
+dictionary_disable_concurrency(
+	ion_dictionary_t *dictionary
+) {
+#if !defined(ARDUINO)
+
+	if (NULL != dictionary->lock) {
+		pthread_rwlock_destroy(&dictionary->lock->rwlock);
+		free(dictionary->lock);
+		dictionary->lock = NULL;
+	}
+
+#else
+	UNUSED(dictionary);
+#endif
+}
+
+/**
+@brief		Reapplies a change found in the log to the dictionary being
+			attached to it.
+@details	The dictionary's files hold it as it was at its last checkpoint,
+			so the change is made again as it was first made. A change that
+			failed then, as a delete of a missing key, fails the same way.
+*/
+static ion_err_t
+dictionary_wal_apply(
+	void					*context,
+	ion_wal_record_type_t	type,
+	ion_byte_t				*key,
+	ion_byte_t				*value
+) {
+	ion_dictionary_t	*dictionary = context;
+	ion_status_t		status;
+
+	switch (type) {
+		case ion_wal_record_insert: {
+			status = dictionary->handler->insert(dictionary, key, value);
+			break;
+		}
+
+		case ion_wal_record_update: {
+			status = dictionary->handler->update(dictionary, key, value);
+			break;
+		}
+
+		case ion_wal_record_delete: {
+			status = dictionary->handler->remove(dictionary, key);
+			break;
+		}
+
+		default: {
+			return err_ok;
+		}
+	}
+
+	if ((err_item_not_found == status.error) || (err_duplicate_key == status.error)) {
+		return err_ok;
+	}
+
+	return status.error;
+}
+
+/**
+@brief		Writes a dictionary attached to a log through to storage, for a
+			checkpoint.
+@details	The checkpoint holds off every change, so only readers can hold
+			the lock. It is not waited for, as a reader may hold it while it
+			waits for the checkpoint to end, to write. The files are written
+			back through the log, so a crash can't leave them torn.
+@return		err_cursor_open if the lock is held, or the status of the sync.
+*/
+static ion_err_t
+dictionary_wal_sync(
+	void *context
+) {
+	ion_dictionary_t	*dictionary = context;
+	ion_err_t			error;
+
+	if (!dictionary_try_lock_write(dictionary->lock)) {
+		return err_cursor_open;
+	}
+
+	error = dictionary->handler->sync(dictionary);
+
+	if (err_ok == error) {
+		error = ion_wal_write_back(dictionary->wal, dictionary->instance->id, &dictionary->writeback);
+	}
+
+	dictionary_unlock(dictionary->lock);
+
+	return error;
+}
+
+ion_err_t
+dictionary_enable_wal(
+	ion_dictionary_t	*dictionary,
+	ion_wal_t			*wal
+) {
+#if !defined(ARDUINO)
+	ion_err_t error;
+
+	if (NULL != dictionary->wal) {
+		return dictionary->wal == wal ? err_ok : err_duplicate_dictionary_error;
+	}
+
+	/* a checkpoint would lose the changes of a dictionary held in memory */
+	if ((NULL == dictionary->handler->sync) || (NULL == dictionary->handler->hold)) {
+		return err_not_implemented;
+	}
+
+	/* the log starts from files that are on disk, and keeps them as they are until each checkpoint */
+	error = dictionary->handler->sync(dictionary);
+
+	if (err_ok == error) {
+		memset(&dictionary->writeback, 0, sizeof(dictionary->writeback));
+		error = dictionary->handler->hold(dictionary, &dictionary->writeback);
+	}
+
+	/* set before attaching, as a checkpoint may sync the dictionary once it is attached */
+	if (err_ok == error) {
+		dictionary->wal = wal;
+		error			= ion_wal_attach(wal, dictionary->instance->id, dictionary_wal_apply, dictionary_wal_sync, dictionary);
+
+		if (err_ok != error) {
+			dictionary->handler->hold(dictionary, NULL);
+			dictionary->wal = NULL;
+		}
+	}
+	else {
+		dictionary->handler->hold(dictionary, NULL);
+	}
+
+	return error;
+#else
+	UNUSED(dictionary);
+	UNUSED(wal);
+	return err_not_implemented;
+#endif
+}
+
+/**
+@brief		Detaches a dictionary from its log, if it has one.
+@param		dictionary
+				The dictionary to detach.
+@param		sync
+				Whether to write the dictionary through to storage first;
+				false if it is being deleted.
+@return		The status of detaching the dictionary.
+*/
+static ion_err_t
+dictionary_disable_wal(
+	ion_dictionary_t	*dictionary,
+	ion_boolean_t		sync
+) {
+#if !defined(ARDUINO)
+	ion_err_t error = err_ok;
+
+	if (NULL == dictionary->wal) {
+		return err_ok;
+	}
+
+	/* written back as a change, so that no checkpoint writes the log meanwhile */
+	if (sync) {
+		ion_wal_begin(dictionary->wal);
+		dictionary_lock_write(dictionary->lock);
+		error = dictionary->handler->sync(dictionary);
+
+		if (err_ok == error) {
+			error = ion_wal_write_back(dictionary->wal, dictionary->instance->id, &dictionary->writeback);
+		}
+
+		dictionary_unlock(dictionary->lock);
+		ion_wal_end(dictionary->wal);
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_detach(dictionary->wal, dictionary->instance->id);
+	}
+
+	if (err_ok == error) {
+		error = dictionary->handler->hold(dictionary, NULL);
+	}
+
+	if (err_ok == error) {
+		dictionary->wal = NULL;
+	}
+
+	return error;
+#else
+	UNUSED(dictionary);
+	UNUSED(sync);
+	return err_ok;
+#endif
+}
+
+/**
+@brief		Makes a change to a dictionary attached to a log: the change is
+			made, appended to the log if it succeeded, and then committed.
+@details	The change is appended under the write lock, so the log holds the
+			dictionary's changes in the order they were made. A change that
+			failed is not logged, so it cannot fail again when replayed.
+@param		dictionary
+				The dictionary to change.
+@param		type
+				The change to make.
+@param		key
+				The key to change.
+@param		value
+				The value to write, or NULL for a delete.
+@return		The status of the change.
+*/
+static ion_status_t
+dictionary_write_logged(
+	ion_dictionary_t		*dictionary,
+	ion_wal_record_type_t	type,
+	ion_key_t				key,
+	ion_value_t				value
+) {
+#if !defined(ARDUINO)
+	ion_wal_t		*wal = dictionary->wal;
+	ion_wal_lsn_t	lsn;
+	ion_status_t	status;
+	ion_err_t		error;
+
+	ion_wal_begin(wal);
+	dictionary_lock_write(dictionary->lock);
+
+	if (ion_wal_record_insert == type) {
+		status = dictionary->handler->insert(dictionary, key, value);
+	}
+	else if (ion_wal_record_update == type) {
+		status = dictionary->handler->update(dictionary, key, value);
+	}
+	else {
+		status = dictionary->handler->remove(dictionary, key);
+	}
+
+	error = status.error;
+
+	if ((err_ok == error) && (err_ok != (error = ion_wal_append(wal, type, dictionary->instance->id, key, dictionary->instance->record.key_size, value, dictionary->instance->record.value_size, &lsn)))) {
+		status.error = error;
+	}
+
+	dictionary_unlock(dictionary->lock);
+	ion_wal_end(wal);
+
+	/* the lock is released first, so that other writers join the sync */
+	if ((err_ok == error) && (err_ok != (error = ion_wal_commit(wal, lsn)))) {
+		status.error = error;
+	}
+
+	return status;
+#else
+	UNUSED(dictionary);
+	UNUSED(type);
+	UNUSED(key);
+	UNUSED(value);
+	return ION_STATUS_ERROR(err_not_implemented);
+#endif
+}
+
 int
 dictionary_get_filename(
 	ion_dictionary_id_t id,
@@ -87,18 +623,71 @@ dictionary_compare_null_terminated_string(
 
 ion_dictionary_compare_t
 dictionary_switch_compare(
-	ion_key_type_t key_type
+	ion_key_type_t	key_type,
+	ion_key_size_t	key_size
 ) {
 	ion_dictionary_compare_t compare;
 
 	switch (key_type) {
 		case key_type_numeric_signed: {
-			compare = dictionary_compare_signed_value;
+			switch (key_size) {
+				case 1: {
+					compare = dictionary_compare_signed_1;
+					break;
+				}
+
+				case 2: {
+					compare = dictionary_compare_signed_2;
+					break;
+				}
+
+				case 4: {
+					compare = dictionary_compare_signed_4;
+					break;
+				}
+
+				case 8: {
+					compare = dictionary_compare_signed_8;
+					break;
+				}
+
+				default: {
+					compare = dictionary_compare_signed_value;
+					break;
+				}
+			}
+
 			break;
 		}
 
 		case key_type_numeric_unsigned: {
-			compare = dictionary_compare_unsigned_value;
+			switch (key_size) {
+				case 1: {
+					compare = dictionary_compare_unsigned_1;
+					break;
+				}
+
+				case 2: {
+					compare = dictionary_compare_unsigned_2;
+					break;
+				}
+
+				case 4: {
+					compare = dictionary_compare_unsigned_4;
+					break;
+				}
+
+				case 8: {
+					compare = dictionary_compare_unsigned_8;
+					break;
+				}
+
+				default: {
+					compare = dictionary_compare_unsigned_value;
+					break;
+				}
+			}
+
 			break;
 		}
 
@@ -132,9 +721,11 @@ dictionary_create(
 	ion_dictionary_size_t		dictionary_size
 ) {
 	ion_err_t					err;
-	ion_dictionary_compare_t	compare = dictionary_switch_compare(key_type);
+	ion_dictionary_compare_t	compare = dictionary_switch_compare(key_type, key_size);
 
-	err = handler->create_dictionary(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary);
+	dictionary->lock	= NULL;
+	dictionary->wal		= NULL;
+	err					= handler->create_dictionary(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary);
 
 	if (err_ok == err) {
 		dictionary->instance->id	= id;
@@ -153,7 +744,158 @@ dictionary_insert(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->insert(dictionary, key, value);
+	ion_status_t status;
+
+	if (NULL != dictionary->wal) {
+		return dictionary_write_logged(dictionary, ion_wal_record_insert, key, value);
+	}
+
+	dictionary_lock_write(dictionary->lock);
+	status = dictionary->handler->insert(dictionary, key, value);
+	dictionary_unlock(dictionary->lock);
+
+	return status;
+}
+
+ion_status_t
+dictionary_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+) {
+	ion_status_t		status;
+	ion_status_t		single;
+	ion_result_count_t	i;
+	ion_wal_lsn_t		lsn;
+	ion_boolean_t		logged = boolean_false;
+	ion_err_t			error;
+
+	if (NULL != dictionary->wal) {
+		ion_wal_begin(dictionary->wal);
+	}
+
+	dictionary_lock_write(dictionary->lock);
+
+	/* held in memory until a checkpoint, a logged dictionary gains little from a native */
+	/* batch, whose failure does not say which records it applied; each record is logged */
+	/* once it is inserted, and the batch is committed with a single sync */
+	if ((NULL != dictionary->handler->insert_batch) && (NULL == dictionary->wal)) {
+		status = dictionary->handler->insert_batch(dictionary, records, count);
+	}
+	else {
+		status = ION_STATUS_OK(0);
+
+		for (i = 0; i < count; i++) {
+			single = dictionary->handler->insert(dictionary, records[i].key, records[i].value);
+
+			if ((err_ok == single.error) && (NULL != dictionary->wal) && (err_ok == (single.error = ion_wal_append(dictionary->wal, ion_wal_record_insert, dictionary->instance->id, records[i].key, dictionary->instance->record.key_size, records[i].value, dictionary->instance->record.value_size, &lsn)))) {
+				logged = boolean_true;
+			}
+
+			if (err_ok != single.error) {
+				status.error = single.error;
+				break;
+			}
+
+			status.count += single.count;
+		}
+	}
+
+	dictionary_unlock(dictionary->lock);
+
+	if (NULL != dictionary->wal) {
+		ion_wal_end(dictionary->wal);
+
+		if (logged && (err_ok != (error = ion_wal_commit(dictionary->wal, lsn)))) {
+			status.error = error;
+		}
+	}
+
+	return status;
+}
+
+ion_err_t
+dictionary_order_keys(
+	ion_dictionary_parent_t *parent,
+	ion_key_t				*keys,
+	size_t					stride,
+	ion_result_count_t		count,
+	ion_result_count_t		*order
+) {
+	ion_result_count_t	*scratch;
+	ion_result_count_t	*from;
+	ion_result_count_t	*to;
+	ion_result_count_t	*swap;
+	ion_result_count_t	width;
+	ion_result_count_t	left;
+	ion_result_count_t	mid;
+	ion_result_count_t	right;
+	ion_result_count_t	i;
+	ion_result_count_t	j;
+	ion_result_count_t	k;
+	ion_key_t			key_i;
+	ion_key_t			key_j;
+
+	for (i = 0; i < count; i++) {
+		order[i] = i;
+	}
+
+	if (count < 2) {
+		return err_ok;
+	}
+
+	scratch = malloc(sizeof(ion_result_count_t) * count);
+
+	if (NULL == scratch) {
+		return err_out_of_memory;
+	}
+
+	/* Bottom-up merge sort. It is stable, so records sharing a key keep the order they were given in. */
+	from	= order;
+	to		= scratch;
+
+	for (width = 1; width < count; width *= 2) {
+		for (left = 0; left < count; left += 2 * width) {
+			mid		= (left + width < count) ? left + width : count;
+			right	= (left + 2 * width < count) ? left + 2 * width : count;
+			i		= left;
+			j		= mid;
+
+			for (k = left; k < right; k++) {
+				if (i >= mid) {
+					to[k] = from[j++];
+					continue;
+				}
+
+				if (j >= right) {
+					to[k] = from[i++];
+					continue;
+				}
+
+				key_i	= *(ion_key_t *) ((char *) keys + from[i] * stride);
+				key_j	= *(ion_key_t *) ((char *) keys + from[j] * stride);
+
+				if (parent->compare(key_i, key_j, parent->record.key_size) <= 0) {
+					to[k] = from[i++];
+				}
+				else {
+					to[k] = from[j++];
+				}
+			}
+		}
+
+		swap	= from;
+		from	= to;
+		to		= swap;
+	}
+
+	if (from != order) {
+		memcpy(order, from, sizeof(ion_result_count_t) * count);
+	}
+
+	free(scratch);
+
+	return err_ok;
 }
 
 ion_status_t
@@ -162,7 +904,149 @@ dictionary_get(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->get(dictionary, key, value);
+	ion_status_t status;
+
+	dictionary_lock_read(dictionary->lock, dictionary->handler->shared_reads);
+	status = dictionary->handler->get(dictionary, key, value);
+	dictionary_unlock(dictionary->lock);
+
+	return status;
+}
+
+ion_status_t
+dictionary_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	ion_status_t		status;
+	ion_result_count_t	i;
+
+	dictionary_lock_read(dictionary->lock, dictionary->handler->shared_reads);
+
+	if (NULL != dictionary->handler->get_many) {
+		status = dictionary->handler->get_many(dictionary, keys, count, values, statuses);
+		dictionary_unlock(dictionary->lock);
+		return status;
+	}
+
+	status = ION_STATUS_OK(0);
+
+	for (i = 0; i < count; i++) {
+		statuses[i] = dictionary->handler->get(dictionary, keys[i], values[i]);
+
+		if (err_ok == statuses[i].error) {
+			status.count++;
+		}
+		else if (err_item_not_found != statuses[i].error) {
+			status.error = statuses[i].error;
+		}
+	}
+
+	dictionary_unlock(dictionary->lock);
+
+	return status;
+}
+
+ion_status_t
+dictionary_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+) {
+	ion_key_size_t	key_size = dictionary->instance->record.key_size;
+	ion_byte_t		*copy;
+	ion_status_t	status;
+
+	ref->copy	= NULL;
+	ref->lock	= NULL;
+
+	if (NULL != dictionary->handler->get_ref) {
+		/* The record is handed out in place, so it stays locked until it is released. */
+		dictionary_lock_read(dictionary->lock, dictionary->handler->shared_reads);
+		status = dictionary->handler->get_ref(dictionary, key, ref);
+
+		if (err_ok == status.error) {
+			ref->lock = dictionary->lock;
+		}
+		else {
+			dictionary_unlock(dictionary->lock);
+		}
+
+		return status;
+	}
+
+	copy = malloc(key_size + dictionary->instance->record.value_size);
+
+	if (NULL == copy) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	memcpy(copy, key, key_size);
+	status = dictionary_get(dictionary, key, copy + key_size);
+
+	if (err_ok != status.error) {
+		free(copy);
+		return status;
+	}
+
+	ref->key	= copy;
+	ref->value	= copy + key_size;
+	ref->copy	= copy;
+
+	return status;
+}
+
+ion_cursor_status_t
+dictionary_next_ref(
+	ion_dict_cursor_t	*cursor,
+	ion_record_ref_t	*ref
+) {
+	ion_byte_t			*copy;
+	ion_record_t		record;
+	ion_cursor_status_t status;
+
+	ref->copy	= NULL;
+	ref->lock	= NULL;
+
+	if (NULL != cursor->next_ref) {
+		return cursor->next_ref(cursor, ref);
+	}
+
+	copy = malloc(cursor->dictionary->instance->record.key_size + cursor->dictionary->instance->record.value_size);
+
+	if (NULL == copy) {
+		return cs_possible_data_inconsistency;
+	}
+
+	record.key		= copy;
+	record.value	= copy + cursor->dictionary->instance->record.key_size;
+	status			= cursor->next(cursor, &record);
+
+	if ((cs_cursor_active != status) && (cs_cursor_initialized != status)) {
+		free(copy);
+		return status;
+	}
+
+	ref->key	= record.key;
+	ref->value	= record.value;
+	ref->copy	= copy;
+
+	return status;
+}
+
+void
+dictionary_release_ref(
+	ion_record_ref_t *ref
+) {
+	dictionary_unlock(ref->lock);
+	free(ref->copy);
+	ref->key	= NULL;
+	ref->value	= NULL;
+	ref->copy	= NULL;
+	ref->lock	= NULL;
 }
 
 ion_status_t
@@ -171,14 +1055,36 @@ dictionary_update(
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return dictionary->handler->update(dictionary, key, value);
+	ion_status_t status;
+
+	if (NULL != dictionary->wal) {
+		return dictionary_write_logged(dictionary, ion_wal_record_update, key, value);
+	}
+
+	dictionary_lock_write(dictionary->lock);
+	status = dictionary->handler->update(dictionary, key, value);
+	dictionary_unlock(dictionary->lock);
+
+	return status;
 }
 
 ion_err_t
 dictionary_delete_dictionary(
 	ion_dictionary_t *dictionary
 ) {
-	return dictionary->handler->delete_dictionary(dictionary);
+	ion_err_t error = dictionary_disable_wal(dictionary, boolean_false);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	error = dictionary->handler->delete_dictionary(dictionary);
+
+	if (err_ok == error) {
+		dictionary_disable_concurrency(dictionary);
+	}
+
+	return error;
 }
 
 ion_err_t
@@ -200,7 +1106,17 @@ dictionary_delete(
 	ion_dictionary_t	*dictionary,
 	ion_key_t			key
 ) {
-	return dictionary->handler->remove(dictionary, key);
+	ion_status_t status;
+
+	if (NULL != dictionary->wal) {
+		return dictionary_write_logged(dictionary, ion_wal_record_delete, key, NULL);
+	}
+
+	dictionary_lock_write(dictionary->lock);
+	status = dictionary->handler->remove(dictionary, key);
+	dictionary_unlock(dictionary->lock);
+
+	return status;
 }
 
 char
@@ -283,13 +1199,138 @@ dictionary_compare_signed_value(
 	return return_value;
 }
 
+char
+dictionary_compare_unsigned_1(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	uint8_t	first	= *(uint8_t *) first_key;
+	uint8_t	second	= *(uint8_t *) second_key;
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_unsigned_2(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	uint16_t	first;
+	uint16_t	second;
+
+	memcpy(&first, first_key, sizeof(first));
+	memcpy(&second, second_key, sizeof(second));
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_unsigned_4(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	uint32_t	first;
+	uint32_t	second;
+
+	memcpy(&first, first_key, sizeof(first));
+	memcpy(&second, second_key, sizeof(second));
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_unsigned_8(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	uint64_t	first;
+	uint64_t	second;
+
+	memcpy(&first, first_key, sizeof(first));
+	memcpy(&second, second_key, sizeof(second));
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_signed_1(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	int8_t	first	= *(int8_t *) first_key;
+	int8_t	second	= *(int8_t *) second_key;
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_signed_2(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	int16_t	first;
+	int16_t	second;
+
+	memcpy(&first, first_key, sizeof(first));
+	memcpy(&second, second_key, sizeof(second));
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_signed_4(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	int32_t	first;
+	int32_t	second;
+
+	memcpy(&first, first_key, sizeof(first));
+	memcpy(&second, second_key, sizeof(second));
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
+char
+dictionary_compare_signed_8(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+) {
+	int64_t	first;
+	int64_t	second;
+
+	memcpy(&first, first_key, sizeof(first));
+	memcpy(&second, second_key, sizeof(second));
+
+	UNUSED(key_size);
+	return (first > second) - (first < second);
+}
+
 ion_err_t
 dictionary_open(
 	ion_dictionary_handler_t		*handler,
 	ion_dictionary_t				*dictionary,
 	ion_dictionary_config_info_t	*config
 ) {
-	ion_dictionary_compare_t compare	= dictionary_switch_compare(config->type);
+	ion_dictionary_compare_t compare	= dictionary_switch_compare(config->type, config->key_size);
+
+	dictionary->lock	= NULL;
+	dictionary->wal		= NULL;
 
 	ion_err_t error						= handler->open_dictionary(handler, dictionary, config, compare);
 
@@ -376,7 +1417,13 @@ dictionary_close(
 		return err_ok;
 	}
 
-	ion_err_t error = dictionary->handler->close_dictionary(dictionary);
+	ion_err_t error = dictionary_disable_wal(dictionary, boolean_true);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	error = dictionary->handler->close_dictionary(dictionary);
 
 	if (err_not_implemented == error) {
 		ion_predicate_t		predicate;
@@ -445,6 +1492,7 @@ dictionary_close(
 	}
 
 	if (err_ok == error) {
+		dictionary_disable_concurrency(dictionary);
 		dictionary->status = ion_dictionary_status_closed;
 	}
 
@@ -564,7 +1612,69 @@ dictionary_find(
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
 ) {
-	return dictionary->handler->find(dictionary, predicate, cursor);
+	ion_err_t error;
+
+	/* In concurrent mode the cursor holds the lock until it is destroyed,
+	   unless it reads a snapshot. */
+	dictionary_lock_read(dictionary->lock, dictionary->handler->shared_reads);
+	error = dictionary->handler->find(dictionary, predicate, cursor);
+
+	if (NULL == dictionary->lock) {
+		return error;
+	}
+
+	if (err_ok != error) {
+		dictionary_unlock(dictionary->lock);
+		return error;
+	}
+
+#if !defined(ARDUINO)
+
+	if (dictionary->handler->snapshot_cursors) {
+		error = dictionary_wrap_snapshot_cursor(cursor);
+		dictionary_unlock(dictionary->lock);
+		return error;
+	}
+
+	dictionary->lock->destroy_cursor	= (*cursor)->destroy;
+	(*cursor)->destroy					= dictionary_destroy_locked_cursor;
+#endif
+
+	return error;
+}
+
+ion_cursor_status_t
+dictionary_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			*buffer,
+	ion_result_count_t	capacity,
+	ion_result_count_t	*count
+) {
+	ion_cursor_status_t status;
+	ion_record_t		record;
+	int					row_size;
+
+	if (NULL != cursor->next_batch) {
+		return cursor->next_batch(cursor, buffer, capacity, count);
+	}
+
+	row_size	= cursor->dictionary->instance->record.key_size + cursor->dictionary->instance->record.value_size;
+	status		= cursor->status;
+	*count		= 0;
+
+	while (*count < capacity) {
+		record.key		= buffer + *count * row_size;
+		record.value	= (ion_byte_t *) record.key + cursor->dictionary->instance->record.key_size;
+		status			= cursor->next(cursor, &record);
+
+		if ((cs_cursor_active != status) && (cs_cursor_initialized != status)) {
+			break;
+		}
+
+		(*count)++;
+	}
+
+	return 0 < *count ? cs_cursor_active : status;
 }
 
 ion_boolean_t
@@ -98,6 +98,69 @@ dictionary_create(
 	ion_dictionary_size_t		dictionary_size
 );
 
+/**
+@brief		Puts a dictionary into concurrent mode, so that it may be used from
+			several threads at once.
+@details	Reads (get, get_many, find) take a shared lock and writes (insert,
+			update, delete) an exclusive one. Implementations whose reads
+			change internal state, such as a page cache or the current file
+			position, take the exclusive lock for reads as well. Cursors hold
+			the lock until they are destroyed, and references handed out in
+			place by @ref dictionary_get_ref until they are released, so a
+			thread must release them before writing to the same dictionary.
+			Implementations whose cursors read a snapshot, such as the B+
+			tree, instead take the lock only while a cursor fetches, so
+			writes may run while it is open without changing what it
+			returns.
+			The lock is freed when the dictionary is closed or deleted, which
+			must not race with any other operation. Concurrent mode is not
+			available on Arduino.
+@param		dictionary
+				An open dictionary that no other thread is using yet.
+@return		The status of enabling concurrent mode.
+*/
+ion_err_t
+dictionary_enable_concurrency(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Writes the changes of a dictionary to a write-ahead log, after
+			first replaying the changes the log holds for it.
+@details	Each insert, update and delete that succeeds is appended to the
+			log once it is made, and returns once the log is synced to
+			storage. Writers committing at the same time share one sync, so
+			in concurrent mode throughput grows with the number of writing
+			threads. A commit that grows the log past its limit checkpoints
+			it: every dictionary attached is synced and the log emptied,
+			which waits for changes in progress. A dictionary whose lock a
+			reader holds then, as an open cursor does, is not synced, and
+			keeps its records in the log until a later checkpoint. The
+			dictionary is synced before it is attached, and from then on
+			holds its writes in memory until it is next written back, so
+			its files stay as they were at its last checkpoint. Its pages
+			are written back through the log, which repairs them if a crash
+			cuts the write short, so the log must be opened before the
+			dictionary is. Each write back is marked in the log, and replay
+			makes every change logged for the dictionary's id since the mark
+			again, in order, so the log may be shared by any number of
+			dictionaries with distinct ids.
+			Closing the dictionary syncs it and detaches it from the log.
+			Only dictionaries kept in files can be logged, and not on
+			Arduino.
+@param		dictionary
+				An open dictionary that no other thread is using yet, opened
+				from the files the dictionary was last left in.
+@param		wal
+				The log, from @ref ion_wal_open.
+@return		The status of replaying the log.
+*/
+ion_err_t
+dictionary_enable_wal(
+	ion_dictionary_t	*dictionary,
+	ion_wal_t			*wal
+);
+
 /**
 @brief		Insert a value into a dictionary.
 
@@ -116,6 +179,66 @@ dictionary_insert(
 	ion_value_t			value
 );
 
+/**
+@brief		Insert a batch of records into a dictionary.
+@details	Implementations that provide a native batch insert group their
+			writes by page or bucket, and may apply the records in another
+			order: a B+ tree applies them in key order, a linear hash bucket
+			by bucket and a sharded dictionary shard by shard. Records with
+			equal keys keep their order, so a batch that succeeds leaves the
+			same records as calling @ref dictionary_insert for each of them.
+			When a native batch fails, the count says how many records were
+			inserted but not which: some that follow the failing record may
+			have been inserted, and some that precede it may not.
+			Dictionaries without a native batch insert, and any with a
+			write-ahead log, insert the records one at a time in the order
+			given, stopping at the first record that fails.
+@param		dictionary
+				The dictionary that the records are to be inserted to.
+@param		records
+				An array of @p count records to insert.
+@param		count
+				The number of records in @p records.
+@returns	A status describing the result of the insertion. The count is
+			the number of records inserted.
+*/
+ion_status_t
+dictionary_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+);
+
+/**
+@brief		Compute the order in which to visit a set of keys so that equal
+			and neighbouring keys are visited together.
+@details	Used by batch operations to group work per page or bucket. The
+			sort is stable.
+@param		parent
+				The dictionary instance whose comparison function orders
+				the keys.
+@param		keys
+				A pointer to the first key. Successive keys are found every
+				@p stride bytes, so this can point into an array of keys or
+				into an array of records.
+@param		stride
+				The distance, in bytes, between successive keys.
+@param		count
+				The number of keys.
+@param		order
+				An array of @p count indices that is written back in
+				ascending key order.
+@return		The status of the sort.
+*/
+ion_err_t
+dictionary_order_keys(
+	ion_dictionary_parent_t *parent,
+	ion_key_t				*keys,
+	size_t					stride,
+	ion_result_count_t		count,
+	ion_result_count_t		*order
+);
+
 /**
 @brief		Retrieve a value given a key.
 
@@ -134,6 +257,91 @@ dictionary_get(
 	ion_value_t			value
 );
 
+/**
+@brief		Retrieve the values for many keys at once.
+@details	Implementations that provide a native multi-key get reorder the
+			lookups internally so that each page or bucket is visited once.
+			Results are always written back in the order the keys were
+			given.
+@param		dictionary
+				A pointer to the dictionary to search.
+@param		keys
+				An array of @p count keys to retrieve values for.
+@param		count
+				The number of keys in @p keys.
+@param		values
+				An array of @p count pointers. Each must point to enough
+				space to hold one value. The value for @p keys[i] is copied
+				into @p values[i].
+@param		statuses
+				An array of @p count statuses. The status of the lookup of
+				@p keys[i] is written to @p statuses[i].
+@return		A status describing the result of the retrieval. The count is
+			the number of keys that were found. A key that was not found
+			does not make the whole call an error.
+*/
+ion_status_t
+dictionary_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+);
+
+/**
+@brief		Retrieve a record without copying its value out.
+@details	Implementations that keep records in memory hand out pointers
+			straight into their storage; the others copy the record into
+			storage owned by @p ref. The reference stays valid until it is
+			released with @ref dictionary_release_ref, provided the dictionary
+			is not used again in the meantime. In-memory implementations also
+			allow further reads while references are held, but no writes.
+@param		dictionary
+				A pointer to the dictionary to search.
+@param		key
+				The key to retrieve the record for.
+@param		ref
+				Set to reference the record. It only needs to be released
+				if the lookup succeeded.
+@return		A status describing the result of the retrieval.
+*/
+ion_status_t
+dictionary_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+);
+
+/**
+@brief		Fetches the next record from a cursor without copying it out.
+@details	The same rules as for @ref dictionary_get_ref apply. Each record
+			returned must be released before the cursor is advanced again.
+@param		cursor
+				The cursor to fetch the record from.
+@param		ref
+				Set to reference the record. It only needs to be released
+				if the status returned is @ref cs_cursor_active.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+dictionary_next_ref(
+	ion_dict_cursor_t	*cursor,
+	ion_record_ref_t	*ref
+);
+
+/**
+@brief		Releases a reference handed out by @ref dictionary_get_ref or
+			@ref dictionary_next_ref.
+@param		ref
+				The reference to release. Its pointers must not be used
+				afterwards.
+*/
+void
+dictionary_release_ref(
+	ion_record_ref_t *ref
+);
+
 /**
 @brief		Delete a value given a key.
 @param		dictionary
@@ -250,6 +458,191 @@ dictionary_compare_signed_value(
 	ion_key_size_t	key_size
 );
 
+/**
+@brief		Compares two unsigned 1 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_unsigned_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 1 byte long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_unsigned_1(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two unsigned 2 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_unsigned_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 2 bytes long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_unsigned_2(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two unsigned 4 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_unsigned_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 4 bytes long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_unsigned_4(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two unsigned 8 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_unsigned_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 8 bytes long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_unsigned_8(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two signed 1 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_signed_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 1 byte long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_signed_1(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two signed 2 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_signed_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 2 bytes long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_signed_2(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two signed 4 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_signed_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 4 bytes long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_signed_4(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Compares two signed 8 byte numeric keys.
+@details	Loads each key as one native integer instead of walking its
+			bytes. Returns the same values as
+			@ref dictionary_compare_signed_value, which is what
+			@ref dictionary_switch_compare binds for other key sizes.
+@param	  first_key
+				The pointer to the first key in the comparison.
+@param	  second_key
+				The pointer to the second key in the comparison.
+@param	  key_size
+				Ignored; the keys are always 8 bytes long.
+@return		The resulting comparison value.
+*/
+char
+dictionary_compare_signed_8(
+	ion_key_t		first_key,
+	ion_key_t		second_key,
+	ion_key_size_t	key_size
+);
+
+/**
+@brief		Picks the comparison function for a key type and size.
+@details	Fixed size numeric keys of 1, 2, 4 or 8 bytes get a comparator
+			specialized for their width. Other numeric sizes fall back to
+			the byte-wise comparators.
+@param		key_type
+				The type of the keys to compare.
+@param		key_size
+				The size of the keys in bytes.
+@return		The comparison function to use.
+*/
+ion_dictionary_compare_t
+dictionary_switch_compare(
+	ion_key_type_t	key_type,
+	ion_key_size_t	key_size
+);
+
 /**
 @brief		Opens a dictionary, given the desired config.
 @param		handler
@@ -326,6 +719,33 @@ dictionary_find(
 	ion_dict_cursor_t	**cursor
 );
 
+/**
+@brief		Fetches the next batch of records from a cursor.
+@details	Records are copied into @p buffer back to back, each as a key of
+			the dictionary's key size followed by a value of its value size.
+			Cursors of implementations that can walk their storage directly
+			fill the buffer natively; otherwise @p next is called once per
+			record. A batch may hold fewer than @p capacity records even
+			when more remain.
+@param		cursor
+				The cursor to fetch records from.
+@param		buffer
+				Room for @p capacity rows of key and value.
+@param		capacity
+				The most records to fetch.
+@param		count
+				Set to the number of records fetched.
+@return		@ref cs_cursor_active if any records were fetched, otherwise
+			the status of the cursor, such as @ref cs_end_of_results.
+*/
+ion_cursor_status_t
+dictionary_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			*buffer,
+	ion_result_count_t	capacity,
+	ion_result_count_t	*count
+);
+
 /**
 @brief		Tests the supplied @p key against the predicate registered in the
 			@p cursor. If the supplied @p cursor if of the type equality, the key is tested for equality with that
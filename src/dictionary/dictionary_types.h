@@ -43,6 +43,7 @@ extern "C" {
 #endif
 
 #include "../key_value/kv_system.h"
+#include "../file/ion_wal.h"
 
 /**
 @brief	  A type used to identify dictionaries, specifically in the master
@@ -77,6 +78,13 @@ typedef struct dictionary ion_dictionary_t;
 */
 typedef struct dictionary_handler ion_dictionary_handler_t;
 
+/**
+@brief		The reader-writer lock guarding a dictionary in concurrent mode.
+@details	Its layout is private to @ref dictionary.c.
+@see		dictionary_enable_concurrency
+*/
+typedef struct dictionary_lock ion_dictionary_lock_t;
+
 /**
 @brief	Function pointer type for dictionary comparison methods.
 */
@@ -199,6 +207,24 @@ typedef struct {
 													dictionary, either closed or ok. */
 } ion_dictionary_config_info_t;
 
+/**
+@brief		A record handed out in place by @ref dictionary_get_ref or
+			@ref dictionary_next_ref.
+@details	When the implementation keeps the record in memory, @p key and
+			@p value point straight into its storage and @p copy is NULL.
+			Otherwise the record is copied into @p copy. Either way the
+			reference must be handed back with @ref dictionary_release_ref.
+*/
+typedef struct {
+	ion_key_t				key;
+	/**< The referenced key. */
+	ion_value_t				value;
+	/**< The referenced value. */
+	void					*copy;	/**< Storage owned by the reference, or NULL. */
+	ion_dictionary_lock_t	*lock;	/**< Lock held until the reference is
+										 released, or NULL. */
+} ion_record_ref_t;
+
 /**
 @brief		A dictionary_handler is responsible for dealing with the specific
 			interface for an underlying dictionary, but is decoupled from a
@@ -211,6 +237,13 @@ struct dictionary_handler {
 		ion_value_t
 	);
 	/**< A pointer to the dictionaries insertion function. */
+	ion_status_t (*insert_batch)(
+		ion_dictionary_t *,
+		ion_record_t *,
+		ion_result_count_t
+	);
+	/**< A pointer to the dictionaries batch insertion function. May be
+		 NULL, in which case records are inserted one at a time. */
 	ion_err_t (*create_dictionary)(
 		ion_dictionary_id_t,
 		ion_key_type_t,
@@ -228,6 +261,22 @@ struct dictionary_handler {
 		ion_value_t
 	);
 	/**< A pointer to the dictionaries get function. */
+	ion_status_t (*get_many)(
+		ion_dictionary_t *,
+		ion_key_t *,
+		ion_result_count_t,
+		ion_value_t *,
+		ion_status_t *
+	);
+	/**< A pointer to the dictionaries multi-key get function. May be
+		 NULL, in which case each key is looked up on its own. */
+	ion_status_t (*get_ref)(
+		ion_dictionary_t *,
+		ion_key_t,
+		ion_record_ref_t *
+	);
+	/**< A pointer to the dictionaries in-place get function. May be
+		 NULL, in which case the record is copied out with get. */
 	ion_status_t (*update)(
 		ion_dictionary_t *,
 		ion_key_t,
@@ -264,6 +313,28 @@ struct dictionary_handler {
 		ion_dictionary_t *
 	);
 	/**< A pointer to the dictionaries close function */
+	ion_err_t (*sync)(
+		ion_dictionary_t *
+	);
+	/**< A pointer to the dictionaries sync function, which writes its
+		 changes through to storage. May be NULL for dictionaries held in
+		 memory. */
+	ion_err_t (*hold)(
+		ion_dictionary_t *,
+		ion_file_writeback_t *
+	);
+	/**< A pointer to the dictionaries function that holds its writes in
+		 memory, registering its files with the given writeback, until
+		 they are written back, so its files stay as they were when last
+		 written back, or lets them through again when given NULL. May be
+		 NULL for dictionaries held in memory. */
+	ion_boolean_t shared_reads;
+	/**< Whether get and find leave the implementation's state untouched,
+		 so that in concurrent mode they may run alongside each other. */
+	ion_boolean_t snapshot_cursors;
+	/**< Whether cursors read the dictionary as it was when they were
+		 found, so that in concurrent mode they need only hold the lock
+		 while they fetch, and writes may run between fetches. */
 };
 
 /**
@@ -277,6 +348,13 @@ struct dictionary {
 											 dictionary (but we don't
 											 know type). */
 	ion_dictionary_handler_t	*handler;	/**< Handler for the specific type. */
+	ion_dictionary_lock_t		*lock;	/**< Lock guarding the dictionary in
+											 concurrent mode, or NULL. */
+	ion_wal_t					*wal;	/**< Log the dictionary's changes are
+											 written to first, or NULL. */
+	ion_file_writeback_t		writeback;	/**< The files holding the
+											 dictionary's writes, while
+											 @p wal is set. */
 };
 
 /**
@@ -408,6 +486,26 @@ struct dictionary_cursor {
 	);
 	/**< A pointer to the next function,
 		 which sets ion_cursor_status_t). */
+	ion_cursor_status_t (*next_batch)(
+		ion_dict_cursor_t *,
+		ion_byte_t *,
+		ion_result_count_t,
+		ion_result_count_t *
+	);
+	/**< A pointer to the batched next function,
+		 which copies up to the given number of
+		 records into a buffer as rows of key
+		 then value. May be NULL, in which case
+		 @ref dictionary_next_batch falls back
+		 to calling next once per record. */
+	ion_cursor_status_t (*next_ref)(
+		ion_dict_cursor_t *,
+		ion_record_ref_t *
+	);
+	/**< A pointer to the in-place next
+		 function. May be NULL, in which case
+		 @ref dictionary_next_ref copies the
+		 record out with next. */
 	void (*destroy)(
 		ion_dict_cursor_t **
 	);
@@ -35,6 +35,7 @@
 /******************************************************************************/
 
 #include "flat_file.h"
+#include "../../file/ion_file.h"
 
 ion_err_t
 flat_file_initialize(
@@ -65,25 +66,26 @@ flat_file_initialize(
 	flat_file->num_buffered				= dictionary_size;
 	flat_file->current_loaded_region	= -1;	/* No loaded region yet */
 
-	flat_file->data_file				= fopen(filename, "r+b");
+	flat_file->data_file				= ion_fopen(filename);
 
-	if (NULL == flat_file->data_file) {
-		/* The file did not exist - lets open to write */
-		flat_file->data_file = fopen(filename, "w+b");
+#if defined(ARDUINO)
 
-		if (NULL == flat_file->data_file) {
-			/* Failed to open, even to create */
-			return err_file_open_error;
-		}
+	if (NULL == flat_file->data_file.file) {
+#else
+
+	if (ION_NOFILE == flat_file->data_file) {
+#endif
+		/* Failed to open, even to create */
+		return err_file_open_error;
 	}
 
 	/* For now, we don't have any header information. But we write some garbage there just so that
 	   we can verify that the code to handle the header is working.*/
-	fwrite(&(int) { 0xADDE }, sizeof(int), 1, flat_file->data_file);
-	flat_file->start_of_data = ftell(flat_file->data_file);
+	ion_fwrite(flat_file->data_file, sizeof(int), (ion_byte_t *) &(int) { 0xADDE });
+	flat_file->start_of_data = ion_ftell(flat_file->data_file);
 
 	if (-1 == flat_file->start_of_data) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err_file_read_error;
 	}
 
@@ -91,21 +93,17 @@ flat_file_initialize(
 	/*				   Bytes:	(1)	 (key_size)   (value_size)	*/
 	flat_file->row_size = sizeof(ion_flat_file_row_status_t) + key_size + value_size;
 	flat_file->buffer	= calloc(flat_file->num_buffered, flat_file->row_size);
+	flat_file->region	= flat_file->buffer;
 
 	if (NULL == flat_file->buffer) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err_out_of_memory;
 	}
 
-	if (0 != fseek(flat_file->data_file, 0, SEEK_END)) {
-		fclose(flat_file->data_file);
-		return err_file_bad_seek;
-	}
-
-	flat_file->eof_position = ftell(flat_file->data_file);
+	flat_file->eof_position = ion_fend(flat_file->data_file);
 
 	if (-1 == flat_file->eof_position) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err_file_read_error;
 	}
 
@@ -115,7 +113,7 @@ flat_file_initialize(
 	ion_err_t			err = flat_file_scan(flat_file, -1, &loc, &row, ION_FLAT_FILE_SCAN_BACKWARDS, flat_file_predicate_not_empty);
 
 	if ((err_ok != err) && (err_file_hit_eof != err)) {
-		fclose(flat_file->data_file);
+		ion_fclose(flat_file->data_file);
 		return err;
 	}
 
@@ -127,6 +125,10 @@ flat_file_initialize(
 	/* Move to its final position as one-past the position found. */
 	flat_file->eof_position = flat_file->start_of_data + (loc + 1) * flat_file->row_size;
 
+#if !defined(ARDUINO)
+	pthread_mutex_init(&flat_file->region_lock, NULL);
+#endif
+
 	return err_ok;
 }
 
@@ -148,7 +150,38 @@ flat_file_destroy(
 		return err_file_delete_error;
 	}
 
-	flat_file->data_file = NULL;
+	flat_file->data_file = ION_NOFILE;
+
+	return err_ok;
+}
+
+/**
+@brief		Loads rows into the region cache.
+@details	Rows are read in place from the mapping of a mapped data file, and otherwise into
+			the row buffer. The caller records which region was loaded.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	location
+				The row index of the first row to load.
+@param[in]	num_rows
+				How many rows to load, at most the number buffered.
+@return		Resulting status of the read.
+*/
+static ion_err_t
+flat_file_load_rows(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location,
+	size_t			num_rows
+) {
+	ion_fpos_t		offset		= flat_file->start_of_data + location * flat_file->row_size;
+	unsigned int	num_bytes	= num_rows * flat_file->row_size;
+
+	flat_file->region = ion_fmap_at(flat_file->data_file, offset, num_bytes);
+
+	if (NULL == flat_file->region) {
+		flat_file->region = flat_file->buffer;
+		return ion_fread_at(flat_file->data_file, offset, num_bytes, flat_file->buffer);
+	}
 
 	return err_ok;
 }
@@ -186,10 +219,6 @@ flat_file_scan(
 	}
 
 	while (cur_offset != end_offset) {
-		if (0 != fseek(flat_file->data_file, cur_offset, SEEK_SET)) {
-			return err_file_bad_seek;
-		}
-
 		/* We set cur_offset to be the next block to read after this next code segment, so */
 		/* we need t save what block we're currently reading now for location calculation purposes */
 		ion_fpos_t	prev_offset				= cur_offset;
@@ -201,13 +230,13 @@ flat_file_scan(
 
 			num_records_to_process = records_left > (unsigned) flat_file->num_buffered ? (unsigned) flat_file->num_buffered : records_left;
 
-			if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
-				return err_file_read_error;
-			}
+			ion_err_t err = flat_file_load_rows(flat_file, (cur_offset - flat_file->start_of_data) / flat_file->row_size, num_records_to_process);
 
-			if (-1 == (cur_offset = ftell(flat_file->data_file))) {
-				return err_file_read_error;
+			if (err_ok != err) {
+				return err;
 			}
+
+			cur_offset += num_records_to_process * flat_file->row_size;
 		}
 		else {
 			/* Move the offset pointer to the next read location, clamp it at start_of_file if we go too far. */
@@ -219,12 +248,10 @@ flat_file_scan(
 				cur_offset				= flat_file->start_of_data;
 			}
 
-			if (0 != fseek(flat_file->data_file, cur_offset, SEEK_SET)) {
-				return err_file_bad_seek;
-			}
+			ion_err_t err = flat_file_load_rows(flat_file, (cur_offset - flat_file->start_of_data) / flat_file->row_size, num_records_to_process);
 
-			if (num_records_to_process != fread(flat_file->buffer, flat_file->row_size, num_records_to_process, flat_file->data_file)) {
-				return err_file_read_error;
+			if (err_ok != err) {
+				return err;
 			}
 
 			/* In this case, the prev_offset is actually the cur_offset. */
@@ -240,9 +267,9 @@ flat_file_scan(
 			size_t cur_rec = i * flat_file->row_size;
 
 			/* This cast is done because in the future, the status could possibly be a non-byte type */
-			row->row_status = *((ion_flat_file_row_status_t *) &flat_file->buffer[cur_rec]);
-			row->key		= &flat_file->buffer[cur_rec + sizeof(ion_flat_file_row_status_t)];
-			row->value		= &flat_file->buffer[cur_rec + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
+			row->row_status = *((ion_flat_file_row_status_t *) &flat_file->region[cur_rec]);
+			row->key		= &flat_file->region[cur_rec + sizeof(ion_flat_file_row_status_t)];
+			row->value		= &flat_file->region[cur_rec + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
 
 			va_list predicate_arguments;
 
@@ -307,7 +334,8 @@ flat_file_predicate_within_bounds(
 			of the write is dependent on the occurence of the writes that come before
 			it. This means that the @p key cannot be @p NULL while the value is not @p NULL.
 			After any call to this function, the internal cache of the flat file is considered
-			to be invalidated.
+			to be invalidated. The row is staged in the row buffer and written at once, so
+			@p row may point into the buffer or the loaded region.
 @param[in]	flat_file
 				Which flat file instance to write to.
 @param[in]	location
@@ -323,27 +351,26 @@ flat_file_write_row(
 	ion_fpos_t			location,
 	ion_flat_file_row_t *row
 ) {
+	size_t num_bytes = sizeof(row->row_status);
+
 	/* Invalidate the region cache, since data will be mutated. */
 	flat_file->current_loaded_region	= -1;
 	flat_file->num_in_buffer			= 0;
 
-	if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
-
-	if (1 != fwrite(&row->row_status, sizeof(row->row_status), 1, flat_file->data_file)) {
-		return err_file_write_error;
-	}
+	/* The key and value may lie in the buffer already, so they are moved rather than copied. */
+	*((ion_flat_file_row_status_t *) flat_file->buffer) = row->row_status;
 
-	if ((NULL != row->key) && (1 != fwrite(row->key, flat_file->super.record.key_size, 1, flat_file->data_file))) {
-		return err_file_write_error;
-	}
+	if (NULL != row->key) {
+		memmove(flat_file->buffer + num_bytes, row->key, flat_file->super.record.key_size);
+		num_bytes += flat_file->super.record.key_size;
 
-	if ((NULL != row->value) && (1 != fwrite(row->value, flat_file->super.record.value_size, 1, flat_file->data_file))) {
-		return err_file_write_error;
+		if (NULL != row->value) {
+			memmove(flat_file->buffer + num_bytes, row->value, flat_file->super.record.value_size);
+			num_bytes += flat_file->super.record.value_size;
+		}
 	}
 
-	return err_ok;
+	return ion_fwrite_at(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, num_bytes, flat_file->buffer);
 }
 
 ion_err_t
@@ -360,26 +387,23 @@ flat_file_read_row(
 	}
 	else {
 		/* Cache miss, have to re-read from file */
-		if (0 != fseek(flat_file->data_file, flat_file->start_of_data + location * flat_file->row_size, SEEK_SET)) {
-			return err_file_bad_seek;
-		}
+		flat_file->current_loaded_region	= -1;
+		flat_file->num_in_buffer			= 0;
 
-		if (1 != fread(flat_file->buffer, sizeof(row->row_status), 1, flat_file->data_file)) {
-			return err_file_write_error;
-		}
+		ion_err_t err = flat_file_load_rows(flat_file, location, 1);
 
-		if (1 != fread(flat_file->buffer + sizeof(row->row_status), flat_file->super.record.key_size, 1, flat_file->data_file)) {
-			return err_file_write_error;
+		if (err_ok != err) {
+			return err;
 		}
 
-		if (1 != fread(flat_file->buffer + sizeof(row->row_status) + flat_file->super.record.key_size, flat_file->super.record.value_size, 1, flat_file->data_file)) {
-			return err_file_write_error;
-		}
+		/* The buffer now holds just this row, so the region it caches shrinks to match. */
+		flat_file->current_loaded_region	= location;
+		flat_file->num_in_buffer			= 1;
 	}
 
-	row->row_status = *((ion_flat_file_row_status_t *) &flat_file->buffer[read_index * flat_file->row_size]);
-	row->key		= &flat_file->buffer[read_index * flat_file->row_size + sizeof(ion_flat_file_row_status_t)];
-	row->value		= &flat_file->buffer[read_index * flat_file->row_size + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
+	row->row_status = *((ion_flat_file_row_status_t *) &flat_file->region[read_index * flat_file->row_size]);
+	row->key		= &flat_file->region[read_index * flat_file->row_size + sizeof(ion_flat_file_row_status_t)];
+	row->value		= &flat_file->region[read_index * flat_file->row_size + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size];
 
 	return err_ok;
 }
@@ -423,7 +447,7 @@ flat_file_insert(
 	}
 
 	/* Record new eof position */
-	flat_file->eof_position = ftell(flat_file->data_file);
+	flat_file->eof_position = ion_ftell(flat_file->data_file);
 
 	if (-1 == flat_file->eof_position) {
 		status.error = err_file_read_error;
@@ -436,10 +460,88 @@ flat_file_insert(
 }
 
 ion_status_t
-flat_file_get(
+flat_file_insert_batch(
+	ion_flat_file_t		*flat_file,
+	ion_record_t		*records,
+	ion_result_count_t	count
+) {
+	ion_status_t		status	= ION_STATUS_OK(0);
+	ion_err_t			err		= err_ok;
+	ion_result_count_t	i		= 0;
+	size_t				staged;
+	ion_byte_t			*row;
+
+	if (count <= 0) {
+		return status;
+	}
+
+	if (flat_file->sorted_mode) {
+		ion_fpos_t			last_record_loc = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size - 1;
+		ion_flat_file_row_t last_row;
+
+		if (last_record_loc >= 0) {
+			err = flat_file_read_row(flat_file, last_record_loc, &last_row);
+
+			if (err_ok != err) {
+				status.error = err;
+				return status;
+			}
+
+			if (flat_file->super.compare(records[0].key, last_row.key, flat_file->super.record.key_size) < 0) {
+				status.error = err_sorted_order_violation;
+				return status;
+			}
+		}
+	}
+
+	/* The row buffer is used to stage the new rows, so the region cache no longer holds valid data. */
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+	if (err_ok != ion_fseek(flat_file->data_file, flat_file->eof_position, ION_FILE_START)) {
+		status.error = err_file_bad_seek;
+		return status;
+	}
+
+	while (i < count && err_ok == err) {
+		for (staged = 0; staged < flat_file->num_buffered && i < count; staged++, i++) {
+			if (flat_file->sorted_mode && (i > 0) && (flat_file->super.compare(records[i].key, records[i - 1].key, flat_file->super.record.key_size) < 0)) {
+				err = err_sorted_order_violation;
+				break;
+			}
+
+			row = flat_file->buffer + staged * flat_file->row_size;
+
+			*((ion_flat_file_row_status_t *) row) = ION_FLAT_FILE_STATUS_OCCUPIED;
+			memcpy(row + sizeof(ion_flat_file_row_status_t), records[i].key, flat_file->super.record.key_size);
+			memcpy(row + sizeof(ion_flat_file_row_status_t) + flat_file->super.record.key_size, records[i].value, flat_file->super.record.value_size);
+		}
+
+		if ((0 != staged) && (err_ok != ion_fwrite(flat_file->data_file, staged * flat_file->row_size, flat_file->buffer))) {
+			err = err_file_write_error;
+			break;
+		}
+
+		status.count += staged;
+	}
+
+	/* Record new eof position */
+	flat_file->eof_position = ion_ftell(flat_file->data_file);
+
+	if (-1 == flat_file->eof_position) {
+		status.error = err_file_read_error;
+		return status;
+	}
+
+	status.error = err;
+	return status;
+}
+
+ion_status_t
+flat_file_get_ref(
 	ion_flat_file_t *flat_file,
 	ion_key_t		key,
-	ion_value_t		value
+	ion_record_t	*record
 ) {
 	ion_status_t		status		= ION_STATUS_INITIALIZE;
 	ion_err_t			err;
@@ -484,13 +586,287 @@ flat_file_get(
 		}
 	}
 
-	memcpy(value, row.value, flat_file->super.record.value_size);
+	record->key		= row.key;
+	record->value	= row.value;
 	status.error	= err_ok;
 	status.count	= 1;
 
 	return status;
 }
 
+ion_status_t
+flat_file_get(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key,
+	ion_value_t		value
+) {
+	ion_record_t	record;
+	ion_status_t	status = flat_file_get_ref(flat_file, key, &record);
+
+	if (err_ok == status.error) {
+		memcpy(value, record.value, flat_file->super.record.value_size);
+	}
+
+	return status;
+}
+
+ion_err_t
+flat_file_load_region(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location
+) {
+	ion_fpos_t	num_rows = (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	size_t		num_records_to_read;
+
+	if ((location < 0) || (location >= num_rows)) {
+		return err_out_of_bounds;
+	}
+
+	num_records_to_read = num_rows - location > (ion_fpos_t) flat_file->num_buffered ? flat_file->num_buffered : (size_t) (num_rows - location);
+
+	/* Invalidate first, in case the read below fails part way through. */
+	flat_file->current_loaded_region	= -1;
+	flat_file->num_in_buffer			= 0;
+
+	ion_err_t err = flat_file_load_rows(flat_file, location, num_records_to_read);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	flat_file->current_loaded_region	= location;
+	flat_file->num_in_buffer			= num_records_to_read;
+
+	return err_ok;
+}
+
+/**
+@brief		Finds the first position in @p order whose key is not less than @p key.
+@param[in]	flat_file
+				Which flat file the keys belong to.
+@param[in]	keys
+				The keys being looked up.
+@param[in]	order
+				The indices of @p keys, in ascending key order.
+@param[in]	count
+				How many keys there are.
+@param[in]	key
+				The key to search for.
+@return		A position in @p order, or @p count if every key is less than @p key.
+*/
+static ion_result_count_t
+flat_file_lower_bound(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			*keys,
+	ion_result_count_t	*order,
+	ion_result_count_t	count,
+	ion_key_t			key
+) {
+	ion_result_count_t	low		= 0;
+	ion_result_count_t	high	= count;
+	ion_result_count_t	mid;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+
+		if (flat_file->super.compare(keys[order[mid]], key, flat_file->super.record.key_size) < 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/**
+@brief		Looks up many keys in a sorted mode flat file.
+@details	Keys are visited in ascending order. A key that falls inside the region currently
+			held in the row buffer is found there with an in-memory binary search. Otherwise,
+			the file is binary searched and the region starting at the result is loaded, so
+			that the keys that follow are likely to be found in memory.
+*/
+static ion_status_t
+flat_file_get_many_sorted(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			*keys,
+	ion_result_count_t	*order,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	ion_status_t		status	= ION_STATUS_OK(0);
+	ion_err_t			err;
+	ion_fpos_t			loc;
+	ion_result_count_t	i;
+	ion_result_count_t	idx;
+	ion_result_count_t	low, high, mid;
+	ion_byte_t			*row;
+	ion_key_t			key;
+	ion_key_size_t		key_size	= flat_file->super.record.key_size;
+	size_t				key_offset	= sizeof(ion_flat_file_row_status_t);
+
+	for (i = 0; i < count; i++) {
+		idx = order[i];
+		key = keys[idx];
+
+		/* Repeated keys share a result. */
+		if ((i > 0) && (0 == flat_file->super.compare(key, keys[order[i - 1]], key_size))) {
+			statuses[idx] = statuses[order[i - 1]];
+
+			if (err_ok == statuses[idx].error) {
+				memcpy(values[idx], values[order[i - 1]], flat_file->super.record.value_size);
+				status.count++;
+			}
+
+			continue;
+		}
+
+		row = NULL;
+
+		/* A key equal to the first row of the region could have duplicates before it, unless the region starts the file. */
+		if ((-1 != flat_file->current_loaded_region) && (0 != flat_file->num_in_buffer)) {
+			char first_cmp = flat_file->super.compare(key, flat_file->region + key_offset, key_size);
+
+			if (((first_cmp > 0) || ((0 == first_cmp) && (0 == flat_file->current_loaded_region))) && (flat_file->super.compare(key, flat_file->region + (flat_file->num_in_buffer - 1) * flat_file->row_size + key_offset, key_size) <= 0)) {
+				low		= 0;
+				high	= flat_file->num_in_buffer;
+
+				while (low < high) {
+					mid = low + (high - low) / 2;
+
+					if (flat_file->super.compare(flat_file->region + mid * flat_file->row_size + key_offset, key, key_size) < 0) {
+						low = mid + 1;
+					}
+					else {
+						high = mid;
+					}
+				}
+
+				row = flat_file->region + low * flat_file->row_size;
+			}
+		}
+
+		if (NULL == row) {
+			err = flat_file_binary_search(flat_file, key, &loc);
+
+			if (err_item_not_found == err) {
+				statuses[idx] = ION_STATUS_ERROR(err_item_not_found);
+				continue;
+			}
+
+			if (err_ok == err) {
+				err = flat_file_load_region(flat_file, loc);
+			}
+
+			if (err_ok != err) {
+				statuses[idx]	= ION_STATUS_ERROR(err);
+				status.error	= err;
+				continue;
+			}
+
+			row = flat_file->region;
+		}
+
+		if (0 != flat_file->super.compare(row + key_offset, key, key_size)) {
+			statuses[idx] = ION_STATUS_ERROR(err_item_not_found);
+			continue;
+		}
+
+		memcpy(values[idx], row + key_offset + key_size, flat_file->super.record.value_size);
+		statuses[idx] = ION_STATUS_OK(1);
+		status.count++;
+	}
+
+	return status;
+}
+
+ion_status_t
+flat_file_get_many(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	ion_status_t		status	= ION_STATUS_OK(0);
+	ion_err_t			err;
+	ion_result_count_t	*order;
+	ion_result_count_t	remaining;
+	ion_result_count_t	i, j;
+	ion_fpos_t			location;
+	ion_fpos_t			num_rows;
+	ion_byte_t			*row;
+	ion_key_size_t		key_size = flat_file->super.record.key_size;
+
+	if (count <= 0) {
+		return status;
+	}
+
+	order = malloc(sizeof(ion_result_count_t) * count);
+
+	if (NULL == order) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	err = dictionary_order_keys(&flat_file->super, keys, sizeof(ion_key_t), count, order);
+
+	if (err_ok != err) {
+		free(order);
+		return ION_STATUS_ERROR(err);
+	}
+
+	if (flat_file->sorted_mode) {
+		status = flat_file_get_many_sorted(flat_file, keys, order, count, values, statuses);
+		free(order);
+		return status;
+	}
+
+	for (i = 0; i < count; i++) {
+		statuses[i] = ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	/* Without sorted mode every get is a full scan, so make that scan once for all of the keys. Each
+	   row is matched against the sorted keys, and the first occurrence of a key wins, as in flat_file_get. */
+	remaining	= count;
+	num_rows	= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+
+	for (location = 0; location < num_rows && remaining > 0; location += flat_file->num_in_buffer) {
+		err = flat_file_load_region(flat_file, location);
+
+		if (err_ok != err) {
+			status.error = err;
+			break;
+		}
+
+		for (j = 0; (size_t) j < flat_file->num_in_buffer && remaining > 0; j++) {
+			row = flat_file->region + j * flat_file->row_size;
+
+			if (ION_FLAT_FILE_STATUS_OCCUPIED != *((ion_flat_file_row_status_t *) row)) {
+				continue;
+			}
+
+			for (i = flat_file_lower_bound(flat_file, keys, order, count, row + sizeof(ion_flat_file_row_status_t)); i < count; i++) {
+				if (0 != flat_file->super.compare(keys[order[i]], row + sizeof(ion_flat_file_row_status_t), key_size)) {
+					break;
+				}
+
+				if (err_ok != statuses[order[i]].error) {
+					memcpy(values[order[i]], row + sizeof(ion_flat_file_row_status_t) + key_size, flat_file->super.record.value_size);
+					statuses[order[i]] = ION_STATUS_OK(1);
+					status.count++;
+					remaining--;
+				}
+			}
+		}
+	}
+
+	free(order);
+
+	return status;
+}
+
 ion_status_t
 flat_file_delete(
 	ion_flat_file_t *flat_file,
@@ -620,18 +996,34 @@ flat_file_update(
 	return status;
 }
 
+ion_err_t
+flat_file_sync(
+	ion_flat_file_t *flat_file
+) {
+	return ion_fsync(flat_file->data_file);
+}
+
+ion_err_t
+flat_file_hold(
+	ion_flat_file_t			*flat_file,
+	ion_file_writeback_t	*writeback
+) {
+	return ion_fhold(flat_file->data_file, writeback);
+}
+
 ion_err_t
 flat_file_close(
 	ion_flat_file_t *flat_file
 ) {
 	free(flat_file->buffer);
-	flat_file->buffer = NULL;
+	flat_file->buffer	= NULL;
+	flat_file->region	= NULL;
 
-	if (0 != fclose(flat_file->data_file)) {
-		return err_file_close_error;
-	}
+#if !defined(ARDUINO)
+	pthread_mutex_destroy(&flat_file->region_lock);
+#endif
 
-	return err_ok;
+	return ion_fclose(flat_file->data_file);
 }
 
 ion_err_t
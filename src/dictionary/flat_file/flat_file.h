@@ -108,6 +108,30 @@ flat_file_insert(
 	ion_value_t		value
 );
 
+/**
+@brief		Inserts a batch of records into the flat file store.
+@details	Rows are staged in the row buffer and appended @p num_buffered at a
+			time, so a batch costs one seek and one write per buffer of rows
+			instead of per record. In sorted mode the batch must continue the
+			existing non-decreasing key order; insertion stops at the first
+			record that would violate it.
+@param[in]	flat_file
+				Which flat file to insert into.
+@param[in]	records
+				The records to insert.
+@param[in]	count
+				How many records are in @p records.
+@return		Resulting status of insertion. The count is the number of
+			records written.
+@see		ffdict_insert_batch
+*/
+ion_status_t
+flat_file_insert_batch(
+	ion_flat_file_t		*flat_file,
+	ion_record_t		*records,
+	ion_result_count_t	count
+);
+
 /**
 @brief		Fetches the record stored with the given @p key.
 @param[in]	flat_file
@@ -126,6 +150,54 @@ flat_file_get(
 	ion_value_t		value
 );
 
+/**
+@brief		Fetches the record stored with the given @p key, without copying it out.
+@details	On success @p record points into the flat file's row buffer. The pointers are
+			only valid until the next operation on the flat file, since any of them may
+			reuse the buffer.
+@param[in]	flat_file
+				Which flat file to look in.
+@param[in]	key
+				Specified key to look for.
+@param[out]	record
+				Set to point at the key and value of the row found.
+@return		Resulting status of the operation.
+@see		ffdict_get_ref
+*/
+ion_status_t
+flat_file_get_ref(
+	ion_flat_file_t *flat_file,
+	ion_key_t		key,
+	ion_record_t	*record
+);
+
+/**
+@brief		Fetches the records stored with each of the given @p keys.
+@details	Without sorted mode, all of the keys are resolved in a single pass over the file,
+			instead of one full scan per key. In sorted mode, the keys are looked up in ascending
+			order so that neighbouring keys are found in the region already loaded in the buffer.
+@param[in]	flat_file
+				Which flat file to look in.
+@param[in]	keys
+				Specified keys to look for.
+@param[in]	count
+				How many keys are in @p keys.
+@param[out]	values
+				Where to write the value found for each key.
+@param[out]	statuses
+				Where to write the status of the lookup of each key.
+@return		Resulting status of the operation. The count is the number of keys found.
+@see		ffdict_get_many
+*/
+ion_status_t
+flat_file_get_many(
+	ion_flat_file_t		*flat_file,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+);
+
 /**
 @brief		Deletes all records stored with the given @p key.
 @param[in]	flat_file
@@ -159,6 +231,33 @@ flat_file_update(
 	ion_value_t		value
 );
 
+/**
+@brief		Writes the flat file through to storage.
+@param		flat_file
+				Which flat file to sync.
+@return		Status of the sync.
+*/
+ion_err_t
+flat_file_sync(
+	ion_flat_file_t *flat_file
+);
+
+/**
+@brief		Holds the writes to the flat file in memory until they are
+			written back, or lets them through again.
+@param		flat_file
+				Which flat file to hold the writes of.
+@param		writeback
+				The files to write back with, or NULL to let writes
+				through.
+@return		Status of holding or letting through the writes.
+*/
+ion_err_t
+flat_file_hold(
+	ion_flat_file_t			*flat_file,
+	ion_file_writeback_t	*writeback
+);
+
 /**
 @brief		Closes and frees any memory associated with the flat file.
 @param		flat_file
@@ -276,6 +375,22 @@ flat_file_read_row(
 	ion_flat_file_row_t *row
 );
 
+/**
+@brief		Loads the region of rows starting at @p location into the buffer.
+@details	Up to @p num_buffered rows are read. Afterwards, @ref flat_file_read_row
+			will serve any of them as a cache hit.
+@param[in]	flat_file
+				Which flat file instance to read from.
+@param[in]	location
+				The row index of the first row to load.
+@return		Resulting status of the several file operations used to perform the read.
+*/
+ion_err_t
+flat_file_load_region(
+	ion_flat_file_t *flat_file,
+	ion_fpos_t		location
+);
+
 /**
 @brief		Performs a binary search for the given @p target_key, returning to @p location
 			the first-less-than-or-equal key within the flat file. This can only be used if
@@ -38,21 +38,95 @@
 #include "flat_file_dictionary_handler.h"
 
 /**
-@brief			Fetches the next record to be returned from a cursor that has already been initialized.
-@details		The returned record is written back to @p record, and then the cursor is advanced to the next
-				record. The returned status code signifies whether or not there are more results to traverse.
-				This function should not be called directly, but instead will be bound to the cursor like a method.
+@brief		Takes the lock guarding a flat file's loaded region.
+@details	Readers may share the dictionary lock, but the region is loaded
+			into a single row buffer, so they take turns with it.
+@param[in]	flat_file
+				Which flat file to lock the region of.
+*/
+static void
+ffdict_lock_region(
+	ion_flat_file_t *flat_file
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_lock(&flat_file->region_lock);
+#else
+	UNUSED(flat_file);
+#endif
+}
+
+/**
+@brief		Releases the lock taken with @ref ffdict_lock_region.
+@param[in]	flat_file
+				Which flat file to unlock the region of.
+*/
+static void
+ffdict_unlock_region(
+	ion_flat_file_t *flat_file
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_unlock(&flat_file->region_lock);
+#else
+	UNUSED(flat_file);
+#endif
+}
+
+/**
+@brief		Points a reference at a row of the loaded region.
+@details	A row read in place from the mapping stays put while the
+			reference holds the dictionary lock, but a row in the row buffer
+			may be loaded over by another reader, so it is copied out.
+@param[in]	flat_file
+				Which flat file the row belongs to.
+@param[in]	row
+				The row to reference.
+@param[out]	ref
+				Set to reference the row.
+@return		The resulting status of the operation.
+*/
+static ion_err_t
+ffdict_reference(
+	ion_flat_file_t		*flat_file,
+	ion_flat_file_row_t *row,
+	ion_record_ref_t	*ref
+) {
+	ion_key_size_t	key_size = flat_file->super.record.key_size;
+	ion_byte_t		*copy;
+
+	if (flat_file->region != flat_file->buffer) {
+		ref->key	= row->key;
+		ref->value	= row->value;
+		return err_ok;
+	}
+
+	copy = malloc(key_size + flat_file->super.record.value_size);
+
+	if (NULL == copy) {
+		return err_out_of_memory;
+	}
+
+	memcpy(copy, row->key, key_size);
+	memcpy(copy + key_size, row->value, flat_file->super.record.value_size);
+	ref->key	= copy;
+	ref->value	= copy + key_size;
+	ref->copy	= copy;
+
+	return err_ok;
+}
+
+/**
+@brief			Advances a cursor onto the next row that satisfies its predicate.
 @param[in]		cursor
-					Which cursor to fetch results from.
-@param[out]		record
-					An initialized record struct with the @p key and @p value appropriately allocated to fit
-					the returned key and value. This function will write back data to the struct.
+					Which cursor to advance.
+@param[out]		row
+					Set to the row the cursor was moved onto. The key and value point into the
+					flat file's loaded region.
 @return			The resulting status of the operation.
 */
-ion_cursor_status_t
-ffdict_next(
+static ion_cursor_status_t
+ffdict_advance(
 	ion_dict_cursor_t	*cursor,
-	ion_record_t		*record
+	ion_flat_file_row_t *row
 ) {
 	ion_flat_file_t			*flat_file			= (ion_flat_file_t *) cursor->dictionary->instance;
 	ion_flat_file_cursor_t	*flat_file_cursor	= (ion_flat_file_cursor_t *) cursor;
@@ -106,21 +180,167 @@ ffdict_next(
 			cursor->status = cs_cursor_active;
 		}
 
-		ion_flat_file_row_t row;
-		ion_err_t			err = flat_file_read_row(flat_file, flat_file_cursor->current_location, &row);
+		ion_err_t err = flat_file_read_row(flat_file, flat_file_cursor->current_location, row);
 
 		if (err_ok != err) {
 			return cs_invalid_index;
 		}
 
+		return cursor->status;
+	}
+
+	return cs_invalid_cursor;
+}
+
+/**
+@brief			Fetches the next record to be returned from a cursor that has already been initialized.
+@details		The returned record is written back to @p record, and then the cursor is advanced to the next
+				record. The returned status code signifies whether or not there are more results to traverse.
+				This function should not be called directly, but instead will be bound to the cursor like a method.
+@param[in]		cursor
+					Which cursor to fetch results from.
+@param[out]		record
+					An initialized record struct with the @p key and @p value appropriately allocated to fit
+					the returned key and value. This function will write back data to the struct.
+@return			The resulting status of the operation.
+*/
+ion_cursor_status_t
+ffdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_flat_file_t		*flat_file = (ion_flat_file_t *) cursor->dictionary->instance;
+	ion_flat_file_row_t row;
+	ion_cursor_status_t status;
+
+	ffdict_lock_region(flat_file);
+	status = ffdict_advance(cursor, &row);
+
+	if (cs_cursor_active == status) {
 		/*Copy both key and value into user provided struct */
 		memcpy(record->key, row.key, cursor->dictionary->instance->record.key_size);
 		memcpy(record->value, row.value, cursor->dictionary->instance->record.value_size);
+	}
+
+	ffdict_unlock_region(flat_file);
+
+	return status;
+}
+
+/**
+@brief			Fetches the next record from a cursor that has already been initialized, without copying it.
+@details		@p ref is pointed at the row in the mapping of a mapped data file, and otherwise at a copy of
+				the row. This function should not be called directly, but instead will be bound to the cursor
+				like a method.
+@param[in]		cursor
+					Which cursor to fetch results from.
+@param[out]		ref
+					Set to point at the key and value of the record.
+@return			The resulting status of the operation.
+*/
+ion_cursor_status_t
+ffdict_next_ref(
+	ion_dict_cursor_t	*cursor,
+	ion_record_ref_t	*ref
+) {
+	ion_flat_file_t		*flat_file = (ion_flat_file_t *) cursor->dictionary->instance;
+	ion_flat_file_row_t row;
+	ion_cursor_status_t status;
+
+	ffdict_lock_region(flat_file);
+	status = ffdict_advance(cursor, &row);
 
+	if ((cs_cursor_active == status) && (err_ok != ffdict_reference(flat_file, &row, ref))) {
+		status = cs_possible_data_inconsistency;
+	}
+
+	ffdict_unlock_region(flat_file);
+
+	return status;
+}
+
+/**
+@brief			Fetches up to @p capacity records from a cursor that has already been initialized.
+@details		Rows are walked forwards one buffered region at a time, so that each region is read from
+				the file once per batch instead of once per record. This function should not be called
+				directly, but instead will be bound to the cursor like a method.
+@param[in]		cursor
+					Which cursor to fetch results from.
+@param[out]		buffer
+					Room for @p capacity rows, each a key followed by its value.
+@param[in]		capacity
+					The most records to fetch.
+@param[out]		count
+					Set to the number of records fetched.
+@return			@ref cs_cursor_active if any records were fetched, otherwise the status of the cursor.
+*/
+ion_cursor_status_t
+ffdict_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			*buffer,
+	ion_result_count_t	capacity,
+	ion_result_count_t	*count
+) {
+	ion_flat_file_t			*flat_file			= (ion_flat_file_t *) cursor->dictionary->instance;
+	ion_flat_file_cursor_t	*flat_file_cursor	= (ion_flat_file_cursor_t *) cursor;
+	ion_key_size_t			key_size			= flat_file->super.record.key_size;
+	ion_value_size_t		value_size			= flat_file->super.record.value_size;
+	ion_fpos_t				num_rows			= (flat_file->eof_position - flat_file->start_of_data) / flat_file->row_size;
+	ion_fpos_t				location;
+	ion_flat_file_row_t		row;
+	ion_err_t				err;
+
+	*count = 0;
+
+	if ((0 == capacity) || ((cursor->status != cs_cursor_initialized) && (cursor->status != cs_cursor_active))) {
 		return cursor->status;
 	}
 
-	return cs_invalid_cursor;
+	location = flat_file_cursor->current_location;
+
+	if (cursor->status == cs_cursor_active) {
+		location++;
+	}
+
+	cursor->status = cs_cursor_active;
+	ffdict_lock_region(flat_file);
+
+	while (*count < capacity) {
+		if (location >= num_rows) {
+			cursor->status = cs_end_of_results;
+			break;
+		}
+
+		if ((-1 == flat_file->current_loaded_region) || (location < flat_file->current_loaded_region) || ((unsigned) location >= flat_file->current_loaded_region + flat_file->num_in_buffer)) {
+			err = flat_file_load_region(flat_file, location);
+
+			if (err_ok != err) {
+				cursor->status = cs_possible_data_inconsistency;
+				break;
+			}
+		}
+
+		err = flat_file_read_row(flat_file, location, &row);
+
+		if (err_ok != err) {
+			cursor->status = cs_invalid_index;
+			break;
+		}
+
+		if ((ION_FLAT_FILE_STATUS_OCCUPIED == row.row_status) && test_predicate(cursor, row.key)) {
+			memcpy(buffer, row.key, key_size);
+			memcpy(buffer + key_size, row.value, value_size);
+			buffer								+= key_size + value_size;
+			flat_file_cursor->current_location	= location;
+			(*count)++;
+		}
+
+		location++;
+	}
+
+	ffdict_unlock_region(flat_file);
+
+	return 0 < *count ? cs_cursor_active : cursor->status;
 }
 
 /**
@@ -190,6 +410,37 @@ ffdict_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief		Writes this flat file store through to storage.
+@param[in]	dictionary
+				Which instance of a flat file store to sync.
+@return		The resulting status of the operation.
+*/
+ion_err_t
+ffdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return flat_file_sync((ion_flat_file_t *) dictionary->instance);
+}
+
+/**
+@brief		Holds the writes of this flat file store in memory until they
+			are written back, or lets them through again.
+@param[in]	dictionary
+				Which instance of a flat file store to hold the writes of.
+@param[in]	writeback
+				The files to write back with, or NULL to let writes
+				through.
+@return		The resulting status of the operation.
+*/
+ion_err_t
+ffdict_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+) {
+	return flat_file_hold((ion_flat_file_t *) dictionary->instance, writeback);
+}
+
 /**
 @brief			Initializes a cursor query and returns an allocated cursor object.
 @details		Given a @p predicate that was previously initialized by @ref dictionary_build_predicate,
@@ -205,8 +456,8 @@ ffdict_close_dictionary(
 					effectively be lost, if there is no other reference to said thing.
 @return			The resulting status of the operation.
 */
-ion_err_t
-ffdict_find(
+static ion_err_t
+ffdict_find_first(
 	ion_dictionary_t	*dictionary,
 	ion_predicate_t		*predicate,
 	ion_dict_cursor_t	**cursor
@@ -224,6 +475,8 @@ ffdict_find(
 
 	(*cursor)->destroy		= ffdict_destroy_cursor;
 	(*cursor)->next			= ffdict_next;
+	(*cursor)->next_batch	= ffdict_next_batch;
+	(*cursor)->next_ref		= ffdict_next_ref;
 
 	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
 
@@ -360,13 +613,32 @@ ffdict_find(
 	return err_ok;
 }
 
+ion_err_t
+ffdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_flat_file_t *flat_file = (ion_flat_file_t *) dictionary->instance;
+	ion_err_t		err;
+
+	ffdict_lock_region(flat_file);
+	err = ffdict_find_first(dictionary, predicate, cursor);
+	ffdict_unlock_region(flat_file);
+
+	return err;
+}
+
 void
 ffdict_init(
 	ion_dictionary_handler_t *handler
 ) {
 	handler->insert				= ffdict_insert;
+	handler->insert_batch		= ffdict_insert_batch;
 	handler->create_dictionary	= ffdict_create_dictionary;
 	handler->get				= ffdict_get;
+	handler->get_many			= ffdict_get_many;
+	handler->get_ref			= ffdict_get_ref;
 	handler->update				= ffdict_update;
 	handler->find				= ffdict_find;
 	handler->remove				= ffdict_delete;
@@ -374,6 +646,10 @@ ffdict_init(
 	handler->destroy_dictionary = ffdict_destroy_dictionary;
 	handler->open_dictionary	= ffdict_open_dictionary;
 	handler->close_dictionary	= ffdict_close_dictionary;
+	handler->sync				= ffdict_sync_dictionary;
+	handler->hold				= ffdict_hold_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_false;
 }
 
 ion_status_t
@@ -385,13 +661,47 @@ ffdict_insert(
 	return flat_file_insert((ion_flat_file_t *) dictionary->instance, key, value);
 }
 
+ion_status_t
+ffdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+) {
+	return flat_file_insert_batch((ion_flat_file_t *) dictionary->instance, records, count);
+}
+
 ion_status_t
 ffdict_get(
 	ion_dictionary_t	*dictionary,
 	ion_key_t			key,
 	ion_value_t			value
 ) {
-	return flat_file_get((ion_flat_file_t *) dictionary->instance, key, value);
+	ion_flat_file_t *flat_file = (ion_flat_file_t *) dictionary->instance;
+	ion_status_t	status;
+
+	ffdict_lock_region(flat_file);
+	status = flat_file_get(flat_file, key, value);
+	ffdict_unlock_region(flat_file);
+
+	return status;
+}
+
+ion_status_t
+ffdict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	ion_flat_file_t *flat_file = (ion_flat_file_t *) dictionary->instance;
+	ion_status_t	status;
+
+	ffdict_lock_region(flat_file);
+	status = flat_file_get_many(flat_file, keys, count, values, statuses);
+	ffdict_unlock_region(flat_file);
+
+	return status;
 }
 
 ion_err_t
@@ -457,6 +767,31 @@ ffdict_destroy_dictionary(
 	return err_ok;
 }
 
+ion_status_t
+ffdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+) {
+	ion_flat_file_t		*flat_file = (ion_flat_file_t *) dictionary->instance;
+	ion_record_t		record;
+	ion_flat_file_row_t row;
+	ion_status_t		status;
+
+	ffdict_lock_region(flat_file);
+	status = flat_file_get_ref(flat_file, key, &record);
+
+	if (err_ok == status.error) {
+		row.key		= record.key;
+		row.value	= record.value;
+		status		= err_ok == ffdict_reference(flat_file, &row, ref) ? status : ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	ffdict_unlock_region(flat_file);
+
+	return status;
+}
+
 ion_status_t
 ffdict_update(
 	ion_dictionary_t	*dictionary,
@@ -76,6 +76,23 @@ ffdict_insert(
 	ion_value_t			value
 );
 
+/**
+@brief		Insert a batch of records into the dictionary.
+@param[in]	dictionary
+				The initialized dictionary instance we want to insert into.
+@param[in]	records
+				The records to be inserted.
+@param[in]	count
+				The number of records in @p records.
+@return		The resulting status of the operation.
+*/
+ion_status_t
+ffdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+);
+
 /**
 @brief		Performs a "get" operation on the dictionary to retrieve a single record.
 @details	Given a @p key, returns the associated value stored under
@@ -99,6 +116,48 @@ ffdict_get(
 	ion_value_t			value
 );
 
+/**
+@brief		Performs a "get" operation that points at the record in place instead of copying it.
+@details	A record read in place from the mapping of a mapped data file is pointed at there.
+			One read into the row buffer is copied out, as other readers may load over it.
+@param[in]	dictionary
+				Which dictionary to perform the operation on.
+@param[in]	key
+				The desired search key.
+@param[out]	ref
+				Set to point at the key and value of the record found.
+@return		The resulting status of the operation.
+*/
+ion_status_t
+ffdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+);
+
+/**
+@brief		Performs a "get" operation for many keys at once.
+@param[in]	dictionary
+				Which dictionary to perform the operation on.
+@param[in]	keys
+				The desired search keys.
+@param[in]	count
+				How many keys are in @p keys.
+@param[out]	values
+				The output locations in which to write each returned value.
+@param[out]	statuses
+				The status of each lookup.
+@return		The resulting status of the operation.
+*/
+ion_status_t
+ffdict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+);
+
 /**
 @brief		Creates an instance of a flat file backed dictionary.
 @param[in]	id
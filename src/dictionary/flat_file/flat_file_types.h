@@ -43,6 +43,7 @@ extern "C" {
 
 #include "../dictionary.h"
 #include "../../file/sd_stdio_c_iface.h"
+#include "../../file/ion_file.h"
 
 /**
 @brief		This type describes the status flag within a flat file row.
@@ -87,8 +88,11 @@ typedef struct {
 	/**> Memory buffer capable of holding @p row_size number of rows. This is used
 		 for many purposes throughout the flat file. */
 	ion_byte_t				*buffer;
-	/**> The file descriptor of the file this flat file instance operates on. */
-	FILE					*data_file;
+	/**> The rows of the loaded region. These are read in place from the mapping of a mapped
+		 @p data_file, and otherwise into @p buffer. */
+	ion_byte_t				*region;
+	/**> The file this flat file instance operates on. */
+	ion_file_handle_t		data_file;
 	/**> This value expresses the size of one row inside the @p data_file. A row is defined
 		 as a record + metadata. Change this if @ref ion_flat_file_row_t changes!*/
 	size_t					row_size;
@@ -99,6 +103,10 @@ typedef struct {
 	ion_fpos_t	current_loaded_region;
 	/**> Expresses how many valid records are currently in the buffer. */
 	size_t		num_in_buffer;
+#if !defined(ARDUINO)
+	/**> Guards the loaded region, so that readers sharing the dictionary lock load it in turn. */
+	pthread_mutex_t region_lock;
+#endif
 } ion_flat_file_t;
 
 /**
@@ -569,6 +569,11 @@ ion_switch_handler(
 			break;
 		}
 
+		case dictionary_type_sharded_t: {
+			shdict_init(handler);
+			break;
+		}
+
 		case dictionary_type_error_t: {
 			return err_uninitialized;
 		}
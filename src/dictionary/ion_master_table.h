@@ -60,6 +60,7 @@ extern "C" {
 #include "open_address_hash/open_address_hash_dictionary_handler.h"
 #include "skip_list/skip_list_handler.h"
 #include "linear_hash/linear_hash_handler.h"
+#include "sharded/sharded_handler.h"
 
 #define ION_MASTER_TABLE_CALCULATE_POS	-1
 #define ION_MASTER_TABLE_WRITE_FROM_END -2
@@ -35,13 +35,427 @@
 /******************************************************************************/
 
 #include "linear_hash.h"
+#include "../../file/ion_file.h"
 #include <math.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define GET_BUCKET_RECORDS_LOC(bucket_loc) (bucket_loc) + sizeof(linear_hash_bucket_t)
 
+#if defined(ARDUINO)
+#define LINEAR_HASH_IS_OPEN(file) (NULL != (file).file)
+#else
+#define LINEAR_HASH_IS_OPEN(file) (ION_NOFILE != (file))
+#endif
+
+/* "LHS4", leading state files laid out as linear_hash_state_t whose buckets carry key filters sized by chain */
+#define LINEAR_HASH_STATE_TAG 0x3453484CUL
+
+/* whether every bit of a key's filter is set in a bucket's filter */
+#define LINEAR_HASH_FILTER_MAY_HOLD(filter, key_filter) ((key_filter) == ((filter) & (key_filter)))
+
+/* the two bits a key sets in a filter, taken from the top of its filter hash */
+#define LINEAR_HASH_FILTER_BITS(hash) (((linear_hash_filter_t) 1 << ((hash) >> 58)) | ((linear_hash_filter_t) 1 << (((hash) >> 52) & 63)))
+
+/* the word of a chain's filter a key sets its bits in */
+#define LINEAR_HASH_FILTER_WORD(hash, words) ((int) ((hash) >> 32) & ((words) - 1))
+
+/* the keys of a chain given to each word of its filter before the chain takes more words, which leaves about one
+ * word bit in five set and lets about one miss in twenty through */
+#define LINEAR_HASH_FILTER_WORD_KEYS 8
+
+/* the fixed fields of the state file, each at its own offset so it can be rewritten alone; the location of the
+ * head of each bucket chain follows, one ion_fpos_t a bucket */
+typedef struct {
+	uint32_t	tag;
+	uint32_t	hash;
+	uint64_t	seed;
+	int			initial_size;
+	int			next_split;
+	int			split_threshold;
+	int			records_per_bucket;
+	int			num_records;
+} linear_hash_state_t;
+
+/* where the state file keeps the head of a bucket chain */
+#define LINEAR_HASH_STATE_MAP_LOC(idx) ((ion_fpos_t) sizeof(linear_hash_state_t) + (ion_fpos_t) (idx) * (ion_fpos_t) sizeof(ion_fpos_t))
+
+/* the bytes a bucket takes in the data file; new buckets are written with a slot of
+ * sizeof(linear_hash_record_status_empty), an int, per record status, so they are longer
+ * than their header and records */
+#define LINEAR_HASH_BUCKET_SIZE(linear_hash) (sizeof(linear_hash_bucket_t) + (linear_hash)->records_per_bucket * ((linear_hash)->super.record.key_size + (linear_hash)->super.record.value_size + sizeof(linear_hash_record_status_empty)))
+
+/* flags of a cached bucket */
+#define LINEAR_HASH_CACHE_REFERENCED	1
+#define LINEAR_HASH_CACHE_DIRTY			2
+
+/**
+@brief		Points a bucket chain at a new head, in the bucket map and in
+			the state file.
+@param[in]	idx
+				Index of the bucket chain.
+@param[in]	bucket_loc
+				Location of the new head of the chain.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the update.
+*/
+static ion_err_t
+linear_hash_map_bucket(
+	int					idx,
+	ion_fpos_t			bucket_loc,
+	linear_hash_table_t *linear_hash
+) {
+	ion_err_t err = array_list_insert(idx, bucket_loc, linear_hash->bucket_map);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	if (err_ok != ion_fwrite_at(linear_hash->state, LINEAR_HASH_STATE_MAP_LOC(idx), sizeof(bucket_loc), (ion_byte_t *) &bucket_loc)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Takes the lock guarding the bucket cache and the readahead of a
+			linear hash.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+*/
+static void
+linear_hash_cache_lock(
+	linear_hash_table_t *linear_hash
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_lock(&linear_hash->buckets.lock);
+#else
+	UNUSED(linear_hash);
+#endif
+}
+
+/**
+@brief		Releases the lock taken with @ref linear_hash_cache_lock.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+*/
+static void
+linear_hash_cache_unlock(
+	linear_hash_table_t *linear_hash
+) {
+#if !defined(ARDUINO)
+	pthread_mutex_unlock(&linear_hash->buckets.lock);
+#else
+	UNUSED(linear_hash);
+#endif
+}
+
+/**
+@brief		Sets up the bucket cache of a linear hash, leaving it off when
+			there is no memory for it.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+*/
+static void
+linear_hash_cache_init(
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_cache_t *cache = &linear_hash->buckets;
+	int					i;
+
+	cache->frames	= 0;
+	cache->hand		= 0;
+	cache->last		= 0;
+	cache->hits		= 0;
+	cache->misses	= 0;
+	cache->locs		= NULL;
+	cache->flags	= NULL;
+	cache->pages	= NULL;
+
+	if (ION_LINEAR_HASH_CACHE_BUCKETS <= 0) {
+		return;
+	}
+
+	cache->locs		= malloc(ION_LINEAR_HASH_CACHE_BUCKETS * sizeof(ion_fpos_t));
+	cache->flags	= malloc(ION_LINEAR_HASH_CACHE_BUCKETS);
+	cache->pages	= malloc(ION_LINEAR_HASH_CACHE_BUCKETS * LINEAR_HASH_BUCKET_SIZE(linear_hash));
+
+	if ((NULL == cache->locs) || (NULL == cache->flags) || (NULL == cache->pages)) {
+		free(cache->locs);
+		free(cache->flags);
+		free(cache->pages);
+		cache->locs		= NULL;
+		cache->flags	= NULL;
+		cache->pages	= NULL;
+		return;
+	}
+
+	for (i = 0; i < ION_LINEAR_HASH_CACHE_BUCKETS; i++) {
+		cache->locs[i]	= linear_hash_end_of_list;
+		cache->flags[i] = 0;
+	}
+
+	cache->frames = ION_LINEAR_HASH_CACHE_BUCKETS;
+}
+
+/**
+@brief		Writes a cached bucket back to the data file if it was changed.
+@param[in]	frame
+				The frame holding the bucket.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the write.
+*/
+static ion_err_t
+linear_hash_cache_write_back(
+	int					frame,
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_cache_t *cache	= &linear_hash->buckets;
+	ion_fpos_t			size	= LINEAR_HASH_BUCKET_SIZE(linear_hash);
+
+	if (0 == (cache->flags[frame] & LINEAR_HASH_CACHE_DIRTY)) {
+		return err_ok;
+	}
+
+	ion_readahead_drop(linear_hash->ahead, cache->locs[frame], size);
+
+	if (err_ok != ion_fwrite_at(linear_hash->database, cache->locs[frame], size, cache->pages + frame * size)) {
+		return err_file_write_error;
+	}
+
+	cache->flags[frame] &= ~LINEAR_HASH_CACHE_DIRTY;
+
+	return err_ok;
+}
+
+/**
+@brief		Writes every changed bucket in the cache back to the data file.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the writes.
+*/
+static ion_err_t
+linear_hash_cache_flush(
+	linear_hash_table_t *linear_hash
+) {
+	ion_err_t	err;
+	int			i;
+
+	for (i = 0; i < linear_hash->buckets.frames; i++) {
+		err = linear_hash_cache_write_back(i, linear_hash);
+
+		if (err_ok != err) {
+			return err;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Finds the frame holding a bucket, without reading it in.
+@param[in]	bucket_loc
+				Location of the bucket in the data file.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		The frame, or -1 if the bucket is not cached.
+*/
+static int
+linear_hash_cache_lookup(
+	ion_fpos_t			bucket_loc,
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_cache_t *cache = &linear_hash->buckets;
+	int					i;
+
+	if ((cache->frames > 0) && (cache->locs[cache->last] == bucket_loc)) {
+		return cache->last;
+	}
+
+	for (i = 0; i < cache->frames; i++) {
+		if (cache->locs[i] == bucket_loc) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+@brief		Finds the frame holding a bucket, reading the bucket in if it
+			is not cached.
+@details	The frame read into is chosen by CLOCK: the hand sweeps the
+			frames, sparing once each frame used since it last passed. A
+			changed bucket is written back before its frame is reused.
+@param[in]	bucket_loc
+				Location of the bucket in the data file.
+@param[out]	frame
+				Where the frame is written back to.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the several file operations used.
+*/
+static ion_err_t
+linear_hash_cache_fetch(
+	ion_fpos_t			bucket_loc,
+	int					*frame,
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_cache_t *cache	= &linear_hash->buckets;
+	ion_fpos_t			size	= LINEAR_HASH_BUCKET_SIZE(linear_hash);
+	ion_err_t			err;
+	int					victim	= linear_hash_cache_lookup(bucket_loc, linear_hash);
+
+	if (-1 != victim) {
+		cache->hits++;
+		cache->flags[victim]	|= LINEAR_HASH_CACHE_REFERENCED;
+		cache->last				= victim;
+		*frame					= victim;
+		return err_ok;
+	}
+
+	cache->misses++;
+
+	while (cache->flags[cache->hand] & LINEAR_HASH_CACHE_REFERENCED) {
+		cache->flags[cache->hand]	&= ~LINEAR_HASH_CACHE_REFERENCED;
+		cache->hand					= (cache->hand + 1) % cache->frames;
+	}
+
+	victim		= cache->hand;
+	cache->hand = (cache->hand + 1) % cache->frames;
+	err			= linear_hash_cache_write_back(victim, linear_hash);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	cache->locs[victim] = linear_hash_end_of_list;
+
+	/* a bucket read ahead is taken rather than read again */
+	if (((NULL == linear_hash->ahead) || !ion_readahead_take(linear_hash->ahead, bucket_loc, size, cache->pages + victim * size)) && (err_ok != ion_fread_at(linear_hash->database, bucket_loc, size, cache->pages + victim * size))) {
+		return err_file_read_error;
+	}
+
+	cache->locs[victim]		= bucket_loc;
+	cache->flags[victim]	= LINEAR_HASH_CACHE_REFERENCED;
+	cache->last				= victim;
+	*frame					= victim;
+
+	return err_ok;
+}
+
+/**
+@brief		Reads bytes of the data file, through the bucket cache.
+@details	The data file holds only buckets, one after the other, so the
+			bucket around any location is found by rounding down.
+@param[in]	loc
+				Location of the first byte to read.
+@param[in]	size
+				The number of bytes to read.
+@param[out]	bytes
+				Where the bytes are written back to.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the several file operations used.
+*/
+static ion_err_t
+linear_hash_read_at(
+	ion_fpos_t			loc,
+	ion_fpos_t			size,
+	ion_byte_t			*bytes,
+	linear_hash_table_t *linear_hash
+) {
+	ion_fpos_t	bucket_size = LINEAR_HASH_BUCKET_SIZE(linear_hash);
+	ion_fpos_t	offset, length;
+	ion_err_t	err;
+	int			frame;
+
+	if (0 == linear_hash->buckets.frames) {
+		return ion_fread_at(linear_hash->database, loc, size, bytes);
+	}
+
+	linear_hash_cache_lock(linear_hash);
+
+	while (size > 0) {
+		offset	= loc % bucket_size;
+		length	= bucket_size - offset < size ? bucket_size - offset : size;
+		err		= linear_hash_cache_fetch(loc - offset, &frame, linear_hash);
+
+		if (err_ok != err) {
+			linear_hash_cache_unlock(linear_hash);
+			return err;
+		}
+
+		memcpy(bytes, linear_hash->buckets.pages + frame * bucket_size + offset, length);
+		loc		+= length;
+		bytes	+= length;
+		size	-= length;
+	}
+
+	linear_hash_cache_unlock(linear_hash);
+
+	return err_ok;
+}
+
+/**
+@brief		Writes bytes of the data file into the bucket cache, to be
+			written back when their bucket leaves it.
+@param[in]	loc
+				Location of the first byte to write.
+@param[in]	size
+				The number of bytes to write.
+@param[in]	bytes
+				The bytes to write.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the several file operations used.
+*/
+static ion_err_t
+linear_hash_write_at(
+	ion_fpos_t			loc,
+	ion_fpos_t			size,
+	ion_byte_t			*bytes,
+	linear_hash_table_t *linear_hash
+) {
+	ion_fpos_t	bucket_size = LINEAR_HASH_BUCKET_SIZE(linear_hash);
+	ion_fpos_t	offset, length;
+	ion_err_t	err;
+	int			frame;
+
+	if (0 == linear_hash->buckets.frames) {
+		ion_readahead_drop(linear_hash->ahead, loc, size);
+		return ion_fwrite_at(linear_hash->database, loc, size, bytes);
+	}
+
+	linear_hash_cache_lock(linear_hash);
+
+	while (size > 0) {
+		offset	= loc % bucket_size;
+		length	= bucket_size - offset < size ? bucket_size - offset : size;
+		err		= linear_hash_cache_fetch(loc - offset, &frame, linear_hash);
+
+		if (err_ok != err) {
+			linear_hash_cache_unlock(linear_hash);
+			return err;
+		}
+
+		memcpy(linear_hash->buckets.pages + frame * bucket_size + offset, bytes, length);
+		linear_hash->buckets.flags[frame]	|= LINEAR_HASH_CACHE_DIRTY;
+		loc									+= length;
+		bytes								+= length;
+		size								-= length;
+	}
+
+	linear_hash_cache_unlock(linear_hash);
+
+	return err_ok;
+}
+
 /* initialization function */
 ion_err_t
 linear_hash_init(
@@ -54,6 +468,30 @@ linear_hash_init(
 	int						split_threshold,
 	int						records_per_bucket,
 	linear_hash_table_t		*linear_hash
+) {
+	return linear_hash_init_hash(id, dictionary_size, key_type, key_size, value_size, initial_size, split_threshold, records_per_bucket, ION_LINEAR_HASH_FUNCTION, ION_LINEAR_HASH_SEED, linear_hash);
+}
+
+/**
+@brief		Initializes a linear hash, giving a new table the hash @p hash
+			seeded with @p seed.
+@details	The hash and seed are kept in the state file, so an existing
+			table is always reopened with the hash it was created with.
+@return		The resulting status of initialization.
+*/
+ion_err_t
+linear_hash_init_hash(
+	ion_dictionary_id_t		id,
+	ion_dictionary_size_t	dictionary_size,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	int						initial_size,
+	int						split_threshold,
+	int						records_per_bucket,
+	linear_hash_hash_t		hash,
+	uint64_t				seed,
+	linear_hash_table_t		*linear_hash
 ) {
 	/* err */
 	ion_err_t err;
@@ -73,7 +511,19 @@ linear_hash_init(
 	linear_hash->split_threshold			= split_threshold;
 	linear_hash->records_per_bucket			= records_per_bucket;
 	linear_hash->record_total_size			= key_size + value_size + sizeof(ion_byte_t);
+	linear_hash->hash						= hash;
+	linear_hash->seed						= seed;
 	linear_hash->cache						= malloc(128);
+	linear_hash->ahead						= NULL;
+	linear_hash->no_ahead					= boolean_false;
+	linear_hash->database					= ION_NOFILE;
+	linear_hash->state						= ION_NOFILE;
+
+	/* the cache is sized once the state has given the size of the buckets */
+	memset(&linear_hash->buckets, 0, sizeof(linear_hash->buckets));
+#if !defined(ARDUINO)
+	pthread_mutex_init(&linear_hash->buckets.lock, NULL);
+#endif
 
 	char data_filename[ION_MAX_FILENAME_LENGTH];
 
@@ -103,15 +553,26 @@ linear_hash_init(
 	}
 
 	linear_hash->bucket_map = bucket_map;
-	linear_hash->database	= fopen(data_filename, "r+b");
 
-	if (NULL == linear_hash->database) {
-		linear_hash->database = fopen(data_filename, "w+b");
+	ion_boolean_t exists = ion_fexists(data_filename);
 
-		if (NULL == linear_hash->database) {
-			return err_file_open_error;
-		}
+	linear_hash->database = ion_fopen(data_filename);
 
+	if (!LINEAR_HASH_IS_OPEN(linear_hash->database)) {
+		return err_file_open_error;
+	}
+
+	/* the state is opened first, as new buckets record their location in it */
+	linear_hash->state = ion_fopen(state_filename);
+
+	if (!LINEAR_HASH_IS_OPEN(linear_hash->state)) {
+		return err_file_open_error;
+	}
+
+	if (exists) {
+		err = linear_hash_read_state(linear_hash);
+	}
+	else {
 		int i;
 
 		for (i = 0; i < linear_hash->initial_size; i++) {
@@ -122,44 +583,23 @@ linear_hash_init(
 				return err;
 			}
 		}
-	}
-
-	linear_hash->state = fopen(state_filename, "r+b");
-
-	if (NULL == linear_hash->state) {
-		linear_hash->state = fopen(state_filename, "w+b");
-
-		if (NULL == linear_hash->state) {
-			return err_file_open_error;
-		}
 
 		err = linear_hash_write_state(linear_hash);
-
-		if (err != err_ok) {
-			return err;
-		}
-	}
-	else {
-		err = linear_hash_read_state(linear_hash);
-
-		if (err != err_ok) {
-			return err;
-		}
 	}
 
-	err = linear_hash_write_state(linear_hash);
-
 	if (err != err_ok) {
 		return err;
 	}
 
+	linear_hash_cache_init(linear_hash);
+
 	/* return pointer to the linear_hash that is sitting in memory */
 	return err_ok;
 }
 
 /**
-@brief		Writes the current state of the linear hash to a .lhs file.
-@details	Each instace of a linear hash has an associated .lhs file which stores its state in non-volatile storage. The name of a linear hash's .lhs file is the id of linear hash in the master table. This is the file the state is written to.
+@brief		Writes the fixed fields of the state of the linear hash to its .lhs file.
+@details	Each instace of a linear hash has an associated .lhs file which stores its state in non-volatile storage. The name of a linear hash's .lhs file is the id of linear hash in the master table. The bucket map is not written here; each entry is written as it changes.
 @param[in]	linear_hash
 Which linear hash instance to write.
 @return		Resulting status of the several file operations used to commit the write.
@@ -168,40 +608,42 @@ ion_err_t
 linear_hash_write_state(
 	linear_hash_table_t *linear_hash
 ) {
-	if (1 != fwrite(&linear_hash->initial_size, sizeof(linear_hash->initial_size), 1, linear_hash->state)) {
-		return err_file_write_error;
-	}
-
-	if (1 != fwrite(&linear_hash->next_split, sizeof(linear_hash->next_split), 1, linear_hash->state)) {
-		return err_file_write_error;
-	}
-
-	if (1 != fwrite(&linear_hash->split_threshold, sizeof(linear_hash->split_threshold), 1, linear_hash->state)) {
-		return err_file_write_error;
-	}
-
-	if (1 != fwrite(&linear_hash->num_buckets, sizeof(linear_hash->num_buckets), 1, linear_hash->state)) {
-		return err_file_write_error;
-	}
-
-	if (1 != fwrite(&linear_hash->num_records, sizeof(linear_hash->num_records), 1, linear_hash->state)) {
-		return err_file_write_error;
-	}
-
-	if (1 != fwrite(&linear_hash->records_per_bucket, sizeof(linear_hash->records_per_bucket), 1, linear_hash->state)) {
+	linear_hash_state_t state;
+
+	memset(&state, 0, sizeof(state));
+	state.tag					= LINEAR_HASH_STATE_TAG;
+	state.hash					= linear_hash->hash;
+	state.seed					= linear_hash->seed;
+	state.initial_size			= linear_hash->initial_size;
+	state.next_split			= linear_hash->next_split;
+	state.split_threshold		= linear_hash->split_threshold;
+	state.records_per_bucket	= linear_hash->records_per_bucket;
+	state.num_records			= linear_hash->num_records;
+
+	if (err_ok != ion_fwrite_at(linear_hash->state, 0, sizeof(state), (ion_byte_t *) &state)) {
 		return err_file_write_error;
 	}
 
-	if (1 != fwrite(&linear_hash->bucket_map->current_size, sizeof(int), 1, linear_hash->state)) {
-		return err_file_write_error;
-	}
+	return ion_fflush(linear_hash->state);
+}
 
-	ion_byte_t *cached_bucket_map = alloca(sizeof(ion_fpos_t) * linear_hash->bucket_map->current_size);
+/**
+@brief		Writes the fields of the state a split changes: the size the
+			hash functions work from and the split pointer.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the write.
+*/
+static ion_err_t
+linear_hash_write_split_state(
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_state_t state;
 
-	memset(cached_bucket_map, 0, sizeof(ion_fpos_t) * linear_hash->bucket_map->current_size);
-	memcpy(cached_bucket_map, linear_hash->bucket_map->data, linear_hash->num_buckets * sizeof(ion_fpos_t));
+	state.initial_size	= linear_hash->initial_size;
+	state.next_split	= linear_hash->next_split;
 
-	if (1 != fwrite(cached_bucket_map, sizeof(linear_hash->bucket_map->data), 1, linear_hash->state)) {
+	if (err_ok != ion_fwrite_at(linear_hash->state, offsetof(linear_hash_state_t, initial_size), offsetof(linear_hash_state_t, next_split) + sizeof(state.next_split) - offsetof(linear_hash_state_t, initial_size), (ion_byte_t *) &state.initial_size)) {
 		return err_file_write_error;
 	}
 
@@ -210,7 +652,7 @@ linear_hash_write_state(
 
 /**
 @brief		Read the state of a linear hash from a .lhs file.
-@details	Each instance of a linear hash has an associated .lhs file which stores its state in non-volatile storage. The name of a linear hash's .lhs file is the id of linear hash in the master table. This is the file the state is read from.
+@details	Each instance of a linear hash has an associated .lhs file which stores its state in non-volatile storage. The name of a linear hash's .lhs file is the id of linear hash in the master table. Only the fixed fields are read; each entry of the bucket map is read the first time it is used.
 @param[in]	linear_hash
 				Pointer to a linear hash instance to read the data to.
 @return		Resulting status of the several file operations used to commit the write.
@@ -219,41 +661,40 @@ ion_err_t
 linear_hash_read_state(
 	linear_hash_table_t *linear_hash
 ) {
-	if (0 != fseek(linear_hash->state, 0, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
-
-	if (1 != fread(&(linear_hash->initial_size), sizeof(linear_hash->initial_size), 1, linear_hash->state)) {
-		return err_file_read_error;
-	}
+	linear_hash_state_t state;
+	ion_fpos_t			*data;
+	int					size, i;
 
-	if (1 != fread(&linear_hash->next_split, sizeof(linear_hash->next_split), 1, linear_hash->state)) {
+	/* state files from before the tag did not keep the bucket map, so their tables can't be found again */
+	if ((err_ok != ion_fread_at(linear_hash->state, 0, sizeof(state), (ion_byte_t *) &state)) || (LINEAR_HASH_STATE_TAG != state.tag)) {
 		return err_file_read_error;
 	}
 
-	if (1 != fread(&linear_hash->split_threshold, sizeof(linear_hash->split_threshold), 1, linear_hash->state)) {
-		return err_file_read_error;
-	}
+	linear_hash->hash				= (linear_hash_hash_t) state.hash;
+	linear_hash->seed				= state.seed;
+	linear_hash->initial_size		= state.initial_size;
+	linear_hash->next_split			= state.next_split;
+	linear_hash->split_threshold	= state.split_threshold;
+	linear_hash->records_per_bucket = state.records_per_bucket;
+	linear_hash->num_records		= state.num_records;
 
-	if (1 != fread(&linear_hash->num_buckets, sizeof(linear_hash->num_buckets), 1, linear_hash->state)) {
-		return err_file_read_error;
-	}
+	/* each split adds one bucket to the initial ones and moves the split pointer one on */
+	linear_hash->num_buckets		= linear_hash->initial_size + linear_hash->next_split;
 
-	if (1 != fread(&linear_hash->num_records, sizeof(linear_hash->num_records), 1, linear_hash->state)) {
-		return err_file_read_error;
-	}
+	size							= linear_hash->num_buckets > 5 ? linear_hash->num_buckets : 5;
+	data							= malloc(size * sizeof(ion_fpos_t));
 
-	if (1 != fread(&linear_hash->records_per_bucket, sizeof(linear_hash->records_per_bucket), 1, linear_hash->state)) {
-		return err_file_read_error;
+	if (NULL == data) {
+		return err_out_of_memory;
 	}
 
-	if (1 != fread(&linear_hash->bucket_map->current_size, sizeof(int), 1, linear_hash->state)) {
-		return err_file_read_error;
+	for (i = 0; i < size; i++) {
+		data[i] = linear_hash_map_unread;
 	}
 
-	if (1 != fwrite(&linear_hash->bucket_map->data, sizeof(ion_fpos_t) * linear_hash->num_buckets, 1, linear_hash->state)) {
-		return err_file_read_error;
-	}
+	free(linear_hash->bucket_map->data);
+	linear_hash->bucket_map->data			= data;
+	linear_hash->bucket_map->current_size	= size;
 
 	return err_ok;
 }
@@ -298,6 +739,10 @@ linear_hash_increment_num_records(
 
 		linear_hash_increment_num_buckets(linear_hash);
 		err = split(linear_hash);
+
+		if (err_ok == err) {
+			err = linear_hash_write_split_state(linear_hash);
+		}
 	}
 
 	return err;
@@ -322,149 +767,362 @@ linear_hash_decrement_num_records(
 @details	The new bucket is written to the end of the .lhd file associated with the linear hash. When a bucket is added to a linear hash, the inital_size parameter used in the hash functions is doubled and the pointer is reset to the first bucket. This helps the linear hash's distribution remains constant over time.
 @param[in]	linear_hash
 				Pointer to a linear hash instance.
-@return		err_ok.
+@return		err_ok.
+*/
+ion_err_t
+linear_hash_increment_num_buckets(
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash->num_buckets++;
+
+	if (linear_hash->num_buckets == 2 * linear_hash->initial_size + 1) {
+		linear_hash->initial_size	= linear_hash->initial_size * 2;
+		linear_hash->next_split		= 0;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Helper method to increment the split linear hash.
+@details	The new bucket is written to the end of the .lhd file associated with the linear hash. When a bucket is added to a linear hash, the inital_size parameter used in the hash functions is doubled and the pointer is reset to the first bucket. This helps the linear hash's distribution remains constant over time.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		err_ok.
+*/
+ion_err_t
+linear_hash_increment_next_split(
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash->next_split++;
+	return err_ok;
+}
+
+/**
+@brief		Mix the hash of a key again, so the bits it sets in filters do
+			not follow the low bits that address its bucket.
+@param[in]	key
+				Pointer to the key to hash
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		The filter hash of the key.
+*/
+static uint64_t
+linear_hash_filter_hash(
+	ion_byte_t			*key,
+	linear_hash_table_t *linear_hash
+) {
+	return linear_hash_key_hash(key, linear_hash) * 0x9E3779B97F4A7C15ULL;
+}
+
+/**
+@brief		Whether the filter of a chain may hold a key.
+@param[in]	bucket
+				The head of the chain.
+@param[in]	hash
+				The filter hash of the key.
+@return		boolean_false when no bucket of the chain holds the key.
+*/
+static ion_boolean_t
+linear_hash_chain_holds(
+	linear_hash_bucket_t	*bucket,
+	uint64_t				hash
+) {
+	return LINEAR_HASH_FILTER_MAY_HOLD(bucket->chain_filter[LINEAR_HASH_FILTER_WORD(hash, bucket->chain_words)], LINEAR_HASH_FILTER_BITS(hash));
+}
+
+/**
+@brief		Adds a key to the filter of a chain.
+@param[in]	bucket
+				The head of the chain.
+@param[in]	hash
+				The filter hash of the key.
+*/
+static void
+linear_hash_chain_add(
+	linear_hash_bucket_t	*bucket,
+	uint64_t				hash
+) {
+	bucket->chain_filter[LINEAR_HASH_FILTER_WORD(hash, bucket->chain_words)] |= LINEAR_HASH_FILTER_BITS(hash);
+}
+
+/**
+@brief		The words of filter a chain of buckets uses.
+@param[in]	chain_length
+				The number of buckets in the chain.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		The smallest power of two giving each word at most
+			@ref LINEAR_HASH_FILTER_WORD_KEYS keys of a full chain, up to
+			@ref ION_LINEAR_HASH_CHAIN_FILTER_WORDS.
+*/
+static int
+linear_hash_chain_words(
+	int					chain_length,
+	linear_hash_table_t *linear_hash
+) {
+	int words = 1;
+
+	while ((words < ION_LINEAR_HASH_CHAIN_FILTER_WORDS) && (words * LINEAR_HASH_FILTER_WORD_KEYS < chain_length * linear_hash->records_per_bucket)) {
+		words *= 2;
+	}
+
+	return words;
+}
+
+/**
+@brief		Starts a chain's filter over with a given number of words.
+@param[in]	bucket
+				The bucket whose filter to clear.
+@param[in]	words
+				The words of filter to use.
+*/
+static void
+linear_hash_chain_reset(
+	linear_hash_bucket_t	*bucket,
+	int						words
+) {
+	bucket->chain_words = words;
+	memset(bucket->chain_filter, 0, sizeof(bucket->chain_filter));
+}
+
+/**
+@brief		Counts a new empty head into the length of its chain.
+@details	A chain that grows past what its filter can hold takes more
+			words, and its filter is rebuilt from the records of the buckets
+			after the head, each read once. The words double each time, so
+			the reads come to at most about two per bucket added.
+@param[in]	bucket
+				The new head, linked to the rest of the chain.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the reads.
 */
-ion_err_t
-linear_hash_increment_num_buckets(
-	linear_hash_table_t *linear_hash
+static ion_err_t
+linear_hash_chain_grow(
+	linear_hash_bucket_t	*bucket,
+	linear_hash_table_t		*linear_hash
 ) {
-	linear_hash->num_buckets++;
+	ion_fpos_t				page_size	= sizeof(linear_hash_bucket_t) + linear_hash->records_per_bucket * linear_hash->record_total_size;
+	ion_byte_t				*page;
+	ion_byte_t				*record;
+	linear_hash_bucket_t	next;
+	ion_fpos_t				loc;
+	int						words;
+	int						i;
 
-	if (linear_hash->num_buckets == 2 * linear_hash->initial_size + 1) {
-		linear_hash->initial_size	= linear_hash->initial_size * 2;
-		linear_hash->next_split		= 0;
+	bucket->chain_length++;
+	words = linear_hash_chain_words(bucket->chain_length, linear_hash);
+
+	if (words <= bucket->chain_words) {
+		return err_ok;
+	}
+
+	page = alloca(page_size);
+	linear_hash_chain_reset(bucket, words);
+
+	for (loc = bucket->overflow_location; linear_hash_end_of_list != loc; loc = next.overflow_location) {
+		if (err_ok != linear_hash_read_at(loc, page_size, page, linear_hash)) {
+			return err_file_read_error;
+		}
+
+		memcpy(&next, page, sizeof(linear_hash_bucket_t));
+
+		for (i = 0; i < next.record_count; i++) {
+			record = page + sizeof(linear_hash_bucket_t) + i * linear_hash->record_total_size;
+
+			if (linear_hash_record_status_empty != *record) {
+				linear_hash_chain_add(bucket, linear_hash_filter_hash(record + sizeof(ion_byte_t), linear_hash));
+			}
+		}
 	}
 
 	return err_ok;
 }
 
 /**
-@brief		Helper method to increment the split linear hash.
-@details	The new bucket is written to the end of the .lhd file associated with the linear hash. When a bucket is added to a linear hash, the inital_size parameter used in the hash functions is doubled and the pointer is reset to the first bucket. This helps the linear hash's distribution remains constant over time.
+@brief		Writes records over a chain of buckets.
+@details	Every bucket but the head of the chain is filled, and the head
+			takes the rest, as inserts and swap-on-delete expect. Each
+			bucket is written, header and records, with one write.
+@param[in]	idx
+				Index of the bucket chain.
+@param[in]	locs
+				Locations of the buckets to use, the head first.
+@param[in]	count
+				The number of buckets in @p locs.
+@param[in]	records
+				The records, the newest first.
+@param[in]	record_count
+				The number of records; @p count buckets must hold them.
 @param[in]	linear_hash
 				Pointer to a linear hash instance.
-@return		err_ok.
+@return		Resulting status of the several file operations used.
 */
-ion_err_t
-linear_hash_increment_next_split(
+static ion_err_t
+linear_hash_write_chain(
+	int					idx,
+	ion_fpos_t			*locs,
+	int					count,
+	ion_byte_t			*records,
+	int					record_count,
 	linear_hash_table_t *linear_hash
 ) {
-	linear_hash->next_split++;
-	return err_ok;
+	ion_fpos_t				records_size	= linear_hash->records_per_bucket * linear_hash->record_total_size;
+	ion_byte_t				*page			= alloca(sizeof(linear_hash_bucket_t) + records_size);
+	linear_hash_bucket_t	bucket;
+	int						i, j;
+
+	bucket.idx = idx;
+	linear_hash_chain_reset(&bucket, linear_hash_chain_words(count, linear_hash));
+
+	/* every bucket takes the filter of the whole chain, which covers those after it */
+	for (i = 0; i < record_count; i++) {
+		linear_hash_chain_add(&bucket, linear_hash_filter_hash(records + i * linear_hash->record_total_size + sizeof(ion_byte_t), linear_hash));
+	}
+
+	for (i = 0; i < count; i++) {
+		bucket.record_count			= 0 == i ? record_count - (count - 1) * linear_hash->records_per_bucket : linear_hash->records_per_bucket;
+		bucket.overflow_location	= i + 1 < count ? locs[i + 1] : linear_hash_end_of_list;
+		bucket.chain_length			= count - i;
+		bucket.key_filter			= 0;
+
+		for (j = 0; j < bucket.record_count; j++) {
+			bucket.key_filter |= linear_hash_key_filter(records + j * linear_hash->record_total_size + sizeof(ion_byte_t), linear_hash);
+		}
+
+		memset(page, 0, sizeof(linear_hash_bucket_t) + records_size);
+		memcpy(page, &bucket, sizeof(linear_hash_bucket_t));
+		memcpy(page + sizeof(linear_hash_bucket_t), records, bucket.record_count * linear_hash->record_total_size);
+
+		if (err_ok != linear_hash_write_at(locs[i], sizeof(linear_hash_bucket_t) + records_size, page, linear_hash)) {
+			return err_file_write_error;
+		}
+
+		records += bucket.record_count * linear_hash->record_total_size;
+	}
+
+	return linear_hash_map_bucket(idx, locs[0], linear_hash);
 }
 
 /**
 @brief		Performs the split operation on a linear hash instance.
-@details	A split is triggered when the load of the linear hash surpasses the split_threshold. A new bucket is created and the bucket currently pointed to by the split pointer has all of its records checked against a condition. If this condition passes, the record is deleted from the current bucket and inserted to the new bucket. This operation may require several several calls to linear_hash_insert and linear_hash_delete methods. To avoid data loss caused by the swap-on-delete strategy used in the linear_hash_delete deleting multiple records per call potentially, a cache is used to store the values associated with records which are deleted.
+@details	A split is triggered when the load of the linear hash surpasses the split_threshold. A new bucket has been
+			created at the end of the table, and the records of the bucket chain pointed to by the split pointer that
+			now hash to the new bucket move there. The chain is read once, its records are partitioned into those that
+			stay and those that move, and both chains are written back, each bucket once. The buckets of the old chain
+			are reused, the ones it no longer needs being left unlinked, and the number of records does not change, so
+			no further split can be triggered.
 @param[in]	linear_hash
 				Pointer to a linear hash instance.
-@return		err_ok.
+@return		Resulting status of the several file operations used.
 */
 ion_err_t
 split(
 	linear_hash_table_t *linear_hash
 ) {
-	/* status to hold amount of records deleted */
-	ion_status_t status					= ION_STATUS_INITIALIZE;
-
-	/* get bucket to split */
-	ion_fpos_t				bucket_loc	= bucket_idx_to_ion_fpos_t(linear_hash->next_split, linear_hash);
+	ion_err_t				err				= err_ok;
+	int						split_idx		= linear_hash->num_buckets - 1;
+	ion_fpos_t				bucket_loc		= bucket_idx_to_ion_fpos_t(linear_hash->next_split, linear_hash);
+	ion_fpos_t				records_size	= linear_hash->records_per_bucket * linear_hash->record_total_size;
+	ion_fpos_t				*locs			= NULL;
+	ion_byte_t				*records		= NULL;
+	ion_byte_t				*moved			= NULL;
+	void					*grown;
+	int						buckets			= 0;
+	int						capacity		= 0;
+	int						total			= 0;
+	int						stay			= 0;
+	int						move			= 0;
+	int						stay_buckets, move_buckets;
 	linear_hash_bucket_t	bucket;
+	ion_byte_t				*record;
+	int						i;
 
-	status.error = linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
-
-	if (status.error != err_ok) {
-		return status.error;
-	}
-
-	/* stores for record data */
-	ion_byte_t	*record_key		= alloca(linear_hash->super.record.key_size);
-	ion_byte_t	*record_value	= alloca(linear_hash->super.record.value_size);
-	ion_byte_t	record_status	= linear_hash_record_status_empty;
+	/* read the whole chain, keeping the records in the order they are found */
+	while (linear_hash_end_of_list != bucket_loc) {
+		if (buckets == capacity) {
+			capacity = 0 == capacity ? 4 : 2 * capacity;
 
-	int split_hash_key;
-	int insert_hash_key;
+			if (NULL == (grown = realloc(locs, capacity * sizeof(ion_fpos_t)))) {
+				err = err_out_of_memory;
+				goto cleanup;
+			}
 
-	int			i, j;
-	ion_byte_t	*records = alloca(linear_hash->record_total_size * linear_hash->records_per_bucket);
+			locs = grown;
 
-	memset(records, 0, linear_hash->record_total_size * linear_hash->records_per_bucket);
+			if (NULL == (grown = realloc(records, capacity * records_size))) {
+				err = err_out_of_memory;
+				goto cleanup;
+			}
 
-	ion_fpos_t		record_offset	= 0;
-	ion_boolean_t	terminal		= boolean_false;
+			records = grown;
+		}
 
-	while (terminal == boolean_false) {
-		/* if the bucket is not empty */
-		if (bucket.record_count > 0) {
-			/* read all records into memory */
-			fseek(linear_hash->database, bucket_loc + sizeof(linear_hash_bucket_t), SEEK_SET);
-			fread(records, linear_hash->record_total_size, linear_hash->records_per_bucket, linear_hash->database);
+		err = linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
 
-			/* scan records for records that should be placed in the new bucket */
-			for (i = 0; i < bucket.record_count; i++) {
-				memcpy(&record_status, records + record_offset, sizeof(record_status));
-				memcpy(record_key, records + record_offset + sizeof(record_status), linear_hash->super.record.key_size);
-				memcpy(record_value, records + record_offset + sizeof(record_status) + linear_hash->super.record.key_size, linear_hash->super.record.value_size);
+		if (err_ok != err) {
+			goto cleanup;
+		}
 
-				insert_hash_key = insert_hash_to_bucket(record_key, linear_hash);
+		if ((bucket.record_count > 0) && (err_ok != linear_hash_read_at(GET_BUCKET_RECORDS_LOC(bucket_loc), bucket.record_count * linear_hash->record_total_size, records + total * linear_hash->record_total_size, linear_hash))) {
+			err = err_file_read_error;
+			goto cleanup;
+		}
 
-				split_hash_key	= hash_to_bucket(record_key, linear_hash);
+		locs[buckets++] = bucket_loc;
+		total			+= bucket.record_count;
+		bucket_loc		= bucket.overflow_location;
+	}
 
-				/* if the record is not a tombstone and h0(k) != h1(k) */
-				if ((record_status == linear_hash_record_status_full) && (insert_hash_key != split_hash_key)) {
-					/* delete all records with this key from the table */
-					status = linear_hash_delete(record_key, linear_hash);
+	moved = malloc(total * linear_hash->record_total_size + 1);
 
-					if (status.error != err_ok) {
-						return status.error;
-					}
+	if (NULL == moved) {
+		err = err_out_of_memory;
+		goto cleanup;
+	}
 
-					int num_deleted = status.count;
+	/* partition the records in place, dropping empty slots */
+	for (i = 0; i < total; i++) {
+		record = records + i * linear_hash->record_total_size;
 
-					linear_hash->last_cache_idx = 0;
+		if (linear_hash_record_status_full != *record) {
+			continue;
+		}
 
-					/* insert that many records into the table */
-					for (j = 0; j < num_deleted; j++) {
-						memcpy(record_value, linear_hash->cache + linear_hash->last_cache_idx * linear_hash->super.record.value_size, linear_hash->super.record.value_size);
-						linear_hash->last_cache_idx++;
+		if (split_idx == hash_to_bucket(record + sizeof(ion_byte_t), linear_hash)) {
+			memcpy(moved + move++ * linear_hash->record_total_size, record, linear_hash->record_total_size);
+		}
+		else {
+			memmove(records + stay++ * linear_hash->record_total_size, record, linear_hash->record_total_size);
+		}
+	}
 
-						status = linear_hash_insert(record_key, record_value, hash_to_bucket(record_key, linear_hash), linear_hash);
+	stay_buckets	= stay > 0 ? (stay + linear_hash->records_per_bucket - 1) / linear_hash->records_per_bucket : 1;
+	move_buckets	= move > 0 ? (move + linear_hash->records_per_bucket - 1) / linear_hash->records_per_bucket : 1;
 
-						if (status.error != err_ok) {
-							return status.error;
-						}
-					}
+	err				= linear_hash_write_chain(linear_hash->next_split, locs, stay_buckets, records, stay, linear_hash);
 
-					/* refresh cached data and restart iteration and offset tracker */
-					fseek(linear_hash->database, bucket_loc + sizeof(linear_hash_bucket_t), SEEK_SET);
-					fread(records, linear_hash->record_total_size, linear_hash->records_per_bucket, linear_hash->database);
-					status.error	= linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
-					i				= -1;
-					record_offset	= -1 * linear_hash->record_total_size;
-				}
+	if (err_ok != err) {
+		goto cleanup;
+	}
 
-				/* track offset from locations of records in memory the next record is at */
-				record_offset += linear_hash->record_total_size;
-			}
+	/* the new bucket heads its chain, followed by old buckets left over; there are always enough */
+	locs[stay_buckets - 1]	= bucket_idx_to_ion_fpos_t(split_idx, linear_hash);
+	err						= linear_hash_write_chain(split_idx, locs + stay_buckets - 1, move_buckets, moved, move, linear_hash);
 
-			/* reset offset */
-			record_offset = 0;
-		}
+	if (err_ok != err) {
+		goto cleanup;
+	}
 
-		if (bucket.overflow_location == linear_hash_end_of_list) {
-			terminal = boolean_true;
-		}
-		else {
-			bucket_loc		= bucket.overflow_location;
-			status.error	= linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
+	err = linear_hash_increment_next_split(linear_hash);
 
-			if (status.error != err_ok) {
-				return status.error;
-			}
-		}
-	}
+cleanup:
+	free(locs);
+	free(records);
+	free(moved);
 
-	return linear_hash_increment_next_split(linear_hash);
+	return err;
 }
 
 /**
@@ -513,7 +1171,7 @@ linear_hash_get_bucket_swap_record(
 	linear_hash_table_t *linear_hash
 ) {
 	/* read in bucket currently swapping to obtain the last record */
-	ion_fpos_t				bucket_loc = array_list_get(bucket_idx, linear_hash->bucket_map);
+	ion_fpos_t				bucket_loc = bucket_idx_to_ion_fpos_t(bucket_idx, linear_hash);
 	linear_hash_bucket_t	bucket;
 
 	linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
@@ -541,7 +1199,25 @@ linear_hash_get_bucket_swap_record(
 
 	/* garuntee the bucket in the bucket map has records in it - THIS LEAVES EMPTY BUCKETS FLOATING ABOUT */
 	if ((bucket.record_count == 0) && (bucket.overflow_location != linear_hash_end_of_list)) {
-		array_list_insert(bucket.idx, bucket.overflow_location, linear_hash->bucket_map);
+		linear_hash_bucket_t next;
+
+		/* the new head takes the filter of the chain, which may hold records swapped down past it */
+		err = linear_hash_get_bucket(bucket.overflow_location, &next, linear_hash);
+
+		if (err != err_ok) {
+			return err;
+		}
+
+		next.chain_length	= bucket.chain_length - 1;
+		next.chain_words	= bucket.chain_words;
+		memcpy(next.chain_filter, bucket.chain_filter, sizeof(next.chain_filter));
+		err					= linear_hash_update_bucket(bucket.overflow_location, &next, linear_hash);
+
+		if (err != err_ok) {
+			return err;
+		}
+
+		linear_hash_map_bucket(bucket.idx, bucket.overflow_location, linear_hash);
 	}
 
 	/* only to update bucket if not becoming junk bucket */
@@ -621,9 +1297,15 @@ linear_hash_insert(
 				return status;
 			}
 
-			/* update parameters of bucket to match that of overflow just created */
+			/* update parameters of bucket to match that of overflow just created, which keeps the chain's filter */
 			bucket.record_count			= 0;
 			bucket.overflow_location	= bucket_loc;
+			bucket.key_filter			= 0;
+			status.error				= linear_hash_chain_grow(&bucket, linear_hash);
+
+			if (err_ok != status.error) {
+				return status;
+			}
 
 			/* update the locations to write to in the file for the record and bucket */
 			record_loc					= GET_BUCKET_RECORDS_LOC(*overflow_location);
@@ -646,7 +1328,11 @@ linear_hash_insert(
 	status.count++;
 
 	/* update bucket */
+	uint64_t filter_hash = linear_hash_filter_hash(record_key, linear_hash);
+
 	bucket.record_count++;
+	bucket.key_filter |= LINEAR_HASH_FILTER_BITS(filter_hash);
+	linear_hash_chain_add(&bucket, filter_hash);
 	status.error = linear_hash_update_bucket(bucket_loc, &bucket, linear_hash);
 
 	if (status.error != err_ok) {
@@ -658,6 +1344,189 @@ linear_hash_insert(
 	return status;
 }
 
+/**
+@brief		Insert a group of records that will not push the load of the linear hash above its split threshold.
+@details	The records are grouped by the bucket they hash to. Each bucket chain is then visited once: its tail is
+			read a single time, the records that fit are written with one write, and the tail is updated once.
+			Overflow buckets are created as the tail fills. Since no split can occur, bucket assignments stay stable
+			for the whole group.
+@param[in]	records
+				The records to insert.
+@param[in]	count
+				How many records are in @p records.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the several file operations used to commit the writes.
+*/
+ion_status_t
+linear_hash_insert_group(
+	ion_record_t		*records,
+	ion_result_count_t	count,
+	linear_hash_table_t *linear_hash
+) {
+	ion_status_t			status			= ION_STATUS_OK(0);
+	int						*bucket_of		= malloc(sizeof(int) * count);
+	int						*order			= malloc(sizeof(int) * count);
+	int						*starts			= calloc(linear_hash->num_buckets + 1, sizeof(int));
+	ion_byte_t				*run			= malloc(linear_hash->record_total_size * linear_hash->records_per_bucket);
+	ion_byte_t				record_status	= linear_hash_record_status_full;
+	ion_fpos_t				bucket_loc;
+	ion_fpos_t				overflow_loc;
+	linear_hash_bucket_t	bucket;
+	uint64_t				filter_hash;
+	int						idx, i, j, n;
+
+	if ((NULL == bucket_of) || (NULL == order) || (NULL == starts) || (NULL == run)) {
+		status.error = err_out_of_memory;
+		goto cleanup;
+	}
+
+	/* Counting sort of the records by destination bucket, which keeps records bound for the same bucket in order. */
+	for (i = 0; i < count; i++) {
+		idx = insert_hash_to_bucket(records[i].key, linear_hash);
+
+		if (idx < linear_hash->next_split) {
+			idx = hash_to_bucket(records[i].key, linear_hash);
+		}
+
+		bucket_of[i] = idx;
+		starts[idx + 1]++;
+	}
+
+	for (idx = 0; idx < linear_hash->num_buckets; idx++) {
+		starts[idx + 1] += starts[idx];
+	}
+
+	for (i = 0; i < count; i++) {
+		order[starts[bucket_of[i]]++] = i;
+	}
+
+	/* After placement each start has moved to the end of its bucket's range. */
+	i = 0;
+
+	for (idx = 0; idx < linear_hash->num_buckets; idx++) {
+		j = starts[idx];
+
+		if (i == j) {
+			continue;
+		}
+
+		bucket_loc		= bucket_idx_to_ion_fpos_t(idx, linear_hash);
+		status.error	= linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
+
+		if (err_ok != status.error) {
+			goto cleanup;
+		}
+
+		while (i < j) {
+			if (linear_hash_bucket_is_full(bucket, linear_hash)) {
+				status.error = create_overflow_bucket(bucket.idx, &overflow_loc, linear_hash);
+
+				if (err_ok != status.error) {
+					goto cleanup;
+				}
+
+				bucket.record_count			= 0;
+				bucket.overflow_location	= bucket_loc;
+				bucket.key_filter			= 0;
+				bucket_loc					= overflow_loc;
+				status.error				= linear_hash_chain_grow(&bucket, linear_hash);
+
+				if (err_ok != status.error) {
+					goto cleanup;
+				}
+			}
+
+			for (n = 0; (i < j) && (bucket.record_count + n < linear_hash->records_per_bucket); n++, i++) {
+				ion_byte_t *record = run + n * linear_hash->record_total_size;
+
+				memcpy(record, &record_status, sizeof(record_status));
+				memcpy(record + sizeof(record_status), records[order[i]].key, linear_hash->super.record.key_size);
+				memcpy(record + sizeof(record_status) + linear_hash->super.record.key_size, records[order[i]].value, linear_hash->super.record.value_size);
+				filter_hash			= linear_hash_filter_hash(records[order[i]].key, linear_hash);
+				bucket.key_filter	|= LINEAR_HASH_FILTER_BITS(filter_hash);
+				linear_hash_chain_add(&bucket, filter_hash);
+			}
+
+			if (err_ok != linear_hash_write_at(GET_BUCKET_RECORDS_LOC(bucket_loc) + bucket.record_count * linear_hash->record_total_size, n * linear_hash->record_total_size, run, linear_hash)) {
+				status.error = err_file_write_error;
+				goto cleanup;
+			}
+
+			bucket.record_count += n;
+			status.error		= linear_hash_update_bucket(bucket_loc, &bucket, linear_hash);
+
+			if (err_ok != status.error) {
+				goto cleanup;
+			}
+
+			status.count				+= n;
+			linear_hash->num_records	+= n;
+		}
+	}
+
+cleanup:
+	free(bucket_of);
+	free(order);
+	free(starts);
+	free(run);
+
+	return status;
+}
+
+/**
+@brief		Insert a batch of records into the linear hash.
+@details	The batch is cut into groups that fit under the split threshold, and each group is written bucket by
+			bucket with @ref linear_hash_insert_group. The record that crosses the threshold is inserted on its own
+			so that the split happens at the same point it would for one-at-a-time inserts.
+@param[in]	records
+				The records to insert.
+@param[in]	count
+				How many records are in @p records.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the several file operations used to commit the writes.
+*/
+ion_status_t
+linear_hash_insert_batch(
+	ion_record_t		*records,
+	ion_result_count_t	count,
+	linear_hash_table_t *linear_hash
+) {
+	ion_status_t		status	= ION_STATUS_OK(0);
+	ion_status_t		partial;
+	ion_result_count_t	done	= 0;
+	ion_result_count_t	room;
+
+	while (done < count) {
+		/* The most records the table can hold before linear_hash_above_threshold() becomes true. */
+		room = (linear_hash->split_threshold * linear_hash->num_buckets * linear_hash->records_per_bucket) / 100 - linear_hash->num_records;
+
+		if (room > count - done) {
+			room = count - done;
+		}
+
+		if (room > 0) {
+			partial = linear_hash_insert_group(records + done, room, linear_hash);
+		}
+		else {
+			partial = linear_hash_insert(records[done].key, records[done].value, insert_hash_to_bucket(records[done].key, linear_hash), linear_hash);
+			room	= 1;
+		}
+
+		status.count += partial.count;
+
+		if (err_ok != partial.error) {
+			status.error = partial.error;
+			break;
+		}
+
+		done += room;
+	}
+
+	return status;
+}
+
 /* linear hash operations */
 /**
 @brief		Retrieve a record from the linear hash. The key and value will be written to the key and value pointers passed in.
@@ -706,60 +1575,189 @@ linear_hash_get(
 
 	memset(records, 0, linear_hash->record_total_size * linear_hash->records_per_bucket);
 
-	ion_fpos_t		record_offset	= 0;
-	ion_fpos_t		record_loc;
-	ion_boolean_t	terminal		= boolean_false;
+	ion_fpos_t				record_offset	= 0;
+	ion_fpos_t				record_loc;
+	ion_boolean_t			terminal		= boolean_false;
+	uint64_t				filter_hash		= linear_hash_filter_hash(key, linear_hash);
+	linear_hash_filter_t	key_filter		= LINEAR_HASH_FILTER_BITS(filter_hash);
+
+	/* a key missing from the filter of the chain is in none of its buckets */
+	if (!linear_hash_chain_holds(&bucket, filter_hash)) {
+		terminal = boolean_true;
+	}
+
+	while (terminal == boolean_false && found == boolean_false) {
+		record_loc = bucket_loc + sizeof(linear_hash_bucket_t);
+
+		if (LINEAR_HASH_FILTER_MAY_HOLD(bucket.key_filter, key_filter)) {
+			linear_hash_read_at(GET_BUCKET_RECORDS_LOC(bucket_loc), linear_hash->record_total_size * linear_hash->records_per_bucket, records, linear_hash);
+		}
+
+		for (i = 0; i < linear_hash->records_per_bucket && LINEAR_HASH_FILTER_MAY_HOLD(bucket.key_filter, key_filter); i++) {
+			memcpy(&record_status, records + record_offset, sizeof(record_status));
+			memcpy(record_key, records + record_offset + sizeof(record_status), linear_hash->super.record.key_size);
+			memcpy(record_value, records + record_offset + sizeof(record_status) + linear_hash->super.record.key_size, linear_hash->super.record.value_size);
+
+			if (record_status != 0) {
+				if (linear_hash->super.compare(record_key, key, linear_hash->super.record.key_size) == 0) {
+					status.count++;
+					memcpy(value, record_value, linear_hash->super.record.value_size);
+					found = 1;
+					break;
+				}
+			}
+
+			record_offset	+= linear_hash->record_total_size;
+			record_loc		+= linear_hash->record_total_size;
+		}
+
+		if (found == boolean_false) {
+			if (bucket.overflow_location == linear_hash_end_of_list) {
+				terminal = boolean_true;
+			}
+			else {
+				record_offset	= 0;
+				bucket_loc		= bucket.overflow_location;
+				status.error	= linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
+
+				if (status.error != err_ok) {
+					return status;
+				}
+			}
+		}
+	}
+
+	if (status.count == 0) {
+		status.error = err_item_not_found;
+	}
+	else {
+		status.error = err_ok;
+	}
+
+	return status;
+}
+
+/* linear hash operations */
+/**
+@brief		Retrieve the values for many keys from the linear hash.
+@details	The keys are grouped by the bucket they hash to, and each bucket chain is walked once for all of its
+			keys. Each bucket in the chain is read with a single read of its header and records.
+@param[in]	keys
+				The keys to look up.
+@param[in]	count
+				How many keys are in @p keys.
+@param[out]	values
+				Where the value found for each key is written back to.
+@param[out]	statuses
+				Where the status of the lookup of each key is written back to.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		Resulting status of the several file operations used. The count is the number of keys found.
+*/
+ion_status_t
+linear_hash_get_many(
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses,
+	linear_hash_table_t *linear_hash
+) {
+	ion_status_t			status		= ION_STATUS_OK(0);
+	size_t					page_size	= sizeof(linear_hash_bucket_t) + linear_hash->record_total_size * linear_hash->records_per_bucket;
+	int						*bucket_of	= malloc(sizeof(int) * count);
+	int						*order		= malloc(sizeof(int) * count);
+	int						*starts		= calloc(linear_hash->num_buckets + 1, sizeof(int));
+	ion_byte_t				*page		= malloc(page_size);
+	ion_fpos_t				bucket_loc;
+	linear_hash_bucket_t	bucket;
+	ion_byte_t				*record;
+	int						idx, i, j, k, first, remaining;
+
+	if ((NULL == bucket_of) || (NULL == order) || (NULL == starts) || (NULL == page)) {
+		status.error = err_out_of_memory;
+		goto cleanup;
+	}
+
+	for (i = 0; i < count; i++) {
+		idx = insert_hash_to_bucket(keys[i], linear_hash);
+
+		if (idx < linear_hash->next_split) {
+			idx = hash_to_bucket(keys[i], linear_hash);
+		}
+
+		bucket_of[i]	= idx;
+		statuses[i]		= ION_STATUS_ERROR(err_item_not_found);
+		starts[idx + 1]++;
+	}
+
+	for (idx = 0; idx < linear_hash->num_buckets; idx++) {
+		starts[idx + 1] += starts[idx];
+	}
+
+	for (i = 0; i < count; i++) {
+		order[starts[bucket_of[i]]++] = i;
+	}
+
+	/* After placement each start has moved to the end of its bucket's range. */
+	first = 0;
+
+	for (idx = 0; idx < linear_hash->num_buckets; idx++) {
+		remaining	= starts[idx] - first;
+		bucket_loc	= bucket_idx_to_ion_fpos_t(idx, linear_hash);
 
-	while (terminal == boolean_false && found == boolean_false) {
-		record_loc = bucket_loc + sizeof(linear_hash_bucket_t);
-		fseek(linear_hash->database, bucket_loc + sizeof(linear_hash_bucket_t), SEEK_SET);
-		fread(records, linear_hash->record_total_size, linear_hash->records_per_bucket, linear_hash->database);
+		while (remaining > 0) {
+			if (err_ok != linear_hash_read_at(bucket_loc, page_size, page, linear_hash)) {
+				status.error = err_file_read_error;
+				goto cleanup;
+			}
 
-		for (i = 0; i < linear_hash->records_per_bucket; i++) {
-			memcpy(&record_status, records + record_offset, sizeof(record_status));
-			memcpy(record_key, records + record_offset + sizeof(record_status), linear_hash->super.record.key_size);
-			memcpy(record_value, records + record_offset + sizeof(record_status) + linear_hash->super.record.key_size, linear_hash->super.record.value_size);
+			memcpy(&bucket, page, sizeof(linear_hash_bucket_t));
 
-			if (record_status != 0) {
-				if (linear_hash->super.compare(record_key, key, linear_hash->super.record.key_size) == 0) {
-					status.count++;
-					memcpy(value, record_value, linear_hash->super.record.value_size);
-					found = 1;
-					break;
+			/* keys missing from the filter of the chain are not looked for further */
+			if (bucket_idx_to_ion_fpos_t(idx, linear_hash) == bucket_loc) {
+				for (k = first; k < starts[idx]; k++) {
+					if (!linear_hash_chain_holds(&bucket, linear_hash_filter_hash(keys[order[k]], linear_hash))) {
+						remaining--;
+					}
 				}
 			}
 
-			record_offset	+= linear_hash->record_total_size;
-			record_loc		+= linear_hash->record_total_size;
-		}
+			for (j = 0; j < linear_hash->records_per_bucket && remaining > 0; j++) {
+				record = page + sizeof(linear_hash_bucket_t) + j * linear_hash->record_total_size;
 
-		if (found == boolean_false) {
-			if (bucket.overflow_location == linear_hash_end_of_list) {
-				terminal = boolean_true;
-			}
-			else {
-				record_offset	= 0;
-				bucket_loc		= bucket.overflow_location;
-				status.error	= linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
+				if (linear_hash_record_status_empty == *record) {
+					continue;
+				}
 
-				if (status.error != err_ok) {
-					return status;
+				for (k = first; k < starts[idx]; k++) {
+					if ((err_ok != statuses[order[k]].error) && (0 == linear_hash->super.compare(record + sizeof(ion_byte_t), keys[order[k]], linear_hash->super.record.key_size))) {
+						memcpy(values[order[k]], record + sizeof(ion_byte_t) + linear_hash->super.record.key_size, linear_hash->super.record.value_size);
+						statuses[order[k]] = ION_STATUS_OK(1);
+						status.count++;
+						remaining--;
+					}
 				}
 			}
+
+			if (linear_hash_end_of_list == bucket.overflow_location) {
+				break;
+			}
+
+			bucket_loc = bucket.overflow_location;
 		}
-	}
 
-	if (status.count == 0) {
-		status.error = err_item_not_found;
-	}
-	else {
-		status.error = err_ok;
+		first = starts[idx];
 	}
 
+cleanup:
+	free(bucket_of);
+	free(order);
+	free(starts);
+	free(page);
+
 	return status;
 }
 
-/* linear hash operations */
 /**
 @brief		Update the value of the first record matching the key specified in the linear hash.
 @param[in]	key
@@ -801,13 +1799,20 @@ linear_hash_update(
 
 	ion_fpos_t record_loc;
 
-	int				i;
-	ion_boolean_t	terminal = boolean_false;
+	int						i;
+	ion_boolean_t			terminal	= boolean_false;
+	uint64_t				filter_hash	= linear_hash_filter_hash(key, linear_hash);
+	linear_hash_filter_t	key_filter	= LINEAR_HASH_FILTER_BITS(filter_hash);
+
+	/* a key missing from the filter of the chain is in none of its buckets */
+	if (!linear_hash_chain_holds(&bucket, filter_hash)) {
+		terminal = boolean_true;
+	}
 
 	while (terminal == boolean_false) {
 		record_loc = bucket_loc + sizeof(linear_hash_bucket_t);
 
-		for (i = 0; i < linear_hash->records_per_bucket; i++) {
+		for (i = 0; i < linear_hash->records_per_bucket && LINEAR_HASH_FILTER_MAY_HOLD(bucket.key_filter, key_filter); i++) {
 			status.error = linear_hash_get_record(record_loc, record_key, record_value, &record_status, linear_hash);
 
 			if (status.error != err_ok) {
@@ -908,14 +1913,23 @@ linear_hash_delete(
 
 	linear_hash->last_cache_idx = 0;
 
-	ion_boolean_t terminal = boolean_false;
+	ion_boolean_t			terminal	= boolean_false;
+	uint64_t				filter_hash	= linear_hash_filter_hash(key, linear_hash);
+	linear_hash_filter_t	key_filter	= LINEAR_HASH_FILTER_BITS(filter_hash);
+
+	/* a key missing from the filter of the chain is in none of its buckets */
+	if (!linear_hash_chain_holds(&bucket, filter_hash)) {
+		terminal = boolean_true;
+	}
 
 	while (terminal == boolean_false) {
 		record_loc = bucket_loc + sizeof(linear_hash_bucket_t);
-		fseek(linear_hash->database, bucket_loc + sizeof(linear_hash_bucket_t), SEEK_SET);
-		fread(records, linear_hash->record_total_size, linear_hash->records_per_bucket, linear_hash->database);
 
-		for (i = 0; i < bucket.record_count; i++) {
+		if (LINEAR_HASH_FILTER_MAY_HOLD(bucket.key_filter, key_filter)) {
+			linear_hash_read_at(GET_BUCKET_RECORDS_LOC(bucket_loc), linear_hash->record_total_size * linear_hash->records_per_bucket, records, linear_hash);
+		}
+
+		for (i = 0; i < bucket.record_count && LINEAR_HASH_FILTER_MAY_HOLD(bucket.key_filter, key_filter); i++) {
 			/* read in record */
 			memcpy(&record_status, records + record_offset, sizeof(record_status));
 			memcpy(record_key, records + record_offset + sizeof(record_status), linear_hash->super.record.key_size);
@@ -967,6 +1981,16 @@ linear_hash_delete(
 					}
 
 					linear_hash_get_bucket(bucket_loc, &bucket, linear_hash);
+
+					/* the swapped record now lives in this bucket, which must say so */
+					if ((record_loc != swap_record_loc) && !LINEAR_HASH_FILTER_MAY_HOLD(bucket.key_filter, linear_hash_key_filter(terminal_record_key, linear_hash))) {
+						bucket.key_filter	|= linear_hash_key_filter(terminal_record_key, linear_hash);
+						status.error		= linear_hash_update_bucket(bucket_loc, &bucket, linear_hash);
+
+						if (status.error != err_ok) {
+							return status;
+						}
+					}
 				}
 			}
 
@@ -1021,15 +2045,10 @@ linear_hash_get_record(
 	ion_byte_t			*status,
 	linear_hash_table_t *linear_hash
 ) {
-	/* seek to location of record in file */
-	if (0 != fseek(linear_hash->database, loc, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
-
 	/* cache record data from file */
 	ion_byte_t *record = alloca(linear_hash->record_total_size);
 
-	if (1 != fread(record, linear_hash->record_total_size, 1, linear_hash->database)) {
+	if (err_ok != linear_hash_read_at(loc, linear_hash->record_total_size, record, linear_hash)) {
 		return err_file_read_error;
 	}
 
@@ -1064,22 +2083,17 @@ linear_hash_write_record(
 	linear_hash_table_t *linear_hash
 ) {
 	/* check the file is open */
-	if (!linear_hash->database) {
+	if (!LINEAR_HASH_IS_OPEN(linear_hash->database)) {
 		return err_file_close_error;
 	}
 
-	/* seek to end of file to append new bucket */
-	if (0 != fseek(linear_hash->database, record_loc, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
-
 	ion_byte_t *record = alloca(linear_hash->record_total_size);
 
 	memcpy(record, status, sizeof(*status));
 	memcpy(record + sizeof(*status), key, linear_hash->super.record.key_size);
 	memcpy(record + linear_hash->super.record.key_size + sizeof(*status), value, linear_hash->super.record.value_size);
 
-	if (1 != fwrite(record, linear_hash->record_total_size, 1, linear_hash->database)) {
+	if (err_ok != linear_hash_write_at(record_loc, linear_hash->record_total_size, record, linear_hash)) {
 		return err_file_write_error;
 	}
 
@@ -1100,7 +2114,7 @@ write_new_bucket(
 	int					idx,
 	linear_hash_table_t *linear_hash
 ) {
-	if (linear_hash->database == NULL) {
+	if (!LINEAR_HASH_IS_OPEN(linear_hash->database)) {
 		return err_file_open_error;
 	}
 
@@ -1110,43 +2124,106 @@ write_new_bucket(
 	bucket.idx					= idx;
 	bucket.record_count			= 0;
 	bucket.overflow_location	= linear_hash_end_of_list;
+	bucket.key_filter			= 0;
+	bucket.chain_length			= 1;
+	linear_hash_chain_reset(&bucket, 1);
 
 	/* seek to end of file to append new bucket */
 	ion_fpos_t bucket_loc;
 
-	if (0 != fseek(linear_hash->database, 0, SEEK_END)) {
+	if (err_ok != ion_fseek(linear_hash->database, 0, ION_FILE_END)) {
 		return err_file_bad_seek;
 	}
 
-	bucket_loc = ftell(linear_hash->database);
+	bucket_loc = ion_ftell(linear_hash->database);
 
 	/* write bucket data to file */
-	if (1 != fwrite(&bucket, sizeof(linear_hash_bucket_t), 1, linear_hash->database)) {
+	if (err_ok != ion_fwrite(linear_hash->database, sizeof(linear_hash_bucket_t), (ion_byte_t *) &bucket)) {
 		return err_file_write_error;
 	}
 
 	/* write bucket data to file */
 	ion_byte_t record_blank[linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(linear_hash_record_status_empty)];
 
-	memset(record_blank, 0, linear_hash->super.record.key_size + linear_hash->super.record.value_size);
+	memset(record_blank, 0, sizeof(record_blank));
 
 	int i;
 
 	for (i = 0; i < linear_hash->records_per_bucket; i++) {
-		if (1 != fwrite(record_blank, linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(linear_hash_record_status_empty), 1, linear_hash->database)) {
+		if (err_ok != ion_fwrite(linear_hash->database, linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(linear_hash_record_status_empty), record_blank)) {
 			return err_file_write_error;
 		}
 	}
 
-	/* write bucket_loc in mapping */
-	/* store_bucket_loc_in_map(idx, bucket_loc, linear_hash); */
-	ion_err_t err = array_list_insert(idx, bucket_loc, linear_hash->bucket_map);
+	/* write bucket_loc in mapping, and let the grown map reach the state file, so a table left without a
+	 * sync can still be opened */
+	ion_err_t err = linear_hash_map_bucket(idx, bucket_loc, linear_hash);
 
 	if (err != err_ok) {
 		return err;
 	}
 
-	return err_ok;
+	return ion_fflush(linear_hash->state);
+}
+
+/**
+@brief		Queues reads of the overflow buckets chained after a bucket.
+@details	The chain is followed as far as the buckets already read ahead
+			tell, so each walk down it queues about one bucket more. The
+			bucket cache takes each bucket read ahead as the walk reaches
+			it, so it is read only once; a bucket written back before then
+			is dropped from the readahead. Without the cache there is
+			nowhere to keep what is read, so nothing is.
+@param[in]	overflow_loc
+				Location of the first overflow bucket of the chain.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+*/
+static void
+linear_hash_read_ahead(
+	ion_fpos_t			overflow_loc,
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_bucket_t	bucket;
+	ion_byte_t				*bytes;
+	int						i;
+
+	if ((ION_LINEAR_HASH_READAHEAD <= 0) || (0 == linear_hash->buckets.frames)) {
+		return;
+	}
+
+	linear_hash_cache_lock(linear_hash);
+
+	if (linear_hash->no_ahead) {
+		linear_hash_cache_unlock(linear_hash);
+		return;
+	}
+
+	if ((NULL == linear_hash->ahead) && (NULL == (linear_hash->ahead = ion_readahead_open(linear_hash->database, 2 * ION_LINEAR_HASH_READAHEAD, LINEAR_HASH_BUCKET_SIZE(linear_hash))))) {
+		linear_hash->no_ahead = boolean_true;
+		linear_hash_cache_unlock(linear_hash);
+		return;
+	}
+
+	for (i = 0; i < ION_LINEAR_HASH_READAHEAD && linear_hash_end_of_list != overflow_loc; i++) {
+		int frame = linear_hash_cache_lookup(overflow_loc, linear_hash);
+
+		/* a cached bucket needs no read, and may be newer than the file */
+		if (-1 != frame) {
+			memcpy(&bucket, linear_hash->buckets.pages + frame * LINEAR_HASH_BUCKET_SIZE(linear_hash), sizeof(linear_hash_bucket_t));
+			overflow_loc = bucket.overflow_location;
+			continue;
+		}
+
+		if ((err_ok != ion_readahead_queue(linear_hash->ahead, overflow_loc)) || (NULL == (bytes = ion_readahead_peek(linear_hash->ahead, overflow_loc, sizeof(linear_hash_bucket_t))))) {
+			break;
+		}
+
+		memcpy(&bucket, bytes, sizeof(linear_hash_bucket_t));
+		overflow_loc = bucket.overflow_location;
+	}
+
+	linear_hash_cache_unlock(linear_hash);
 }
 
 /**
@@ -1168,18 +2245,13 @@ linear_hash_get_bucket(
 	if (bucket_loc == -1) {}
 
 	/* check if file is open */
-	if (!linear_hash->database) {
+	if (!LINEAR_HASH_IS_OPEN(linear_hash->database)) {
 		return err_file_close_error;
 	}
 
-	/* seek to location of record in file */
-	if (0 != fseek(linear_hash->database, bucket_loc, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
-
 	ion_byte_t *bucket_cache = alloca(sizeof(linear_hash_bucket_t));
 
-	if (1 != fread(bucket_cache, sizeof(linear_hash_bucket_t), 1, linear_hash->database)) {
+	if (err_ok != linear_hash_read_at(bucket_loc, sizeof(linear_hash_bucket_t), bucket_cache, linear_hash)) {
 		return err_file_read_error;
 	}
 
@@ -1187,6 +2259,15 @@ linear_hash_get_bucket(
 	memcpy(&bucket->idx, bucket_cache, sizeof(int));
 	memcpy(&bucket->record_count, bucket_cache + sizeof(int), sizeof(int));
 	memcpy(&bucket->overflow_location, bucket_cache + 2 * sizeof(int), sizeof(ion_fpos_t));
+	memcpy(&bucket->key_filter, bucket_cache + offsetof(linear_hash_bucket_t, key_filter), sizeof(linear_hash_filter_t));
+	memcpy(&bucket->chain_length, bucket_cache + offsetof(linear_hash_bucket_t, chain_length), sizeof(int));
+	memcpy(&bucket->chain_words, bucket_cache + offsetof(linear_hash_bucket_t, chain_words), sizeof(int));
+	memcpy(bucket->chain_filter, bucket_cache + offsetof(linear_hash_bucket_t, chain_filter), sizeof(bucket->chain_filter));
+
+	/* only a walk that has gone past the head of a chain reads the rest ahead, as most stop there */
+	if ((linear_hash_end_of_list != bucket->overflow_location) && (array_list_get(bucket->idx, linear_hash->bucket_map) != bucket_loc)) {
+		linear_hash_read_ahead(bucket->overflow_location, linear_hash);
+	}
 
 	return err_ok;
 }
@@ -1208,17 +2289,12 @@ linear_hash_update_bucket(
 	linear_hash_table_t		*linear_hash
 ) {
 	/* check the file is open */
-	if (NULL == linear_hash->database) {
+	if (!LINEAR_HASH_IS_OPEN(linear_hash->database)) {
 		return err_file_open_error;
 	}
 
-	/* seek to end of file to append new bucket */
-	if (0 != fseek(linear_hash->database, bucket_loc, SEEK_SET)) {
-		return err_file_bad_seek;
-	}
-
 	/* write bucket data to file */
-	if (1 != fwrite(bucket, sizeof(linear_hash_bucket_t), 1, linear_hash->database)) {
+	if (err_ok != linear_hash_write_at(bucket_loc, sizeof(linear_hash_bucket_t), (ion_byte_t *) bucket, linear_hash)) {
 		return err_file_write_error;
 	}
 
@@ -1249,36 +2325,39 @@ create_overflow_bucket(
 
 	bucket.idx					= bucket_idx;
 	bucket.record_count			= 0;
-	bucket.overflow_location	= array_list_get(bucket_idx, linear_hash->bucket_map);
+	bucket.overflow_location	= bucket_idx_to_ion_fpos_t(bucket_idx, linear_hash);
+	bucket.key_filter			= 0;
+	bucket.chain_length			= 1;
+	linear_hash_chain_reset(&bucket, 1);
 
 	/* seek to end of file to append new bucket */
-	if (0 != fseek(linear_hash->database, 0, SEEK_END)) {
+	if (err_ok != ion_fseek(linear_hash->database, 0, ION_FILE_END)) {
 		return err_file_bad_seek;
 	}
 
 	/* get overflow location for new overflow bucket */
-	*overflow_loc	= ftell(linear_hash->database);
+	*overflow_loc	= ion_ftell(linear_hash->database);
 
-	err				= array_list_insert(bucket.idx, *overflow_loc, linear_hash->bucket_map);
+	err				= linear_hash_map_bucket(bucket.idx, *overflow_loc, linear_hash);
 
 	if (err != err_ok) {
 		return err;
 	}
 
 	/* write to file */
-	if (1 != fwrite(&bucket, sizeof(linear_hash_bucket_t), 1, linear_hash->database)) {
+	if (err_ok != ion_fwrite(linear_hash->database, sizeof(linear_hash_bucket_t), (ion_byte_t *) &bucket)) {
 		return err_file_write_error;
 	}
 
 	/* write bucket data to file */
 	ion_byte_t record_blank[linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(linear_hash_record_status_empty)];
 
-	memset(record_blank, 0, linear_hash->super.record.key_size + linear_hash->super.record.value_size);
+	memset(record_blank, 0, sizeof(record_blank));
 
 	int i;
 
 	for (i = 0; i < linear_hash->records_per_bucket; i++) {
-		if (1 != fwrite(record_blank, linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(linear_hash_record_status_empty), 1, linear_hash->database)) {
+		if (err_ok != ion_fwrite(linear_hash->database, linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(linear_hash_record_status_empty), record_blank)) {
 			return err_file_write_error;
 		}
 	}
@@ -1299,7 +2378,18 @@ bucket_idx_to_ion_fpos_t(
 	int					idx,
 	linear_hash_table_t *linear_hash
 ) {
-	return array_list_get(idx, linear_hash->bucket_map);
+	ion_fpos_t bucket_loc = array_list_get(idx, linear_hash->bucket_map);
+
+	/* a reopened table reads each entry of its map the first time it is needed */
+	if (linear_hash_map_unread == bucket_loc) {
+		if (err_ok != ion_fread_at(linear_hash->state, LINEAR_HASH_STATE_MAP_LOC(idx), sizeof(bucket_loc), (ion_byte_t *) &bucket_loc)) {
+			return linear_hash_end_of_list;
+		}
+
+		linear_hash->bucket_map->data[idx] = bucket_loc;
+	}
+
+	return bucket_loc;
 }
 
 /**
@@ -1320,13 +2410,223 @@ key_bytes_to_int(
 	int			key_bytes_as_int	= 0;
 	static int	coefficients[]		= { 3, 5, 7, 11, 13, 17, 19 };
 
+	/* keys longer than the coefficients reuse them, rather than reading past them */
 	for (i = 0; i < linear_hash->super.record.key_size - 1; i++) {
-		key_bytes_as_int += *(key + i) * coefficients[i + 1] - *(key + i) * coefficients[i];
+		key_bytes_as_int += *(key + i) * coefficients[i % 6 + 1] - *(key + i) * coefficients[i % 6];
 	}
 
 	return key_bytes_as_int;
 }
 
+/* the secrets of wyhash */
+static const uint64_t linear_hash_wyp[4] = {
+	0x2D358DCCAA6C78A5ULL, 0x8BB84B93962EACC9ULL, 0x4B33A62ED433D4A3ULL, 0x4D5A2DA51DE1AA47ULL
+};
+
+/**
+@brief		Multiplies @p a by @p b, leaving the low half of the 128 bit
+			product in @p a and the high half in @p b.
+*/
+static void
+linear_hash_wymum(
+	uint64_t	*a,
+	uint64_t	*b
+) {
+#if defined(__SIZEOF_INT128__)
+	__extension__ unsigned __int128 product = (unsigned __int128) *a * *b;
+
+	*a	= (uint64_t) product;
+	*b	= (uint64_t) (product >> 64);
+#else
+	/* four 32 bit products, for targets without a 128 bit type */
+	uint64_t	high	= (*a >> 32) * (*b >> 32);
+	uint64_t	cross0	= (*a >> 32) * (uint32_t) *b;
+	uint64_t	cross1	= (*b >> 32) * (uint32_t) *a;
+	uint64_t	low		= (uint64_t) (uint32_t) *a * (uint32_t) *b;
+	uint64_t	sum		= low + (cross0 << 32);
+	uint64_t	carry	= sum < low;
+
+	low		= sum + (cross1 << 32);
+	carry	+= low < sum;
+	*a		= low;
+	*b		= high + (cross0 >> 32) + (cross1 >> 32) + carry;
+#endif
+}
+
+/**
+@brief		Folds the 128 bit product of @p a and @p b into 64 bits.
+*/
+static uint64_t
+linear_hash_wymix(
+	uint64_t	a,
+	uint64_t	b
+) {
+	linear_hash_wymum(&a, &b);
+	return a ^ b;
+}
+
+/**
+@brief		Reads @p num_bytes bytes, 4 or 8, of a key as an integer.
+*/
+static uint64_t
+linear_hash_wyread(
+	ion_byte_t	*bytes,
+	int			num_bytes
+) {
+	uint64_t	wide;
+	uint32_t	narrow;
+
+	if (8 == num_bytes) {
+		memcpy(&wide, bytes, sizeof(wide));
+		return wide;
+	}
+
+	memcpy(&narrow, bytes, sizeof(narrow));
+	return narrow;
+}
+
+/**
+@brief		Hashes a key with wyhash.
+@details	Keys of 4 and 8 bytes, the numeric keys, are mixed as a single
+			integer in two multiplications.
+@param[in]	key
+				Pointer to the key to hash.
+@param[in]	length
+				The size of the key in bytes.
+@param[in]	seed
+				The seed of the table.
+@return		The hash of the key.
+*/
+static uint64_t
+linear_hash_wyhash(
+	ion_byte_t	*key,
+	int			length,
+	uint64_t	seed
+) {
+	uint64_t	a;
+	uint64_t	b;
+	uint64_t	see1;
+	uint64_t	see2;
+	int			i;
+
+	if ((4 == length) || (8 == length)) {
+		a	= linear_hash_wyread(key, length) ^ linear_hash_wyp[0];
+		b	= seed ^ linear_hash_wyp[1];
+		linear_hash_wymum(&a, &b);
+		return linear_hash_wymix(a ^ linear_hash_wyp[0], b ^ linear_hash_wyp[1]);
+	}
+
+	seed ^= linear_hash_wymix(seed ^ linear_hash_wyp[0], linear_hash_wyp[1]);
+
+	if (length <= 16) {
+		if (length >= 4) {
+			a	= (linear_hash_wyread(key, 4) << 32) | linear_hash_wyread(key + ((length >> 3) << 2), 4);
+			b	= (linear_hash_wyread(key + length - 4, 4) << 32) | linear_hash_wyread(key + length - 4 - ((length >> 3) << 2), 4);
+		}
+		else if (length > 0) {
+			a	= ((uint64_t) key[0] << 16) | ((uint64_t) key[length >> 1] << 8) | key[length - 1];
+			b	= 0;
+		}
+		else {
+			a	= 0;
+			b	= 0;
+		}
+	}
+	else {
+		i = length;
+
+		if (i >= 48) {
+			see1	= seed;
+			see2	= seed;
+
+			do {
+				seed	= linear_hash_wymix(linear_hash_wyread(key, 8) ^ linear_hash_wyp[1], linear_hash_wyread(key + 8, 8) ^ seed);
+				see1	= linear_hash_wymix(linear_hash_wyread(key + 16, 8) ^ linear_hash_wyp[2], linear_hash_wyread(key + 24, 8) ^ see1);
+				see2	= linear_hash_wymix(linear_hash_wyread(key + 32, 8) ^ linear_hash_wyp[3], linear_hash_wyread(key + 40, 8) ^ see2);
+				key		+= 48;
+				i		-= 48;
+			} while (i >= 48);
+
+			seed ^= see1 ^ see2;
+		}
+
+		while (i > 16) {
+			seed	= linear_hash_wymix(linear_hash_wyread(key, 8) ^ linear_hash_wyp[1], linear_hash_wyread(key + 8, 8) ^ seed);
+			key		+= 16;
+			i		-= 16;
+		}
+
+		a	= linear_hash_wyread(key + i - 16, 8);
+		b	= linear_hash_wyread(key + i - 8, 8);
+	}
+
+	a	^= linear_hash_wyp[1];
+	b	^= seed;
+	linear_hash_wymum(&a, &b);
+
+	return linear_hash_wymix(a ^ linear_hash_wyp[0] ^ (uint64_t) length, b ^ linear_hash_wyp[1]);
+}
+
+/**
+@brief		Hash a key with the hash of the linear hash.
+@param[in]	key
+				Pointer to the key to hash
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		The hash of the key. Buckets are addressed by its low bits.
+*/
+uint64_t
+linear_hash_key_hash(
+	ion_byte_t			*key,
+	linear_hash_table_t *linear_hash
+) {
+	if (linear_hash_hash_polynomial == linear_hash->hash) {
+		return (unsigned int) key_bytes_to_int(key, linear_hash);
+	}
+
+	return linear_hash_wyhash(key, linear_hash->super.record.key_size, linear_hash->seed);
+}
+
+/**
+@brief		Compute the bits a key sets in the filters of the buckets holding it.
+@details	The hash is mixed again, so the bits do not follow the low bits that address the bucket, and two bits
+			are taken from the top.
+@param[in]	key
+				Pointer to the key to hash
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		The filter of the key.
+*/
+linear_hash_filter_t
+linear_hash_key_filter(
+	ion_byte_t			*key,
+	linear_hash_table_t *linear_hash
+) {
+	uint64_t hash = linear_hash_filter_hash(key, linear_hash);
+
+	return LINEAR_HASH_FILTER_BITS(hash);
+}
+
+/**
+@brief		Whether the filter of a bucket chain may hold a key.
+@details	The key sets its bits in one word of the filter, picked by other bits of the same hash.
+@param[in]	bucket
+				The head of the chain.
+@param[in]	key
+				Pointer to the key to look for.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+@return		boolean_false when no bucket of the chain holds the key.
+*/
+ion_boolean_t
+linear_hash_chain_may_hold(
+	linear_hash_bucket_t	*bucket,
+	ion_byte_t				*key,
+	linear_hash_table_t		*linear_hash
+) {
+	return linear_hash_chain_holds(bucket, linear_hash_filter_hash(key, linear_hash));
+}
+
 /**
 @brief		Map a key to the address space of the linear hash. Used to map records to buckets with an index greater than or equal to the split pointer.
 @param[in]	key
@@ -1341,9 +2641,7 @@ hash_to_bucket(
 	linear_hash_table_t *linear_hash
 ) {
 	/* Case the record we are looking for was in a bucket that has already been split and h1 was used */
-	int key_bytes_as_int = key_bytes_to_int(key, linear_hash);
-
-	return key_bytes_as_int & ((2 * linear_hash->initial_size) - 1);
+	return (int) (linear_hash_key_hash(key, linear_hash) & ((2 * linear_hash->initial_size) - 1));
 }
 
 /**
@@ -1359,9 +2657,7 @@ insert_hash_to_bucket(
 	ion_byte_t			*key,
 	linear_hash_table_t *linear_hash
 ) {
-	int key_bytes_as_int = key_bytes_to_int(key, linear_hash);
-
-	return key_bytes_as_int & (linear_hash->initial_size - 1);
+	return (int) (linear_hash_key_hash(key, linear_hash) & (linear_hash->initial_size - 1));
 }
 
 /* ARRAY LIST METHODS */
@@ -1466,8 +2762,33 @@ ion_err_t
 linear_hash_close(
 	linear_hash_table_t *linear_hash
 ) {
-	if (0 != fclose(linear_hash->state)) {
-		linear_hash_write_state(linear_hash);
+	/* the readahead reads the data file until it is closed */
+	ion_readahead_close(linear_hash->ahead);
+	linear_hash->ahead = NULL;
+
+	ion_err_t flushed = err_ok;
+
+	if (LINEAR_HASH_IS_OPEN(linear_hash->database)) {
+		flushed = linear_hash_cache_flush(linear_hash);
+	}
+
+	free(linear_hash->buckets.locs);
+	free(linear_hash->buckets.flags);
+	free(linear_hash->buckets.pages);
+	linear_hash->buckets.locs	= NULL;
+	linear_hash->buckets.flags	= NULL;
+	linear_hash->buckets.pages	= NULL;
+	linear_hash->buckets.frames = 0;
+#if !defined(ARDUINO)
+	pthread_mutex_destroy(&linear_hash->buckets.lock);
+#endif
+
+	if (LINEAR_HASH_IS_OPEN(linear_hash->state) && (err_ok == flushed)) {
+		flushed = linear_hash_write_state(linear_hash);
+	}
+
+	/* a table that failed to open may not have both files */
+	if (LINEAR_HASH_IS_OPEN(linear_hash->state) && (err_ok != ion_fclose(linear_hash->state))) {
 		return err_file_close_error;
 	}
 
@@ -1481,7 +2802,7 @@ linear_hash_close(
 		linear_hash->bucket_map = NULL;
 	}
 
-	if (0 != fclose(linear_hash->database)) {
+	if (LINEAR_HASH_IS_OPEN(linear_hash->database) && (err_ok != ion_fclose(linear_hash->database))) {
 		return err_file_close_error;
 	}
 
@@ -1490,11 +2811,68 @@ linear_hash_close(
 		linear_hash->bucket_map = NULL;
 	}
 
-	linear_hash->database	= NULL;
+	linear_hash->database	= ION_NOFILE;
 
-	linear_hash->state		= NULL;
+	linear_hash->state		= ION_NOFILE;
 
-	return err_ok;
+	return flushed;
+}
+
+/**
+@brief		Writes the state of a linear hash, and its buckets, through to
+			storage.
+@param[in]	linear_hash
+				The linear hash instance to sync.
+@return		Resulting status of the several file operations used to commit the write.
+*/
+ion_err_t
+linear_hash_sync(
+	linear_hash_table_t *linear_hash
+) {
+	ion_err_t err;
+
+	err = linear_hash_write_state(linear_hash);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	err = ion_fsync(linear_hash->state);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	err = linear_hash_cache_flush(linear_hash);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	return ion_fsync(linear_hash->database);
+}
+
+/**
+@brief		Hold the writes to a linear hash instance's .lhs and .lhd files in memory until they are written back, or let them through again.
+@param[in]	linear_hash
+				The linear hash instance.
+@param[in]	writeback
+				The files to write back with, or NULL to let writes
+				through.
+@return		Resulting status of the several file operations used to let the writes through.
+*/
+ion_err_t
+linear_hash_hold(
+	linear_hash_table_t		*linear_hash,
+	ion_file_writeback_t	*writeback
+) {
+	ion_err_t err = ion_fhold(linear_hash->state, writeback);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	return ion_fhold(linear_hash->database, writeback);
 }
 
 /**
@@ -1529,3 +2907,72 @@ linear_hash_destroy(
 
 	return err_ok;
 }
+
+/* chains of this many buckets or more are counted together */
+#define LINEAR_HASH_DISTRIBUTION_CHAINS 8
+
+/**
+@brief		Prints how the records of a linear hash are spread over its
+			buckets: the number of empty buckets, the longest overflow
+			chain, and how many buckets have chains of each length.
+@param[in]	linear_hash
+				Pointer to a linear hash instance.
+*/
+void
+print_linear_hash_distribution(
+	linear_hash_table_t *linear_hash
+) {
+	linear_hash_bucket_t	bucket;
+	ion_fpos_t				bucket_loc;
+	int						chains[LINEAR_HASH_DISTRIBUTION_CHAINS];
+	int						records;
+	int						empty;
+	int						longest;
+	int						length;
+	int						held;
+	int						i;
+
+	memset(chains, 0, sizeof(chains));
+	records = 0;
+	empty	= 0;
+	longest = 0;
+
+	for (i = 0; i < linear_hash->num_buckets; i++) {
+		bucket_loc	= bucket_idx_to_ion_fpos_t(i, linear_hash);
+		length		= 0;
+		held		= 0;
+
+		while (linear_hash_end_of_list != bucket_loc) {
+			if (err_ok != linear_hash_get_bucket(bucket_loc, &bucket, linear_hash)) {
+				printf("bucket %d could not be read\n", i);
+				return;
+			}
+
+			length++;
+			held		+= bucket.record_count;
+			bucket_loc	= bucket.overflow_location;
+		}
+
+		records += held;
+
+		if (0 == held) {
+			empty++;
+		}
+
+		if (length > longest) {
+			longest = length;
+		}
+
+		if (0 < length) {
+			chains[(length < LINEAR_HASH_DISTRIBUTION_CHAINS ? length : LINEAR_HASH_DISTRIBUTION_CHAINS) - 1]++;
+		}
+	}
+
+	printf("%d records in %d buckets, %d empty, longest chain %d buckets\n", records, linear_hash->num_buckets, empty, longest);
+
+	for (i = 0; i < LINEAR_HASH_DISTRIBUTION_CHAINS; i++) {
+		if (0 != chains[i]) {
+			printf("\tchains of %d%s buckets: %d\n", i + 1, LINEAR_HASH_DISTRIBUTION_CHAINS - 1 == i ? " or more" : "", chains[i]);
+		}
+	}
+}
@@ -54,6 +54,22 @@ linear_hash_init(
 	linear_hash_table_t		*linear_hash
 );
 
+/* initialization with a chosen hash; an existing table keeps the hash in its state file */
+ion_err_t
+linear_hash_init_hash(
+	ion_dictionary_id_t		id,
+	ion_dictionary_size_t	dictionary_size,
+	ion_key_type_t			key_type,
+	ion_key_size_t			key_size,
+	ion_value_size_t		value_size,
+	int						initial_size,
+	int						split_threshold,
+	int						records_per_bucket,
+	linear_hash_hash_t		hash,
+	uint64_t				seed,
+	linear_hash_table_t		*linear_hash
+);
+
 ion_err_t
 linear_hash_read_state(
 	linear_hash_table_t *linear_hash
@@ -105,6 +121,20 @@ linear_hash_insert(
 	linear_hash_table_t *linear_hash
 );
 
+ion_status_t
+linear_hash_insert_group(
+	ion_record_t		*records,
+	ion_result_count_t	count,
+	linear_hash_table_t *linear_hash
+);
+
+ion_status_t
+linear_hash_insert_batch(
+	ion_record_t		*records,
+	ion_result_count_t	count,
+	linear_hash_table_t *linear_hash
+);
+
 /* linear hash operations */
 ion_status_t
 linear_hash_get(
@@ -113,6 +143,15 @@ linear_hash_get(
 	linear_hash_table_t *linear_hash
 );
 
+ion_status_t
+linear_hash_get_many(
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses,
+	linear_hash_table_t *linear_hash
+);
+
 ion_status_t
 linear_hash_update(
 	ion_key_t			key,
@@ -193,6 +232,25 @@ invalidate_buffer_records(
 );
 
 /* hash methods */
+uint64_t
+linear_hash_key_hash(
+	ion_byte_t			*key,
+	linear_hash_table_t *linear_hash
+);
+
+linear_hash_filter_t
+linear_hash_key_filter(
+	ion_byte_t			*key,
+	linear_hash_table_t *linear_hash
+);
+
+ion_boolean_t
+linear_hash_chain_may_hold(
+	linear_hash_bucket_t	*bucket,
+	ion_byte_t				*key,
+	linear_hash_table_t		*linear_hash
+);
+
 int
 hash_to_bucket(
 	ion_byte_t			*key,
@@ -266,6 +324,17 @@ linear_hash_destroy(
 	linear_hash_table_t *linear_hash
 );
 
+ion_err_t
+linear_hash_sync(
+	linear_hash_table_t *linear_hash
+);
+
+ion_err_t
+linear_hash_hold(
+	linear_hash_table_t		*linear_hash,
+	ion_file_writeback_t	*writeback
+);
+
 ion_err_t
 linear_hash_close(
 	linear_hash_table_t *linear_hash
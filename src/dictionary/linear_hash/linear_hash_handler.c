@@ -41,15 +41,22 @@ linear_hash_dict_init(
 	ion_dictionary_handler_t *handler
 ) {
 	handler->insert				= linear_hash_dict_insert;
+	handler->insert_batch		= linear_hash_dict_insert_batch;
 	handler->get				= linear_hash_dict_get;
+	handler->get_many			= linear_hash_dict_get_many;
+	handler->get_ref			= NULL;
 	handler->create_dictionary	= linear_hash_create_dictionary;
 	handler->remove				= linear_hash_dict_delete;
 	handler->delete_dictionary	= linear_hash_delete_dictionary;
 	handler->destroy_dictionary = linear_hash_destroy_dictionary;
 	handler->update				= linear_hash_dict_update;
-	/* handler->find				= linear_hash_dict_find; */
+	handler->find				= NULL;	/* linear_hash_dict_find is not implemented yet. */
 	handler->close_dictionary	= linear_hash_close_dictionary;
+	handler->sync				= linear_hash_sync_dictionary;
+	handler->hold				= linear_hash_hold_dictionary;
 	handler->open_dictionary	= linear_hash_open_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_false;
 }
 
 ion_status_t
@@ -61,6 +68,15 @@ linear_hash_dict_insert(
 	return linear_hash_insert(key, value, insert_hash_to_bucket(key, (linear_hash_table_t *) dictionary->instance), (linear_hash_table_t *) dictionary->instance);
 }
 
+ion_status_t
+linear_hash_dict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+) {
+	return linear_hash_insert_batch(records, count, (linear_hash_table_t *) dictionary->instance);
+}
+
 ion_status_t
 linear_hash_dict_get(
 	ion_dictionary_t	*dictionary,
@@ -70,6 +86,17 @@ linear_hash_dict_get(
 	return linear_hash_get(key, value, (linear_hash_table_t *) dictionary->instance);
 }
 
+ion_status_t
+linear_hash_dict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	return linear_hash_get_many(keys, count, values, statuses, (linear_hash_table_t *) dictionary->instance);
+}
+
 ion_status_t
 linear_hash_dict_update(
 	ion_dictionary_t	*dictionary,
@@ -183,6 +210,21 @@ linear_hash_close_dictionary(
 	return err_ok;
 }
 
+ion_err_t
+linear_hash_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return linear_hash_sync((linear_hash_table_t *) dictionary->instance);
+}
+
+ion_err_t
+linear_hash_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+) {
+	return linear_hash_hold((linear_hash_table_t *) dictionary->instance, writeback);
+}
+
 ion_status_t
 linear_hash_dict_find(
 	ion_dictionary_t *dictionary
@@ -76,6 +76,24 @@ linear_hash_dict_insert(
 	ion_value_t			value
 );
 
+/**
+@brief	  Inserts a batch of records into the dictionary.
+
+@param	  dictionary
+				The dictionary instance to insert the records into.
+@param	  records
+				The records to insert.
+@param	  count
+				The number of records in @p records.
+@return	 Status of insertion.
+*/
+ion_status_t
+linear_hash_dict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+);
+
 /**
 @brief	  Creates an instance of a dictionary.
 
@@ -117,6 +135,17 @@ linear_hash_close_dictionary(
 	ion_dictionary_t *dictionary
 );
 
+ion_err_t
+linear_hash_sync_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+ion_err_t
+linear_hash_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+);
+
 ion_err_t
 linear_hash_open_dictionary(
 	ion_dictionary_handler_t		*handler,
@@ -132,6 +161,30 @@ linear_hash_dict_get(
 	ion_value_t			value
 );
 
+/**
+@brief	  Queries the dictionary for many keys at once.
+
+@param	  dictionary
+				The dictionary instance to query.
+@param	  keys
+				The keys to look up.
+@param	  count
+				The number of keys in @p keys.
+@param	  values
+				Where to write the value found for each key.
+@param	  statuses
+				Where to write the status of each lookup.
+@return	 Status of the lookups.
+*/
+ion_status_t
+linear_hash_dict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+);
+
 /**
 @brief	  Deletes the @p key and associated value from the given dictionary
 			instance.
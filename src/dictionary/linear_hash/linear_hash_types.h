@@ -37,31 +37,113 @@
 #include <stdio.h>
 #include "../../key_value/kv_system.h"
 #include "../dictionary.h"
-#include "../../file/sd_stdio_c_iface.h"
+#include "../../file/ion_file.h"
+#include "../../file/ion_readahead.h"
 
 typedef ion_byte_t *linear_hash_record_status_t;
 
 #define linear_hash_end_of_list			-1
+#define linear_hash_map_unread			-2
 #define linear_hash_record_status_empty 0
 #define linear_hash_record_status_full	1
 
+/* overflow buckets queued ahead of a walk down a bucket's chain */
+#if !defined(ION_LINEAR_HASH_READAHEAD)
+#if defined(ARDUINO)
+#define ION_LINEAR_HASH_READAHEAD 0
+#else
+#define ION_LINEAR_HASH_READAHEAD 4
+#endif
+#endif
+
+/* buckets each table keeps in memory, written back when evicted, synced or closed */
+#if !defined(ION_LINEAR_HASH_CACHE_BUCKETS)
+#if defined(ARDUINO)
+#define ION_LINEAR_HASH_CACHE_BUCKETS 0
+#else
+#define ION_LINEAR_HASH_CACHE_BUCKETS 32
+#endif
+#endif
+
+/* how keys are mapped to buckets, kept in the state file */
+typedef enum {
+	/* the polynomial over the key bytes of tables written before hashes were recorded */
+	linear_hash_hash_polynomial = 0,
+	/* wyhash over the whole key, seeded */
+	linear_hash_hash_wyhash		= 1
+} linear_hash_hash_t;
+
+/* the hash given to new tables */
+#if !defined(ION_LINEAR_HASH_FUNCTION)
+#define ION_LINEAR_HASH_FUNCTION linear_hash_hash_wyhash
+#endif
+
+/* the seed given to new tables */
+#if !defined(ION_LINEAR_HASH_SEED)
+#define ION_LINEAR_HASH_SEED 0x9E3779B97F4A7C15ULL
+#endif
+
 /* SIMPLE ARRAY_LIST FOR BUCKET MAP */
 typedef struct {
 	int			current_size;
 	ion_fpos_t	*data;
 } array_list_t;
 
+/* whole buckets kept in memory, evicted by CLOCK */
+typedef struct {
+	/* the location of the bucket in each frame, or linear_hash_end_of_list */
+	ion_fpos_t		*locs;
+	/* whether each frame was used since the hand passed it, and whether it differs from the file */
+	ion_byte_t		*flags;
+	/* the bucket in each frame, its header then its records */
+	ion_byte_t		*pages;
+	/* zero when the cache is off */
+	int				frames;
+	/* the next frame to consider for eviction */
+	int				hand;
+	/* the frame found last, tried first */
+	int				last;
+	/* bucket reads served from memory */
+	unsigned long	hits;
+	/* bucket reads that went to the file */
+	unsigned long	misses;
+#if !defined(ARDUINO)
+	/* guards the frames and the readahead, so readers sharing the dictionary lock use them in turn */
+	pthread_mutex_t lock;
+#endif
+} linear_hash_cache_t;
+
 /* definition of linear hash record, with a type and pointer instance declared for later use */
 typedef struct {
 	ion_key_t	key;
 	ion_value_t value;
 } linear_hash_record_t;
 
+/* a few bits a key, set for each key a bucket holds; a key whose bits are not all set is not there */
+typedef uint64_t linear_hash_filter_t;
+
+/* the most words of filter a bucket chain keeps for its keys, a power of two; a chain uses more of them as it grows */
+#if !defined(ION_LINEAR_HASH_CHAIN_FILTER_WORDS)
+#if defined(ARDUINO)
+#define ION_LINEAR_HASH_CHAIN_FILTER_WORDS 1
+#else
+#define ION_LINEAR_HASH_CHAIN_FILTER_WORDS 8
+#endif
+#endif
+
 /* buckets */
 typedef struct {
-	int			idx;
-	int			record_count;
-	ion_fpos_t	overflow_location;
+	int						idx;
+	int						record_count;
+	ion_fpos_t				overflow_location;
+	/* the keys of the records in this bucket */
+	linear_hash_filter_t	key_filter;
+	/* the number of buckets in the chain from this one on */
+	int						chain_length;
+	/* the words of chain_filter in use, a power of two; each key sets its bits in one of them */
+	int						chain_words;
+	/* the keys of the records in this bucket and those after it, kept whole for the head of the chain */
+	linear_hash_filter_t	chain_filter[ION_LINEAR_HASH_CHAIN_FILTER_WORDS];
 } linear_hash_bucket_t;
 
 /* function pointer syntax: return_type (*function_name) (arg_type) */
@@ -77,8 +159,10 @@ typedef struct {
 	int						num_records;
 	int						records_per_bucket;
 	ion_fpos_t				record_total_size;
-	FILE					*database;
-	FILE					*state;
+	linear_hash_hash_t		hash;
+	uint64_t				seed;
+	ion_file_handle_t		database;
+	ion_file_handle_t		state;
 
 	/* maps the location of the head of the linked list of buckets corresponding to its index */
 	array_list_t			*bucket_map;
@@ -89,6 +173,13 @@ typedef struct {
 
 	/* pointer location of the next record to swap-on-delete*/
 	ion_fpos_t				swap_bucket_loc;
+
+	/* overflow buckets read ahead, opened once a chain is first found */
+	ion_readahead_t			*ahead;
+	ion_boolean_t			no_ahead;
+
+	/* recently used buckets, so hot keys are found without the file */
+	linear_hash_cache_t		buckets;
 } linear_hash_table_t;
 
 /* typedef struct { */
@@ -41,16 +41,29 @@
 /******************************************************************************/
 
 #include "open_address_file_hash.h"
+#include "../../file/ion_file.h"
 
 #define ION_TEST_FILE "file.bin"
 
+/**
+@brief		How many empty buckets are written at a time when a hash map
+			is created.
+*/
+#define ION_OAFH_INIT_BUCKETS 64
+
 ion_err_t
 oafh_close(
 	ion_file_hashmap_t *hash_map
 ) {
-	if (NULL != hash_map->file) {
+#if defined(ARDUINO)
+
+	if (NULL != hash_map->file.file) {
+#else
+
+	if (ION_NOFILE != hash_map->file) {
+#endif
 		/* check to ensure that you are not freeing something already free */
-		fclose(hash_map->file);
+		ion_fclose(hash_map->file);
 		free(hash_map);
 		return err_ok;
 	}
@@ -59,6 +72,43 @@ oafh_close(
 	}
 }
 
+ion_err_t
+oafh_sync(
+	ion_file_hashmap_t *hash_map
+) {
+	return ion_fsync(hash_map->file);
+}
+
+ion_err_t
+oafh_hold(
+	ion_file_hashmap_t		*hash_map,
+	ion_file_writeback_t	*writeback
+) {
+	return ion_fhold(hash_map->file, writeback);
+}
+
+ion_hash_bucket_t *
+oafh_read_bucket(
+	ion_file_hashmap_t	*hash_map,
+	int					location,
+	ion_hash_bucket_t	*buffer
+) {
+	int					record_size = SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size;
+	ion_hash_bucket_t	*bucket;
+
+	bucket = (ion_hash_bucket_t *) ion_fmap_at(hash_map->file, (ion_file_offset_t) location * record_size, record_size);
+
+	if (NULL != bucket) {
+		return bucket;
+	}
+
+	if (err_ok != ion_fread_at(hash_map->file, (ion_file_offset_t) location * record_size, record_size, (ion_byte_t *) buffer)) {
+		return NULL;
+	}
+
+	return buffer;
+}
+
 ion_err_t
 oafh_initialize(
 	ion_file_hashmap_t *hashmap,
@@ -89,43 +139,60 @@ oafh_initialize(
 		return err_uninitialized;
 	}
 
-	hashmap->file = fopen(addr_filename, "r+b");
+	ion_boolean_t exists = ion_fexists(addr_filename);
 
-	if (NULL != hashmap->file) {
-		return err_ok;
+	hashmap->file = ion_fopen(addr_filename);
+
+#if defined(ARDUINO)
+
+	if (NULL == hashmap->file.file) {
+#else
+
+	if (ION_NOFILE == hashmap->file) {
+#endif
+		return err_file_open_error;
 	}
 
-	/* open the file */
-	hashmap->file = fopen(addr_filename, "w+b");
+	if (exists) {
+		return err_ok;
+	}
 
-	ion_hash_bucket_t *file_record;
+	ion_byte_t *file_records;
 
 	int record_size = SIZEOF(STATUS) + hashmap->super.record.key_size + hashmap->super.record.value_size;
 
-	file_record			= calloc(record_size, 1);
-	file_record->status = ION_EMPTY;
+	file_records = calloc(ION_OAFH_INIT_BUCKETS, record_size);
+
+	if (NULL == file_records) {
+		ion_fclose(hashmap->file);
+		return err_out_of_memory;
+	}
 
 	/* write out the records to disk to prep */
 #if ION_DEBUG
 	printf("Initializing hash table\n");
 #endif
 
-	int i, writes = 0;
+	int			i, count;
+	ion_err_t	err = err_ok;
 
-	for (i = 0; i < hashmap->map_size; i++) {
-		writes	+= fwrite(&file_record->status, SIZEOF(STATUS), 1, hashmap->file);
-		writes	+= fwrite(file_record->data, record_size - SIZEOF(STATUS), 1, hashmap->file);
+	for (i = 0; i < ION_OAFH_INIT_BUCKETS; i++) {
+		((ion_hash_bucket_t *) (file_records + i * record_size))->status = ION_EMPTY;
 	}
 
-	fflush(hashmap->file);
+	/* the empty buckets are written a batch at a time, so a mapped file grows seldom */
+	for (i = 0; i < hashmap->map_size && err_ok == err; i += count) {
+		count	= hashmap->map_size - i < ION_OAFH_INIT_BUCKETS ? hashmap->map_size - i : ION_OAFH_INIT_BUCKETS;
+		err		= ion_fwrite(hashmap->file, count * record_size, file_records);
+	}
+
+	free(file_records);
 
-	if (writes / 2 != hashmap->map_size) {
-		fclose(hashmap->file);
+	if (err_ok != err) {
+		ion_fclose(hashmap->file);
 		return err_file_write_error;
 	}
 
-	free(file_record);
-
 	return err_ok;
 }
 
@@ -154,11 +221,17 @@ oafh_destroy(
 		return err_dictionary_destruction_error;
 	}
 
-	if (hash_map->file != NULL) {
+#if defined(ARDUINO)
+
+	if (NULL != hash_map->file.file) {
+#else
+
+	if (ION_NOFILE != hash_map->file) {
+#endif
 		/* check to ensure that you are not freeing something already free */
-		fclose(hash_map->file);
+		ion_fclose(hash_map->file);
 		fremove(addr_filename);
-		hash_map->file = NULL;
+		hash_map->file = ION_NOFILE;
 		return err_ok;
 	}
 	else {
@@ -195,25 +268,34 @@ oafh_insert(
 	/* Scan until find an empty location - oah_insert if found */
 	int count		= 0;
 
-	ion_hash_bucket_t *item;
+	ion_hash_bucket_t	*item;
+	ion_hash_bucket_t	*bucket;
+	ion_err_t			err;
 
 	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
 	item = malloc(record_size);
 
-	/* set file position */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	if (NULL == item) {
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
 
 	while (count != hash_map->map_size) {
-		fread(item, record_size, 1, hash_map->file);
+		bucket = oafh_read_bucket(hash_map, loc, item);
+
+		if (NULL == bucket) {
+			free(item);
+			return ION_STATUS_ERROR(err_file_read_error);
+		}
+
 #if ION_DEBUG
-		DUMP((int) ftell(hash_map->file), "%i");
+		DUMP(loc * record_size, "%i");
 #endif
 
-		if (item->status == ION_IN_USE) {
+		if (bucket->status == ION_IN_USE) {
 			/* if a cell is in use, need to key to */
 
-			if (hash_map->super.compare(item->data, key, hash_map->super.record.key_size) == ION_IS_EQUAL) {
+			if (hash_map->super.compare(bucket->data, key, hash_map->super.record.key_size) == ION_IS_EQUAL) {
 				if (hash_map->write_concern == wc_insert_unique) {
 					/* allow unique entries only */
 					free(item);
@@ -221,15 +303,12 @@ oafh_insert(
 				}
 				else if (hash_map->write_concern == wc_update) {
 					/* allows for values to be updated											// */
-					/* backup and write */
-					fseek(hash_map->file, SIZEOF(STATUS) + hash_map->super.record.key_size - record_size, SEEK_CUR);
 #if ION_DEBUG
-					DUMP((int) ftell(hash_map->file), "%i");
 					DUMP(value, "%s");
 #endif
-					fwrite(value, hash_map->super.record.value_size, 1, hash_map->file);
+					err = ion_fwrite_at(hash_map->file, (ion_file_offset_t) loc * record_size + SIZEOF(STATUS) + hash_map->super.record.key_size, hash_map->super.record.value_size, value);
 					free(item);
-					return ION_STATUS_OK(1);
+					return err_ok == err ? ION_STATUS_OK(1) : ION_STATUS_ERROR(err_file_write_error);
 				}
 				else {
 					free(item);
@@ -237,20 +316,16 @@ oafh_insert(
 				}
 			}
 		}
-		else if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
+		else if ((bucket->status == ION_EMPTY) || (bucket->status == ION_DELETED)) {
 			/* problem is here with base types as it is just an array of data.  Need better way */
 			/* printf("empty\n"); */
-			fseek(hash_map->file, -record_size, SEEK_CUR);
-#if ION_DEBUG
-			DUMP((int) ftell(hash_map->file), "%i");
-#endif
 			item->status = ION_IN_USE;
 			memcpy(item->data, key, (hash_map->super.record.key_size));
 			memcpy(item->data + hash_map->super.record.key_size, value, (hash_map->super.record.value_size));
-			fwrite(item, record_size, 1, hash_map->file);
+			err = ion_fwrite_at(hash_map->file, (ion_file_offset_t) loc * record_size, record_size, (ion_byte_t *) item);
 			free(item);
 
-			return ION_STATUS_OK(1);
+			return err_ok == err ? ION_STATUS_OK(1) : ION_STATUS_ERROR(err_file_write_error);
 		}
 
 		loc++;
@@ -258,8 +333,6 @@ oafh_insert(
 		if (loc >= hash_map->map_size) {
 			/* Perform wrapping */
 			loc = 0;
-			/* rewind the file */
-			frewind(hash_map->file);
 		}
 
 #if ION_DEBUG
@@ -289,29 +362,35 @@ oafh_find_item_loc(
 
 	int count		= 0;
 
-	ion_hash_bucket_t *item;
+	ion_hash_bucket_t	*item;
+	ion_hash_bucket_t	*bucket;
 
 	int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
 	item = malloc(record_size);
 
-	/* set file position */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
+	if (NULL == item) {
+		return err_out_of_memory;
+	}
 
 	/* needs to traverse file again */
 	while (count != hash_map->map_size) {
-		fread(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fread(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+		bucket = oafh_read_bucket(hash_map, loc, item);
+
+		if (NULL == bucket) {
+			free(item);
+			return err_file_read_error;
+		}
 
-		if (item->status == ION_EMPTY) {
+		if (bucket->status == ION_EMPTY) {
 			free(item);
 			return err_item_not_found;	/* if you hit an empty cell, exit */
 		}
 		else {
 			/* calculate if there is a match */
 
-			if (item->status != ION_DELETED) {
-				int key_is_equal = hash_map->super.compare(item->data, key, hash_map->super.record.key_size);
+			if (bucket->status != ION_DELETED) {
+				int key_is_equal = hash_map->super.compare(bucket->data, key, hash_map->super.record.key_size);
 
 				if (ION_IS_EQUAL == key_is_equal) {
 					(*location) = loc;
@@ -326,7 +405,6 @@ oafh_find_item_loc(
 			if (loc >= hash_map->map_size) {
 				/* Perform wrapping */
 				loc = 0;
-				frewind(hash_map->file);
 			}
 		}
 	}
@@ -340,36 +418,23 @@ oafh_delete(
 	ion_file_hashmap_t	*hash_map,
 	ion_key_t			key
 ) {
-	int loc;
+	int			loc;
+	ion_err_t	err = oafh_find_item_loc(hash_map, key, &loc);
 
-	if (oafh_find_item_loc(hash_map, key, &loc) == err_item_not_found) {
+	if (err_ok != err) {
 #if ION_DEBUG
 		printf("Item not found when trying to oah_delete.\n");
 #endif
-		return ION_STATUS_ERROR(err_item_not_found);
+		return ION_STATUS_ERROR(err);
 	}
 	else {
-		/* locate item */
-		ion_hash_bucket_t *item;
-
 		int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
-		item = malloc(record_size);
-
-		/* set file position */
-		fseek(hash_map->file, loc * record_size, SEEK_SET);
-
-		fread(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fread(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
-
-		item->status = ION_DELETED;	/* delete item */
-
-		/* backup */
-		fseek(hash_map->file, -record_size, SEEK_CUR);
-		fwrite(&item->status, SIZEOF(STATUS), 1, hash_map->file);
-		fwrite(item->data, record_size - SIZEOF(STATUS), 1, hash_map->file);
+		/* only the status changes, so the rest of the bucket is left as it is */
+		if (err_ok != ion_fwrite_at(hash_map->file, (ion_file_offset_t) loc * record_size, SIZEOF(STATUS), &(ion_byte_t) { (ion_byte_t) ION_DELETED })) {
+			return ION_STATUS_ERROR(err_file_write_error);
+		}
 
-		free(item);
 #if ION_DEBUG
 		printf("Item deleted at location %d\n", loc);
 #endif
@@ -392,12 +457,13 @@ oafh_get(
 
 		int record_size = hash_map->super.record.key_size + hash_map->super.record.value_size + SIZEOF(STATUS);
 
-		/* set file position */
-		fseek(hash_map->file, (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size, SEEK_SET);
 #if ION_DEBUG
 		printf("seeking %i\n", (loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size);
 #endif
-		fread(value, hash_map->super.record.value_size, 1, hash_map->file);
+
+		if (err_ok != ion_fread_at(hash_map->file, ((ion_file_offset_t) loc * record_size) + SIZEOF(STATUS) + hash_map->super.record.key_size, hash_map->super.record.value_size, value)) {
+			return ION_STATUS_ERROR(err_file_read_error);
+		}
 
 		return ION_STATUS_OK(1);
 	}
@@ -52,6 +52,7 @@ extern "C" {
 
 /*edefines file operations for arduino */
 #include "../../file/sd_stdio_c_iface.h"
+#include "../../file/ion_file.h"
 
 #define ION_EMPTY	-1
 #define ION_DELETED -2
@@ -80,7 +81,7 @@ struct file_hashmap {
 
 	/**< The hashing function to be used for
 		 the instance*/
-	FILE *file;	/**< file pointer */
+	ion_file_handle_t file;	/**< The file holding the buckets. */
 };
 
 /**
@@ -110,6 +111,57 @@ oafh_close(
 	ion_file_hashmap_t *hash_map
 );
 
+/**
+@brief		This function writes a hashmap through to storage.
+
+@param		hash_map
+				Pointer to the hashmap instance to sync.
+@return		The status describing the result of the sync.
+ */
+ion_err_t
+oafh_sync(
+	ion_file_hashmap_t *hash_map
+);
+
+/**
+@brief		This function holds the writes to a hashmap in memory until they
+			are written back, or lets them through again.
+
+@param		hash_map
+				Pointer to the hashmap instance.
+@param		writeback
+				The files to write back with, or NULL to let writes
+				through.
+@return		The status describing the result of holding or letting through
+			the writes.
+ */
+ion_err_t
+oafh_hold(
+	ion_file_hashmap_t		*hash_map,
+	ion_file_writeback_t	*writeback
+);
+
+/**
+@brief		This function reads a bucket of a hashmap.
+
+@details	Where the file is mapped the bucket is read in place, and is
+			valid until the hashmap is next written to.
+
+@param		hash_map
+				Pointer to the hashmap instance to read.
+@param		location
+				The index of the bucket.
+@param		buffer
+				Room for a bucket, used where the file isn't mapped.
+@return		The bucket, or NULL if it couldn't be read.
+ */
+ion_hash_bucket_t *
+oafh_read_bucket(
+	ion_file_hashmap_t	*hash_map,
+	int					location,
+	ion_hash_bucket_t	*buffer
+);
+
 /**
 @brief		This function initializes an open address in memory hash map.
 
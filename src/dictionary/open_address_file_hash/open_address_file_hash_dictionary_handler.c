@@ -97,25 +97,32 @@ oafdict_scan(
 
 	int record_size = SIZEOF(STATUS) + hash_map->super.record.key_size + hash_map->super.record.value_size;
 
-	/* move to the correct position in the fie */
-	fseek(hash_map->file, loc * record_size, SEEK_SET);
-
-	ion_hash_bucket_t *item;
+	ion_hash_bucket_t	*item;
+	ion_hash_bucket_t	*bucket;
 
 	item = malloc(record_size);
 
+	if (NULL == item) {
+		return cs_possible_data_inconsistency;
+	}
+
 	/* start at the current position, scan forward */
 	while (loc != cursor->first) {
-		fread(item, record_size, 1, hash_map->file);
+		bucket = oafh_read_bucket(hash_map, loc, item);
 
-		if ((item->status == ION_EMPTY) || (item->status == ION_DELETED)) {
+		if (NULL == bucket) {
+			free(item);
+			return cs_possible_data_inconsistency;
+		}
+
+		if ((bucket->status == ION_EMPTY) || (bucket->status == ION_DELETED)) {
 			/* if empty, just skip to next cell */
 			loc++;
 		}
 		else {
 			/* check to see if the current key value satisfies the predicate */
 
-			ion_boolean_t key_satisfies_predicate = test_predicate(&(cursor->super), item->data);	/* assumes that the key is first */
+			ion_boolean_t key_satisfies_predicate = test_predicate(&(cursor->super), bucket->data);	/* assumes that the key is first */
 
 			if (key_satisfies_predicate == boolean_true) {
 				cursor->current = loc;	/* this is the next index for value */
@@ -174,9 +181,11 @@ oafdict_next(
 			/* find the next valid entry */
 
 			/* scan and determine what to do? */
-			if (cs_end_of_results == oafdict_scan(oafdict_cursor)) {
-				/* Then this is the end and there are no more results */
-				cursor->status = cs_end_of_results;
+			ion_cursor_status_t scanned = oafdict_scan(oafdict_cursor);
+
+			if (cs_cursor_active != scanned) {
+				/* Then this is the end and there are no more results, or the file couldn't be read */
+				cursor->status = scanned;
 				return cursor->status;
 			}
 		}
@@ -187,12 +196,12 @@ oafdict_next(
 
 		/* the results are now ready //reference item at given position */
 
-		/* set position in file to read value */
-		fseek(hash_map->file, (SIZEOF(STATUS) + data_length) * oafdict_cursor->current	/* position is based on indexes (not abs file pos) */
-			+ SIZEOF(STATUS), SEEK_SET);
+		/* position is based on indexes (not abs file pos) */
+		ion_file_offset_t offset = (ion_file_offset_t) (SIZEOF(STATUS) + data_length) * oafdict_cursor->current + SIZEOF(STATUS);
 
-		fread(record->key, hash_map->super.record.key_size, 1, hash_map->file);
-		fread(record->value, hash_map->super.record.value_size, 1, hash_map->file);
+		if ((err_ok != ion_fread_at(hash_map->file, offset, hash_map->super.record.key_size, record->key)) || (err_ok != ion_fread_at(hash_map->file, offset + hash_map->super.record.key_size, hash_map->super.record.value_size, record->value))) {
+			cursor->status = cs_possible_data_inconsistency;
+		}
 
 		/* and update current cursor position */
 		return cursor->status;
@@ -238,6 +247,8 @@ oafdict_find(
 
 	/* bind correct next function */
 	(*cursor)->next					= oafdict_next;	/* this will use the correct value */
+	(*cursor)->next_batch			= NULL;
+	(*cursor)->next_ref				= NULL;
 
 	/* allocate predicate */
 	(*cursor)->predicate			= malloc(sizeof(ion_predicate_t));
@@ -314,8 +325,8 @@ oafdict_find(
 
 			ion_err_t err = oafdict_scan(oafdict_cursor);
 
-			if (cs_end_of_results == err) {
-				(*cursor)->status = cs_end_of_results;
+			if (cs_cursor_active != err) {
+				(*cursor)->status = err;
 			}
 
 			return err_ok;
@@ -390,13 +401,53 @@ oafdict_close_dictionary(
 	return err_ok;
 }
 
+/**
+@brief			Writes an open address file hash instance of a dictionary through
+				to storage.
+
+@param			dictionary
+					A pointer to the specific dictionary instance to sync.
+
+@return			The status of syncing the dictionary.
+ */
+ion_err_t
+oafdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	return oafh_sync((ion_file_hashmap_t *) dictionary->instance);
+}
+
+/**
+@brief			Holds the writes of an open address file hash instance of a
+				dictionary in memory until they are written back, or lets them
+				through again.
+
+@param			dictionary
+					A pointer to the specific dictionary instance.
+@param			writeback
+					The files to write back with, or NULL to let writes
+					through.
+
+@return			The status of holding or letting through the writes.
+ */
+ion_err_t
+oafdict_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+) {
+	return oafh_hold((ion_file_hashmap_t *) dictionary->instance, writeback);
+}
+
 void
 oafdict_init(
 	ion_dictionary_handler_t *handler
 ) {
 	handler->insert				= oafdict_insert;
+	handler->insert_batch		= NULL;
 	handler->create_dictionary	= oafdict_create_dictionary;
 	handler->get				= oafdict_get;
+	handler->get_many			= NULL;
+	handler->get_ref			= NULL;
 	handler->update				= oafdict_update;
 	handler->find				= oafdict_find;
 	handler->remove				= oafdict_delete;
@@ -404,6 +455,10 @@ oafdict_init(
 	handler->destroy_dictionary = oafdict_destroy_dictionary;
 	handler->open_dictionary	= oafdict_open_dictionary;
 	handler->close_dictionary	= oafdict_close_dictionary;
+	handler->sync				= oafdict_sync_dictionary;
+	handler->hold				= oafdict_hold_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_false;
 }
 
 ion_status_t
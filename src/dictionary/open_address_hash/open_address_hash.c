@@ -291,6 +291,27 @@ oah_get(
 	}
 }
 
+ion_status_t
+oah_get_ref(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	ion_record_t	*record
+) {
+	int loc;
+
+	if (oah_find_item_loc(hash_map, key, &loc) != err_ok) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	int					data_length = hash_map->super.record.key_size + hash_map->super.record.value_size;
+	ion_hash_bucket_t	*item		= (ion_hash_bucket_t *) (hash_map->entry + (data_length + SIZEOF(STATUS)) * loc);
+
+	record->key		= item->data;
+	record->value	= item->data + hash_map->super.record.key_size;
+
+	return ION_STATUS_OK(1);
+}
+
 /**
 @brief		Helper function to print out map.
 
@@ -250,6 +250,27 @@ oah_get(
 	ion_value_t		value
 );
 
+/**
+@brief		Locates the record if it exists, without copying it out.
+
+@details	On success @p record points at the key and value held in the
+			map's entry array. The pointers stay valid until the map is
+			next modified.
+
+@param		hash_map
+				The map to search.
+@param		key
+				The key for the record that is being searched for.
+@param		record
+				Set to point at the stored key and value.
+*/
+ion_status_t
+oah_get_ref(
+	ion_hashmap_t	*hash_map,
+	ion_key_t		key,
+	ion_record_t	*record
+);
+
 /**
 @brief		A simple hashing algorithm implementation.
 
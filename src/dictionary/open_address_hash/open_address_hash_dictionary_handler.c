@@ -69,6 +69,35 @@ oadict_get(
 	return oah_get((ion_hashmap_t *) dictionary->instance, key, value);
 }
 
+/**
+@brief	  Queries a dictionary instance for the given @p key and points
+			@p ref at the record in the map's entry array.
+
+@param	  dictionary
+				The instance of the dictionary to query.
+@param	  key
+				The key to search for.
+@param	  ref
+				Set to point at the stored key and value.
+@return	 The status of the query.
+*/
+ion_status_t
+oadict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+) {
+	ion_record_t	record;
+	ion_status_t	status = oah_get_ref((ion_hashmap_t *) dictionary->instance, key, &record);
+
+	if (err_ok == status.error) {
+		ref->key	= record.key;
+		ref->value	= record.value;
+	}
+
+	return status;
+}
+
 /**
 
 @brief		  Starts scanning map looking for conditions that match
@@ -164,6 +193,8 @@ oadict_find(
 
 	/* bind correct next function */
 	(*cursor)->next					= oadict_next;	/* this will use the correct value */
+	(*cursor)->next_batch			= NULL;
+	(*cursor)->next_ref				= NULL;
 
 	/* allocate predicate */
 	(*cursor)->predicate			= malloc(sizeof(ion_predicate_t));
@@ -325,15 +356,22 @@ oadict_init(
 	ion_dictionary_handler_t *handler
 ) {
 	handler->insert				= oadict_insert;
+	handler->insert_batch		= NULL;
 	handler->create_dictionary	= oadict_create_dictionary;
 	handler->get				= oadict_get;
+	handler->get_many			= NULL;
+	handler->get_ref			= oadict_get_ref;
 	handler->update				= oadict_update;
 	handler->find				= oadict_find;
 	handler->remove				= oadict_delete;
 	handler->delete_dictionary	= oadict_delete_dictionary;
 	handler->destroy_dictionary = oadict_destroy_dictionary;
 	handler->close_dictionary	= oadict_close_dictionary;
+	handler->sync				= NULL;
+	handler->hold				= NULL;
 	handler->open_dictionary	= oadict_open_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_false;
 }
 
 ion_status_t
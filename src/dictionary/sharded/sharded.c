@@ -0,0 +1,360 @@
+/******************************************************************************/
+/**
+@file		sharded.c
+@author		IonDB Project Contributors
+@brief		Shard placement, layout files and the worker pool of the sharded dictionary.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+#include "sharded.h"
+#include "../bpp_tree/bpp_tree_handler.h"
+#include "../flat_file/flat_file_dictionary_handler.h"
+#include "../open_address_file_hash/open_address_file_hash_dictionary_handler.h"
+#include "../open_address_hash/open_address_hash_dictionary_handler.h"
+#include "../skip_list/skip_list_handler.h"
+#include "../linear_hash/linear_hash_handler.h"
+#include "../../file/ion_file.h"
+
+#if defined(ARDUINO)
+#define SHARDED_IS_OPEN(file) (NULL != (file).file)
+#else
+#define SHARDED_IS_OPEN(file) (ION_NOFILE != (file))
+#endif
+
+ion_err_t
+sharded_switch_handler(
+	ion_dictionary_type_t		type,
+	ion_dictionary_handler_t	*handler
+) {
+	switch (type) {
+		case dictionary_type_bpp_tree_t: {
+			bpptree_init(handler);
+			break;
+		}
+
+		case dictionary_type_flat_file_t: {
+			ffdict_init(handler);
+			break;
+		}
+
+		case dictionary_type_open_address_file_hash_t: {
+			oafdict_init(handler);
+			break;
+		}
+
+		case dictionary_type_open_address_hash_t: {
+			oadict_init(handler);
+			break;
+		}
+
+		case dictionary_type_skip_list_t: {
+			sldict_init(handler);
+			break;
+		}
+
+		case dictionary_type_linear_hash_t: {
+			linear_hash_dict_init(handler);
+			break;
+		}
+
+		default: {
+			return err_uninitialized;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+sharded_write_layout(
+	ion_dictionary_id_t		id,
+	ion_sharded_layout_t	*layout
+) {
+	char				filename[ION_MAX_FILENAME_LENGTH];
+	ion_file_handle_t	file;
+
+	dictionary_get_filename(id, "shd", filename);
+
+	/* the layout is always the same size, so it simply overwrites the last one */
+	file = ion_fopen(filename);
+
+	if (!SHARDED_IS_OPEN(file)) {
+		return err_file_open_error;
+	}
+
+	if (err_ok != ion_fwrite_at(file, 0, sizeof(ion_sharded_layout_t), (ion_byte_t *) layout)) {
+		ion_fclose(file);
+		return err_file_write_error;
+	}
+
+	if (err_ok != ion_fclose(file)) {
+		return err_file_close_error;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+sharded_read_layout(
+	ion_dictionary_id_t		id,
+	ion_sharded_layout_t	*layout
+) {
+	char				filename[ION_MAX_FILENAME_LENGTH];
+	ion_file_handle_t	file;
+
+	dictionary_get_filename(id, "shd", filename);
+
+	if (!ion_fexists(filename)) {
+		return err_file_open_error;
+	}
+
+	file = ion_fopen(filename);
+
+	if (!SHARDED_IS_OPEN(file)) {
+		return err_file_open_error;
+	}
+
+	if (err_ok != ion_fread_at(file, 0, sizeof(ion_sharded_layout_t), (ion_byte_t *) layout)) {
+		ion_fclose(file);
+		return err_file_read_error;
+	}
+
+	if (err_ok != ion_fclose(file)) {
+		return err_file_close_error;
+	}
+
+	return err_ok;
+}
+
+ion_err_t
+sharded_remove_layout(
+	ion_dictionary_id_t id
+) {
+	char filename[ION_MAX_FILENAME_LENGTH];
+
+	dictionary_get_filename(id, "shd", filename);
+
+	if (0 != fremove(filename)) {
+		return err_file_delete_error;
+	}
+
+	return err_ok;
+}
+
+int
+sharded_shard_of(
+	ion_sharded_t	*sharded,
+	ion_key_t		key
+) {
+	ion_byte_t	*bytes	= key;
+	uint32_t	hash	= 2166136261U;
+	int			i;
+
+	for (i = 0; i < sharded->super.record.key_size; i++) {
+		if ((key_type_null_terminated_string == sharded->super.key_type) && (0 == bytes[i])) {
+			break;
+		}
+
+		hash	^= bytes[i];
+		hash	*= 16777619U;
+	}
+
+	return (int) (hash % (uint32_t) sharded->layout.num_shards);
+}
+
+#if !defined(ARDUINO)
+
+/**
+@brief		The body of a worker thread.
+@param		arg
+				The sharded dictionary the worker belongs to.
+@return		Always NULL.
+*/
+static void *
+sharded_worker(
+	void *arg
+) {
+	ion_sharded_t		*sharded	= arg;
+	ion_sharded_pool_t	*pool		= &sharded->pool;
+	ion_sharded_job_t	job;
+	void				*context;
+	int					shard;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	while (boolean_true) {
+		while (!pool->quit && (pool->next_shard >= sharded->layout.num_shards)) {
+			pthread_cond_wait(&pool->work, &pool->mutex);
+		}
+
+		if (pool->quit) {
+			break;
+		}
+
+		shard	= pool->next_shard++;
+		job		= pool->job;
+		context = pool->context;
+		pthread_mutex_unlock(&pool->mutex);
+
+		job(sharded, shard, context);
+
+		pthread_mutex_lock(&pool->mutex);
+
+		if (0 == --pool->remaining) {
+			pthread_cond_signal(&pool->done);
+		}
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+#endif
+
+ion_err_t
+sharded_start_pool(
+	ion_sharded_t *sharded
+) {
+#if !defined(ARDUINO)
+	ion_sharded_pool_t *pool = &sharded->pool;
+
+	pool->num_threads	= 0;
+	pool->job			= NULL;
+	pool->context		= NULL;
+	pool->next_shard	= sharded->layout.num_shards;
+	pool->remaining		= 0;
+	pool->quit			= boolean_false;
+
+	if (0 != pthread_mutex_init(&pool->running, NULL)) {
+		return err_out_of_memory;
+	}
+
+	if (0 != pthread_mutex_init(&pool->mutex, NULL)) {
+		pthread_mutex_destroy(&pool->running);
+		return err_out_of_memory;
+	}
+
+	if (0 != pthread_cond_init(&pool->work, NULL)) {
+		pthread_mutex_destroy(&pool->mutex);
+		pthread_mutex_destroy(&pool->running);
+		return err_out_of_memory;
+	}
+
+	if (0 != pthread_cond_init(&pool->done, NULL)) {
+		pthread_cond_destroy(&pool->work);
+		pthread_mutex_destroy(&pool->mutex);
+		pthread_mutex_destroy(&pool->running);
+		return err_out_of_memory;
+	}
+
+	/* A single shard gains nothing from a worker, so its jobs stay inline. */
+	if (1 == sharded->layout.num_shards) {
+		return err_ok;
+	}
+
+	while ((pool->num_threads < ION_SHARDED_MAX_THREADS) && (pool->num_threads < sharded->layout.num_shards)) {
+		if (0 != pthread_create(&pool->threads[pool->num_threads], NULL, sharded_worker, sharded)) {
+			sharded_stop_pool(sharded);
+			return err_out_of_memory;
+		}
+
+		pool->num_threads++;
+	}
+
+#else
+	UNUSED(sharded);
+#endif
+	return err_ok;
+}
+
+void
+sharded_stop_pool(
+	ion_sharded_t *sharded
+) {
+#if !defined(ARDUINO)
+	ion_sharded_pool_t	*pool = &sharded->pool;
+	int					i;
+
+	pthread_mutex_lock(&pool->mutex);
+	pool->quit = boolean_true;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (i = 0; i < pool->num_threads; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	pool->num_threads = 0;
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_mutex_destroy(&pool->running);
+#else
+	UNUSED(sharded);
+#endif
+}
+
+void
+sharded_run(
+	ion_sharded_t		*sharded,
+	ion_sharded_job_t	job,
+	void				*context
+) {
+#if !defined(ARDUINO)
+	ion_sharded_pool_t *pool = &sharded->pool;
+
+	if (0 < pool->num_threads) {
+		pthread_mutex_lock(&pool->running);
+		pthread_mutex_lock(&pool->mutex);
+		pool->job			= job;
+		pool->context		= context;
+		pool->remaining		= sharded->layout.num_shards;
+		pool->next_shard	= 0;
+		pthread_cond_broadcast(&pool->work);
+
+		while (0 < pool->remaining) {
+			pthread_cond_wait(&pool->done, &pool->mutex);
+		}
+
+		pthread_mutex_unlock(&pool->mutex);
+		pthread_mutex_unlock(&pool->running);
+		return;
+	}
+
+#endif
+
+	int shard;
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		job(sharded, shard, context);
+	}
+}
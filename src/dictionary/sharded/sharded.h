@@ -0,0 +1,175 @@
+/******************************************************************************/
+/**
+@file		sharded.h
+@author		IonDB Project Contributors
+@brief		Shard placement, layout files and the worker pool of the sharded dictionary.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+#if !defined(SHARDED_H_)
+#define SHARDED_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "sharded_types.h"
+
+/**
+@brief		Binds the handler of a child dictionary implementation.
+
+@param		type
+				The implementation to bind. Sharded dictionaries cannot be
+				nested.
+@param		handler
+				The handler to bind.
+@return		The resulting error condition.
+*/
+ion_err_t
+sharded_switch_handler(
+	ion_dictionary_type_t		type,
+	ion_dictionary_handler_t	*handler
+);
+
+/**
+@brief		Writes the layout file of a sharded dictionary.
+
+@param		id
+				The identifier of the sharded dictionary.
+@param		layout
+				The layout to write.
+@return		The resulting error condition.
+*/
+ion_err_t
+sharded_write_layout(
+	ion_dictionary_id_t		id,
+	ion_sharded_layout_t	*layout
+);
+
+/**
+@brief		Reads the layout file of a sharded dictionary.
+
+@param		id
+				The identifier of the sharded dictionary.
+@param		layout
+				Where to read the layout to.
+@return		The resulting error condition. @ref err_file_open_error if
+			the dictionary has no layout file.
+*/
+ion_err_t
+sharded_read_layout(
+	ion_dictionary_id_t		id,
+	ion_sharded_layout_t	*layout
+);
+
+/**
+@brief		Removes the layout file of a sharded dictionary.
+
+@param		id
+				The identifier of the sharded dictionary.
+@return		The resulting error condition.
+*/
+ion_err_t
+sharded_remove_layout(
+	ion_dictionary_id_t id
+);
+
+/**
+@brief		Picks the shard that owns a key.
+
+@details	Hashes the bytes of the key with FNV-1a. Null terminated string
+			keys are only hashed up to their terminator, matching how they
+			are compared.
+
+@param		sharded
+				The sharded dictionary.
+@param		key
+				The key to place.
+@return		The index of the owning shard.
+*/
+int
+sharded_shard_of(
+	ion_sharded_t	*sharded,
+	ion_key_t		key
+);
+
+/**
+@brief		Starts the worker threads of a sharded dictionary.
+
+@details	Does nothing on platforms without threads, where jobs run on
+			the calling thread.
+
+@param		sharded
+				The sharded dictionary, with its layout set.
+@return		The resulting error condition.
+*/
+ion_err_t
+sharded_start_pool(
+	ion_sharded_t *sharded
+);
+
+/**
+@brief		Stops and joins the worker threads of a sharded dictionary.
+
+@param		sharded
+				The sharded dictionary.
+*/
+void
+sharded_stop_pool(
+	ion_sharded_t *sharded
+);
+
+/**
+@brief		Runs a job over every shard and waits for it to finish.
+
+@details	Each shard is handed to exactly one worker, so a job may use
+			its child dictionary without locking. Readers sharing the
+			dictionary lock run their jobs one at a time. Jobs must not
+			call @ref sharded_run themselves.
+
+@param		sharded
+				The sharded dictionary.
+@param		job
+				The job to run.
+@param		context
+				Passed through to every call of @p job.
+*/
+void
+sharded_run(
+	ion_sharded_t		*sharded,
+	ion_sharded_job_t	job,
+	void				*context
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SHARDED_H_ */
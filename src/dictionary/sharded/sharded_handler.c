@@ -0,0 +1,889 @@
+/******************************************************************************/
+/**
+@file		sharded_handler.c
+@author		IonDB Project Contributors
+@brief		The handler for a dictionary split over several child dictionaries.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+
+#include "sharded_handler.h"
+
+/**
+@brief		The arguments of a batched operation, grouped by shard.
+*/
+typedef struct {
+	ion_record_t		*records;	/**< Records to insert, grouped by
+										 shard. */
+	ion_key_t			*keys;	/**< Keys to look up, grouped by shard. */
+	ion_value_t			*values;/**< Where to write each looked up value. */
+	ion_status_t		*statuses;	/**< The status of each looked up key. */
+	ion_result_count_t	offsets[ION_SHARDED_MAX_SHARDS + 1];	/**< Where
+																	 each
+																	 shard's
+																	 group
+																	 starts. */
+	ion_status_t		results[ION_SHARDED_MAX_SHARDS];/**< The status of each
+														 shard's group. */
+} ion_shdict_batch_t;
+
+/**
+@brief		The arguments of a find spread over the shards.
+*/
+typedef struct {
+	ion_shdict_cursor_t *cursor;/**< The cursor being built. */
+	ion_predicate_t		*predicate;	/**< The predicate to search with. */
+	int					only;	/**< The one shard to search, or -1 to
+									 search them all. */
+	ion_err_t			errors[ION_SHARDED_MAX_SHARDS];	/**< The result of
+														 each shard's find. */
+} ion_shdict_find_t;
+
+/**
+@brief		Returns the child dictionary that owns a key.
+*/
+static ion_dictionary_t *
+shdict_shard(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	ion_sharded_t *sharded = (ion_sharded_t *) dictionary->instance;
+
+	return &sharded->shards[sharded_shard_of(sharded, key)];
+}
+
+/**
+@brief		Groups the items of a batch by the shard owning them.
+
+@param		sharded
+				The sharded dictionary.
+@param		owners
+				The owning shard of each item.
+@param		count
+				The number of items.
+@param		offsets
+				Set to where each shard's group starts, with the total count
+				at index @p num_shards.
+@param		order
+				Set to the original index of each item, in grouped order.
+*/
+static void
+shdict_partition(
+	ion_sharded_t		*sharded,
+	int					*owners,
+	ion_result_count_t	count,
+	ion_result_count_t	*offsets,
+	ion_result_count_t	*order
+) {
+	ion_result_count_t	fill[ION_SHARDED_MAX_SHARDS];
+	ion_result_count_t	i;
+	int					shard;
+
+	memset(offsets, 0, (sharded->layout.num_shards + 1) * sizeof(ion_result_count_t));
+
+	for (i = 0; i < count; i++) {
+		offsets[owners[i] + 1]++;
+	}
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		offsets[shard + 1]	+= offsets[shard];
+		fill[shard]			= offsets[shard];
+	}
+
+	for (i = 0; i < count; i++) {
+		order[fill[owners[i]]++] = i;
+	}
+}
+
+/**
+@brief		Folds the per shard results of a batch into one status.
+*/
+static ion_status_t
+shdict_combine(
+	ion_sharded_t		*sharded,
+	ion_shdict_batch_t	*batch
+) {
+	ion_status_t	status = ION_STATUS_OK(0);
+	int				shard;
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		status.count += batch->results[shard].count;
+
+		if ((err_ok == status.error) && (err_ok != batch->results[shard].error)) {
+			status.error = batch->results[shard].error;
+		}
+	}
+
+	return status;
+}
+
+/**
+@brief		Inserts one shard's group of a batch.
+*/
+static void
+shdict_insert_batch_job(
+	ion_sharded_t	*sharded,
+	int				shard,
+	void			*context
+) {
+	ion_shdict_batch_t	*batch	= context;
+	ion_result_count_t	start	= batch->offsets[shard];
+
+	batch->results[shard] = dictionary_insert_batch(&sharded->shards[shard], batch->records + start, batch->offsets[shard + 1] - start);
+}
+
+/**
+@brief		Looks up one shard's group of a batch.
+*/
+static void
+shdict_get_many_job(
+	ion_sharded_t	*sharded,
+	int				shard,
+	void			*context
+) {
+	ion_shdict_batch_t	*batch	= context;
+	ion_result_count_t	start	= batch->offsets[shard];
+
+	batch->results[shard] = dictionary_get_many(&sharded->shards[shard], batch->keys + start, batch->offsets[shard + 1] - start, batch->values + start, batch->statuses + start);
+}
+
+/**
+@brief		Opens one shard's cursor and loads its first record.
+*/
+static void
+shdict_find_job(
+	ion_sharded_t	*sharded,
+	int				shard,
+	void			*context
+) {
+	ion_shdict_find_t	*find	= context;
+	ion_shdict_cursor_t *cursor = find->cursor;
+	ion_record_t		record;
+	ion_cursor_status_t status;
+
+	find->errors[shard] = err_ok;
+
+	if ((-1 != find->only) && (shard != find->only)) {
+		return;
+	}
+
+	find->errors[shard] = dictionary_find(&sharded->shards[shard], find->predicate, &cursor->children[shard]);
+
+	if (err_ok != find->errors[shard]) {
+		cursor->children[shard] = NULL;
+		return;
+	}
+
+	record.key				= cursor->heads + shard * (sharded->super.record.key_size + sharded->super.record.value_size);
+	record.value			= (ion_byte_t *) record.key + sharded->super.record.key_size;
+	status					= cursor->children[shard]->next(cursor->children[shard], &record);
+	cursor->loaded[shard]	= (cs_cursor_active == status) || (cs_cursor_initialized == status);
+}
+
+/**
+@brief		Copies a predicate, including the keys it points to.
+*/
+static ion_err_t
+shdict_copy_predicate(
+	ion_predicate_t *predicate,
+	ion_key_size_t	key_size,
+	ion_predicate_t **copy
+) {
+	*copy = malloc(sizeof(ion_predicate_t));
+
+	if (NULL == *copy) {
+		return err_out_of_memory;
+	}
+
+	**copy = *predicate;
+
+	switch (predicate->type) {
+		case predicate_equality: {
+			(*copy)->statement.equality.equality_value = malloc(key_size);
+
+			if (NULL == (*copy)->statement.equality.equality_value) {
+				break;
+			}
+
+			memcpy((*copy)->statement.equality.equality_value, predicate->statement.equality.equality_value, key_size);
+			return err_ok;
+		}
+
+		case predicate_range: {
+			(*copy)->statement.range.lower_bound	= malloc(key_size);
+			(*copy)->statement.range.upper_bound	= malloc(key_size);
+
+			if ((NULL == (*copy)->statement.range.lower_bound) || (NULL == (*copy)->statement.range.upper_bound)) {
+				free((*copy)->statement.range.lower_bound);
+				free((*copy)->statement.range.upper_bound);
+				break;
+			}
+
+			memcpy((*copy)->statement.range.lower_bound, predicate->statement.range.lower_bound, key_size);
+			memcpy((*copy)->statement.range.upper_bound, predicate->statement.range.upper_bound, key_size);
+			return err_ok;
+		}
+
+		default: {
+			return err_ok;
+		}
+	}
+
+	free(*copy);
+	*copy = NULL;
+	return err_out_of_memory;
+}
+
+/**
+@brief		Builds the in-memory side of a sharded dictionary and creates or
+			opens its children.
+*/
+static ion_err_t
+shdict_build(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_sharded_layout_t		*layout,
+	ion_boolean_t				open
+) {
+	ion_sharded_t	*sharded;
+	ion_err_t		err;
+	int				shard;
+
+	if ((1 > layout->num_shards) || (ION_SHARDED_MAX_SHARDS < layout->num_shards)) {
+		return err_invalid_initial_size;
+	}
+
+	sharded = malloc(sizeof(ion_sharded_t));
+
+	if (NULL == sharded) {
+		return err_out_of_memory;
+	}
+
+	sharded->super.key_type				= key_type;
+	sharded->super.record.key_size		= key_size;
+	sharded->super.record.value_size	= value_size;
+	sharded->super.compare				= compare;
+	sharded->super.id					= id;
+	sharded->super.type					= dictionary_type_sharded_t;
+	sharded->layout						= *layout;
+
+	err									= sharded_switch_handler(layout->child_type, &sharded->child_handler);
+
+	if (err_ok != err) {
+		free(sharded);
+		return err;
+	}
+
+	for (shard = 0; shard < layout->num_shards; shard++) {
+		if (open) {
+			ion_dictionary_config_info_t config = {
+				ION_SHARDED_CHILD_ID(id, shard), 0, key_type, key_size, value_size, dictionary_size, layout->child_type, ion_dictionary_status_closed
+			};
+
+			err = dictionary_open(&sharded->child_handler, &sharded->shards[shard], &config);
+		}
+		else {
+			err = dictionary_create(&sharded->child_handler, &sharded->shards[shard], ION_SHARDED_CHILD_ID(id, shard), key_type, key_size, value_size, dictionary_size);
+		}
+
+		if (err_ok != err) {
+			break;
+		}
+	}
+
+	if (err_ok == err) {
+		err = sharded_start_pool(sharded);
+	}
+
+	if (err_ok != err) {
+		while (0 < shard--) {
+			if (open) {
+				dictionary_close(&sharded->shards[shard]);
+			}
+			else {
+				dictionary_delete_dictionary(&sharded->shards[shard]);
+			}
+		}
+
+		free(sharded);
+		return err;
+	}
+
+	dictionary->instance	= (ion_dictionary_parent_t *) sharded;
+	dictionary->handler		= handler;
+
+	return err_ok;
+}
+
+void
+shdict_init(
+	ion_dictionary_handler_t *handler
+) {
+	handler->insert				= shdict_insert;
+	handler->insert_batch		= shdict_insert_batch;
+	handler->get				= shdict_get;
+	handler->get_many			= shdict_get_many;
+	handler->get_ref			= shdict_get_ref;
+	handler->create_dictionary	= shdict_create_dictionary;
+	handler->remove				= shdict_delete;
+	handler->delete_dictionary	= shdict_delete_dictionary;
+	handler->destroy_dictionary = shdict_destroy_dictionary;
+	handler->update				= shdict_update;
+	handler->find				= shdict_find;
+	handler->close_dictionary	= shdict_close_dictionary;
+	handler->open_dictionary	= shdict_open_dictionary;
+	handler->sync				= shdict_sync_dictionary;
+	handler->hold				= shdict_hold_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_false;
+}
+
+ion_err_t
+shdict_create(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_type_t		child_type,
+	int							num_shards
+) {
+	ion_sharded_layout_t		layout;
+	ion_dictionary_handler_t	child_handler;
+	ion_err_t					err;
+
+	if ((1 > num_shards) || (ION_SHARDED_MAX_SHARDS < num_shards)) {
+		return err_invalid_initial_size;
+	}
+
+	err = sharded_switch_handler(child_type, &child_handler);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	layout.child_type	= child_type;
+	layout.num_shards	= num_shards;
+
+	err					= sharded_write_layout(id, &layout);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	err = dictionary_create(handler, dictionary, id, key_type, key_size, value_size, dictionary_size);
+
+	if (err_ok != err) {
+		sharded_remove_layout(id);
+	}
+
+	return err;
+}
+
+ion_err_t
+shdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+) {
+	ion_sharded_layout_t	layout;
+	ion_err_t				err = sharded_read_layout(id, &layout);
+
+	if (err_file_open_error == err) {
+		layout.child_type	= ION_SHARDED_DEFAULT_CHILD_TYPE;
+		layout.num_shards	= ION_SHARDED_DEFAULT_SHARDS;
+		err					= sharded_write_layout(id, &layout);
+	}
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	err = shdict_build(id, key_type, key_size, value_size, dictionary_size, compare, handler, dictionary, &layout, boolean_false);
+
+	if (err_ok != err) {
+		sharded_remove_layout(id);
+	}
+
+	return err;
+}
+
+ion_status_t
+shdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return dictionary_insert(shdict_shard(dictionary, key), key, value);
+}
+
+ion_status_t
+shdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+) {
+	ion_sharded_t		*sharded = (ion_sharded_t *) dictionary->instance;
+	ion_shdict_batch_t	batch;
+	ion_result_count_t	*order;
+	int					*owners;
+	ion_result_count_t	i;
+
+	if (0 == count) {
+		return ION_STATUS_OK(0);
+	}
+
+	order			= malloc(count * sizeof(ion_result_count_t));
+	owners			= malloc(count * sizeof(int));
+	batch.records	= malloc(count * sizeof(ion_record_t));
+
+	if ((NULL == order) || (NULL == owners) || (NULL == batch.records)) {
+		free(order);
+		free(owners);
+		free(batch.records);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	for (i = 0; i < count; i++) {
+		owners[i] = sharded_shard_of(sharded, records[i].key);
+	}
+
+	shdict_partition(sharded, owners, count, batch.offsets, order);
+
+	for (i = 0; i < count; i++) {
+		batch.records[i] = records[order[i]];
+	}
+
+	sharded_run(sharded, shdict_insert_batch_job, &batch);
+
+	free(order);
+	free(owners);
+	free(batch.records);
+
+	return shdict_combine(sharded, &batch);
+}
+
+ion_status_t
+shdict_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return dictionary_get(shdict_shard(dictionary, key), key, value);
+}
+
+ion_status_t
+shdict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+) {
+	ion_sharded_t		*sharded = (ion_sharded_t *) dictionary->instance;
+	ion_shdict_batch_t	batch;
+	ion_result_count_t	*order;
+	int					*owners;
+	ion_result_count_t	i;
+
+	if (0 == count) {
+		return ION_STATUS_OK(0);
+	}
+
+	order			= malloc(count * sizeof(ion_result_count_t));
+	owners			= malloc(count * sizeof(int));
+	batch.keys		= malloc(count * sizeof(ion_key_t));
+	batch.values	= malloc(count * sizeof(ion_value_t));
+	batch.statuses	= malloc(count * sizeof(ion_status_t));
+
+	if ((NULL == order) || (NULL == owners) || (NULL == batch.keys) || (NULL == batch.values) || (NULL == batch.statuses)) {
+		free(order);
+		free(owners);
+		free(batch.keys);
+		free(batch.values);
+		free(batch.statuses);
+		return ION_STATUS_ERROR(err_out_of_memory);
+	}
+
+	for (i = 0; i < count; i++) {
+		owners[i] = sharded_shard_of(sharded, keys[i]);
+	}
+
+	shdict_partition(sharded, owners, count, batch.offsets, order);
+
+	for (i = 0; i < count; i++) {
+		batch.keys[i]	= keys[order[i]];
+		batch.values[i] = values[order[i]];
+	}
+
+	sharded_run(sharded, shdict_get_many_job, &batch);
+
+	for (i = 0; i < count; i++) {
+		statuses[order[i]] = batch.statuses[i];
+	}
+
+	free(order);
+	free(owners);
+	free(batch.keys);
+	free(batch.values);
+	free(batch.statuses);
+
+	return shdict_combine(sharded, &batch);
+}
+
+ion_status_t
+shdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+) {
+	return dictionary_get_ref(shdict_shard(dictionary, key), key, ref);
+}
+
+ion_status_t
+shdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+) {
+	return dictionary_update(shdict_shard(dictionary, key), key, value);
+}
+
+ion_status_t
+shdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+) {
+	return dictionary_delete(shdict_shard(dictionary, key), key);
+}
+
+ion_err_t
+shdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+) {
+	ion_sharded_t		*sharded	= (ion_sharded_t *) dictionary->instance;
+	ion_shdict_cursor_t *shard_cursor;
+	ion_shdict_find_t	find;
+	ion_err_t			err;
+	int					shard;
+
+	if (NULL == sharded->child_handler.find) {
+		return err_not_implemented;
+	}
+
+	shard_cursor = malloc(sizeof(ion_shdict_cursor_t));
+
+	if (NULL == shard_cursor) {
+		return err_out_of_memory;
+	}
+
+	shard_cursor->heads = malloc(sharded->layout.num_shards * (sharded->super.record.key_size + sharded->super.record.value_size));
+
+	if (NULL == shard_cursor->heads) {
+		free(shard_cursor);
+		return err_out_of_memory;
+	}
+
+	err = shdict_copy_predicate(predicate, sharded->super.record.key_size, &shard_cursor->super.predicate);
+
+	if (err_ok != err) {
+		free(shard_cursor->heads);
+		free(shard_cursor);
+		return err;
+	}
+
+	for (shard = 0; shard < ION_SHARDED_MAX_SHARDS; shard++) {
+		shard_cursor->children[shard]	= NULL;
+		shard_cursor->loaded[shard]		= boolean_false;
+	}
+
+	shard_cursor->super.dictionary	= dictionary;
+	shard_cursor->super.status		= cs_end_of_results;
+	shard_cursor->super.next		= shdict_next;
+	shard_cursor->super.next_batch	= NULL;
+	shard_cursor->super.next_ref	= NULL;
+	shard_cursor->super.destroy		= shdict_destroy_cursor;
+	*cursor							= (ion_dict_cursor_t *) shard_cursor;
+
+	find.cursor						= shard_cursor;
+	find.predicate					= predicate;
+	/* An exact match can only live in the shard that owns the key. */
+	find.only						= predicate_equality == predicate->type ? sharded_shard_of(sharded, predicate->statement.equality.equality_value) : -1;
+
+	sharded_run(sharded, shdict_find_job, &find);
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		if (err_ok != find.errors[shard]) {
+			shdict_destroy_cursor(cursor);
+			return find.errors[shard];
+		}
+
+		if (shard_cursor->loaded[shard]) {
+			shard_cursor->super.status = cs_cursor_initialized;
+		}
+	}
+
+	return err_ok;
+}
+
+ion_cursor_status_t
+shdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_shdict_cursor_t *shard_cursor	= (ion_shdict_cursor_t *) cursor;
+	ion_sharded_t		*sharded		= (ion_sharded_t *) cursor->dictionary->instance;
+	ion_key_size_t		key_size		= sharded->super.record.key_size;
+	int					row_size		= key_size + sharded->super.record.value_size;
+	ion_record_t		head;
+	ion_cursor_status_t status;
+	int					best			= -1;
+	int					shard;
+
+	if ((cs_cursor_initialized != cursor->status) && (cs_cursor_active != cursor->status)) {
+		return cursor->status;
+	}
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		if (shard_cursor->loaded[shard] && ((-1 == best) || (0 > sharded->super.compare(shard_cursor->heads + shard * row_size, shard_cursor->heads + best * row_size, key_size)))) {
+			best = shard;
+		}
+	}
+
+	if (-1 == best) {
+		cursor->status = cs_end_of_results;
+		return cursor->status;
+	}
+
+	head.key	= shard_cursor->heads + best * row_size;
+	head.value	= (ion_byte_t *) head.key + key_size;
+
+	memcpy(record->key, head.key, key_size);
+	memcpy(record->value, head.value, sharded->super.record.value_size);
+
+	status							= shard_cursor->children[best]->next(shard_cursor->children[best], &head);
+	shard_cursor->loaded[best]		= (cs_cursor_active == status) || (cs_cursor_initialized == status);
+
+	cursor->status					= cs_cursor_active;
+	return cursor->status;
+}
+
+void
+shdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+) {
+	ion_shdict_cursor_t *shard_cursor = (ion_shdict_cursor_t *) *cursor;
+	int					shard;
+
+	for (shard = 0; shard < ION_SHARDED_MAX_SHARDS; shard++) {
+		if (NULL != shard_cursor->children[shard]) {
+			shard_cursor->children[shard]->destroy(&shard_cursor->children[shard]);
+		}
+	}
+
+	(*cursor)->predicate->destroy(&(*cursor)->predicate);
+	free(shard_cursor->heads);
+	free(*cursor);
+	*cursor = NULL;
+}
+
+ion_err_t
+shdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_sharded_t	*sharded	= (ion_sharded_t *) dictionary->instance;
+	ion_err_t		result		= err_ok;
+	ion_err_t		err;
+	int				shard;
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		err = dictionary_delete_dictionary(&sharded->shards[shard]);
+
+		if (err_ok == result) {
+			result = err;
+		}
+	}
+
+	err = sharded_remove_layout(sharded->super.id);
+
+	if (err_ok == result) {
+		result = err;
+	}
+
+	sharded_stop_pool(sharded);
+	free(sharded);
+	dictionary->instance = NULL;
+
+	return result;
+}
+
+ion_err_t
+shdict_destroy_dictionary(
+	ion_dictionary_id_t id
+) {
+	ion_sharded_layout_t		layout;
+	ion_dictionary_handler_t	child_handler;
+	ion_err_t					result;
+	ion_err_t					err;
+	int							shard;
+
+	result = sharded_read_layout(id, &layout);
+
+	if (err_ok != result) {
+		return result;
+	}
+
+	result = sharded_switch_handler(layout.child_type, &child_handler);
+
+	if (err_ok != result) {
+		return result;
+	}
+
+	for (shard = 0; shard < layout.num_shards; shard++) {
+		err = dictionary_destroy_dictionary(&child_handler, ION_SHARDED_CHILD_ID(id, shard));
+
+		if (err_ok == result) {
+			result = err;
+		}
+	}
+
+	err = sharded_remove_layout(id);
+
+	if (err_ok == result) {
+		result = err;
+	}
+
+	return result;
+}
+
+ion_err_t
+shdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+) {
+	ion_sharded_layout_t	layout;
+	ion_err_t				err = sharded_read_layout(config->id, &layout);
+
+	if (err_ok != err) {
+		return err;
+	}
+
+	return shdict_build(config->id, config->type, config->key_size, config->value_size, config->dictionary_size, compare, handler, dictionary, &layout, boolean_true);
+}
+
+ion_err_t
+shdict_close_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_sharded_t	*sharded	= (ion_sharded_t *) dictionary->instance;
+	ion_err_t		result		= err_ok;
+	ion_err_t		err;
+	int				shard;
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		err = dictionary_close(&sharded->shards[shard]);
+
+		if (err_ok == result) {
+			result = err;
+		}
+	}
+
+	sharded_stop_pool(sharded);
+	free(sharded);
+	dictionary->instance = NULL;
+
+	return result;
+}
+
+ion_err_t
+shdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+) {
+	ion_sharded_t	*sharded	= (ion_sharded_t *) dictionary->instance;
+	ion_err_t		result		= err_ok;
+	ion_err_t		err;
+	int				shard;
+
+	if (NULL == sharded->child_handler.sync) {
+		return err_not_implemented;
+	}
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		err = sharded->child_handler.sync(&sharded->shards[shard]);
+
+		if (err_ok == result) {
+			result = err;
+		}
+	}
+
+	return result;
+}
+
+ion_err_t
+shdict_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+) {
+	ion_sharded_t	*sharded	= (ion_sharded_t *) dictionary->instance;
+	ion_err_t		result		= err_ok;
+	ion_err_t		err;
+	int				shard;
+
+	if (NULL == sharded->child_handler.hold) {
+		return err_not_implemented;
+	}
+
+	for (shard = 0; shard < sharded->layout.num_shards; shard++) {
+		err = sharded->child_handler.hold(&sharded->shards[shard], writeback);
+
+		if (err_ok == result) {
+			result = err;
+		}
+	}
+
+	return result;
+}
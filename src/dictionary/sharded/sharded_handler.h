@@ -0,0 +1,423 @@
+/******************************************************************************/
+/**
+@file		sharded_handler.h
+@author		IonDB Project Contributors
+@brief		The handler for a dictionary split over several child dictionaries.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+#if !defined(SHARDED_HANDLER_H_)
+#define SHARDED_HANDLER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "sharded_types.h"
+#include "sharded.h"
+
+/**
+@brief		Registers a sharded dictionary handler to a dictionary instance.
+
+@details	A sharded dictionary splits its keys by hash over several child
+			dictionaries of one implementation. Single key operations go
+			straight to the owning child. Batched inserts and lookups, and
+			the opening of cursors, are spread over a pool of worker
+			threads, one shard per worker at a time.
+
+@param		handler
+				An instance of a dictionary handler that is to be bound.
+*/
+void
+shdict_init(
+	ion_dictionary_handler_t *handler
+);
+
+/**
+@brief		Creates a sharded dictionary with a chosen child implementation
+			and number of shards.
+
+@details	Works like @ref dictionary_create, which creates sharded
+			dictionaries with @ref ION_SHARDED_DEFAULT_CHILD_TYPE and
+			@ref ION_SHARDED_DEFAULT_SHARDS. The layout is written to a file
+			next to the children, so the dictionary can later be opened
+			through the master table like any other.
+
+@param		handler
+				A handler bound with @ref shdict_init.
+@param		dictionary
+				The dictionary to create.
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to store.
+@param		key_size
+				The size of the keys in bytes.
+@param		value_size
+				The size of the values in bytes.
+@param		dictionary_size
+				The dictionary size given to every child.
+@param		child_type
+				The implementation backing each shard.
+@param		num_shards
+				The number of shards, between 1 and
+				@ref ION_SHARDED_MAX_SHARDS.
+@return		The resulting error condition.
+*/
+ion_err_t
+shdict_create(
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary,
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_type_t		child_type,
+	int							num_shards
+);
+
+/**
+@brief		Creates an instance of a sharded dictionary.
+
+@details	Uses the layout file of @p id if one was written by
+			@ref shdict_create, and the default layout otherwise.
+
+@param		id
+				The identifier of the dictionary.
+@param		key_type
+				The type of keys to store.
+@param		key_size
+				The size of the keys in bytes.
+@param		value_size
+				The size of the values in bytes.
+@param		dictionary_size
+				The dictionary size given to every child.
+@param		compare
+				The function used to compare keys.
+@param		handler
+				Handler to be bound to the dictionary instance being created.
+@param		dictionary
+				The dictionary instance to create.
+@return		The resulting error condition.
+*/
+ion_err_t
+shdict_create_dictionary(
+	ion_dictionary_id_t			id,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_value_size_t			value_size,
+	ion_dictionary_size_t		dictionary_size,
+	ion_dictionary_compare_t	compare,
+	ion_dictionary_handler_t	*handler,
+	ion_dictionary_t			*dictionary
+);
+
+/**
+@brief		Inserts a @p key and @p value into the shard owning @p key.
+
+@param		dictionary
+				The dictionary to insert into.
+@param		key
+				The key to insert.
+@param		value
+				The value to insert.
+@return		The status of the insertion.
+*/
+ion_status_t
+shdict_insert(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Inserts a batch of records, with every shard inserting its part
+			of the batch in parallel.
+
+@details	A shard stops at its first failing record, but the other shards
+			carry on with theirs.
+
+@param		dictionary
+				The dictionary to insert into.
+@param		records
+				The records to insert.
+@param		count
+				The number of records.
+@return		The number of records inserted, and the first error met.
+*/
+ion_status_t
+shdict_insert_batch(
+	ion_dictionary_t	*dictionary,
+	ion_record_t		*records,
+	ion_result_count_t	count
+);
+
+/**
+@brief		Fetches the value of @p key from the shard owning it.
+
+@param		dictionary
+				The dictionary to search.
+@param		key
+				The key to search for.
+@param		value
+				Where to write the value.
+@return		The status of the lookup.
+*/
+ion_status_t
+shdict_get(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Fetches the values of several keys, with every shard looking up
+			its keys in parallel.
+
+@param		dictionary
+				The dictionary to search.
+@param		keys
+				The keys to search for.
+@param		count
+				The number of keys.
+@param		values
+				Where to write the value of each key.
+@param		statuses
+				Set to the status of each lookup.
+@return		The number of keys found, and the first error other than
+			@ref err_item_not_found.
+*/
+ion_status_t
+shdict_get_many(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			*keys,
+	ion_result_count_t	count,
+	ion_value_t			*values,
+	ion_status_t		*statuses
+);
+
+/**
+@brief		Fetches a reference to the record of @p key from the shard
+			owning it.
+
+@param		dictionary
+				The dictionary to search.
+@param		key
+				The key to search for.
+@param		ref
+				The reference to fill.
+@return		The status of the lookup.
+*/
+ion_status_t
+shdict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+);
+
+/**
+@brief		Updates the value of @p key in the shard owning it.
+
+@param		dictionary
+				The dictionary to update.
+@param		key
+				The key to update.
+@param		value
+				The new value.
+@return		The status of the update.
+*/
+ion_status_t
+shdict_update(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_value_t			value
+);
+
+/**
+@brief		Deletes @p key from the shard owning it.
+
+@param		dictionary
+				The dictionary to delete from.
+@param		key
+				The key to delete.
+@return		The status of the deletion.
+*/
+ion_status_t
+shdict_delete(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key
+);
+
+/**
+@brief		Opens a cursor over the records matching a predicate.
+
+@details	Equality predicates search only the shard owning the key. Other
+			predicates open a cursor on every shard in parallel, and the
+			results are merged by key, so range and all records cursors
+			come out in key order when the child implementation is sorted.
+
+@param		dictionary
+				The dictionary to search.
+@param		predicate
+				The predicate to match.
+@param		cursor
+				Set to the new cursor.
+@return		The resulting error condition. @ref err_not_implemented if the
+			child implementation has no cursors.
+*/
+ion_err_t
+shdict_find(
+	ion_dictionary_t	*dictionary,
+	ion_predicate_t		*predicate,
+	ion_dict_cursor_t	**cursor
+);
+
+/**
+@brief		Fetches the next record of a merged cursor.
+
+@param		cursor
+				The cursor to advance.
+@param		record
+				Where to copy the record.
+@return		The status of the cursor.
+*/
+ion_cursor_status_t
+shdict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+);
+
+/**
+@brief		Destroys a merged cursor and the cursors of its shards.
+
+@param		cursor
+				The cursor to destroy.
+*/
+void
+shdict_destroy_cursor(
+	ion_dict_cursor_t **cursor
+);
+
+/**
+@brief		Deletes a sharded dictionary along with its children and layout.
+
+@param		dictionary
+				The dictionary to delete.
+@return		The first error met.
+*/
+ion_err_t
+shdict_delete_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Destroys a closed sharded dictionary along with its children
+			and layout.
+
+@param		id
+				The identifier of the dictionary to destroy.
+@return		The first error met.
+*/
+ion_err_t
+shdict_destroy_dictionary(
+	ion_dictionary_id_t id
+);
+
+/**
+@brief		Opens a sharded dictionary and its children from its layout
+			file.
+
+@param		handler
+				Handler to be bound to the dictionary instance being opened.
+@param		dictionary
+				The dictionary to open.
+@param		config
+				The configuration the dictionary was created with.
+@param		compare
+				The function used to compare keys.
+@return		The resulting error condition.
+*/
+ion_err_t
+shdict_open_dictionary(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_t				*dictionary,
+	ion_dictionary_config_info_t	*config,
+	ion_dictionary_compare_t		compare
+);
+
+/**
+@brief		Closes a sharded dictionary and its children.
+
+@param		dictionary
+				The dictionary to close.
+@return		The first error met.
+*/
+ion_err_t
+shdict_close_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Writes every child of a sharded dictionary through to storage.
+
+@param		dictionary
+				The dictionary to sync.
+@return		The first error met, or @ref err_not_implemented when the
+			children cannot be synced.
+*/
+ion_err_t
+shdict_sync_dictionary(
+	ion_dictionary_t *dictionary
+);
+
+/**
+@brief		Holds the writes of every child of a sharded dictionary in
+			memory until they are written back, or lets them through again.
+
+@param		dictionary
+				The dictionary.
+@param		writeback
+				The files to write back with, or NULL to let writes
+				through.
+@return		The first error met, or @ref err_not_implemented when the
+			children cannot hold their writes.
+*/
+ion_err_t
+shdict_hold_dictionary(
+	ion_dictionary_t		*dictionary,
+	ion_file_writeback_t	*writeback
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SHARDED_HANDLER_H_ */
@@ -0,0 +1,188 @@
+/******************************************************************************/
+/**
+@file		sharded_types.h
+@author		IonDB Project Contributors
+@brief		Contains all types local to the sharded dictionary.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+/******************************************************************************/
+#if !defined(SHARDED_TYPES_H_)
+#define SHARDED_TYPES_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "../dictionary_types.h"
+#include "../dictionary.h"
+
+#include "../../key_value/kv_system.h"
+
+#if !defined(ARDUINO)
+#include <pthread.h>
+#endif
+
+/**
+@brief		The most shards a sharded dictionary may be split into.
+*/
+#if !defined(ION_SHARDED_MAX_SHARDS)
+#define ION_SHARDED_MAX_SHARDS 16
+#endif
+
+/**
+@brief		The number of shards used when a sharded dictionary is created
+			through the generic dictionary interface.
+*/
+#if !defined(ION_SHARDED_DEFAULT_SHARDS)
+#define ION_SHARDED_DEFAULT_SHARDS 4
+#endif
+
+/**
+@brief		The child implementation used when a sharded dictionary is
+			created through the generic dictionary interface.
+*/
+#if !defined(ION_SHARDED_DEFAULT_CHILD_TYPE)
+#define ION_SHARDED_DEFAULT_CHILD_TYPE dictionary_type_bpp_tree_t
+#endif
+
+/**
+@brief		The most worker threads a sharded dictionary starts. Each batch
+			is spread over at most this many threads, but never more than
+			there are shards.
+*/
+#if !defined(ION_SHARDED_MAX_THREADS)
+#define ION_SHARDED_MAX_THREADS 4
+#endif
+
+/**
+@brief		The first identifier handed to child dictionaries.
+@details	Children are not registered in the master table, so their
+			identifiers are kept well clear of the ones it hands out. The
+			resulting file names must still fit in
+			@ref ION_MAX_FILENAME_LENGTH.
+*/
+#if !defined(ION_SHARDED_CHILD_ID_BASE)
+#if defined(ARDUINO)
+#define ION_SHARDED_CHILD_ID_BASE 32768U
+#else
+#define ION_SHARDED_CHILD_ID_BASE 5000000U
+#endif
+#endif
+
+/**
+@brief		The identifier of the child dictionary holding shard @p shard of
+			sharded dictionary @p id.
+*/
+#define ION_SHARDED_CHILD_ID(id, shard) (ION_SHARDED_CHILD_ID_BASE + (id) * ION_SHARDED_MAX_SHARDS + (shard))
+
+typedef struct sharded ion_sharded_t;
+
+/**
+@brief		A unit of work run once for every shard of a sharded dictionary.
+*/
+typedef void (*ion_sharded_job_t)(
+	ion_sharded_t *,
+	int,
+	void *
+);
+
+/**
+@brief		The shape of a sharded dictionary, kept in its layout file so that
+			it can be reopened.
+*/
+typedef struct {
+	ion_dictionary_type_t	child_type;	/**< The implementation backing
+											 each shard. */
+	int						num_shards;	/**< The number of shards. */
+} ion_sharded_layout_t;
+
+#if !defined(ARDUINO)
+
+/**
+@brief		A fixed pool of worker threads that runs a job over every shard.
+@details	Shards are handed out one at a time, so no two workers ever touch
+			the same child dictionary during a job.
+*/
+typedef struct {
+	pthread_t			threads[ION_SHARDED_MAX_THREADS];	/**< The workers. */
+	int					num_threads;/**< The number of workers started. */
+	pthread_mutex_t		running;	/**< Held while a job runs, so callers
+										 sharing the dictionary lock run
+										 their jobs in turn. */
+	pthread_mutex_t		mutex;	/**< Guards the fields below. */
+	pthread_cond_t		work;	/**< Signalled when a job is posted. */
+	pthread_cond_t		done;	/**< Signalled when a job completes. */
+	ion_sharded_job_t	job;	/**< The job being run. */
+	void				*context;	/**< The argument for @p job. */
+	int					next_shard;	/**< The next shard to hand out. */
+	int					remaining;	/**< Shards not yet finished. */
+	ion_boolean_t		quit;	/**< Set to stop the workers. */
+} ion_sharded_pool_t;
+
+#endif
+
+/**
+@brief		A dictionary that hashes its keys over several child
+			dictionaries.
+*/
+struct sharded {
+	ion_dictionary_parent_t		super;	/**< Parent structure holding
+											 dictionary level information. */
+	ion_sharded_layout_t		layout;	/**< The shape of the dictionary. */
+	ion_dictionary_handler_t	child_handler;	/**< The handler shared by all
+													 children. */
+	ion_dictionary_t			shards[ION_SHARDED_MAX_SHARDS];	/**< The
+																	 children. */
+#if !defined(ARDUINO)
+	ion_sharded_pool_t			pool;	/**< The workers running batches. */
+#endif
+};
+
+/**
+@brief		A cursor merging the cursors of every shard by key.
+*/
+typedef struct {
+	ion_dict_cursor_t	super;	/**< Supertype of cursor. */
+	ion_dict_cursor_t	*children[ION_SHARDED_MAX_SHARDS];	/**< The cursor
+															 of each shard,
+															 or NULL. */
+	ion_boolean_t		loaded[ION_SHARDED_MAX_SHARDS];	/**< Whether the
+														 shard has a record
+														 waiting in
+														 @p heads. */
+	ion_byte_t			*heads;	/**< The next record of each shard, as rows
+									 of key then value. */
+} ion_shdict_cursor_t;
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SHARDED_TYPES_H_ */
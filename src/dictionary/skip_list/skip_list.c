@@ -221,6 +221,24 @@ sl_get(
 	return ION_STATUS_OK(1);
 }
 
+ion_status_t
+sl_get_ref(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key,
+	ion_record_t	*record
+) {
+	ion_sl_node_t *cursor = sl_find_node(skiplist, key);
+
+	if ((NULL == cursor->key) || (skiplist->super.compare(cursor->key, key, skiplist->super.record.key_size) != 0)) {
+		return ION_STATUS_ERROR(err_item_not_found);
+	}
+
+	record->key		= cursor->key;
+	record->value	= cursor->value;
+
+	return ION_STATUS_OK(1);
+}
+
 ion_status_t
 sl_update(
 	ion_skiplist_t	*skiplist,
@@ -131,6 +131,28 @@ sl_get(
 	ion_value_t		value
 );
 
+/**
+@brief	  Requests the record stored at the given @p key without copying it.
+
+@details	On success @p record points at the key and value held in the
+			skiplist node. The pointers stay valid until that record is
+			updated or deleted.
+
+@param	  skiplist
+				The skiplist in which to query
+@param	  key
+				The key to be found
+@param	  record
+				Set to point at the stored key and value
+@return	 Status of query.
+*/
+ion_status_t
+sl_get_ref(
+	ion_skiplist_t	*skiplist,
+	ion_key_t		key,
+	ion_record_t	*record
+);
+
 /**
 @brief	  Updates the value stored at @p key with the new @p value.
 
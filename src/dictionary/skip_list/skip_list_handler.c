@@ -66,21 +66,47 @@ sldict_get(
 }
 
 /**
-@brief	  Next function queries and retrieves the next key/value pair that
-			satisfies the predicate of the cursor.
+@brief	  Queries a dictionary instance for a given @p key and points
+			@p ref at the record stored in the skiplist node.
+
+@param	  dictionary
+				The instance of the dictionary to query
+@param	  key
+				The key to search for.
+@param	  ref
+				Set to point at the stored key and value.
+@return	 Status of query.
+*/
+ion_status_t
+sldict_get_ref(
+	ion_dictionary_t	*dictionary,
+	ion_key_t			key,
+	ion_record_ref_t	*ref
+) {
+	ion_record_t	record;
+	ion_status_t	status = sl_get_ref((ion_skiplist_t *) dictionary->instance, key, &record);
+
+	if (err_ok == status.error) {
+		ref->key	= record.key;
+		ref->value	= record.value;
+	}
+
+	return status;
+}
+
+/**
+@brief	  Moves the cursor onto the next node that satisfies its predicate.
 
 @param	  cursor
 				The cursor used to iterate over results.
-@param	  record
-				A record pointer that is allocated by the caller in which the
-				cursor will fill with the next key/value result. The assumption
-				is that the caller will also free this memory.
+@param	  node
+				Set to the node the cursor was moved onto.
 @return	 Status of cursor.
 */
-ion_cursor_status_t
-sldict_next(
+static ion_cursor_status_t
+sldict_advance(
 	ion_dict_cursor_t	*cursor,
-	ion_record_t		*record
+	ion_sl_node_t		**node
 ) {
 	ion_sldict_cursor_t *sl_cursor = (ion_sldict_cursor_t *) cursor;
 
@@ -102,17 +128,114 @@ sldict_next(
 			cursor->status = cs_cursor_active;
 		}
 
-		/*Copy both key and value into user provided struct */
-		memcpy(record->key, sl_cursor->current->key, cursor->dictionary->instance->record.key_size);
-		memcpy(record->value, sl_cursor->current->value, cursor->dictionary->instance->record.value_size);
-
-		sl_cursor->current = sl_cursor->current->next[0];
+		*node				= sl_cursor->current;
+		sl_cursor->current	= sl_cursor->current->next[0];
 		return cursor->status;
 	}
 
 	return cs_invalid_cursor;
 }
 
+/**
+@brief	  Next function queries and retrieves the next key/value pair that
+			satisfies the predicate of the cursor.
+
+@param	  cursor
+				The cursor used to iterate over results.
+@param	  record
+				A record pointer that is allocated by the caller in which the
+				cursor will fill with the next key/value result. The assumption
+				is that the caller will also free this memory.
+@return	 Status of cursor.
+*/
+ion_cursor_status_t
+sldict_next(
+	ion_dict_cursor_t	*cursor,
+	ion_record_t		*record
+) {
+	ion_sl_node_t		*node;
+	ion_cursor_status_t status = sldict_advance(cursor, &node);
+
+	if (cs_cursor_active == status) {
+		/*Copy both key and value into user provided struct */
+		memcpy(record->key, node->key, cursor->dictionary->instance->record.key_size);
+		memcpy(record->value, node->value, cursor->dictionary->instance->record.value_size);
+	}
+
+	return status;
+}
+
+/**
+@brief	  Next function that points @p ref at the next key/value pair that
+			satisfies the predicate of the cursor, in place in its node.
+
+@param	  cursor
+				The cursor used to iterate over results.
+@param	  ref
+				Set to point at the stored key and value.
+@return	 Status of cursor.
+*/
+ion_cursor_status_t
+sldict_next_ref(
+	ion_dict_cursor_t	*cursor,
+	ion_record_ref_t	*ref
+) {
+	ion_sl_node_t		*node;
+	ion_cursor_status_t status = sldict_advance(cursor, &node);
+
+	if (cs_cursor_active == status) {
+		ref->key	= node->key;
+		ref->value	= node->value;
+	}
+
+	return status;
+}
+
+/**
+@brief	  Copies the next key/value pairs that satisfy the predicate of the
+			cursor into a buffer, walking the bottom level of the list.
+
+@param	  cursor
+				The cursor used to iterate over results.
+@param	  buffer
+				Room for @p capacity rows, each a key followed by its value.
+@param	  capacity
+				The most pairs to copy.
+@param	  count
+				Set to the number of pairs copied.
+@return	 @ref cs_cursor_active if any pairs were copied, otherwise the
+			status of the cursor.
+*/
+ion_cursor_status_t
+sldict_next_batch(
+	ion_dict_cursor_t	*cursor,
+	ion_byte_t			*buffer,
+	ion_result_count_t	capacity,
+	ion_result_count_t	*count
+) {
+	ion_key_size_t		key_size	= cursor->dictionary->instance->record.key_size;
+	ion_value_size_t	value_size	= cursor->dictionary->instance->record.value_size;
+	ion_cursor_status_t status		= cursor->status;
+	ion_sl_node_t		*node;
+
+	*count = 0;
+
+	while (*count < capacity) {
+		status = sldict_advance(cursor, &node);
+
+		if (cs_cursor_active != status) {
+			break;
+		}
+
+		memcpy(buffer, node->key, key_size);
+		memcpy(buffer + key_size, node->value, value_size);
+		buffer += key_size + value_size;
+		(*count)++;
+	}
+
+	return 0 < *count ? cs_cursor_active : status;
+}
+
 /**
 @brief			Closes a skiplist instance of a dictionary.
 
@@ -183,6 +306,8 @@ sldict_find(
 
 	(*cursor)->destroy		= sldict_destroy_cursor;
 	(*cursor)->next			= sldict_next;
+	(*cursor)->next_batch	= sldict_next_batch;
+	(*cursor)->next_ref		= sldict_next_ref;
 
 	(*cursor)->predicate	= malloc(sizeof(ion_predicate_t));
 
@@ -352,7 +477,10 @@ sldict_init(
 	ion_dictionary_handler_t *handler
 ) {
 	handler->insert				= sldict_insert;
+	handler->insert_batch		= NULL;
 	handler->get				= sldict_get;
+	handler->get_many			= NULL;
+	handler->get_ref			= sldict_get_ref;
 	handler->create_dictionary	= sldict_create_dictionary;
 	handler->remove				= sldict_delete;
 	handler->delete_dictionary	= sldict_delete_dictionary;
@@ -360,7 +488,11 @@ sldict_init(
 	handler->update				= sldict_update;
 	handler->find				= sldict_find;
 	handler->close_dictionary	= sldict_close_dictionary;
+	handler->sync				= NULL;
+	handler->hold				= NULL;
 	handler->open_dictionary	= sldict_open_dictionary;
+	handler->shared_reads		= boolean_true;
+	handler->snapshot_cursors	= boolean_false;
 }
 
 ion_status_t
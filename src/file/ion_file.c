@@ -34,8 +34,842 @@
 */
 /******************************************************************************/
 
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+/* Needed for fileno, fsync, ftruncate, pread and mmap under -std=c99. */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "ion_file.h"
 
+#if !defined(ARDUINO)
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+@brief		The fewest bytes a file is mapped with. Mappings double as the
+			file grows, so appends seldom remap it.
+*/
+#define ION_FILE_MAP_MINIMUM (64 * 1024L)
+
+/**
+@brief		Maps at least @p end bytes of a mapped file.
+@details	The mapping may reach past the end of the file, as long as
+			nothing past the end is touched.
+*/
+static ion_err_t
+ion_file_reserve(
+	ion_file_handle_t	file,
+	ion_file_offset_t	end
+) {
+	ion_file_offset_t	capacity;
+	long				page;
+	void				*map;
+
+	if (end <= file->capacity) {
+		return err_ok;
+	}
+
+	capacity	= file->capacity < ION_FILE_MAP_MINIMUM ? ION_FILE_MAP_MINIMUM : file->capacity;
+	page		= sysconf(_SC_PAGESIZE);
+
+	while (capacity < end) {
+		capacity *= 2;
+	}
+
+	if (page > 0) {
+		capacity = (capacity + page - 1) / page * page;
+	}
+
+	map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+
+	if (MAP_FAILED == map) {
+		return err_out_of_memory;
+	}
+
+	if (NULL != file->map) {
+		munmap(file->map, file->capacity);
+	}
+
+	file->map		= map;
+	file->capacity	= capacity;
+
+	return err_ok;
+}
+
+/**
+@brief		Opens a file through a shared memory mapping.
+@return		The open file, or @ref ION_NOFILE if it can't be opened or
+			mapped.
+*/
+static ion_file_handle_t
+ion_fopen_mapped(
+	char *name
+) {
+	ion_file_handle_t	file;
+	struct stat			status;
+
+	file = malloc(sizeof(ion_file_t));
+
+	if (NULL == file) {
+		return ION_NOFILE;
+	}
+
+	file->backend		= ion_file_mapped;
+	file->stream		= NULL;
+	file->map			= NULL;
+	file->page			= NULL;
+	file->capacity		= 0;
+	file->position		= 0;
+	file->holding		= boolean_false;
+	file->held			= NULL;
+	file->held_count	= 0;
+	file->held_capacity = 0;
+	file->held_size		= 0;
+	file->fd		= open(name, O_RDWR | O_CREAT, 0666);
+
+	if (-1 == file->fd) {
+		free(file);
+		return ION_NOFILE;
+	}
+
+	if (0 != fstat(file->fd, &status)) {
+		close(file->fd);
+		free(file);
+		return ION_NOFILE;
+	}
+
+	file->size = status.st_size;
+
+	if ((0 < file->size) && (err_ok != ion_file_reserve(file, file->size))) {
+		close(file->fd);
+		free(file);
+		return ION_NOFILE;
+	}
+
+	return file;
+}
+
+/**
+@brief		Writes back the bytes of a positional file's page that were
+			written since it was last flushed.
+*/
+static ion_err_t
+ion_file_flush(
+	ion_file_handle_t file
+) {
+	ion_file_offset_t	offset	= file->dirty_start;
+	ssize_t				written;
+
+	while (offset < file->dirty_end) {
+		written = pwrite(file->fd, file->page + offset, file->dirty_end - offset, file->page_offset + offset);
+
+		if (written <= 0) {
+			return err_file_write_error;
+		}
+
+		offset += written;
+	}
+
+	file->dirty_start	= 0;
+	file->dirty_end		= 0;
+
+	return err_ok;
+}
+
+/**
+@brief		Reads exactly @p num_bytes from a descriptor at @p offset,
+			zero filling whatever lies past the end of the file.
+@return		The bytes actually in the file.
+*/
+static ssize_t
+ion_file_pread(
+	int					fd,
+	ion_file_offset_t	offset,
+	size_t				num_bytes,
+	ion_byte_t			*write_to
+) {
+	size_t	done = 0;
+	ssize_t got;
+
+	while (done < num_bytes) {
+		got = pread(fd, write_to + done, num_bytes - done, offset + done);
+
+		if (got < 0) {
+			return -1;
+		}
+
+		if (0 == got) {
+			memset(write_to + done, 0, num_bytes - done);
+			break;
+		}
+
+		done += got;
+	}
+
+	return done;
+}
+
+/**
+@brief		Makes the page holding @p offset the one a positional file
+			buffers, writing back the page it buffered before.
+*/
+static ion_err_t
+ion_file_load_page(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset
+) {
+	ssize_t got;
+
+	offset -= offset % ION_FILE_PAGE_SIZE;
+
+	if (offset == file->page_offset) {
+		return err_ok;
+	}
+
+	if (err_ok != ion_file_flush(file)) {
+		return err_file_write_error;
+	}
+
+	got = ion_file_pread(file->fd, offset, ION_FILE_PAGE_SIZE, file->page);
+
+	if (got < 0) {
+		file->page_offset = -1;
+		return err_file_read_error;
+	}
+
+	file->page_offset	= offset;
+	file->page_length	= got;
+
+	return err_ok;
+}
+
+/**
+@brief		Whether @p num_bytes at @p offset lie within a single page.
+*/
+#define ION_FILE_ONE_PAGE(offset, num_bytes) \
+	(0 < (num_bytes) && (offset) / ION_FILE_PAGE_SIZE == ((offset) + (num_bytes) - 1) / ION_FILE_PAGE_SIZE)
+
+/**
+@brief		Reads from a positional file, leaving its position alone.
+@details	Reads within one page are served from the buffered page, loading
+			it first if need be; anything larger goes straight to the file.
+*/
+static ion_err_t
+ion_file_read_positional(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+	if ((offset < 0) || (offset + (ion_file_offset_t) num_bytes > file->size)) {
+		return err_file_read_error;
+	}
+
+	if (ION_FILE_ONE_PAGE(offset, num_bytes)) {
+		if (err_ok != ion_file_load_page(file, offset)) {
+			return err_file_read_error;
+		}
+
+		memcpy(write_to, file->page + offset - file->page_offset, num_bytes);
+		return err_ok;
+	}
+
+	if ((err_ok != ion_file_flush(file)) || (0 > ion_file_pread(file->fd, offset, num_bytes, write_to))) {
+		return err_file_read_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes to a positional file, leaving its position alone.
+@details	Writes within one page land in the buffered page and reach the
+			file when another page is loaded, or the file is synced or
+			closed. Anything larger goes straight to the file.
+*/
+static ion_err_t
+ion_file_write_positional(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*to_write
+) {
+	ion_file_offset_t	end		= offset + num_bytes;
+	ion_file_offset_t	start;
+	ssize_t				written;
+	unsigned int		done	= 0;
+
+	if (offset < 0) {
+		return err_file_write_error;
+	}
+
+	if (ION_FILE_ONE_PAGE(offset, num_bytes)) {
+		if (err_ok != ion_file_load_page(file, offset)) {
+			return err_file_write_error;
+		}
+
+		start = offset - file->page_offset;
+		memcpy(file->page + start, to_write, num_bytes);
+
+		if (file->dirty_start == file->dirty_end) {
+			file->dirty_start	= start;
+			file->dirty_end		= start + num_bytes;
+		}
+		else {
+			file->dirty_start	= start < file->dirty_start ? start : file->dirty_start;
+			file->dirty_end		= start + num_bytes > file->dirty_end ? start + num_bytes : file->dirty_end;
+		}
+
+		if (file->page_length < start + num_bytes) {
+			file->page_length = start + num_bytes;
+		}
+	}
+	else {
+		if (err_ok != ion_file_flush(file)) {
+			return err_file_write_error;
+		}
+
+		while (done < num_bytes) {
+			written = pwrite(file->fd, to_write + done, num_bytes - done, offset + done);
+
+			if (written <= 0) {
+				return err_file_write_error;
+			}
+
+			done += written;
+		}
+
+		/* the buffered page no longer matches the file where the two overlap */
+		if ((file->page_offset < end) && (offset < file->page_offset + ION_FILE_PAGE_SIZE)) {
+			file->page_offset = -1;
+		}
+	}
+
+	if (end > file->size) {
+		file->size = end;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Opens a file for positional reads and writes.
+@return		The open file, or @ref ION_NOFILE if it can't be opened.
+*/
+static ion_file_handle_t
+ion_fopen_positional(
+	char *name
+) {
+	ion_file_handle_t	file;
+	struct stat			status;
+
+	file = malloc(sizeof(ion_file_t));
+
+	if (NULL == file) {
+		return ION_NOFILE;
+	}
+
+	file->backend		= ion_file_positional;
+	file->stream		= NULL;
+	file->map			= NULL;
+	file->capacity		= 0;
+	file->position		= 0;
+	file->page_offset	= -1;
+	file->page_length	= 0;
+	file->dirty_start	= 0;
+	file->dirty_end		= 0;
+	file->page			= malloc(ION_FILE_PAGE_SIZE);
+	file->fd			= -1;
+	file->holding		= boolean_false;
+	file->held			= NULL;
+	file->held_count	= 0;
+	file->held_capacity = 0;
+	file->held_size		= 0;
+
+	if (NULL != file->page) {
+		file->fd = open(name, O_RDWR | O_CREAT, 0666);
+	}
+
+	if ((-1 == file->fd) || (0 != fstat(file->fd, &status))) {
+		if (-1 != file->fd) {
+			close(file->fd);
+		}
+
+		free(file->page);
+		free(file);
+		return ION_NOFILE;
+	}
+
+	file->size = status.st_size;
+
+	return file;
+}
+
+/**
+@brief		Finds the held page of a file starting at @p offset.
+@return		The index of the page, or, if none is held, minus one less
+			than the index it would take.
+*/
+static int
+ion_file_find_held(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset
+) {
+	int low		= 0;
+	int high	= file->held_count - 1;
+	int middle;
+
+	while (low <= high) {
+		middle = (low + high) / 2;
+
+		if (file->held[middle].offset == offset) {
+			return middle;
+		}
+
+		if (file->held[middle].offset < offset) {
+			low = middle + 1;
+		}
+		else {
+			high = middle - 1;
+		}
+	}
+
+	return -low - 1;
+}
+
+/**
+@brief		The size of a file itself, not counting held writes.
+*/
+static ion_file_offset_t
+ion_file_size(
+	ion_file_handle_t file
+) {
+	long	previous;
+	long	end;
+
+	if (ion_file_stdio != file->backend) {
+		return file->size;
+	}
+
+	previous	= ftell(file->stream);
+	fseek(file->stream, 0, SEEK_END);
+	end			= ftell(file->stream);
+	fseek(file->stream, previous, SEEK_SET);
+
+	return end;
+}
+
+/**
+@brief		Reads from a file itself, past any held writes. Only a stdio
+			file's position moves.
+*/
+static ion_err_t
+ion_file_read_backend(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+	if (ion_file_positional == file->backend) {
+		return ion_file_read_positional(file, offset, num_bytes, write_to);
+	}
+
+	if (ion_file_mapped == file->backend) {
+		if ((offset < 0) || (offset + (ion_file_offset_t) num_bytes > file->size)) {
+			return err_file_read_error;
+		}
+
+		memcpy(write_to, file->map + offset, num_bytes);
+		return err_ok;
+	}
+
+	if (0 != fseek(file->stream, offset, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	if (1 != fread(write_to, num_bytes, 1, file->stream)) {
+		return err_file_read_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes to a file itself, past any held writes. Only a stdio
+			file's position moves.
+*/
+static ion_err_t
+ion_file_write_backend(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*to_write
+) {
+	ion_file_offset_t end = offset + num_bytes;
+
+	if (ion_file_positional == file->backend) {
+		return ion_file_write_positional(file, offset, num_bytes, to_write);
+	}
+
+	if (ion_file_mapped == file->backend) {
+		if (offset < 0) {
+			return err_file_bad_seek;
+		}
+
+		if (end > file->size) {
+			/* the file is grown first, as the mapping past its end can't be touched */
+			if ((err_ok != ion_file_reserve(file, end)) || (0 != ftruncate(file->fd, end))) {
+				return err_file_write_error;
+			}
+
+			file->size = end;
+		}
+
+		memcpy(file->map + offset, to_write, num_bytes);
+		return err_ok;
+	}
+
+	if (0 != fseek(file->stream, offset, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	fwrite(to_write, num_bytes, 1, file->stream);
+	return err_ok;
+}
+
+/**
+@brief		Reads the bytes a file itself has, past any held writes, zero
+			filling whatever lies past its end.
+*/
+static ion_err_t
+ion_file_read_through(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+	ion_file_offset_t size = ion_file_size(file);
+
+	if (offset + (ion_file_offset_t) num_bytes > size) {
+		unsigned int present = offset < size ? (unsigned int) (size - offset) : 0;
+
+		memset(write_to + present, 0, num_bytes - present);
+		num_bytes = present;
+	}
+
+	if (0 == num_bytes) {
+		return err_ok;
+	}
+
+	return ion_file_read_backend(file, offset, num_bytes, write_to);
+}
+
+/**
+@brief		Flushes a file and whatever it buffers to its storage, past
+			any held writes.
+*/
+static ion_err_t
+ion_file_sync(
+	ion_file_handle_t file
+) {
+	if (ion_file_mapped == file->backend) {
+		if (((NULL != file->map) && (0 != msync(file->map, file->size, MS_SYNC))) || (0 != fsync(file->fd))) {
+			return err_file_write_error;
+		}
+
+		return err_ok;
+	}
+
+	if (ion_file_positional == file->backend) {
+		if ((err_ok != ion_file_flush(file)) || (0 != fsync(file->fd))) {
+			return err_file_write_error;
+		}
+
+		return err_ok;
+	}
+
+	if ((0 != fflush(file->stream)) || (0 != fsync(fileno(file->stream)))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes to the held pages of a file, holding each page it
+			touches first.
+*/
+static ion_err_t
+ion_file_hold_write(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*to_write
+) {
+	ion_file_offset_t	start;
+	unsigned int		length;
+	ion_file_held_t		*grown;
+	ion_byte_t			*bytes;
+	int					i;
+
+	if (offset < 0) {
+		return err_file_write_error;
+	}
+
+	while (0 < num_bytes) {
+		start	= offset - offset % ION_FILE_PAGE_SIZE;
+		i		= ion_file_find_held(file, start);
+
+		if (0 > i) {
+			i = -i - 1;
+
+			if (file->held_count == file->held_capacity) {
+				grown = realloc(file->held, sizeof(ion_file_held_t) * (0 == file->held_capacity ? 16 : 2 * file->held_capacity));
+
+				if (NULL == grown) {
+					return err_out_of_memory;
+				}
+
+				file->held			= grown;
+				file->held_capacity = 0 == file->held_capacity ? 16 : 2 * file->held_capacity;
+			}
+
+			bytes = malloc(ION_FILE_PAGE_SIZE);
+
+			if (NULL == bytes) {
+				return err_out_of_memory;
+			}
+
+			if (err_ok != ion_file_read_through(file, start, ION_FILE_PAGE_SIZE, bytes)) {
+				free(bytes);
+				return err_file_write_error;
+			}
+
+			memmove(file->held + i + 1, file->held + i, sizeof(ion_file_held_t) * (file->held_count - i));
+			file->held[i].offset	= start;
+			file->held[i].bytes		= bytes;
+			file->held_count++;
+		}
+
+		length = start + ION_FILE_PAGE_SIZE - offset < num_bytes ? (unsigned int) (start + ION_FILE_PAGE_SIZE - offset) : num_bytes;
+		memcpy(file->held[i].bytes + offset - start, to_write, length);
+
+		offset		+= length;
+		to_write	+= length;
+		num_bytes	-= length;
+
+		if (offset > file->held_size) {
+			file->held_size = offset;
+		}
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Reads from a file holding its writes, taking held pages from
+			memory and the runs between them from the file.
+*/
+static ion_err_t
+ion_file_hold_read(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+	ion_file_offset_t	start;
+	ion_file_offset_t	end;
+	unsigned int		length;
+	int					i;
+
+	if ((offset < 0) || (offset + (ion_file_offset_t) num_bytes > file->held_size)) {
+		return err_file_read_error;
+	}
+
+	while (0 < num_bytes) {
+		start	= offset - offset % ION_FILE_PAGE_SIZE;
+		i		= ion_file_find_held(file, start);
+
+		if (0 <= i) {
+			length = start + ION_FILE_PAGE_SIZE - offset < num_bytes ? (unsigned int) (start + ION_FILE_PAGE_SIZE - offset) : num_bytes;
+			memcpy(write_to, file->held[i].bytes + offset - start, length);
+		}
+		else {
+			/* read up to the next held page at once */
+			i		= -i - 1;
+			end		= i < file->held_count ? file->held[i].offset : offset + num_bytes;
+			length	= end - offset < num_bytes ? (unsigned int) (end - offset) : num_bytes;
+
+			if (err_ok != ion_file_read_through(file, offset, length, write_to)) {
+				return err_file_read_error;
+			}
+		}
+
+		offset		+= length;
+		write_to	+= length;
+		num_bytes	-= length;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the held pages of a file to it, in order, and lets them
+			go once all are written.
+*/
+static ion_err_t
+ion_file_write_held(
+	ion_file_handle_t file
+) {
+	ion_file_offset_t	length;
+	int					i;
+
+	for (i = 0; i < file->held_count; i++) {
+		length = file->held_size - file->held[i].offset < ION_FILE_PAGE_SIZE ? file->held_size - file->held[i].offset : ION_FILE_PAGE_SIZE;
+
+		if (err_ok != ion_file_write_backend(file, file->held[i].offset, (unsigned int) length, file->held[i].bytes)) {
+			return err_file_write_error;
+		}
+	}
+
+	for (i = 0; i < file->held_count; i++) {
+		free(file->held[i].bytes);
+	}
+
+	file->held_count = 0;
+
+	return err_ok;
+}
+
+/**
+@brief		Takes a file that stops holding its writes out of its writeback.
+*/
+static void
+ion_file_leave_writeback(
+	ion_file_handle_t file
+) {
+	ion_file_writeback_t	*writeback = file->writeback;
+	int						i;
+
+	for (i = 0; i < writeback->count; i++) {
+		if (writeback->files[i] == file) {
+			writeback->files[i] = writeback->files[--writeback->count];
+			break;
+		}
+	}
+
+	if (0 == writeback->count) {
+		free(writeback->files);
+		writeback->files	= NULL;
+		writeback->capacity = 0;
+	}
+
+	file->writeback = NULL;
+}
+
+/**
+@brief		Holds the writes made to a file, or lets them through again,
+			as @ref ion_fhold does.
+*/
+static ion_err_t
+ion_file_hold(
+	ion_file_handle_t		file,
+	ion_file_writeback_t	*writeback
+) {
+	ion_file_handle_t	*grown;
+	ion_err_t			error;
+
+	if ((NULL != writeback) == file->holding) {
+		return err_ok;
+	}
+
+	if (NULL != writeback) {
+		if (writeback->count == writeback->capacity) {
+			grown = realloc(writeback->files, sizeof(ion_file_handle_t) * (0 == writeback->capacity ? 4 : 2 * writeback->capacity));
+
+			if (NULL == grown) {
+				return err_out_of_memory;
+			}
+
+			writeback->files	= grown;
+			writeback->capacity = 0 == writeback->capacity ? 4 : 2 * writeback->capacity;
+		}
+
+		writeback->files[writeback->count++]	= file;
+		file->writeback							= writeback;
+		file->held_size							= ion_file_size(file);
+
+		if (ion_file_stdio == file->backend) {
+			file->position = ftell(file->stream);
+		}
+
+		file->holding = boolean_true;
+		return err_ok;
+	}
+
+	error = ion_file_write_held(file);
+
+	if (err_ok != error) {
+		return error;
+	}
+
+	ion_file_leave_writeback(file);
+	file->holding = boolean_false;
+
+	if ((ion_file_stdio == file->backend) && (0 != fseek(file->stream, file->position, SEEK_SET))) {
+		return err_file_bad_seek;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Opens a file through a stdio stream.
+@return		The open file, or @ref ION_NOFILE if it can't be opened.
+*/
+static ion_file_handle_t
+ion_fopen_stdio(
+	char *name
+) {
+	ion_file_handle_t file;
+
+	file = malloc(sizeof(ion_file_t));
+
+	if (NULL == file) {
+		return ION_NOFILE;
+	}
+
+	file->backend		= ion_file_stdio;
+	file->fd			= -1;
+	file->map			= NULL;
+	file->size			= 0;
+	file->capacity		= 0;
+	file->position		= 0;
+	file->page			= NULL;
+	file->holding		= boolean_false;
+	file->held			= NULL;
+	file->held_count	= 0;
+	file->held_capacity = 0;
+	file->held_size		= 0;
+	file->stream		= fopen(name, "r+b");
+
+	if (NULL == file->stream) {
+		file->stream = fopen(name, "w+b");
+	}
+
+	if (NULL == file->stream) {
+		free(file);
+		return ION_NOFILE;
+	}
+
+	return file;
+}
+
+#endif
+
 ion_boolean_t
 ion_fexists(
 	char *name
@@ -50,11 +884,20 @@ ion_fexists(
 ion_file_handle_t
 ion_fopen(
 	char *name
+) {
+	return ion_fopen_backend(name, ION_FILE_BACKEND);
+}
+
+ion_file_handle_t
+ion_fopen_backend(
+	char				*name,
+	ion_file_backend_t	backend
 ) {
 #if defined(ARDUINO)
 
 	ion_file_handle_t toret;
 
+	UNUSED(backend);
 	toret.file = fopen(name, "r+");
 
 	if (NULL == toret.file) {
@@ -64,14 +907,36 @@ ion_fopen(
 	return toret;
 #else
 
-	ion_file_handle_t file;
+	ion_file_handle_t file = ION_NOFILE;
 
-	file = fopen(name, "r+b");
+	if (ion_file_mapped == backend) {
+		file = ion_fopen_mapped(name);
+	}
+	else if (ion_file_positional == backend) {
+		file = ion_fopen_positional(name);
+	}
 
-	if (NULL == file) {
-		file = fopen(name, "w+b");
+	if (ION_NOFILE == file) {
+		file = ion_fopen_stdio(name);
 	}
 
+	if (ION_NOFILE == file) {
+		return ION_NOFILE;
+	}
+
+	pthread_mutex_init(&file->lock, NULL);
+
+	/* the name lets a log write held pages back to the file after a crash */
+	file->writeback = NULL;
+	file->name		= malloc(strlen(name) + 1);
+
+	if (NULL == file->name) {
+		ion_fclose(file);
+		return ION_NOFILE;
+	}
+
+	strcpy(file->name, name);
+
 	return file;
 #endif
 }
@@ -84,8 +949,48 @@ ion_fclose(
 	fclose(file.file);
 	return err_ok;
 #else
-	fclose(file);
-	return err_ok;
+
+	ion_err_t	error = err_ok;
+	int			i;
+
+	if (file->holding && (err_ok != ion_file_write_held(file))) {
+		error = err_file_close_error;
+	}
+
+	if (NULL != file->writeback) {
+		ion_file_leave_writeback(file);
+	}
+
+	for (i = 0; i < file->held_count; i++) {
+		free(file->held[i].bytes);
+	}
+
+	free(file->held);
+	free(file->name);
+
+	if (ion_file_mapped == file->backend) {
+		if (NULL != file->map) {
+			munmap(file->map, file->capacity);
+		}
+
+		if (0 != close(file->fd)) {
+			error = err_file_close_error;
+		}
+	}
+	else if (ion_file_positional == file->backend) {
+		if ((err_ok != ion_file_flush(file)) || (0 != close(file->fd))) {
+			error = err_file_close_error;
+		}
+
+		free(file->page);
+	}
+	else if (0 != fclose(file->stream)) {
+		error = err_file_close_error;
+	}
+
+	pthread_mutex_destroy(&file->lock);
+	free(file);
+	return error;
 #endif
 }
 
@@ -120,11 +1025,32 @@ ion_fseek(
 	return err_ok;
 #else
 
-	if (0 != fseek(file, seek_to, origin)) {
-		return err_file_bad_seek;
+	ion_err_t error = err_ok;
+
+	pthread_mutex_lock(&file->lock);
+
+	if ((ion_file_stdio != file->backend) || file->holding) {
+		if (SEEK_CUR == origin) {
+			seek_to += file->position;
+		}
+		else if (ION_FILE_END == origin) {
+			seek_to += file->holding ? file->held_size : file->size;
+		}
+
+		if (seek_to < 0) {
+			error = err_file_bad_seek;
+		}
+		else {
+			file->position = seek_to;
+		}
+	}
+	else if (0 != fseek(file->stream, seek_to, origin)) {
+		error = err_file_bad_seek;
 	}
 
-	return err_ok;
+	pthread_mutex_unlock(&file->lock);
+
+	return error;
 #endif
 }
 
@@ -135,7 +1061,14 @@ ion_ftell(
 #if defined(ARDUINO)
 	return ftell(file.file);
 #else
-	return ftell(file);
+
+	ion_file_offset_t position;
+
+	pthread_mutex_lock(&file->lock);
+	position = (ion_file_stdio != file->backend) || file->holding ? file->position : ftell(file->stream);
+	pthread_mutex_unlock(&file->lock);
+
+	return position;
 #endif
 }
 
@@ -143,13 +1076,21 @@ ion_file_offset_t
 ion_fend(
 	ion_file_handle_t file
 ) {
-	ion_file_offset_t	previous;
-	ion_file_offset_t	to_return;
+	ion_file_offset_t to_return;
+
+#if defined(ARDUINO)
+
+	ion_file_offset_t previous;
 
 	previous	= ion_ftell(file);
 	ion_fseek(file, 0, ION_FILE_END);
 	to_return	= ion_ftell(file);
 	ion_fseek(file, previous, ION_FILE_START);
+#else
+	pthread_mutex_lock(&file->lock);
+	to_return = file->holding ? file->held_size : ion_file_size(file);
+	pthread_mutex_unlock(&file->lock);
+#endif
 
 	return to_return;
 }
@@ -168,8 +1109,28 @@ ion_fwrite(
 
 	return err_ok;
 #else
-	fwrite(to_write, num_bytes, 1, file);
-	return err_ok;
+
+	ion_err_t error = err_ok;
+
+	pthread_mutex_lock(&file->lock);
+
+	if (file->holding) {
+		error = ion_file_hold_write(file, file->position, num_bytes, to_write);
+	}
+	else if (ion_file_stdio == file->backend) {
+		fwrite(to_write, num_bytes, 1, file->stream);
+	}
+	else {
+		error = ion_file_write_backend(file, file->position, num_bytes, to_write);
+	}
+
+	if (err_ok == error) {
+		file->position += num_bytes;
+	}
+
+	pthread_mutex_unlock(&file->lock);
+
+	return err_ok == error ? err_ok : err_file_write_error;
 #endif
 }
 
@@ -182,6 +1143,7 @@ ion_fwrite_at(
 ) {
 	ion_err_t error;
 
+#if defined(ARDUINO)
 	error = ion_fseek(file, offset, ION_FILE_START);
 
 	if (err_ok != error) {
@@ -189,6 +1151,23 @@ ion_fwrite_at(
 	}
 
 	error = ion_fwrite(file, num_bytes, to_write);
+#else
+	pthread_mutex_lock(&file->lock);
+
+	if (file->holding) {
+		error = err_ok == ion_file_hold_write(file, offset, num_bytes, to_write) ? err_ok : err_file_write_error;
+	}
+	else {
+		error = ion_file_write_backend(file, offset, num_bytes, to_write);
+	}
+
+	if (err_ok == error) {
+		file->position = offset + num_bytes;
+	}
+
+	pthread_mutex_unlock(&file->lock);
+#endif
+
 	return error;
 }
 
@@ -225,11 +1204,27 @@ ion_fread(
 	return err_ok;
 #else
 
-	if (1 != fread(write_to, num_bytes, 1, file)) {
-		return err_file_read_error;
+	ion_err_t error = err_ok;
+
+	pthread_mutex_lock(&file->lock);
+
+	if (file->holding) {
+		error = ion_file_hold_read(file, file->position, num_bytes, write_to);
+	}
+	else if (ion_file_stdio == file->backend) {
+		error = 1 == fread(write_to, num_bytes, 1, file->stream) ? err_ok : err_file_read_error;
+	}
+	else {
+		error = ion_file_read_backend(file, file->position, num_bytes, write_to);
 	}
 
-	return err_ok;
+	if (err_ok == error) {
+		file->position += num_bytes;
+	}
+
+	pthread_mutex_unlock(&file->lock);
+
+	return err_ok == error ? err_ok : err_file_read_error;
 #endif
 }
 
@@ -242,6 +1237,7 @@ ion_fread_at(
 ) {
 	ion_err_t error;
 
+#if defined(ARDUINO)
 	error = ion_fseek(file, offset, ION_FILE_START);
 
 	if (err_ok != error) {
@@ -249,5 +1245,245 @@ ion_fread_at(
 	}
 
 	error = ion_fread(file, num_bytes, write_to);
+#else
+	pthread_mutex_lock(&file->lock);
+
+	if (file->holding) {
+		error = err_ok == ion_file_hold_read(file, offset, num_bytes, write_to) ? err_ok : err_file_read_error;
+	}
+	else {
+		error = ion_file_read_backend(file, offset, num_bytes, write_to);
+	}
+
+	if (err_ok == error) {
+		file->position = offset + num_bytes;
+	}
+
+	pthread_mutex_unlock(&file->lock);
+#endif
+
+	return error;
+}
+
+ion_byte_t *
+ion_fmap_at(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+#if defined(ARDUINO)
+	UNUSED(file);
+	UNUSED(offset);
+	UNUSED(num_bytes);
+	return NULL;
+#else
+
+	if ((ion_file_mapped != file->backend) || file->holding || (offset < 0) || (offset + (ion_file_offset_t) num_bytes > file->size)) {
+		return NULL;
+	}
+
+	return file->map + offset;
+#endif
+}
+
+ion_err_t
+ion_fsync(
+	ion_file_handle_t file
+) {
+#if defined(ARDUINO)
+
+	if (0 != fflush(file.file)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+#else
+
+	ion_err_t error = err_ok;
+
+	pthread_mutex_lock(&file->lock);
+
+	/* held pages wait for the rest of their writeback */
+	if (!file->holding) {
+		error = ion_file_sync(file);
+	}
+
+	pthread_mutex_unlock(&file->lock);
+
+	return error;
+#endif
+}
+
+ion_err_t
+ion_fflush(
+	ion_file_handle_t file
+) {
+#if defined(ARDUINO)
+
+	if (0 != fflush(file.file)) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+#else
+
+	ion_err_t error = err_ok;
+
+	pthread_mutex_lock(&file->lock);
+
+	if (ion_file_positional == file->backend) {
+		error = ion_file_flush(file);
+	}
+	else if ((ion_file_stdio == file->backend) && (0 != fflush(file->stream))) {
+		error = err_file_write_error;
+	}
+
+	pthread_mutex_unlock(&file->lock);
+
+	return error;
+#endif
+}
+
+ion_err_t
+ion_fhold(
+	ion_file_handle_t		file,
+	ion_file_writeback_t	*writeback
+) {
+#if defined(ARDUINO)
+	UNUSED(file);
+	return NULL != writeback ? err_not_implemented : err_ok;
+#else
+
+	ion_err_t error;
+
+	pthread_mutex_lock(&file->lock);
+	error = ion_file_hold(file, writeback);
+	pthread_mutex_unlock(&file->lock);
+
 	return error;
+#endif
+}
+
+ion_boolean_t
+ion_fholds(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+#if defined(ARDUINO)
+	UNUSED(file);
+	UNUSED(offset);
+	UNUSED(num_bytes);
+	return boolean_false;
+#else
+
+	ion_file_offset_t page;
+
+	if (!file->holding) {
+		return boolean_false;
+	}
+
+	for (page = offset - offset % ION_FILE_PAGE_SIZE; page < offset + (ion_file_offset_t) num_bytes; page += ION_FILE_PAGE_SIZE) {
+		if (ion_file_find_held(file, page) >= 0) {
+			return boolean_true;
+		}
+	}
+
+	return boolean_false;
+#endif
+}
+
+ion_err_t
+ion_file_visit_held(
+	ion_file_writeback_t	*writeback,
+	ion_file_visit_held_t	visit,
+	void					*context
+) {
+#if defined(ARDUINO)
+	UNUSED(writeback);
+	UNUSED(visit);
+	UNUSED(context);
+	return err_ok;
+#else
+
+	ion_file_handle_t	file;
+	ion_file_offset_t	length;
+	ion_err_t			error;
+	int					i;
+	int					j;
+
+	for (i = 0; i < writeback->count; i++) {
+		file = writeback->files[i];
+
+		for (j = 0; j < file->held_count; j++) {
+			length	= file->held_size - file->held[j].offset < ION_FILE_PAGE_SIZE ? file->held_size - file->held[j].offset : ION_FILE_PAGE_SIZE;
+			error	= visit(context, file->name, file->held[j].offset, (unsigned int) length, file->held[j].bytes);
+
+			if (err_ok != error) {
+				return error;
+			}
+		}
+	}
+
+	return err_ok;
+#endif
+}
+
+ion_err_t
+ion_file_write_back(
+	ion_file_writeback_t *writeback
+) {
+#if defined(ARDUINO)
+	UNUSED(writeback);
+	return err_ok;
+#else
+
+	ion_file_handle_t	file;
+	ion_err_t			error;
+	int					i;
+
+	for (i = 0; i < writeback->count; i++) {
+		file = writeback->files[i];
+		pthread_mutex_lock(&file->lock);
+		error = ion_file_write_held(file);
+
+		if (err_ok == error) {
+			error = ion_file_sync(file);
+		}
+
+		pthread_mutex_unlock(&file->lock);
+
+		if (err_ok != error) {
+			return error;
+		}
+	}
+
+	return err_ok;
+#endif
+}
+
+int
+ion_fdescriptor(
+	ion_file_handle_t file
+) {
+#if defined(ARDUINO)
+	UNUSED(file);
+	return -1;
+#else
+
+	int fd = file->fd;
+
+	pthread_mutex_lock(&file->lock);
+
+	if ((ion_file_positional == file->backend) && (err_ok != ion_file_flush(file))) {
+		fd = -1;
+	}
+	else if (ion_file_stdio == file->backend) {
+		fd = 0 == fflush(file->stream) ? fileno(file->stream) : -1;
+	}
+
+	pthread_mutex_unlock(&file->lock);
+
+	return fd;
+#endif
 }
@@ -49,6 +49,38 @@ typedef long ion_file_offset_t;
 #define ION_FILE_START	SEEK_SET
 #define ION_FILE_END	SEEK_END
 
+/**
+@brief		How an open file is read and written.
+*/
+typedef enum {
+	ion_file_stdio,	/**< Through a buffered stdio stream. */
+	ion_file_mapped,/**< Through a shared memory mapping, so reads and
+						 writes within the file are copies rather than
+						 calls into the system. */
+	ion_file_positional	/**< Through pread and pwrite on a descriptor,
+							 buffering a page at a time, so no call moves
+							 a position shared by every user of the file. */
+} ion_file_backend_t;
+
+/**
+@brief		The backend @ref ion_fopen opens files with. Arduino has only
+			stdio, which every backend falls back to there.
+*/
+#if !defined(ION_FILE_BACKEND)
+#if defined(ARDUINO)
+#define ION_FILE_BACKEND ion_file_stdio
+#else
+#define ION_FILE_BACKEND ion_file_positional
+#endif
+#endif
+
+/**
+@brief		The size, in bytes, of the page a positional file buffers.
+*/
+#if !defined(ION_FILE_PAGE_SIZE)
+#define ION_FILE_PAGE_SIZE 4096
+#endif
+
 #if defined(ARDUINO)
 
 #include "sd_stdio_c_iface.h"
@@ -65,8 +97,60 @@ typedef struct file_handle {
 
 #include "stdio.h"
 #include "unistd.h"
+#include <pthread.h>
 
-typedef FILE *ion_file_handle_t;
+/**
+@brief		A page of a file whose writes are held in memory.
+*/
+typedef struct {
+	ion_file_offset_t	offset;	/**< Where the page starts. */
+	ion_byte_t			*bytes;	/**< The page as written, zeroes past
+									 the end of the file. */
+} ion_file_held_t;
+
+/**
+@brief		An open file.
+*/
+typedef struct ion_file {
+	ion_file_backend_t	backend;	/**< How the file is read and written. */
+	FILE				*stream;	/**< The stream of a stdio file. */
+	int					fd;			/**< The descriptor of a mapped or
+										 positional file. */
+	ion_byte_t			*map;		/**< The mapping of a mapped file, NULL
+										 until the file has any bytes. */
+	ion_file_offset_t	size;		/**< The size of a mapped or positional
+										 file, counting buffered writes. */
+	ion_file_offset_t	capacity;	/**< The bytes mapped, at least @p size. */
+	ion_file_offset_t	position;	/**< The position of a mapped or
+										 positional file. */
+	ion_byte_t			*page;		/**< The page a positional file buffers. */
+	ion_file_offset_t	page_offset;/**< Where the buffered page starts, or
+										 -1 if none is. */
+	ion_file_offset_t	page_length;/**< The bytes of the page that are
+										 valid. Past the end of the file the
+										 page holds zeroes. */
+	ion_file_offset_t	dirty_start;/**< The first byte of the page written
+										 but not yet flushed. */
+	ion_file_offset_t	dirty_end;	/**< One past the last such byte, equal
+										 to @p dirty_start if none is. */
+	ion_boolean_t		holding;	/**< Whether writes are held in memory
+										 until the file is synced. */
+	ion_file_held_t		*held;		/**< The pages written while holding,
+										 in the order of their offsets. */
+	int					held_count;	/**< The pages in @p held. */
+	int					held_capacity;	/**< The room for pages in @p held. */
+	ion_file_offset_t	held_size;	/**< The size of the file counting held
+										 writes, while holding. */
+	char				*name;		/**< The name the file was opened by. */
+	struct ion_file_writeback	*writeback;	/**< The files it is written
+											 back with, while holding. */
+	pthread_mutex_t		lock;		/**< Guards the position, stream,
+										 buffered page and held pages, so
+										 threads may read the file at
+										 once. */
+} ion_file_t;
+
+typedef ion_file_t *ion_file_handle_t;
 
 #define ION_NOFILE ((ion_file_handle_t) (NULL))
 
@@ -74,16 +158,75 @@ typedef FILE *ion_file_handle_t;
 
 #define ION_FILE_NULL -1
 
+/**
+@brief		Files holding their writes, which are written back together.
+*/
+typedef struct ion_file_writeback {
+	ion_file_handle_t	*files;		/**< The files. */
+	int					count;		/**< The files in @p files. */
+	int					capacity;	/**< The room for files in @p files. */
+} ion_file_writeback_t;
+
+/**
+@brief		Called for each page a file holds.
+@param		context
+				The context given with the function.
+@param		name
+				The name of the file.
+@param		offset
+				Where the page starts.
+@param		num_bytes
+				The bytes of the page that lie within the file.
+@param		bytes
+				The page.
+@return		The status of visiting the page.
+*/
+typedef ion_err_t (*ion_file_visit_held_t)(
+	void *,
+	char *,
+	ion_file_offset_t,
+	unsigned int,
+	ion_byte_t *
+);
+
 ion_boolean_t
 ion_fexists(
 	char *name
 );
 
+/**
+@brief		Opens a file for reading and writing with the default backend,
+			@ref ION_FILE_BACKEND, creating it if it doesn't exist.
+@param		name
+				The name of the file.
+@return		The open file, or @ref ION_NOFILE if it can't be opened.
+*/
 ion_file_handle_t
 ion_fopen(
 	char *name
 );
 
+/**
+@brief		Opens a file for reading and writing with a chosen backend,
+			creating it if it doesn't exist.
+@details	A mapped file is grown as it is written past its end, and
+			@ref ion_fsync flushes the mapping. A positional file never
+			seeks its descriptor, so handles on the same file don't share
+			a position, and its buffered page reaches the file on
+			@ref ion_fsync or @ref ion_fclose. Where a file can't be
+			opened with the backend asked for it is opened through stdio.
+@param		name
+				The name of the file.
+@param		backend
+				How the file is to be read and written.
+@return		The open file, or @ref ION_NOFILE if it can't be opened.
+*/
+ion_file_handle_t
+ion_fopen_backend(
+	char				*name,
+	ion_file_backend_t	backend
+);
+
 ion_err_t
 ion_fclose(
 	ion_file_handle_t file
@@ -141,6 +284,132 @@ ion_fread_at(
 	ion_byte_t			*write_to
 );
 
+/**
+@brief		Points at bytes of a mapped file, so they can be read in place.
+@details	The pointer is valid until the file is next written past its
+			end, or closed. Bytes written through it reach the file, but
+			mustn't lie past its end.
+@param		file
+				The file.
+@param		offset
+				Where the bytes start.
+@param		num_bytes
+				How many bytes are wanted.
+@return		The bytes, or NULL if the file isn't mapped or doesn't hold
+			them all.
+*/
+ion_byte_t *
+ion_fmap_at(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+);
+
+ion_err_t
+ion_fsync(
+	ion_file_handle_t file
+);
+
+/**
+@brief		Writes back whatever a file buffers in the process, so that it
+			is not lost if the process ends without closing the file.
+@details	Writes held by @ref ion_fhold stay held.
+@param		file
+				The file.
+@return		The status of writing the buffered bytes.
+*/
+ion_err_t
+ion_fflush(
+	ion_file_handle_t file
+);
+
+/**
+@brief		Holds the writes made to a file in memory until they are written
+			back, or lets them through again.
+@details	While writes are held the file keeps the bytes it had when it
+			was last written back, so a crash loses every write since.
+			Reads see the held writes, but nothing of the file can be read
+			in place with @ref ion_fmap_at, and reads straight from its
+			descriptor see only what the file has. @ref ion_fsync leaves the
+			held pages alone; @ref ion_file_write_back writes them, along
+			with those of every other file in the same writeback. Letting
+			writes through, or closing the file, writes them without a
+			sync. Not available on Arduino.
+@param		file
+				The file.
+@param		writeback
+				The files the file is to be written back with, or NULL to
+				let writes through.
+@return		The status of writing back what was held, if @p writeback is
+			NULL.
+*/
+ion_err_t
+ion_fhold(
+	ion_file_handle_t		file,
+	ion_file_writeback_t	*writeback
+);
+
+/**
+@brief		Whether a file holds any of some bytes in memory, so that its
+			descriptor doesn't show them as written.
+@param		file
+				The file.
+@param		offset
+				Where the bytes start.
+@param		num_bytes
+				How many bytes.
+@return		True if a held page covers any of the bytes.
+*/
+ion_boolean_t
+ion_fholds(
+	ion_file_handle_t	file,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+);
+
+/**
+@brief		Visits every page held by the files of a writeback, file by
+			file and in the order of their offsets.
+@param		writeback
+				The files.
+@param		visit
+				Called for each page.
+@param		context
+				Passed to @p visit.
+@return		The first error from @p visit, or err_ok.
+*/
+ion_err_t
+ion_file_visit_held(
+	ion_file_writeback_t	*writeback,
+	ion_file_visit_held_t	visit,
+	void					*context
+);
+
+/**
+@brief		Writes the held pages of the files of a writeback to them and
+			syncs each, and goes on holding.
+@param		writeback
+				The files.
+@return		The status of writing the pages.
+*/
+ion_err_t
+ion_file_write_back(
+	ion_file_writeback_t *writeback
+);
+
+/**
+@brief		Writes back whatever a file buffers, so that reads made straight
+			from its descriptor see it, and returns the descriptor. Writes
+			held by @ref ion_fhold are not seen there.
+@param		file
+				The file.
+@return		The descriptor, or -1 if the file has none, as on Arduino.
+*/
+int
+ion_fdescriptor(
+	ion_file_handle_t file
+);
+
 #if defined(__cplusplus)
 }
 #endif
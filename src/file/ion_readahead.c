@@ -0,0 +1,838 @@
+/******************************************************************************/
+/**
+@file		ion_readahead.c
+@author		IonDB Project Contributors
+@brief		Queues reads of a file ahead of need, through an io_uring or a
+			pool of threads.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* Needed for syscall, as glibc has no io_uring wrappers. */
+#define _GNU_SOURCE
+#endif
+
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+/* Needed for pthreads and pread under -std=c99. */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "ion_readahead.h"
+
+#if !defined(ARDUINO)
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ION_READAHEAD_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+/**
+@brief		What a read's buffer holds.
+*/
+typedef enum {
+	ion_readahead_free,		/**< Nothing, it can be used. */
+	ion_readahead_queued,	/**< A read still under way. */
+	ion_readahead_landed,	/**< A read that has completed. */
+	ion_readahead_failed	/**< A read that failed, or found the file ended. */
+} ion_readahead_state_t;
+
+/**
+@brief		One read, and the buffer it reads into.
+*/
+typedef struct readahead_slot {
+	ion_readahead_t			*readahead;	/**< The readahead it belongs to. */
+	ion_file_offset_t		offset;		/**< Where in the file it reads. */
+	ion_readahead_state_t	state;		/**< What the buffer holds. */
+	unsigned int			landed;		/**< Bytes read, once landed. */
+	unsigned long			order;		/**< When it was queued, so the
+											 oldest is reused first. */
+	ion_boolean_t			dropped;	/**< Whether the file was written
+											 where it reads while under way,
+											 so it is freed as it lands. */
+	ion_byte_t				*buffer;	/**< Where the bytes are read to. */
+	struct readahead_slot	*next;		/**< The next read queued for the
+											 thread pool. */
+} ion_readahead_slot_t;
+
+struct readahead {
+	ion_readahead_engine_t	engine;		/**< How reads are carried out. */
+	ion_file_handle_t		file;		/**< The file read. */
+	int						fd;			/**< The descriptor read from. */
+	int						depth;		/**< How many slots there are. */
+	unsigned int			length;		/**< Bytes each read fetches. */
+	unsigned long			order;		/**< Reads queued so far. */
+	int						in_flight;	/**< Reads still under way. */
+	ion_readahead_slot_t	*slots;		/**< The reads. */
+#if defined(ION_READAHEAD_IO_URING)
+	int						ring;		/**< The io_uring's descriptor. */
+	void					*sq_map;	/**< The mapped submission ring. */
+	size_t					sq_size;	/**< Bytes in @p sq_map. */
+	void					*cq_map;	/**< The mapped completion ring, which
+											 may be @p sq_map. */
+	size_t					cq_size;	/**< Bytes in @p cq_map. */
+	struct io_uring_sqe		*sqes;		/**< The submission entries. */
+	size_t					sqes_size;	/**< Bytes in @p sqes. */
+	unsigned				*sq_tail;	/**< Where the next entry is queued. */
+	unsigned				*sq_mask;	/**< Wraps a submission index. */
+	unsigned				*sq_array;	/**< Indexes of queued entries. */
+	unsigned				*cq_head;	/**< The next completion to reap. */
+	unsigned				*cq_tail;	/**< Past the last completion. */
+	unsigned				*cq_mask;	/**< Wraps a completion index. */
+	struct io_uring_cqe		*cqes;		/**< The completions. */
+#endif
+};
+
+/**
+@brief		Guards the thread pool's queue, and the slots of every
+			readahead using the pool.
+*/
+static pthread_mutex_t ion_readahead_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+@brief		Signalled when a read is queued for the pool.
+*/
+static pthread_cond_t ion_readahead_queued_cond = PTHREAD_COND_INITIALIZER;
+
+/**
+@brief		Signalled when the pool finishes a read.
+*/
+static pthread_cond_t ion_readahead_landed_cond = PTHREAD_COND_INITIALIZER;
+
+/**
+@brief		The reads waiting for a thread of the pool, oldest first.
+*/
+static ion_readahead_slot_t *ion_readahead_head;
+
+/**
+@brief		The read queued for the pool last.
+*/
+static ion_readahead_slot_t *ion_readahead_tail;
+
+/**
+@brief		How many threads of the pool are running.
+*/
+static int ion_readahead_workers;
+
+/**
+@brief		Reads exactly a slot's length, stopping short at the end of
+			the file.
+@return		The bytes read, or -1 if reading failed.
+*/
+static ssize_t
+ion_readahead_pread(
+	ion_readahead_slot_t *slot
+) {
+	ion_readahead_t *readahead	= slot->readahead;
+	size_t			done		= 0;
+	ssize_t			got;
+
+	while (done < readahead->length) {
+		got = pread(readahead->fd, slot->buffer + done, readahead->length - done, slot->offset + done);
+
+		if (got < 0) {
+			return -1;
+		}
+
+		if (0 == got) {
+			break;
+		}
+
+		done += got;
+	}
+
+	return done;
+}
+
+/**
+@brief		Marks a slot as read, given how many bytes a read found.
+*/
+static void
+ion_readahead_land(
+	ion_readahead_slot_t	*slot,
+	long					got
+) {
+	slot->state		= slot->dropped ? ion_readahead_free : got > 0 ? ion_readahead_landed : ion_readahead_failed;
+	slot->landed	= got > 0 ? got : 0;
+	slot->readahead->in_flight--;
+}
+
+/**
+@brief		A thread of the pool, reading whatever is queued for it.
+*/
+static void *
+ion_readahead_worker(
+	void *unused
+) {
+	ion_readahead_slot_t	*slot;
+	ssize_t					got;
+
+	UNUSED(unused);
+	pthread_mutex_lock(&ion_readahead_mutex);
+
+	while (1) {
+		while (NULL == ion_readahead_head) {
+			pthread_cond_wait(&ion_readahead_queued_cond, &ion_readahead_mutex);
+		}
+
+		slot				= ion_readahead_head;
+		ion_readahead_head	= slot->next;
+
+		if (NULL == ion_readahead_head) {
+			ion_readahead_tail = NULL;
+		}
+
+		/* the slot stays queued, so nothing else touches its buffer */
+		pthread_mutex_unlock(&ion_readahead_mutex);
+		got = ion_readahead_pread(slot);
+		pthread_mutex_lock(&ion_readahead_mutex);
+
+		ion_readahead_land(slot, got);
+		pthread_cond_broadcast(&ion_readahead_landed_cond);
+	}
+
+	return NULL;
+}
+
+/**
+@brief		Starts the threads of the pool, unless they are running.
+@return		Whether any thread is running. Called with the pool's mutex
+			held.
+*/
+static ion_boolean_t
+ion_readahead_start_pool(
+	void
+) {
+	pthread_attr_t	attributes;
+	pthread_t		thread;
+
+	if (0 != pthread_attr_init(&attributes)) {
+		return ion_readahead_workers > 0;
+	}
+
+	pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+	while ((ion_readahead_workers < ION_READAHEAD_THREADS) && (0 == pthread_create(&thread, &attributes, ion_readahead_worker, NULL))) {
+		ion_readahead_workers++;
+	}
+
+	pthread_attr_destroy(&attributes);
+
+	return ion_readahead_workers > 0;
+}
+
+#if defined(ION_READAHEAD_IO_URING)
+
+/**
+@brief		Sets up the io_uring of a readahead.
+@return		Whether it could be.
+*/
+static ion_boolean_t
+ion_readahead_setup_ring(
+	ion_readahead_t *readahead
+) {
+	struct io_uring_params	params;
+	char					*sq;
+	char					*cq;
+
+	memset(&params, 0, sizeof(params));
+	readahead->ring = syscall(__NR_io_uring_setup, readahead->depth, &params);
+
+	if (readahead->ring < 0) {
+		return boolean_false;
+	}
+
+	readahead->sq_size		= params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	readahead->cq_size		= params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	readahead->sqes_size	= params.sq_entries * sizeof(struct io_uring_sqe);
+
+	/* newer kernels map both rings at once */
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		readahead->sq_size = readahead->cq_size > readahead->sq_size ? readahead->cq_size : readahead->sq_size;
+	}
+
+	readahead->sq_map	= mmap(NULL, readahead->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED, readahead->ring, IORING_OFF_SQ_RING);
+	readahead->cq_map	= readahead->sq_map;
+	readahead->sqes		= MAP_FAILED;
+
+	if ((MAP_FAILED != readahead->sq_map) && !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+		readahead->cq_map = mmap(NULL, readahead->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED, readahead->ring, IORING_OFF_CQ_RING);
+	}
+
+	if ((MAP_FAILED != readahead->sq_map) && (MAP_FAILED != readahead->cq_map)) {
+		readahead->sqes = mmap(NULL, readahead->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED, readahead->ring, IORING_OFF_SQES);
+	}
+
+	if (MAP_FAILED == readahead->sqes) {
+		if ((MAP_FAILED != readahead->cq_map) && (readahead->cq_map != readahead->sq_map)) {
+			munmap(readahead->cq_map, readahead->cq_size);
+		}
+
+		if (MAP_FAILED != readahead->sq_map) {
+			munmap(readahead->sq_map, readahead->sq_size);
+		}
+
+		close(readahead->ring);
+		return boolean_false;
+	}
+
+	sq						= readahead->sq_map;
+	cq						= readahead->cq_map;
+	readahead->sq_tail		= (unsigned *) (sq + params.sq_off.tail);
+	readahead->sq_mask		= (unsigned *) (sq + params.sq_off.ring_mask);
+	readahead->sq_array		= (unsigned *) (sq + params.sq_off.array);
+	readahead->cq_head		= (unsigned *) (cq + params.cq_off.head);
+	readahead->cq_tail		= (unsigned *) (cq + params.cq_off.tail);
+	readahead->cq_mask		= (unsigned *) (cq + params.cq_off.ring_mask);
+	readahead->cqes			= (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+	return boolean_true;
+}
+
+/**
+@brief		Marks the reads the io_uring has completed as landed.
+@param		wait
+				Whether to wait for a read to complete if none has.
+*/
+static void
+ion_readahead_reap(
+	ion_readahead_t *readahead,
+	ion_boolean_t	wait
+) {
+	unsigned			head	= *readahead->cq_head;
+	unsigned			tail	= __atomic_load_n(readahead->cq_tail, __ATOMIC_ACQUIRE);
+	struct io_uring_cqe *cqe;
+
+	if ((head == tail) && wait && (readahead->in_flight > 0)) {
+		syscall(__NR_io_uring_enter, readahead->ring, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+		tail = __atomic_load_n(readahead->cq_tail, __ATOMIC_ACQUIRE);
+	}
+
+	while (head != tail) {
+		cqe = &readahead->cqes[head & *readahead->cq_mask];
+		ion_readahead_land(&readahead->slots[cqe->user_data], cqe->res);
+		head++;
+	}
+
+	__atomic_store_n(readahead->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+@brief		Hands a slot's read to the io_uring.
+@return		Whether the kernel took it.
+*/
+static ion_boolean_t
+ion_readahead_submit(
+	ion_readahead_slot_t *slot
+) {
+	ion_readahead_t		*readahead	= slot->readahead;
+	unsigned			tail		= *readahead->sq_tail;
+	unsigned			index		= tail & *readahead->sq_mask;
+	struct io_uring_sqe *sqe		= &readahead->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode					= IORING_OP_READ;
+	sqe->fd						= readahead->fd;
+	sqe->addr					= (unsigned long) slot->buffer;
+	sqe->len					= readahead->length;
+	sqe->off					= slot->offset;
+	sqe->user_data				= slot - readahead->slots;
+	readahead->sq_array[index]	= index;
+	__atomic_store_n(readahead->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	return 1 == syscall(__NR_io_uring_enter, readahead->ring, 1, 0, 0, NULL, 0);
+}
+
+#endif
+
+ion_readahead_t *
+ion_readahead_open(
+	ion_file_handle_t	file,
+	int					depth,
+	unsigned int		length
+) {
+	ion_readahead_t *readahead = ion_readahead_open_engine(file, depth, length, ion_readahead_io_uring);
+
+	if (NULL == readahead) {
+		readahead = ion_readahead_open_engine(file, depth, length, ion_readahead_threads);
+	}
+
+	return readahead;
+}
+
+ion_readahead_t *
+ion_readahead_open_engine(
+	ion_file_handle_t		file,
+	int						depth,
+	unsigned int			length,
+	ion_readahead_engine_t	engine
+) {
+	ion_readahead_t *readahead;
+	ion_boolean_t	started;
+	int				i;
+
+	if ((depth <= 0) || (0 == length)) {
+		return NULL;
+	}
+
+	readahead = malloc(sizeof(ion_readahead_t));
+
+	if (NULL == readahead) {
+		return NULL;
+	}
+
+	readahead->engine		= engine;
+	readahead->file			= file;
+	readahead->fd			= ion_fdescriptor(file);
+	readahead->depth		= depth;
+	readahead->length		= length;
+	readahead->order		= 0;
+	readahead->in_flight	= 0;
+	readahead->slots		= calloc(depth, sizeof(ion_readahead_slot_t) + length);
+
+	if ((-1 == readahead->fd) || (NULL == readahead->slots)) {
+		free(readahead->slots);
+		free(readahead);
+		return NULL;
+	}
+
+	/* the buffers follow the slots, in the same allocation */
+	for (i = 0; i < depth; i++) {
+		readahead->slots[i].readahead	= readahead;
+		readahead->slots[i].state		= ion_readahead_free;
+		readahead->slots[i].buffer		= (ion_byte_t *) (readahead->slots + depth) + i * length;
+	}
+
+	if (ion_readahead_io_uring == engine) {
+#if defined(ION_READAHEAD_IO_URING)
+		started = ion_readahead_setup_ring(readahead);
+#else
+		started = boolean_false;
+#endif
+	}
+	else {
+		pthread_mutex_lock(&ion_readahead_mutex);
+		started = ion_readahead_start_pool();
+		pthread_mutex_unlock(&ion_readahead_mutex);
+	}
+
+	if (!started) {
+		free(readahead->slots);
+		free(readahead);
+		return NULL;
+	}
+
+	return readahead;
+}
+
+/**
+@brief		Finds the slot reading an offset, or else the one to read it
+			into: a free slot, or the one landed longest ago.
+@return		The slot, or NULL if every slot is still being read into.
+*/
+static ion_readahead_slot_t *
+ion_readahead_find(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset
+) {
+	ion_readahead_slot_t	*slot;
+	ion_readahead_slot_t	*victim = NULL;
+	int						i;
+
+	for (i = 0; i < readahead->depth; i++) {
+		slot = &readahead->slots[i];
+
+		if (ion_readahead_free == slot->state) {
+			if ((NULL == victim) || (ion_readahead_free != victim->state)) {
+				victim = slot;
+			}
+
+			continue;
+		}
+
+		if (slot->offset == offset) {
+			return slot;
+		}
+
+		if ((ion_readahead_queued != slot->state) && ((NULL == victim) || ((ion_readahead_free != victim->state) && (slot->order < victim->order)))) {
+			victim = slot;
+		}
+	}
+
+	return victim;
+}
+
+ion_err_t
+ion_readahead_queue(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset
+) {
+	ion_readahead_slot_t	*slot;
+	ion_err_t				error = err_ok;
+
+	if (offset < 0) {
+		return err_file_bad_seek;
+	}
+
+	/* the descriptor shows what is buffered once flushed, but never what is held */
+	if ((-1 == ion_fdescriptor(readahead->file)) || ion_fholds(readahead->file, offset, readahead->length)) {
+		return err_ok;
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_lock(&ion_readahead_mutex);
+	}
+
+#if defined(ION_READAHEAD_IO_URING)
+	else {
+		ion_readahead_reap(readahead, boolean_false);
+	}
+#endif
+
+	slot = ion_readahead_find(readahead, offset);
+
+	if (NULL == slot) {
+		error = err_out_of_memory;
+	}
+	else if ((ion_readahead_free == slot->state) || (slot->offset != offset) || (ion_readahead_failed == slot->state)) {
+		slot->offset	= offset;
+		slot->order		= ++readahead->order;
+		slot->state		= ion_readahead_queued;
+		slot->dropped	= boolean_false;
+		readahead->in_flight++;
+
+		if (ion_readahead_threads == readahead->engine) {
+			slot->next = NULL;
+
+			if (NULL == ion_readahead_tail) {
+				ion_readahead_head = slot;
+			}
+			else {
+				ion_readahead_tail->next = slot;
+			}
+
+			ion_readahead_tail = slot;
+			pthread_cond_signal(&ion_readahead_queued_cond);
+		}
+
+#if defined(ION_READAHEAD_IO_URING)
+		else if (!ion_readahead_submit(slot)) {
+			slot->state = ion_readahead_free;
+			readahead->in_flight--;
+			error		= err_file_read_error;
+		}
+#endif
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_unlock(&ion_readahead_mutex);
+	}
+
+	return error;
+}
+
+ion_byte_t *
+ion_readahead_peek(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+	ion_byte_t	*bytes = NULL;
+	int			i;
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_lock(&ion_readahead_mutex);
+	}
+
+#if defined(ION_READAHEAD_IO_URING)
+	else {
+		ion_readahead_reap(readahead, boolean_false);
+	}
+#endif
+
+	for (i = 0; i < readahead->depth; i++) {
+		if ((ion_readahead_landed == readahead->slots[i].state) && (readahead->slots[i].offset == offset) && (readahead->slots[i].landed >= num_bytes)) {
+			bytes = readahead->slots[i].buffer;
+			break;
+		}
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_unlock(&ion_readahead_mutex);
+	}
+
+	return bytes;
+}
+
+ion_boolean_t
+ion_readahead_take(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+	ion_readahead_slot_t	*slot;
+	ion_boolean_t			taken = boolean_false;
+	int						i;
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_lock(&ion_readahead_mutex);
+	}
+
+#if defined(ION_READAHEAD_IO_URING)
+	else {
+		ion_readahead_reap(readahead, boolean_false);
+	}
+#endif
+
+	for (i = 0; i < readahead->depth; i++) {
+		slot = &readahead->slots[i];
+
+		if ((ion_readahead_free == slot->state) || (slot->offset != offset) || slot->dropped) {
+			continue;
+		}
+
+		/* a read under way is waited for rather than made a second time */
+		while (ion_readahead_queued == slot->state) {
+			if (ion_readahead_threads == readahead->engine) {
+				pthread_cond_wait(&ion_readahead_landed_cond, &ion_readahead_mutex);
+			}
+
+#if defined(ION_READAHEAD_IO_URING)
+			else {
+				ion_readahead_reap(readahead, boolean_true);
+			}
+#endif
+		}
+
+		if ((ion_readahead_landed == slot->state) && (slot->landed >= num_bytes)) {
+			memcpy(write_to, slot->buffer, num_bytes);
+			slot->state = ion_readahead_free;
+			taken		= boolean_true;
+		}
+
+		break;
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_unlock(&ion_readahead_mutex);
+	}
+
+	return taken;
+}
+
+void
+ion_readahead_drop(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+	ion_readahead_slot_t	*slot;
+	int						i;
+
+	if (NULL == readahead) {
+		return;
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_lock(&ion_readahead_mutex);
+	}
+
+#if defined(ION_READAHEAD_IO_URING)
+	else {
+		ion_readahead_reap(readahead, boolean_false);
+	}
+#endif
+
+	for (i = 0; i < readahead->depth; i++) {
+		slot = &readahead->slots[i];
+
+		if ((ion_readahead_free == slot->state) || (slot->offset >= offset + (ion_file_offset_t) num_bytes) || (slot->offset + (ion_file_offset_t) readahead->length <= offset)) {
+			continue;
+		}
+
+		/* a read under way may already have passed the bytes */
+		if (ion_readahead_queued == slot->state) {
+			slot->dropped = boolean_true;
+		}
+		else {
+			slot->state = ion_readahead_free;
+		}
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_unlock(&ion_readahead_mutex);
+	}
+}
+
+void
+ion_readahead_close(
+	ion_readahead_t *readahead
+) {
+	ion_readahead_slot_t	**link;
+
+	if (NULL == readahead) {
+		return;
+	}
+
+	if (ion_readahead_threads == readahead->engine) {
+		pthread_mutex_lock(&ion_readahead_mutex);
+
+		/* reads no thread has started are dropped rather than waited for */
+		ion_readahead_tail = NULL;
+
+		for (link = &ion_readahead_head; NULL != *link;) {
+			if ((*link)->readahead == readahead) {
+				(*link)->state = ion_readahead_free;
+				readahead->in_flight--;
+				*link = (*link)->next;
+			}
+			else {
+				ion_readahead_tail	= *link;
+				link				= &(*link)->next;
+			}
+		}
+
+		while (readahead->in_flight > 0) {
+			pthread_cond_wait(&ion_readahead_landed_cond, &ion_readahead_mutex);
+		}
+
+		pthread_mutex_unlock(&ion_readahead_mutex);
+	}
+
+#if defined(ION_READAHEAD_IO_URING)
+	else {
+		/* the kernel may still be writing to the buffers */
+		while (readahead->in_flight > 0) {
+			ion_readahead_reap(readahead, boolean_true);
+		}
+
+		munmap(readahead->sqes, readahead->sqes_size);
+
+		if (readahead->cq_map != readahead->sq_map) {
+			munmap(readahead->cq_map, readahead->cq_size);
+		}
+
+		munmap(readahead->sq_map, readahead->sq_size);
+		close(readahead->ring);
+	}
+#endif
+
+	free(readahead->slots);
+	free(readahead);
+}
+
+#else /* Clause ARDUINO */
+
+ion_readahead_t *
+ion_readahead_open(
+	ion_file_handle_t	file,
+	int					depth,
+	unsigned int		length
+) {
+	return ion_readahead_open_engine(file, depth, length, ion_readahead_threads);
+}
+
+ion_readahead_t *
+ion_readahead_open_engine(
+	ion_file_handle_t		file,
+	int						depth,
+	unsigned int			length,
+	ion_readahead_engine_t	engine
+) {
+	UNUSED(file);
+	UNUSED(depth);
+	UNUSED(length);
+	UNUSED(engine);
+	return NULL;
+}
+
+ion_err_t
+ion_readahead_queue(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset
+) {
+	UNUSED(readahead);
+	UNUSED(offset);
+	return err_not_implemented;
+}
+
+ion_byte_t *
+ion_readahead_peek(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+	UNUSED(readahead);
+	UNUSED(offset);
+	UNUSED(num_bytes);
+	return NULL;
+}
+
+ion_boolean_t
+ion_readahead_take(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+) {
+	UNUSED(readahead);
+	UNUSED(offset);
+	UNUSED(num_bytes);
+	UNUSED(write_to);
+	return boolean_false;
+}
+
+void
+ion_readahead_drop(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+	UNUSED(readahead);
+	UNUSED(offset);
+	UNUSED(num_bytes);
+}
+
+void
+ion_readahead_close(
+	ion_readahead_t *readahead
+) {
+	UNUSED(readahead);
+}
+
+#endif /* Clause ARDUINO */
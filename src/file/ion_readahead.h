@@ -0,0 +1,196 @@
+/******************************************************************************/
+/**
+@file		ion_readahead.h
+@author		IonDB Project Contributors
+@brief		Queues reads of a file ahead of need, several at once, so that
+			scans following a chain of nodes don't wait on each read in
+			turn.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if !defined(ION_READAHEAD_H_)
+#define ION_READAHEAD_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "ion_file.h"
+
+/**
+@brief		How queued reads are carried out.
+*/
+typedef enum {
+	ion_readahead_io_uring,	/**< Submitted together to the kernel through an
+								 io_uring, Linux only. */
+	ion_readahead_threads	/**< Read by a small pool of threads shared by
+								 every readahead. */
+} ion_readahead_engine_t;
+
+/**
+@brief		How many threads read for readaheads without an io_uring.
+*/
+#if !defined(ION_READAHEAD_THREADS)
+#define ION_READAHEAD_THREADS 4
+#endif
+
+/**
+@brief		Reads queued against one open file.
+*/
+typedef struct readahead ion_readahead_t;
+
+/**
+@brief		Starts queueing reads of a file, through an io_uring where the
+			kernel has one and through the thread pool otherwise.
+@details	Each queued read fetches @p length bytes into a buffer of its
+			own, which the read that later wants them takes with
+			@ref ion_readahead_take. Whatever was written to @p file before
+			a read is queued is seen by it; bytes written after must be
+			dropped with @ref ion_readahead_drop. Not available on Arduino.
+@param		file
+				The file to read, which must stay open until the readahead
+				is closed.
+@param		depth
+				The most reads kept at once, queued or landed.
+@param		length
+				The bytes each read fetches.
+@return		The readahead, or NULL if it couldn't be started.
+*/
+ion_readahead_t *
+ion_readahead_open(
+	ion_file_handle_t	file,
+	int					depth,
+	unsigned int		length
+);
+
+/**
+@brief		Starts queueing reads of a file with a chosen engine.
+@details	As @ref ion_readahead_open, except that NULL is returned if
+			@p engine isn't available rather than falling back.
+*/
+ion_readahead_t *
+ion_readahead_open_engine(
+	ion_file_handle_t		file,
+	int						depth,
+	unsigned int			length,
+	ion_readahead_engine_t	engine
+);
+
+/**
+@brief		Queues a read, without waiting for it.
+@details	Reading an offset already queued or landed does nothing, nor
+			does reading bytes the file holds in memory, which its
+			descriptor doesn't show. When every buffer is taken, the read
+			landed longest ago gives up its buffer.
+@param		readahead
+				The readahead.
+@param		offset
+				Where in the file to read.
+@return		@ref err_ok if the read is queued, or the status of failing to
+			queue it, when every buffer is still being read into.
+*/
+ion_err_t
+ion_readahead_queue(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset
+);
+
+/**
+@brief		Looks at the bytes of a queued read, without waiting for it.
+@param		readahead
+				The readahead.
+@param		offset
+				Where in the file the read was queued.
+@param		num_bytes
+				How many bytes are wanted, at most the length of a read.
+@return		The bytes, valid until the next read is queued, or NULL if
+			no read of @p offset has landed with that many.
+*/
+ion_byte_t *
+ion_readahead_peek(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+);
+
+/**
+@brief		Takes the bytes of a queued read, waiting for it to land if it
+			is still under way, and frees its buffer for another.
+@param		readahead
+				The readahead.
+@param		offset
+				Where in the file the read was queued.
+@param		num_bytes
+				How many bytes are wanted, at most the length of a read.
+@param		write_to
+				Where the bytes are copied to.
+@return		Whether a read of @p offset was queued and landed with that
+			many bytes; if not, they must be read from the file.
+*/
+ion_boolean_t
+ion_readahead_take(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*write_to
+);
+
+/**
+@brief		Forgets the reads that cover bytes about to be, or just, written
+			to the file, so that they are never taken.
+@param		readahead
+				The readahead, or NULL.
+@param		offset
+				Where the bytes written start.
+@param		num_bytes
+				How many bytes are written.
+*/
+void
+ion_readahead_drop(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+);
+
+/**
+@brief		Waits for the reads still queued, then frees the readahead.
+@param		readahead
+				The readahead, or NULL.
+*/
+void
+ion_readahead_close(
+	ion_readahead_t *readahead
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
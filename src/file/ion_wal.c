@@ -0,0 +1,1193 @@
+/******************************************************************************/
+/**
+@file		ion_wal.c
+@author		IonDB Project Contributors
+@brief		Implementation of the write-ahead log.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE)
+/* Needed for pthreads, fileno, fsync and ftruncate under -std=c99. */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ion_wal.h"
+
+#if !defined(ARDUINO)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+@brief		The fixed part of a log record, followed by the key and value.
+*/
+typedef struct {
+	uint32_t	checksum;	/**< Of the rest of the record. */
+	uint32_t	type;		/**< An @ref ion_wal_record_type_t. */
+	uint32_t	id;			/**< The dictionary changed. */
+	uint32_t	key_size;	/**< Bytes of key. */
+	uint32_t	value_size;	/**< Bytes of value, 0 for a delete. */
+} ion_wal_header_t;
+
+/**
+@brief		The largest key and value a record may claim, so that a damaged
+			size reads as the end of the log rather than as a huge record.
+*/
+#define ION_WAL_MAX_BODY (1L << 24)
+
+/**
+@brief		A dictionary attached to a log.
+*/
+typedef struct wal_participant {
+	uint32_t				id;			/**< The id it was attached with. */
+	ion_wal_sync_t			sync;		/**< Syncs it at a checkpoint. */
+	void					*context;	/**< Passed to @p sync. */
+	struct wal_participant	*next;		/**< The next attached dictionary. */
+} ion_wal_participant_t;
+
+struct wal {
+	FILE					*file;			/**< The log, opened for appending. */
+	char					*name;			/**< The name of the log file. */
+	pthread_mutex_t			mutex;			/**< Guards the fields below. */
+	pthread_cond_t			changed;		/**< Signalled whenever they change. */
+	ion_wal_lsn_t			appended;		/**< The last record appended. */
+	ion_wal_lsn_t			durable;		/**< The last record synced. */
+	ion_boolean_t			syncing;		/**< True while a commit syncs. */
+	ion_boolean_t			checkpointing;	/**< True while a checkpoint runs. */
+	int						active;			/**< Changes begun and not ended. */
+	long					bytes;			/**< The size of the log. */
+	long					checkpoint_bytes;	/**< Size that triggers a checkpoint. */
+	long					carried;		/**< Bytes the last checkpoint kept. */
+	uint32_t				*pending;		/**< Ids with records, not attached yet. */
+	int						pending_count;	/**< Entries in @p pending. */
+	ion_wal_participant_t	*participants;	/**< The attached dictionaries. */
+	ion_wal_stats_t			stats;			/**< Usage counters. */
+};
+
+/**
+@brief		Called for each intact record while a log is read.
+*/
+typedef ion_err_t (*ion_wal_visit_t)(
+	void *,
+	long,
+	ion_wal_header_t *,
+	ion_byte_t *
+);
+
+/**
+@brief		Context of @ref ion_wal_replay_record.
+*/
+typedef struct {
+	uint32_t		id;			/**< The dictionary being attached. */
+	ion_wal_apply_t apply;		/**< Reapplies its records. */
+	void			*context;	/**< Passed to @p apply. */
+	long			start;		/**< Offset past its last forget record. */
+} ion_wal_replay_t;
+
+/**
+@brief		Context of @ref ion_wal_carry_record.
+*/
+typedef struct {
+	uint32_t	*ids;		/**< The dictionaries whose records are kept. */
+	int			count;		/**< Entries in @p ids. */
+	long		*starts;	/**< For each of @p ids, the offset past its
+								 last forget record. */
+	FILE		*file;		/**< The log replacing it, or NULL while
+								 @p starts are found. */
+	long		bytes;		/**< The bytes copied to @p file. */
+} ion_wal_carry_t;
+
+/**
+@brief		Context of @ref ion_wal_log_page.
+*/
+typedef struct {
+	ion_wal_t	*wal;		/**< The log. */
+	uint32_t	id;			/**< The dictionary written back. */
+	ion_byte_t	*value;		/**< Room for an offset and a page. */
+} ion_wal_page_log_t;
+
+/**
+@brief		Context of @ref ion_wal_repair_record.
+*/
+typedef struct {
+	uint32_t		*ids;		/**< The dictionaries with forget records. */
+	long			*starts;	/**< For each of @p ids, where the pages
+									 before its last forget record start,
+									 or -1 if it has none. */
+	long			*ends;		/**< For each of @p ids, the offset of its
+									 last forget record. */
+	int				count;		/**< Entries in @p ids. */
+	ion_boolean_t	writing;	/**< False while the records are found. */
+	char			*name;		/**< The file pages are written to. */
+	int				fd;			/**< Its descriptor, or -1 if it is gone. */
+} ion_wal_repair_t;
+
+/**
+@brief		The suffix of the file a checkpoint writes the new log to,
+			before it replaces the old one.
+*/
+#define ION_WAL_CARRY_SUFFIX ".new"
+
+/**
+@brief		Checksums a record, 32 bit FNV-1a over all but its first field.
+*/
+static uint32_t
+ion_wal_checksum(
+	ion_wal_header_t	*header,
+	ion_byte_t			*body
+) {
+	uint32_t	hash	= 2166136261UL;
+	ion_byte_t	*bytes	= (ion_byte_t *) &header->type;
+	uint32_t	i;
+
+	for (i = 0; i < sizeof(ion_wal_header_t) - sizeof(header->checksum); i++) {
+		hash = (hash ^ bytes[i]) * 16777619UL;
+	}
+
+	for (i = 0; i < header->key_size + header->value_size; i++) {
+		hash = (hash ^ body[i]) * 16777619UL;
+	}
+
+	return hash;
+}
+
+/**
+@brief		Reads a log from its start, stopping at the first record that is
+			incomplete or fails its checksum.
+@param		file
+				The log.
+@param		visit
+				Called for each intact record.
+@param		context
+				Passed to @p visit.
+@param		end
+				Set to the offset past the last intact record.
+@return		The first error from @p visit, or err_ok.
+*/
+static ion_err_t
+ion_wal_read(
+	FILE			*file,
+	ion_wal_visit_t visit,
+	void			*context,
+	long			*end
+) {
+	ion_wal_header_t	header;
+	ion_byte_t			*body		= NULL;
+	long				capacity	= 0;
+	long				size;
+	ion_byte_t			*grown;
+	ion_err_t			error		= err_ok;
+
+	*end = 0;
+
+	if (0 != fseek(file, 0, SEEK_SET)) {
+		return err_file_bad_seek;
+	}
+
+	while (1 == fread(&header, sizeof(header), 1, file)) {
+		if ((header.key_size > ION_WAL_MAX_BODY) || (header.value_size > ION_WAL_MAX_BODY)) {
+			break;
+		}
+
+		size = (long) header.key_size + header.value_size;
+
+		if (size > capacity) {
+			grown = realloc(body, size);
+
+			if (NULL == grown) {
+				error = err_out_of_memory;
+				break;
+			}
+
+			body		= grown;
+			capacity	= size;
+		}
+
+		if ((0 != size) && (1 != fread(body, size, 1, file))) {
+			break;
+		}
+
+		if (ion_wal_checksum(&header, body) != header.checksum) {
+			break;
+		}
+
+		if (err_ok != (error = visit(context, *end, &header, body))) {
+			break;
+		}
+
+		*end += sizeof(header) + size;
+	}
+
+	free(body);
+	return error;
+}
+
+/**
+@brief		Notes the dictionary of a record found when a log is opened.
+*/
+static ion_err_t
+ion_wal_note_pending(
+	void				*context,
+	long				offset,
+	ion_wal_header_t	*header,
+	ion_byte_t			*body
+) {
+	ion_wal_t	*wal = context;
+	uint32_t	*grown;
+	int			i;
+
+	UNUSED(offset);
+	UNUSED(body);
+
+	if (ion_wal_record_page == header->type) {
+		return err_ok;
+	}
+
+	for (i = 0; i < wal->pending_count; i++) {
+		if (wal->pending[i] == header->id) {
+			if (ion_wal_record_forget == header->type) {
+				wal->pending[i] = wal->pending[--wal->pending_count];
+			}
+
+			return err_ok;
+		}
+	}
+
+	if (ion_wal_record_forget == header->type) {
+		return err_ok;
+	}
+
+	grown = realloc(wal->pending, sizeof(uint32_t) * (wal->pending_count + 1));
+
+	if (NULL == grown) {
+		return err_out_of_memory;
+	}
+
+	wal->pending						= grown;
+	wal->pending[wal->pending_count++]	= header->id;
+
+	return err_ok;
+}
+
+/**
+@brief		Finds where the records still needed by the dictionary being
+			attached start: past the last forget record, written when it
+			was last synced.
+*/
+static ion_err_t
+ion_wal_find_start(
+	void				*context,
+	long				offset,
+	ion_wal_header_t	*header,
+	ion_byte_t			*body
+) {
+	ion_wal_replay_t *replay = context;
+
+	UNUSED(body);
+
+	if ((header->id == replay->id) && (ion_wal_record_forget == header->type)) {
+		replay->start = offset + sizeof(ion_wal_header_t) + header->key_size + header->value_size;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Reapplies a record, if it follows the last sync of the
+			dictionary being attached.
+*/
+static ion_err_t
+ion_wal_replay_record(
+	void				*context,
+	long				offset,
+	ion_wal_header_t	*header,
+	ion_byte_t			*body
+) {
+	ion_wal_replay_t *replay = context;
+
+	if ((header->id != replay->id) || (offset < replay->start) || (ion_wal_record_forget == header->type) || (ion_wal_record_page == header->type)) {
+		return err_ok;
+	}
+
+	return replay->apply(replay->context, (ion_wal_record_type_t) header->type, body, 0 == header->value_size ? NULL : body + header->key_size);
+}
+
+/**
+@brief		Copies a record of a dictionary that keeps its records to the log
+			that replaces the one being checkpointed, if it follows the last
+			forget record of that dictionary.
+*/
+static ion_err_t
+ion_wal_carry_record(
+	void				*context,
+	long				offset,
+	ion_wal_header_t	*header,
+	ion_byte_t			*body
+) {
+	ion_wal_carry_t *carry	= context;
+	long			size	= (long) header->key_size + header->value_size;
+	int				i;
+
+	for (i = 0; i < carry->count && carry->ids[i] != header->id; i++) {}
+
+	/* pages written back before the last forget record are no longer needed */
+	if ((i == carry->count) || (ion_wal_record_page == header->type)) {
+		return err_ok;
+	}
+
+	if (ion_wal_record_forget == header->type) {
+		if (NULL == carry->file) {
+			carry->starts[i] = offset + sizeof(ion_wal_header_t) + size;
+		}
+
+		return err_ok;
+	}
+
+	if ((NULL == carry->file) || (offset < carry->starts[i])) {
+		return err_ok;
+	}
+
+	if ((1 != fwrite(header, sizeof(ion_wal_header_t), 1, carry->file)) || ((0 != size) && (1 != fwrite(body, size, 1, carry->file)))) {
+		return err_file_write_error;
+	}
+
+	carry->bytes += sizeof(ion_wal_header_t) + size;
+
+	return err_ok;
+}
+
+/**
+@brief		Syncs and closes the file a repair writes pages to.
+*/
+static ion_err_t
+ion_wal_repair_close(
+	ion_wal_repair_t *repair
+) {
+	ion_err_t error = err_ok;
+
+	if ((-1 != repair->fd) && ((0 != fsync(repair->fd)) || (0 != close(repair->fd)))) {
+		error = err_file_write_error;
+	}
+
+	free(repair->name);
+	repair->name	= NULL;
+	repair->fd		= -1;
+
+	return error;
+}
+
+/**
+@brief		Finds the last forget record of each dictionary, then writes the
+			pages logged before it to their files again.
+*/
+static ion_err_t
+ion_wal_repair_record(
+	void				*context,
+	long				offset,
+	ion_wal_header_t	*header,
+	ion_byte_t			*body
+) {
+	ion_wal_repair_t	*repair = context;
+	int64_t				at;
+	ion_byte_t			*page;
+	long				length;
+	ion_err_t			error;
+	void				*grown;
+	int					i;
+
+	for (i = 0; i < repair->count && repair->ids[i] != header->id; i++) {}
+
+	if (!repair->writing) {
+		if (ion_wal_record_forget != header->type) {
+			return err_ok;
+		}
+
+		if (i == repair->count) {
+			if (NULL == (grown = realloc(repair->ids, sizeof(uint32_t) * (i + 1)))) {
+				return err_out_of_memory;
+			}
+
+			repair->ids = grown;
+
+			if (NULL == (grown = realloc(repair->starts, sizeof(long) * (i + 1)))) {
+				return err_out_of_memory;
+			}
+
+			repair->starts = grown;
+
+			if (NULL == (grown = realloc(repair->ends, sizeof(long) * (i + 1)))) {
+				return err_out_of_memory;
+			}
+
+			repair->ends	= grown;
+			repair->ids[i]	= header->id;
+			repair->count++;
+		}
+
+		repair->starts[i]	= -1;
+		repair->ends[i]		= offset;
+
+		if (sizeof(at) == header->value_size) {
+			memcpy(&at, body + header->key_size, sizeof(at));
+			repair->starts[i] = (long) at;
+		}
+
+		return err_ok;
+	}
+
+	if ((ion_wal_record_page != header->type) || (i == repair->count) || (offset < repair->starts[i]) || (offset >= repair->ends[i]) || (header->value_size < sizeof(at))) {
+		return err_ok;
+	}
+
+	if ((NULL == repair->name) || (strlen(repair->name) != header->key_size) || (0 != memcmp(repair->name, body, header->key_size))) {
+		if (err_ok != (error = ion_wal_repair_close(repair))) {
+			return error;
+		}
+
+		if (NULL == (repair->name = malloc(header->key_size + 1))) {
+			return err_out_of_memory;
+		}
+
+		memcpy(repair->name, body, header->key_size);
+		repair->name[header->key_size]	= '\0';
+		repair->fd						= open(repair->name, O_WRONLY);
+
+		/* a file deleted since needs no repair */
+		if ((-1 == repair->fd) && (ENOENT != errno)) {
+			return err_file_open_error;
+		}
+	}
+
+	if (-1 == repair->fd) {
+		return err_ok;
+	}
+
+	memcpy(&at, body + header->key_size, sizeof(at));
+	page	= body + header->key_size + sizeof(at);
+	length	= header->value_size - sizeof(at);
+
+	if (pwrite(repair->fd, page, length, (off_t) at) != length) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Writes the files a crash may have left part way through a write
+			back from the pages logged for it.
+@details	The pages of a write back are logged before the forget record
+			that marks it, so the pages of the last one of each dictionary
+			are written again. Until its next forget record its files change
+			only by being written back, so writing them again is harmless.
+@param		file
+				The log.
+@return		The status of repairing the files.
+*/
+static ion_err_t
+ion_wal_repair(
+	FILE *file
+) {
+	ion_wal_repair_t	repair;
+	long				end;
+	ion_err_t			error;
+
+	memset(&repair, 0, sizeof(repair));
+	repair.fd	= -1;
+	error		= ion_wal_read(file, ion_wal_repair_record, &repair, &end);
+
+	if ((err_ok == error) && (0 != repair.count)) {
+		repair.writing	= boolean_true;
+		error			= ion_wal_read(file, ion_wal_repair_record, &repair, &end);
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_repair_close(&repair);
+	}
+	else {
+		ion_wal_repair_close(&repair);
+	}
+
+	free(repair.ids);
+	free(repair.starts);
+	free(repair.ends);
+
+	return error;
+}
+
+/**
+@brief		Flushes the log and syncs it to storage.
+*/
+static ion_err_t
+ion_wal_sync_file(
+	FILE *file
+) {
+	if ((0 != fflush(file)) || (0 != fsync(fileno(file)))) {
+		return err_file_write_error;
+	}
+
+	return err_ok;
+}
+
+/**
+@brief		Replaces a log being checkpointed with one holding only the
+			records of some dictionaries: those not attached yet, and those
+			the checkpoint could not sync.
+@details	The new log is written and synced beside the old one, then
+			renamed over it, so a crash leaves one or the other whole.
+@param		wal
+				The log.
+@param		ids
+				The dictionaries whose records are kept.
+@param		count
+				The entries in @p ids.
+@return		The status of replacing the log.
+*/
+static ion_err_t
+ion_wal_carry(
+	ion_wal_t	*wal,
+	uint32_t	*ids,
+	int			count
+) {
+	ion_wal_carry_t carry;
+	char			*name;
+	long			end;
+	ion_err_t		error = err_ok;
+
+	name			= malloc(strlen(wal->name) + sizeof(ION_WAL_CARRY_SUFFIX));
+	carry.starts	= calloc(count, sizeof(long));
+	carry.ids		= ids;
+	carry.count		= count;
+	carry.file		= NULL;
+	carry.bytes		= 0;
+
+	if ((NULL == name) || (NULL == carry.starts)) {
+		free(name);
+		free(carry.starts);
+		return err_out_of_memory;
+	}
+
+	strcpy(name, wal->name);
+	strcat(name, ION_WAL_CARRY_SUFFIX);
+
+	if (0 != fflush(wal->file)) {
+		error = err_file_write_error;
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_read(wal->file, ion_wal_carry_record, &carry, &end);
+	}
+
+	if (err_ok == error) {
+		remove(name);
+		carry.file = fopen(name, "a+b");
+
+		if (NULL == carry.file) {
+			error = err_file_open_error;
+		}
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_read(wal->file, ion_wal_carry_record, &carry, &end);
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_sync_file(carry.file);
+	}
+
+	if ((err_ok == error) && (0 != rename(name, wal->name))) {
+		error = err_file_write_error;
+	}
+
+	if (err_ok == error) {
+		fclose(wal->file);
+		wal->file = carry.file;
+	}
+	else {
+		if (NULL != carry.file) {
+			fclose(carry.file);
+			remove(name);
+		}
+
+		/* appends follow the reads */
+		fseek(wal->file, 0, SEEK_END);
+	}
+
+	wal->carried = carry.bytes;
+	free(name);
+	free(carry.starts);
+
+	return error;
+}
+
+/**
+@brief		Waits, with the mutex held, until no checkpoint is running.
+*/
+static void
+ion_wal_wait_checkpoint(
+	ion_wal_t *wal
+) {
+	while (wal->checkpointing) {
+		pthread_cond_wait(&wal->changed, &wal->mutex);
+	}
+}
+
+ion_err_t
+ion_wal_open(
+	char		*name,
+	long		checkpoint_bytes,
+	ion_wal_t	**wal
+) {
+	ion_wal_t	*log;
+	long		end;
+	ion_err_t	error;
+
+	log = calloc(1, sizeof(ion_wal_t));
+
+	if (NULL == log) {
+		return err_out_of_memory;
+	}
+
+	log->name = malloc(strlen(name) + 1);
+
+	if (NULL == log->name) {
+		free(log);
+		return err_out_of_memory;
+	}
+
+	strcpy(log->name, name);
+
+	/* appends always go to the end, wherever a read left the position */
+	log->file = fopen(name, "a+b");
+
+	if (NULL == log->file) {
+		free(log->name);
+		free(log);
+		return err_file_open_error;
+	}
+
+	error = ion_wal_repair(log->file);
+
+	if (err_ok == error) {
+		error = ion_wal_read(log->file, ion_wal_note_pending, log, &end);
+	}
+
+	/* drop a record torn by a crash, so that new ones follow the intact ones */
+	if ((err_ok == error) && ((0 != fseek(log->file, 0, SEEK_END)) || ((ftell(log->file) != end) && ((0 != fflush(log->file)) || (0 != ftruncate(fileno(log->file), end)))))) {
+		error = err_file_write_error;
+	}
+
+	if ((err_ok != error) || (0 != pthread_mutex_init(&log->mutex, NULL))) {
+		fclose(log->file);
+		free(log->pending);
+		free(log->name);
+		free(log);
+		return err_ok == error ? err_uninitialized : error;
+	}
+
+	if (0 != pthread_cond_init(&log->changed, NULL)) {
+		pthread_mutex_destroy(&log->mutex);
+		fclose(log->file);
+		free(log->pending);
+		free(log->name);
+		free(log);
+		return err_uninitialized;
+	}
+
+	log->bytes				= end;
+	log->checkpoint_bytes	= checkpoint_bytes;
+	*wal					= log;
+
+	return err_ok;
+}
+
+ion_err_t
+ion_wal_close(
+	ion_wal_t *wal
+) {
+	ion_wal_participant_t	*participant;
+	ion_err_t				error = err_ok;
+
+	if (NULL == wal->participants) {
+		error = ion_wal_checkpoint(wal);
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_sync_file(wal->file);
+	}
+
+	if (0 != fclose(wal->file)) {
+		error = err_file_close_error;
+	}
+
+	while (NULL != (participant = wal->participants)) {
+		wal->participants = participant->next;
+		free(participant);
+	}
+
+	pthread_cond_destroy(&wal->changed);
+	pthread_mutex_destroy(&wal->mutex);
+	free(wal->pending);
+	free(wal->name);
+	free(wal);
+
+	return error;
+}
+
+ion_err_t
+ion_wal_attach(
+	ion_wal_t		*wal,
+	uint32_t		id,
+	ion_wal_apply_t apply,
+	ion_wal_sync_t	sync,
+	void			*context
+) {
+	ion_wal_participant_t	*participant;
+	ion_wal_replay_t		replay;
+	FILE					*file;
+	long					end;
+	ion_err_t				error;
+	int						i;
+
+	pthread_mutex_lock(&wal->mutex);
+
+	for (participant = wal->participants; NULL != participant; participant = participant->next) {
+		if (participant->id == id) {
+			pthread_mutex_unlock(&wal->mutex);
+			return err_duplicate_dictionary_error;
+		}
+	}
+
+	for (i = 0; i < wal->pending_count && wal->pending[i] != id; i++) {}
+
+	pthread_mutex_unlock(&wal->mutex);
+
+	/* a pending dictionary's records are all on disk, and checkpoints copy them to the */
+	/* log that replaces this one until it is attached, so they are read unlocked */
+	if (i < wal->pending_count) {
+		file = fopen(wal->name, "rb");
+
+		if (NULL == file) {
+			return err_file_open_error;
+		}
+
+		replay.id		= id;
+		replay.apply	= apply;
+		replay.context	= context;
+		replay.start	= 0;
+		error			= ion_wal_read(file, ion_wal_find_start, &replay, &end);
+
+		if (err_ok == error) {
+			error = ion_wal_read(file, ion_wal_replay_record, &replay, &end);
+		}
+
+		fclose(file);
+
+		if (err_ok != error) {
+			return error;
+		}
+	}
+
+	participant = malloc(sizeof(ion_wal_participant_t));
+
+	if (NULL == participant) {
+		return err_out_of_memory;
+	}
+
+	participant->id			= id;
+	participant->sync		= sync;
+	participant->context	= context;
+
+	pthread_mutex_lock(&wal->mutex);
+	ion_wal_wait_checkpoint(wal);
+
+	for (i = 0; i < wal->pending_count; i++) {
+		if (wal->pending[i] == id) {
+			wal->pending[i] = wal->pending[--wal->pending_count];
+			break;
+		}
+	}
+
+	participant->next	= wal->participants;
+	wal->participants	= participant;
+	pthread_mutex_unlock(&wal->mutex);
+
+	return err_ok;
+}
+
+ion_err_t
+ion_wal_detach(
+	ion_wal_t	*wal,
+	uint32_t	id
+) {
+	ion_wal_participant_t	**link;
+	ion_wal_participant_t	*participant;
+	ion_wal_lsn_t			lsn;
+	ion_err_t				error;
+
+	ion_wal_begin(wal);
+	error = ion_wal_append(wal, ion_wal_record_forget, id, NULL, 0, NULL, 0, &lsn);
+	ion_wal_end(wal);
+
+	if (err_ok == error) {
+		error = ion_wal_commit(wal, lsn);
+	}
+
+	pthread_mutex_lock(&wal->mutex);
+	ion_wal_wait_checkpoint(wal);
+
+	for (link = &wal->participants; NULL != *link; link = &(*link)->next) {
+		if ((*link)->id == id) {
+			participant = *link;
+			*link		= participant->next;
+			free(participant);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&wal->mutex);
+
+	return error;
+}
+
+/**
+@brief		Appends a page held by a file being written back to the log.
+*/
+static ion_err_t
+ion_wal_log_page(
+	void				*context,
+	char				*name,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes,
+	ion_byte_t			*bytes
+) {
+	ion_wal_page_log_t	*log	= context;
+	int64_t				at		= offset;
+	ion_wal_lsn_t		lsn;
+
+	memcpy(log->value, &at, sizeof(at));
+	memcpy(log->value + sizeof(at), bytes, num_bytes);
+
+	return ion_wal_append(log->wal, ion_wal_record_page, log->id, (ion_byte_t *) name, (int) strlen(name), log->value, (int) (sizeof(at) + num_bytes), &lsn);
+}
+
+ion_err_t
+ion_wal_write_back(
+	ion_wal_t				*wal,
+	uint32_t				id,
+	ion_file_writeback_t	*writeback
+) {
+	ion_wal_page_log_t	log;
+	ion_wal_lsn_t		lsn;
+	int64_t				start;
+	long				bytes;
+	ion_err_t			error;
+
+	log.wal		= wal;
+	log.id		= id;
+	log.value	= malloc(sizeof(start) + ION_FILE_PAGE_SIZE);
+
+	if (NULL == log.value) {
+		return err_out_of_memory;
+	}
+
+	pthread_mutex_lock(&wal->mutex);
+	start = wal->bytes;
+	pthread_mutex_unlock(&wal->mutex);
+
+	error = ion_file_visit_held(writeback, ion_wal_log_page, &log);
+
+	if (err_ok == error) {
+		pthread_mutex_lock(&wal->mutex);
+		bytes = wal->bytes;
+		pthread_mutex_unlock(&wal->mutex);
+
+		/* the forget record says where its pages start, if any were logged */
+		error = ion_wal_append(wal, ion_wal_record_forget, id, NULL, 0, bytes == start ? NULL : (ion_byte_t *) &start, sizeof(start), &lsn);
+	}
+
+	free(log.value);
+
+	/* once the mark is synced the pages can be written again after a crash */
+	if (err_ok == error) {
+		error = ion_wal_sync_file(wal->file);
+	}
+
+	if (err_ok == error) {
+		error = ion_file_write_back(writeback);
+	}
+
+	return error;
+}
+
+void
+ion_wal_begin(
+	ion_wal_t *wal
+) {
+	pthread_mutex_lock(&wal->mutex);
+	ion_wal_wait_checkpoint(wal);
+	wal->active++;
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+ion_err_t
+ion_wal_append(
+	ion_wal_t				*wal,
+	ion_wal_record_type_t	type,
+	uint32_t				id,
+	ion_byte_t				*key,
+	int						key_size,
+	ion_byte_t				*value,
+	int						value_size,
+	ion_wal_lsn_t			*lsn
+) {
+	ion_wal_header_t	header;
+	ion_byte_t			*body;
+	long				size;
+	ion_err_t			error = err_ok;
+
+	if (NULL == value) {
+		value_size = 0;
+	}
+
+	size = (long) key_size + value_size;
+	body = malloc(size + 1);
+
+	if (NULL == body) {
+		return err_out_of_memory;
+	}
+
+	if (0 != key_size) {
+		memcpy(body, key, key_size);
+	}
+
+	if (0 != value_size) {
+		memcpy(body + key_size, value, value_size);
+	}
+
+	header.type			= type;
+	header.id			= id;
+	header.key_size		= key_size;
+	header.value_size	= value_size;
+	header.checksum		= ion_wal_checksum(&header, body);
+
+	pthread_mutex_lock(&wal->mutex);
+
+	if ((1 != fwrite(&header, sizeof(header), 1, wal->file)) || ((0 != size) && (1 != fwrite(body, size, 1, wal->file)))) {
+		error = err_file_write_error;
+	}
+	else {
+		wal->bytes	+= sizeof(header) + size;
+		*lsn		= ++wal->appended;
+	}
+
+	pthread_mutex_unlock(&wal->mutex);
+	free(body);
+
+	return error;
+}
+
+void
+ion_wal_end(
+	ion_wal_t *wal
+) {
+	pthread_mutex_lock(&wal->mutex);
+
+	if (0 == --wal->active) {
+		pthread_cond_broadcast(&wal->changed);
+	}
+
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+ion_err_t
+ion_wal_commit(
+	ion_wal_t		*wal,
+	ion_wal_lsn_t	lsn
+) {
+	ion_wal_lsn_t	target;
+	ion_boolean_t	full;
+	ion_err_t		error = err_ok;
+
+	pthread_mutex_lock(&wal->mutex);
+	wal->stats.commits++;
+
+	while (wal->durable < lsn) {
+		if (wal->syncing) {
+			pthread_cond_wait(&wal->changed, &wal->mutex);
+			continue;
+		}
+
+		/* lead a sync covering every record appended so far */
+		wal->syncing	= boolean_true;
+		target			= wal->appended;
+		pthread_mutex_unlock(&wal->mutex);
+
+		error			= ion_wal_sync_file(wal->file);
+
+		pthread_mutex_lock(&wal->mutex);
+		wal->syncing	= boolean_false;
+		wal->stats.syncs++;
+
+		if ((err_ok == error) && (target > wal->durable)) {
+			wal->durable = target;
+		}
+
+		pthread_cond_broadcast(&wal->changed);
+
+		if (err_ok != error) {
+			break;
+		}
+	}
+
+	full = (0 != wal->checkpoint_bytes) && (wal->bytes - wal->carried >= wal->checkpoint_bytes) && !wal->checkpointing;
+	pthread_mutex_unlock(&wal->mutex);
+
+	if ((err_ok == error) && full) {
+		error = ion_wal_checkpoint(wal);
+	}
+
+	return error;
+}
+
+ion_err_t
+ion_wal_checkpoint(
+	ion_wal_t *wal
+) {
+	ion_wal_participant_t	*participant;
+	uint32_t				*kept;
+	int						kept_count;
+	ion_err_t				error = err_ok;
+
+	pthread_mutex_lock(&wal->mutex);
+
+	if (wal->checkpointing) {
+		/* whoever got here first is doing the work */
+		ion_wal_wait_checkpoint(wal);
+		pthread_mutex_unlock(&wal->mutex);
+		return err_ok;
+	}
+
+	wal->checkpointing = boolean_true;
+
+	/* the log may be replaced, so no commit may be syncing it */
+	while ((0 != wal->active) || wal->syncing) {
+		pthread_cond_wait(&wal->changed, &wal->mutex);
+	}
+
+	wal->syncing = boolean_true;
+	pthread_mutex_unlock(&wal->mutex);
+
+	/* the pending dictionaries keep their records, and so may some attached ones */
+	for (kept_count = 0, participant = wal->participants; NULL != participant; participant = participant->next) {
+		kept_count++;
+	}
+
+	kept = malloc(sizeof(uint32_t) * (wal->pending_count + kept_count + 1));
+
+	if (NULL == kept) {
+		error = err_out_of_memory;
+	}
+	else {
+		for (kept_count = 0; kept_count < wal->pending_count; kept_count++) {
+			kept[kept_count] = wal->pending[kept_count];
+		}
+	}
+
+	/* with no change in progress, the dictionaries hold every record; each is written */
+	/* back through the log, so a crash before it is emptied replays only what follows */
+	for (participant = wal->participants; NULL != participant && err_ok == error; participant = participant->next) {
+		error = participant->sync(participant->context);
+
+		if (err_cursor_open == error) {
+			/* a reader holds the dictionary, and may be waiting for this checkpoint */
+			kept[kept_count++]	= participant->id;
+			error				= err_ok;
+			continue;
+		}
+
+	}
+
+	if ((err_ok == error) && (0 != kept_count)) {
+		error = ion_wal_carry(wal, kept, kept_count);
+	}
+	else if ((err_ok == error) && ((0 != fflush(wal->file)) || (0 != ftruncate(fileno(wal->file), 0)) || (0 != fsync(fileno(wal->file))))) {
+		error = err_file_write_error;
+	}
+	else if (err_ok == error) {
+		wal->carried = 0;
+	}
+
+	pthread_mutex_lock(&wal->mutex);
+
+	if (err_ok == error) {
+		wal->bytes		= wal->carried;
+		wal->durable	= wal->appended;
+		wal->stats.checkpoints++;
+	}
+
+	wal->syncing		= boolean_false;
+	wal->checkpointing	= boolean_false;
+	free(kept);
+	pthread_cond_broadcast(&wal->changed);
+	pthread_mutex_unlock(&wal->mutex);
+
+	return error;
+}
+
+void
+ion_wal_get_stats(
+	ion_wal_t		*wal,
+	ion_wal_stats_t *stats
+) {
+	pthread_mutex_lock(&wal->mutex);
+	*stats = wal->stats;
+	pthread_mutex_unlock(&wal->mutex);
+}
+
+#else /* Clause ARDUINO */
+
+ion_err_t
+ion_wal_open(
+	char		*name,
+	long		checkpoint_bytes,
+	ion_wal_t	**wal
+) {
+	UNUSED(name);
+	UNUSED(checkpoint_bytes);
+	UNUSED(wal);
+	return err_not_implemented;
+}
+
+#endif /* Clause ARDUINO */
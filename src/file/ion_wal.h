@@ -0,0 +1,326 @@
+/******************************************************************************/
+/**
+@file		ion_wal.h
+@author		IonDB Project Contributors
+@brief		A write-ahead log of dictionary changes, with group commit.
+@copyright	Copyright 2017
+			The University of British Columbia,
+			IonDB Project Contributors (see AUTHORS.md)
+@par Redistribution and use in source and binary forms, with or without
+	modification, are permitted provided that the following conditions are met:
+
+@par 1.Redistributions of source code must retain the above copyright notice,
+	this list of conditions and the following disclaimer.
+
+@par 2.Redistributions in binary form must reproduce the above copyright notice,
+	this list of conditions and the following disclaimer in the documentation
+	and/or other materials provided with the distribution.
+
+@par 3.Neither the name of the copyright holder nor the names of its contributors
+	may be used to endorse or promote products derived from this software without
+	specific prior written permission.
+
+@par THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+	AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+	IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+	ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+	LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+	CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+	SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+	INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+	CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+	ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+	POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#if !defined(ION_WAL_H_)
+#define ION_WAL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "../key_value/kv_system.h"
+#include "ion_file.h"
+
+/**
+@brief		How large the log may grow, in bytes, before a commit checkpoints
+			it, unless another limit is given to @ref ion_wal_open.
+*/
+#if !defined(ION_WAL_CHECKPOINT_BYTES)
+#define ION_WAL_CHECKPOINT_BYTES (4L * 1024 * 1024)
+#endif
+
+/**
+@brief		The changes a log record can describe.
+*/
+typedef enum {
+	ion_wal_record_insert = 1,	/**< A record was inserted. */
+	ion_wal_record_update,		/**< The values of a key were replaced. */
+	ion_wal_record_delete,		/**< The values of a key were deleted. */
+	ion_wal_record_forget,		/**< The records before are no longer needed,
+									 as the dictionary was written back. */
+	ion_wal_record_page			/**< A page of a file, to be written to it
+									 if it was being written back. */
+} ion_wal_record_type_t;
+
+/**
+@brief		The sequence number of a log record, counting from 1 since the
+			log was opened.
+*/
+typedef uint64_t ion_wal_lsn_t;
+
+/**
+@brief		An open log, shared by every dictionary attached to it.
+*/
+typedef struct wal ion_wal_t;
+
+/**
+@brief		Reapplies a logged change to a dictionary being attached.
+@details	The dictionary's files must hold it as it was when it was last
+			synced, before the change was first made: the changes logged
+			since are applied again, in the order they were made.
+*/
+typedef ion_err_t (*ion_wal_apply_t)(
+	void *,
+	ion_wal_record_type_t,
+	ion_byte_t *,
+	ion_byte_t *
+);
+
+/**
+@brief		Writes a dictionary's changes through to storage, for a
+			checkpoint, with @ref ion_wal_write_back.
+@details	Returns err_cursor_open, without waiting, if the dictionary
+			can't be synced while a reader holds it; it keeps its records
+			until a later checkpoint.
+*/
+typedef ion_err_t (*ion_wal_sync_t)(
+	void *
+);
+
+/**
+@brief		Counters describing how a log was used.
+*/
+typedef struct {
+	unsigned long	commits;		/**< Changes committed. */
+	unsigned long	syncs;			/**< Times the log was synced; each covers
+										 every change appended before it. */
+	unsigned long	checkpoints;	/**< Times the log was checkpointed. */
+} ion_wal_stats_t;
+
+/**
+@brief		Opens a log, creating it if needed.
+@details	A record left incomplete at the end of the log, by a crash while
+			it was appended, is cut off. Files a crash may have left part
+			way through a write back are repaired from the pages logged for
+			it, so the log must be opened before the dictionaries it
+			recovers. The records of dictionaries that are not attached
+			again are kept by checkpoints until they are. Not available on
+			Arduino.
+@param		name
+				The name of the log file.
+@param		checkpoint_bytes
+				How large the log may grow before it is checkpointed, or 0 to
+				only checkpoint when asked to.
+@param		wal
+				Set to the open log.
+@return		The status of opening the log.
+*/
+ion_err_t
+ion_wal_open(
+	char		*name,
+	long		checkpoint_bytes,
+	ion_wal_t	**wal
+);
+
+/**
+@brief		Syncs and closes a log.
+@details	If no dictionary is attached, the log is checkpointed first,
+			which leaves only the records of dictionaries never attached
+			again. Any dictionary still attached keeps its records for the
+			next open.
+@param		wal
+				The log to close.
+@return		The status of closing the log.
+*/
+ion_err_t
+ion_wal_close(
+	ion_wal_t *wal
+);
+
+/**
+@brief		Replays the records of a dictionary, then logs its changes.
+@param		wal
+				The log.
+@param		id
+				The id of the dictionary, which no other dictionary attached
+				to the log may share.
+@param		apply
+				Reapplies a record found in the log.
+@param		sync
+				Writes the dictionary through to storage at a checkpoint.
+@param		context
+				Passed to @p apply and @p sync.
+@return		The status of replaying the records.
+*/
+ion_err_t
+ion_wal_attach(
+	ion_wal_t		*wal,
+	uint32_t		id,
+	ion_wal_apply_t apply,
+	ion_wal_sync_t	sync,
+	void			*context
+);
+
+/**
+@brief		Stops logging the changes of a dictionary.
+@details	The dictionary must have been written back, or deleted: its
+			records are marked as no longer needed, so they are neither
+			replayed, nor kept from a checkpoint, nor used to repair its
+			files.
+@param		wal
+				The log.
+@param		id
+				The id the dictionary was attached with.
+@return		The status of detaching the dictionary.
+*/
+ion_err_t
+ion_wal_detach(
+	ion_wal_t	*wal,
+	uint32_t	id
+);
+
+/**
+@brief		Writes the files holding a dictionary's writes back to them,
+			through the log.
+@details	The pages held are appended to the log, followed by a forget
+			record, which is synced before the files are written. A crash
+			before then leaves the files as they were, and the records
+			before the mark replay the changes; a crash after leaves the
+			pages for @ref ion_wal_open to write again. Called by the sync
+			passed to @ref ion_wal_attach, or between @ref ion_wal_begin
+			and @ref ion_wal_end, with the dictionary locked.
+@param		wal
+				The log.
+@param		id
+				The id the dictionary is attached with.
+@param		writeback
+				The files holding the dictionary's writes.
+@return		The status of writing the files back.
+*/
+ion_err_t
+ion_wal_write_back(
+	ion_wal_t				*wal,
+	uint32_t				id,
+	ion_file_writeback_t	*writeback
+);
+
+/**
+@brief		Starts a change, holding off checkpoints until
+			@ref ion_wal_end.
+@param		wal
+				The log.
+*/
+void
+ion_wal_begin(
+	ion_wal_t *wal
+);
+
+/**
+@brief		Appends a record to the log, without syncing it.
+@param		wal
+				The log.
+@param		type
+				The change made.
+@param		id
+				The id the changed dictionary is attached with.
+@param		key
+				The key changed.
+@param		key_size
+				The size of @p key.
+@param		value
+				The value written, or NULL for a delete.
+@param		value_size
+				The size of @p value.
+@param		lsn
+				Set to the sequence number of the record.
+@return		The status of appending the record.
+*/
+ion_err_t
+ion_wal_append(
+	ion_wal_t				*wal,
+	ion_wal_record_type_t	type,
+	uint32_t				id,
+	ion_byte_t				*key,
+	int						key_size,
+	ion_byte_t				*value,
+	int						value_size,
+	ion_wal_lsn_t			*lsn
+);
+
+/**
+@brief		Ends a change started with @ref ion_wal_begin.
+@param		wal
+				The log.
+*/
+void
+ion_wal_end(
+	ion_wal_t *wal
+);
+
+/**
+@brief		Waits until a record is synced to storage.
+@details	Threads committing at the same time share a sync: one syncs
+			every record appended so far while the rest wait for it. A
+			commit that grows the log past its limit, not counting the
+			records the last checkpoint kept, checkpoints it.
+@param		wal
+				The log.
+@param		lsn
+				The sequence number of the record.
+@return		The status of syncing the log.
+*/
+ion_err_t
+ion_wal_commit(
+	ion_wal_t		*wal,
+	ion_wal_lsn_t	lsn
+);
+
+/**
+@brief		Syncs every attached dictionary and empties the log.
+@details	Waits for changes in progress to end. Each dictionary is written
+			back with @ref ion_wal_write_back before the next starts, so a
+			crash part way through replays each only from its own mark, and
+			repairs the files it was writing. The records of dictionaries not attached since the log was
+			opened are kept, as are those of dictionaries a reader holds:
+			they are copied to a new log, which replaces this one once it
+			is synced.
+@param		wal
+				The log.
+@return		The status of the checkpoint.
+*/
+ion_err_t
+ion_wal_checkpoint(
+	ion_wal_t *wal
+);
+
+/**
+@brief		Reads the counters of a log.
+@param		wal
+				The log.
+@param		stats
+				Set to the counters.
+*/
+void
+ion_wal_get_stats(
+	ion_wal_t		*wal,
+	ion_wal_stats_t *stats
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ION_WAL_H_ */
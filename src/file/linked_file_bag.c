@@ -122,10 +122,18 @@ lfb_update_next(
 	ion_lfb_t			*bag,
 	ion_file_offset_t	offset,
 	ion_file_offset_t	next
+) {
+	return ion_fwrite_at(bag->file_handle, offset, sizeof(ion_file_offset_t), (ion_byte_t *) &(next));
+}
+
+ion_err_t
+lfb_delete(
+	ion_lfb_t			*bag,
+	ion_file_offset_t	offset
 ) {
 	ion_err_t error;
 
-	error = ion_fwrite_at(bag->file_handle, offset, sizeof(ion_file_offset_t), (ion_byte_t *) &(next));
+	error = lfb_update_next(bag, offset, bag->next_empty);
 
 	if (err_ok == error) {
 		bag->next_empty = offset;
@@ -134,14 +142,6 @@ lfb_update_next(
 	return error;
 }
 
-ion_err_t
-lfb_delete(
-	ion_lfb_t			*bag,
-	ion_file_offset_t	offset
-) {
-	return lfb_update_next(bag, offset, bag->next_empty);
-}
-
 ion_err_t
 lfb_delete_all(
 	ion_lfb_t			*bag,
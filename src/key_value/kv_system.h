@@ -147,6 +147,8 @@ typedef enum ION_DICTIONARY_TYPE {
 	dictionary_type_skip_list_t,
 	/**> Dictionary type is a Linear Hash implementation. */
 	dictionary_type_linear_hash_t,
+	/**> Dictionary type is a Sharded implementation over other types. */
+	dictionary_type_sharded_t,
 	/**> Dictionary type is not initialized. */
 	dictionary_type_error_t
 } ion_dictionary_type_t;
@@ -215,7 +217,10 @@ enum ION_ERROR {
 	err_out_of_bounds,
 	/**> An error code describing the situation where an operation would
 		 violate the sorted precondition. */
-	err_sorted_order_violation
+	err_sorted_order_violation,
+	/**> An error code describing the situation where an operation can't
+		 run while cursors are open. */
+	err_cursor_open
 };
 
 /**
@@ -41,6 +41,10 @@
 
 #include "behaviour_dictionary.h"
 
+#if !defined(ARDUINO)
+#include <pthread.h>
+#endif
+
 /* This is used to define how complicated to pre-fill a dictionary for testing. */
 typedef enum ION_BEHAVIOUR_FILL_LEVEL {
 	ion_fill_none, ion_fill_low, ion_fill_medium, ion_fill_high, ion_fill_edge_cases
@@ -586,6 +590,484 @@ test_bhdct_get_lots(
 	bhdct_takedown(tc, &dict);
 }
 
+/**
+@brief	This function tests a batch insert of many records given out of key order.
+*/
+void
+test_bhdct_insert_batch(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_record_t				records[101];
+	int							keys[101];
+	int							values[101];
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_low);
+
+	int i;
+
+	for (i = 0; i < 101; i++) {
+		keys[i]				= (i * 37) % 101 + 200;
+		values[i]			= keys[i] * 3;
+		records[i].key		= &keys[i];
+		records[i].value	= &values[i];
+	}
+
+	ion_status_t status = dictionary_insert_batch(&dict, records, 101);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 101, status.count);
+
+	for (i = 200; i < 301; i++) {
+		bhdct_get(tc, &dict, IONIZE(i, int), IONIZE(i * 3, int), err_ok, 1);
+	}
+
+	ION_FILL_LOW_LOOP(i) {
+		bhdct_get(tc, &dict, IONIZE(i, int), ION_LOW_VALUE(i), err_ok, 1);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests retrieving many keys at once, some of which don't exist.
+*/
+void
+test_bhdct_get_many(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_key_t					keys[8];
+	ion_value_t					values[8];
+	ion_status_t				statuses[8];
+	int							key_data[8]		= { 98, 51, 4, 50, 1000, 4, 72, -3 };
+	int							value_data[8]	= { 0 };
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_medium);
+
+	for (i = 0; i < 8; i++) {
+		keys[i]		= &key_data[i];
+		values[i]	= &value_data[i];
+	}
+
+	ion_status_t status = dictionary_get_many(&dict, keys, 8, values, statuses);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, status.count);
+
+	for (i = 0; i < 8; i++) {
+		if ((50 <= key_data[i]) && (key_data[i] < 100) && (0 == key_data[i] % 2)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, statuses[i].count);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key_data[i] * 5, value_data[i]);
+		}
+		else if ((0 <= key_data[i]) && (key_data[i] < 10)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key_data[i] * 2, value_data[i]);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, statuses[i].error);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, statuses[i].count);
+		}
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/**
+@brief	This function tests retrieving records in place, without copying them out.
+*/
+void
+test_bhdct_get_ref(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_record_ref_t			ref;
+	ion_status_t				status;
+	int							key;
+	int							value;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_medium);
+
+	ION_FILL_MEDIUM_LOOP(key) {
+		status = dictionary_get_ref(&dict, IONIZE(key, int), &ref);
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(ref.key, &key, sizeof(int)));
+
+		memcpy(&value, ref.value, sizeof(int));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 5, value);
+
+		dictionary_release_ref(&ref);
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ref.value);
+	}
+
+	status = dictionary_get_ref(&dict, IONIZE(51, int), &ref);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, status.count);
+
+	bhdct_takedown(tc, &dict);
+}
+
+#if !defined(ARDUINO)
+
+#define ION_BHDCT_STRESS_THREADS	4
+#define ION_BHDCT_STRESS_KEYS		40
+#define ION_BHDCT_STRESS_ROUNDS		5
+#define ION_BHDCT_STRESS_KEY(thread, j) \
+	((thread) * 50 + (j))
+
+/* The work done by one thread of the concurrency stress test. */
+typedef struct {
+	ion_dictionary_t	*dict;
+	int					thread;
+	int					failures;
+} ion_bhdct_stress_t;
+
+/**
+@brief	Inserts, reads, updates and deletes keys owned by one thread while
+		reading keys owned by the others. Failures are counted rather than
+		asserted, since the test case may only be touched by the main thread.
+*/
+static void *
+bhdct_stress_worker(
+	void *argument
+) {
+	ion_bhdct_stress_t	*stress = argument;
+	int					round;
+	int					j;
+	int					key;
+	int					value;
+	ion_status_t		status;
+
+	for (round = 0; round < ION_BHDCT_STRESS_ROUNDS; round++) {
+		for (j = 0; j < ION_BHDCT_STRESS_KEYS; j++) {
+			key		= ION_BHDCT_STRESS_KEY(stress->thread, j);
+			value	= key * 7;
+			status	= dictionary_insert(stress->dict, &key, &value);
+
+			if (err_ok != status.error) {
+				stress->failures++;
+			}
+
+			status = dictionary_get(stress->dict, &key, &value);
+
+			if ((err_ok != status.error) || (key * 7 != value)) {
+				stress->failures++;
+			}
+
+			/* Another thread's key may or may not be there yet, but must never read back wrong. */
+			key		= ION_BHDCT_STRESS_KEY((stress->thread + 1) % ION_BHDCT_STRESS_THREADS, j);
+			status	= dictionary_get(stress->dict, &key, &value);
+
+			if ((err_ok == status.error) && (key * 7 != value) && (key * 11 != value)) {
+				stress->failures++;
+			}
+			else if ((err_ok != status.error) && (err_item_not_found != status.error)) {
+				stress->failures++;
+			}
+		}
+
+		for (j = 0; j < ION_BHDCT_STRESS_KEYS; j++) {
+			key		= ION_BHDCT_STRESS_KEY(stress->thread, j);
+			value	= key * 11;
+			status	= dictionary_update(stress->dict, &key, &value);
+
+			if (err_ok != status.error) {
+				stress->failures++;
+			}
+		}
+
+		for (j = 0; j < ION_BHDCT_STRESS_KEYS; j++) {
+			key		= ION_BHDCT_STRESS_KEY(stress->thread, j);
+			status	= dictionary_delete(stress->dict, &key);
+
+			if (err_ok != status.error) {
+				stress->failures++;
+			}
+		}
+	}
+
+	/* Leave every other key behind so the main thread can check the final state. */
+	for (j = 0; j < ION_BHDCT_STRESS_KEYS; j += 2) {
+		key		= ION_BHDCT_STRESS_KEY(stress->thread, j);
+		value	= key * 11;
+		status	= dictionary_insert(stress->dict, &key, &value);
+
+		if (err_ok != status.error) {
+			stress->failures++;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief	This function runs several threads against one dictionary in concurrent mode.
+*/
+void
+test_bhdct_concurrent_stress(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	pthread_t					threads[ION_BHDCT_STRESS_THREADS];
+	ion_bhdct_stress_t			stress[ION_BHDCT_STRESS_THREADS];
+	int							i;
+	int							j;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_concurrency(&dict));
+
+	for (i = 0; i < ION_BHDCT_STRESS_THREADS; i++) {
+		stress[i].dict		= &dict;
+		stress[i].thread	= i;
+		stress[i].failures	= 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&threads[i], NULL, bhdct_stress_worker, &stress[i]));
+	}
+
+	for (i = 0; i < ION_BHDCT_STRESS_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stress[i].failures);
+	}
+
+	for (i = 0; i < ION_BHDCT_STRESS_THREADS; i++) {
+		for (j = 0; j < ION_BHDCT_STRESS_KEYS; j++) {
+			int key = ION_BHDCT_STRESS_KEY(i, j);
+
+			if (0 == j % 2) {
+				bhdct_get(tc, &dict, &key, IONIZE(key * 11, int), err_ok, 1);
+			}
+			else {
+				bhdct_get(tc, &dict, &key, IONIZE(0, int), err_item_not_found, 0);
+			}
+		}
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+/* How many keys the concurrent scan test starts with. */
+#define ION_BHDCT_SCAN_KEYS 100
+
+/**
+@brief	Inserts, updates and deletes keys while the main thread holds a cursor.
+*/
+static void *
+bhdct_scan_writer(
+	void *argument
+) {
+	ion_bhdct_stress_t	*stress = argument;
+	int					key;
+	int					value;
+
+	for (key = ION_BHDCT_SCAN_KEYS; key < 3 * ION_BHDCT_SCAN_KEYS; key++) {
+		value = key * 3;
+
+		if (err_ok != dictionary_insert(stress->dict, &key, &value).error) {
+			stress->failures++;
+		}
+	}
+
+	for (key = 0; key < ION_BHDCT_SCAN_KEYS; key++) {
+		value = key * 5;
+
+		if (err_ok != (0 == key % 2 ? dictionary_delete(stress->dict, &key) : dictionary_update(stress->dict, &key, &value)).error) {
+			stress->failures++;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief	This function writes to a dictionary in concurrent mode while a cursor
+		is open on it, for implementations whose cursors read a snapshot.
+*/
+void
+test_bhdct_concurrent_scan(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_bhdct_stress_t			stress;
+	pthread_t					writer;
+	int							key;
+	int							value;
+	int							count;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	if (!handler.snapshot_cursors) {
+		bhdct_takedown(tc, &dict);
+		return;
+	}
+
+	for (key = 0; key < ION_BHDCT_SCAN_KEYS; key++) {
+		bhdct_insert(tc, &dict, IONIZE(key, int), IONIZE(key * 3, int), boolean_true);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_concurrency(&dict));
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dict, &predicate, &cursor));
+
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) &value;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+
+	/* The writer would block on the cursor's lock if it were held between fetches. */
+	stress.dict		= &dict;
+	stress.failures = 0;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&writer, NULL, bhdct_scan_writer, &stress));
+	pthread_join(writer, NULL);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stress.failures);
+
+	count = 1;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 3, value);
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_BHDCT_SCAN_KEYS, count);
+
+	bhdct_get(tc, &dict, IONIZE(2, int), IONIZE(0, int), err_item_not_found, 0);
+	bhdct_get(tc, &dict, IONIZE(3, int), IONIZE(15, int), err_ok, 1);
+	bhdct_get(tc, &dict, IONIZE(ION_BHDCT_SCAN_KEYS, int), IONIZE(ION_BHDCT_SCAN_KEYS * 3, int), err_ok, 1);
+
+	bhdct_takedown(tc, &dict);
+}
+
+/* How many keys the concurrent read test reads. */
+#define ION_BHDCT_READ_KEYS 100
+
+/**
+@brief	Reads every key, both copied out and by reference, then scans them all
+		with a cursor where the implementation has one, while other threads do
+		the same.
+*/
+static void *
+bhdct_read_worker(
+	void *argument
+) {
+	ion_bhdct_stress_t	*stress = argument;
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	ion_record_ref_t	ref;
+	ion_status_t		status;
+	int					round;
+	int					key;
+	int					value;
+	int					count;
+
+	for (round = 0; round < ION_BHDCT_STRESS_ROUNDS; round++) {
+		for (key = 0; key < ION_BHDCT_READ_KEYS; key++) {
+			status = dictionary_get(stress->dict, &key, &value);
+
+			if ((err_ok != status.error) || (key * 3 != value)) {
+				stress->failures++;
+			}
+
+			status = dictionary_get_ref(stress->dict, &key, &ref);
+
+			if (err_ok != status.error) {
+				stress->failures++;
+				continue;
+			}
+
+			memcpy(&value, ref.value, sizeof(int));
+			dictionary_release_ref(&ref);
+
+			if (key * 3 != value) {
+				stress->failures++;
+			}
+		}
+
+		/* Not every implementation has cursors yet. */
+		if (NULL == stress->dict->handler->find) {
+			continue;
+		}
+
+		dictionary_build_predicate(&predicate, predicate_all_records);
+
+		if (err_ok != dictionary_find(stress->dict, &predicate, &cursor)) {
+			stress->failures++;
+			continue;
+		}
+
+		record.key		= (ion_key_t) &key;
+		record.value	= (ion_value_t) &value;
+		count			= 0;
+
+		while (cs_cursor_active == cursor->next(cursor, &record)) {
+			if (key * 3 != value) {
+				stress->failures++;
+			}
+
+			count++;
+		}
+
+		cursor->destroy(&cursor);
+
+		if (ION_BHDCT_READ_KEYS != count) {
+			stress->failures++;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+@brief	This function reads a dictionary from several threads at once in
+		concurrent mode, which share its lock where the implementation allows.
+*/
+void
+test_bhdct_concurrent_reads(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dict;
+	pthread_t					threads[ION_BHDCT_STRESS_THREADS];
+	ion_bhdct_stress_t			stress[ION_BHDCT_STRESS_THREADS];
+	int							key;
+	int							i;
+
+	bhdct_setup(tc, &handler, &dict, ion_fill_none);
+
+	for (key = 0; key < ION_BHDCT_READ_KEYS; key++) {
+		bhdct_insert(tc, &dict, IONIZE(key, int), IONIZE(key * 3, int), boolean_true);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_concurrency(&dict));
+
+	for (i = 0; i < ION_BHDCT_STRESS_THREADS; i++) {
+		stress[i].dict		= &dict;
+		stress[i].thread	= i;
+		stress[i].failures	= 0;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&threads[i], NULL, bhdct_read_worker, &stress[i]));
+	}
+
+	for (i = 0; i < ION_BHDCT_STRESS_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, stress[i].failures);
+	}
+
+	bhdct_takedown(tc, &dict);
+}
+
+#endif
+
 /**
 @brief	This function tests retrieval on a string key dictionary with a whole bunch of records in it.
 */
@@ -1514,11 +1996,14 @@ bhdct_run_tests(
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_setup);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_single);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_multiple);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_insert_batch);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_single);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_in_many);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_lots);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_many);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_ref);
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_nonexist_empty);
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_get_nonexist_single);
@@ -1547,6 +2032,12 @@ bhdct_run_tests(
 
 		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_delete_then_insert);
 
+#if !defined(ARDUINO)
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_concurrent_stress);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_concurrent_scan);
+		PLANCK_UNIT_ADD_TO_SUITE(suite, test_bhdct_concurrent_reads);
+#endif
+
 		planck_unit_run_suite(suite);
 		planck_unit_destroy_suite(suite);
 	}
@@ -2430,6 +2430,72 @@ test_cpp_wrapper_all_records_all(
 	delete dict;
 }
 
+/**
+@brief	Tests an insertion and then iterates over an all records cursor with a
+		range-based for loop, crossing several batch boundaries.
+*/
+void
+test_cpp_wrapper_all_records_iterator(
+	planck_unit_test_t *tc,
+	Dictionary<int, int> *dict,
+	int random_positive_num
+) {
+	ion_boolean_t	found[random_positive_num];
+	int				records_found = 0;
+
+	for (int i = 0; i < random_positive_num; i++) {
+		cpp_wrapper_insert(tc, dict, i, i * 3, boolean_true);
+		found[i] = boolean_false;
+	}
+
+	Cursor<int, int> *cursor = dict->allRecords();
+
+	for (auto entry : *cursor) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, entry.key >= 0 && entry.key < random_positive_num);
+		PLANCK_UNIT_ASSERT_FALSE(tc, found[entry.key]);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, entry.key * 3, entry.value);
+
+		found[entry.key] = boolean_true;
+		records_found++;
+	}
+
+	PLANCK_UNIT_ASSERT_FALSE(tc, cursor->hasNext());
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, random_positive_num, records_found);
+
+	delete cursor;
+}
+
+/**
+@brief	Aggregate test to iterate over an all records cursor with a range-based
+		for loop on all dictionary implementations.
+*/
+void
+test_cpp_wrapper_all_records_iterator_all(
+	planck_unit_test_t *tc
+) {
+	Dictionary<int, int> *dict;
+
+	dict = new BppTree<int, int>(0, key_type_numeric_signed, sizeof(int), sizeof(int));
+	test_cpp_wrapper_all_records_iterator(tc, dict, 100);
+	delete dict;
+
+	dict = new SkipList<int, int>(0, key_type_numeric_signed, sizeof(int), sizeof(int), 7);
+	test_cpp_wrapper_all_records_iterator(tc, dict, 40);
+	delete dict;
+
+	dict = new FlatFile<int, int>(0, key_type_numeric_signed, sizeof(int), sizeof(int), 30);
+	test_cpp_wrapper_all_records_iterator(tc, dict, 70);
+	delete dict;
+
+	dict = new OpenAddressHash<int, int>(0, key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_iterator(tc, dict, 35);
+	delete dict;
+
+	dict = new OpenAddressFileHash<int, int>(0, key_type_numeric_signed, sizeof(int), sizeof(int), 50);
+	test_cpp_wrapper_all_records_iterator(tc, dict, 40);
+	delete dict;
+}
+
 /**
 @brief	Tests an all records cursor on an empty dictionary.
 */
@@ -2935,6 +3001,7 @@ cpp_wrapper_getsuite_3(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_range_exist_single_all);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_range_all_all);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_all);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_iterator_all);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_nonexist_empty_all);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_populated_all);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_cpp_wrapper_all_records_random_all);
@@ -153,12 +153,829 @@ run_bpptreehandler_generic_test_set_1(
 	cleanup_generic_dictionary_test(&test);
 }
 
+/**
+@brief		Streams 1000 records over 500 even keys, two records per key.
+*/
+ion_boolean_t
+bpptreehandler_bulk_stream(
+	void			*context,
+	ion_record_t	*record
+) {
+	static int	key;
+	static int	value;
+	int			*next = (int *) context;
+
+	if (*next >= 1000) {
+		return boolean_false;
+	}
+
+	key				= (*next / 2) * 2;
+	value			= *next;
+	record->key		= &key;
+	record->value	= &value;
+	(*next)++;
+
+	return boolean_true;
+}
+
+void
+test_bpptreehandler_bulk_load(
+	planck_unit_test_t *tc
+) {
+	ion_generic_test_t	test;
+	ion_status_t		status;
+	int					next;
+	int					key;
+	int					value;
+	int					i;
+
+	init_generic_dictionary_test(&test, bpptree_init, key_type_numeric_signed, sizeof(int), sizeof(int), -1);
+
+	dictionary_test_init(&test, tc);
+
+	next	= 0;
+	status	= bpptree_bulk_load(&test.dictionary, bpptreehandler_bulk_stream, &next, 90);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, status.count);
+
+	/* the last value streamed for a key is the one returned */
+	for (i = 0; i < 1000; i += 2) {
+		status = dictionary_get(&test.dictionary, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i + 1, value);
+	}
+
+	dictionary_test_equality(&test, IONIZE(500, int), tc);
+	dictionary_test_range(&test, IONIZE(100, int), IONIZE(300, int), tc);
+	dictionary_test_all_records(&test, 1000, tc);
+
+	/* the loaded tree rebalances as usual */
+	for (i = 1; i < 1000; i += 2) {
+		value	= -i;
+		status	= dictionary_insert(&test.dictionary, &i, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	for (i = 0; i < 1000; i += 4) {
+		dictionary_test_delete(&test, &i, 2, tc);
+	}
+
+	dictionary_test_all_records(&test, 1000, tc);
+
+	/* only an empty dictionary can be loaded */
+	next	= 0;
+	status	= bpptree_bulk_load(&test.dictionary, bpptreehandler_bulk_stream, &next, 90);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != status.error);
+
+	key		= 1;
+	status	= dictionary_get(&test.dictionary, &key, &value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, value);
+
+	cleanup_generic_dictionary_test(&test);
+}
+
+/**
+@brief		Writes the device name numbered @p i to a 32 byte key.
+*/
+void
+bpptreehandler_device_key(
+	char	*key,
+	int		i
+) {
+	memset(key, 0, 32);
+	sprintf(key, "device-%08d", i);
+}
+
+void
+test_bpptreehandler_prefixed(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	ion_bpp_err_t				err;
+	char						key[32];
+	char						prev[32];
+	int							count;
+	int							i;
+
+	info.iName		= "pfx.bpt";
+	info.keySize	= 32;
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_switch_compare(key_type_null_terminated_string, 32);
+	info.prefixed	= boolean_false;
+	info.valueSize	= 0;
+
+	/* a plain 256 byte node can't hold enough 32 byte keys */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrSectorSize, b_open(info, &tree));
+
+	info.prefixed = boolean_true;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 3000; i++) {
+		bpptreehandler_device_key(key, (i * 7919) % 3000);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, key, (i * 7919) % 3000));
+	}
+
+	for (i = 0; i < 3000; i += 3) {
+		bpptreehandler_device_key(key, i);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_delete(tree, key, &rec));
+	}
+
+	/* packed nodes read back whole */
+	b_close(tree);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 3000; i++) {
+		bpptreehandler_device_key(key, i);
+
+		if (0 == i % 3) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrKeyNotFound, b_get(tree, key, &rec));
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_get(tree, key, &rec));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+		}
+	}
+
+	count = 0;
+	memset(prev, 0, sizeof(prev));
+
+	for (err = b_find_first_key(tree, key, &rec); bErrOk == err; err = b_find_next_key(tree, key, &rec)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, strcmp(prev, key) < 0);
+		memcpy(prev, key, sizeof(prev));
+		count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2000, count);
+
+	b_close(tree);
+	ion_fremove(info.iName);
+}
+
+/**
+@brief		Tests that a tree is reopened with the sector size and node
+			format recorded in its header, whatever the caller asks for.
+@param		tc
+				Test case.
+*/
+void
+test_bpptreehandler_sector_size(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	int							key;
+	int							value;
+	int							i;
+
+	info.iName		= "sec.bpt";
+	info.keySize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 2 * ION_BPP_MAX_SECTOR_SIZE;
+	info.comp		= dictionary_switch_compare(key_type_numeric_signed, sizeof(int));
+	info.prefixed	= boolean_false;
+	info.valueSize	= 0;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrSectorSize, b_open(info, &tree));
+
+	info.sectorSize = 8192;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 5000; i++) {
+		key = (i * 7919) % 5000;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, &key, key));
+	}
+
+	b_close(tree);
+
+	/* the header wins over the settings given on reopen */
+	info.sectorSize = 256;
+	info.prefixed	= boolean_true;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 5000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_get(tree, &i, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+	}
+
+	key = 5000;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, &key, key));
+	b_close(tree);
+
+	/* but the key size must match */
+	info.keySize = 2 * sizeof(int);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrIO, b_open(info, &tree));
+
+	ion_fremove(info.iName);
+
+	/* through the dictionary interface */
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_create(&handler, &dictionary, 9, key_type_numeric_signed, sizeof(int), sizeof(int), 16384));
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, &i).error);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 9, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &i, &value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Runs the same random lookups over a tree.
+@return		The pool misses they caused.
+*/
+static unsigned long
+bpptreehandler_pool_lookups(
+	ion_bpp_handle_t tree
+) {
+	ion_bpp_pool_stats_t		stats;
+	ion_bpp_external_address_t	rec;
+	int							key;
+	int							i;
+
+	srand(7);
+	bpp_pool_reset_stats();
+
+	for (i = 0; i < 20000; i++) {
+		key = rand() % 20000;
+		b_get(tree, &key, &rec);
+	}
+
+	bpp_pool_get_stats(&stats);
+	return stats.misses;
+}
+
+/**
+@brief		Tests that a full scan doesn't push the nodes lookups keep
+			reading out of the shared pool.
+@param		tc
+				Test case.
+*/
+void
+test_bpptreehandler_buffer_pool(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	ion_bpp_pool_stats_t		stats;
+	ion_bpp_err_t				err;
+	unsigned long				misses;
+	int							key;
+	int							count;
+	int							i;
+
+	bpp_pool_set_budget(256 * 1024);
+
+	info.iName		= "pool.bpt";
+	info.keySize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_switch_compare(key_type_numeric_signed, sizeof(int));
+	info.prefixed	= boolean_false;
+	info.valueSize	= 0;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 20000; i++) {
+		key = (i * 7919) % 20000;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, &key, key));
+	}
+
+	bpptreehandler_pool_lookups(tree);
+	misses = bpptreehandler_pool_lookups(tree);
+
+	bpp_pool_get_stats(&stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.hits > stats.misses);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.bytes <= 256 * 1024);
+
+	/* the leaves pass through once, and must not displace the hot nodes */
+	count = 0;
+
+	for (err = b_find_first_key(tree, &key, &rec); bErrOk == err; err = b_find_next_key(tree, &key, &rec)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, count, key);
+		count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20000, count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptreehandler_pool_lookups(tree) <= misses + misses / 10);
+
+	/* closing drops the tree's nodes */
+	b_close(tree);
+	bpp_pool_get_stats(&stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == stats.bytes);
+
+	ion_fremove(info.iName);
+	bpp_pool_set_budget(ION_BPP_POOL_BYTES);
+}
+
+/**
+@brief		Tests that small values are kept in the index, leaving the value
+			file to keys with several values.
+@param		tc
+				Test case.
+*/
+void
+test_bpptreehandler_inline_values(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_status_t				status;
+	int64_t						key;
+	int64_t						value[2];
+	int64_t						lower;
+	int64_t						upper;
+	int							count;
+	int							i;
+
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 11, key_type_numeric_signed, sizeof(key), sizeof(value), -1));
+
+	for (i = 0; i < 2000; i++) {
+		key			= ((i * 7919) % 2000) * 10;
+		value[0]	= key;
+		value[1]	= key * 3;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, value).error);
+	}
+
+	/* nothing went to the value file */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_fend(((ion_bpptree_t *) dictionary.instance)->values.file_handle));
+
+	for (i = 0; i < 2000; i++) {
+		key = i * 10;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, value).error);
+		PLANCK_UNIT_ASSERT_TRUE(tc, key == value[0] && key * 3 == value[1]);
+	}
+
+	/* a second value for a key moves the first to a posting list */
+	key			= 500;
+	value[0]	= -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_fend(((ion_bpptree_t *) dictionary.instance)->values.file_handle));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < ion_fend(((ion_bpptree_t *) dictionary.instance)->postings.file_handle));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, value).error);
+	PLANCK_UNIT_ASSERT_TRUE(tc, -1 == value[0]);
+
+	key			= 600;
+	value[0]	= -2;
+	status		= dictionary_update(&dictionary, &key, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+
+	key		= 700;
+	status	= dictionary_delete(&dictionary, &key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, status.count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, dictionary_get(&dictionary, &key, value).error);
+
+	/* cursors read inline values and chains alike */
+	lower			= 400;
+	upper			= 800;
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) value;
+	count			= 0;
+	dictionary_build_predicate(&predicate, predicate_range, &lower, &upper);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		if (500 == key) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, (-1 == value[0]) || (key == value[0]));
+		}
+		else if (600 == key) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, -2 == value[0]);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_TRUE(tc, key == value[0] && key * 3 == value[1]);
+		}
+
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 41, count);
+
+	/* the layout is kept across a reopen */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 11, key_type_numeric_signed, sizeof(key), sizeof(value), -1));
+
+	for (i = 0; i < 2000; i++) {
+		key		= i * 10;
+		status	= dictionary_get(&dictionary, &key, value);
+
+		if (700 == key) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+		}
+		else {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+			PLANCK_UNIT_ASSERT_TRUE(tc, (500 == key ? -1 : 600 == key ? -2 : key) == value[0]);
+		}
+	}
+
+	key		= 500;
+	status	= dictionary_delete(&dictionary, &key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2, status.count);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Returns the size of a file, in bytes.
+*/
+static ion_file_offset_t
+bpptreehandler_file_size(
+	char *name
+) {
+	ion_file_handle_t	file = ion_fopen(name);
+	ion_file_offset_t	size = ion_fend(file);
+
+	ion_fclose(file);
+	return size;
+}
+
+/**
+@brief		Deletes and reinserts every key of a tree.
+*/
+static void
+bpptreehandler_churn(
+	planck_unit_test_t	*tc,
+	ion_bpp_handle_t	tree,
+	int					records
+) {
+	ion_bpp_external_address_t	rec;
+	int							i;
+
+	for (i = 0; i < records; i++) {
+		rec = i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_delete(tree, &i, &rec));
+	}
+
+	for (i = 0; i < records; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, &i, i));
+	}
+}
+
+/**
+@brief		Tests that nodes and values freed by deletes are reused, also
+			after a reopen, and that compaction keeps every key.
+@param		tc
+				Test case.
+*/
+void
+test_bpptreehandler_free_space(
+	planck_unit_test_t *tc
+) {
+	ion_bpp_open_t				info;
+	ion_bpp_handle_t			tree;
+	ion_bpp_external_address_t	rec;
+	ion_bpp_err_t				err;
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_file_offset_t			size;
+	char						value[64];
+	int							key;
+	int							count;
+	int							i;
+
+	info.iName		= "free.bpt";
+	info.keySize	= sizeof(int);
+	info.dupKeys	= boolean_false;
+	info.sectorSize = 256;
+	info.comp		= dictionary_switch_compare(key_type_numeric_signed, sizeof(int));
+	info.prefixed	= boolean_false;
+	info.valueSize	= 0;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 5000; i++) {
+		key = (i * 7919) % 5000;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, &key, key));
+	}
+
+	bpptreehandler_churn(tc, tree, 5000);
+	b_close(tree);
+	size = bpptreehandler_file_size(info.iName);
+
+	/* the free list survives a clean close */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+	bpptreehandler_churn(tc, tree, 5000);
+	bpptreehandler_churn(tc, tree, 5000);
+	b_close(tree);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptreehandler_file_size(info.iName) == size);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 5000; i += 2) {
+		rec = i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_delete(tree, &i, &rec));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_compact(tree));
+
+	count = 0;
+
+	for (err = b_find_first_key(tree, &key, &rec); bErrOk == err; err = b_find_next_key(tree, &key, &rec)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * count + 1, key);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, rec);
+		count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2500, count);
+
+	/* the compacted tree takes updates, and reopens */
+	for (i = 0; i < 5000; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_insert(tree, &i, i));
+	}
+
+	b_close(tree);
+	PLANCK_UNIT_ASSERT_TRUE(tc, bpptreehandler_file_size(info.iName) == size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_open(info, &tree));
+
+	for (i = 0; i < 5000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, bErrOk, b_get(tree, &i, &rec));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i, rec);
+	}
+
+	b_close(tree);
+	ion_fremove(info.iName);
+
+	/* values too large to keep inline reuse the slots of deleted ones */
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 12, key_type_numeric_signed, sizeof(int), sizeof(value), -1));
+	memset(value, 0, sizeof(value));
+
+	for (i = 0; i < 200; i++) {
+		value[0] = (char) i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, value).error);
+	}
+
+	for (i = 0; i < 200; i += 2) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dictionary_delete(&dictionary, &i).count);
+	}
+
+	size = ion_fend(((ion_bpptree_t *) dictionary.instance)->values.file_handle);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 12, key_type_numeric_signed, sizeof(int), sizeof(value), -1));
+
+	for (i = 0; i < 200; i += 2) {
+		value[0] = (char) i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, value).error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_fend(((ion_bpptree_t *) dictionary.instance)->values.file_handle) == size);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_compact(&dictionary));
+
+	for (i = 0; i < 200; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &i, value).error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, (char) i, value[0]);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
+/**
+@brief		Tests that a cursor keeps returning the records it was opened
+			on while records are inserted, updated and deleted around it,
+			for inline values and value chains alike.
+@param		tc
+				Test case.
+*/
+void
+test_bpptreehandler_snapshot_cursor(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_record_t				record;
+	ion_value_size_t			value_sizes[2] = { sizeof(int), 64 };
+	int							value[16];
+	int							key;
+	int							count;
+	int							i;
+	int							j;
+
+	bpptree_init(&handler);
+	memset(value, 0, sizeof(value));
+	record.key		= (ion_key_t) &key;
+	record.value	= (ion_value_t) value;
+
+	for (j = 0; j < 2; j++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 13, key_type_numeric_signed, sizeof(int), value_sizes[j], -1));
+
+		for (i = 0; i < 2000; i += 2) {
+			value[0] = i;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, value).error);
+		}
+
+		dictionary_build_predicate(&predicate, predicate_all_records);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+		for (count = 0; count < 10; count++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_cursor_active, cursor->next(cursor, &record));
+		}
+
+		/* splits, updates in place and deletes, all behind the cursor's back */
+		for (i = 1; i < 2000; i += 2) {
+			value[0] = i;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &i, value).error);
+		}
+
+		for (i = 0; i < 2000; i += 2) {
+			value[0] = i + 1;
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dictionary_update(&dictionary, &i, value).count);
+		}
+
+		for (i = 0; i < 2000; i += 4) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, dictionary_delete(&dictionary, &i).count);
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_cursor_open, bpptree_compact(&dictionary));
+
+		while (cs_cursor_active == cursor->next(cursor, &record)) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 2 * count, key);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value[0]);
+			count++;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, cs_end_of_results, cursor->status);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1000, count);
+		cursor->destroy(&cursor);
+
+		/* once released, the changes are seen and the tree compacts */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, bpptree_compact(&dictionary));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+		count = 0;
+
+		while (cs_cursor_active == cursor->next(cursor, &record)) {
+			PLANCK_UNIT_ASSERT_TRUE(tc, 0 != key % 4);
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0 == key % 2 ? key + 1 : key, value[0]);
+			count++;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1500, count);
+		cursor->destroy(&cursor);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+	}
+}
+
+/**
+@brief		Checks that a cursor returns @p expected values for @p key,
+			newest first, counting down from @p newest unless it is
+			negative.
+*/
+static void
+bpptreehandler_posting_values(
+	planck_unit_test_t	*tc,
+	ion_dictionary_t	*dictionary,
+	int					key,
+	int					newest,
+	int					expected
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor;
+	ion_record_t		record;
+	int					found;
+	int					value;
+	int					count;
+
+	record.key		= (ion_key_t) &found;
+	record.value	= (ion_value_t) &value;
+	count			= 0;
+	dictionary_build_predicate(&predicate, predicate_equality, &key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(dictionary, &predicate, &cursor));
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, found);
+
+		if (0 <= newest) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, newest - count, value);
+		}
+
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, count);
+}
+
+/**
+@brief		Tests that the values of a key with several are packed into
+			blocks, by inserts, batches and bulk loads alike, and that they
+			are updated, deleted and reused a block at a time.
+@param		tc
+				Test case.
+*/
+void
+test_bpptreehandler_posting_lists(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor;
+	ion_bpptree_t				*bpptree;
+	ion_record_t				records[300];
+	ion_status_t				status;
+	ion_file_offset_t			size;
+	int							keys[300];
+	int							values[300];
+	int							key;
+	int							value;
+	int							i;
+
+	bpptree_init(&handler);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 14, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	bpptree = (ion_bpptree_t *) dictionary.instance;
+
+	key = 7;
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &i).error);
+	}
+
+	/* the blocks are full but for the head */
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_fend(bpptree->postings.file_handle) <= (ion_file_offset_t) ((1000 / bpptree->posting_values + 2) * bpptree->posting_size));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 999, value);
+	bpptreehandler_posting_values(tc, &dictionary, 7, 999, 1000);
+
+	/* a batch appends the values of each key together */
+	for (i = 0; i < 300; i++) {
+		keys[i]				= i < 100 ? 7 : 9;
+		values[i]			= 1000 + i;
+		records[i].key		= (ion_key_t) &keys[i];
+		records[i].value	= (ion_value_t) &values[i];
+	}
+
+	status = dictionary_insert_batch(&dictionary, records, 300);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 300, status.count);
+	bpptreehandler_posting_values(tc, &dictionary, 7, 1099, 1100);
+	bpptreehandler_posting_values(tc, &dictionary, 9, 1299, 200);
+
+	/* an update under a cursor writes new blocks, one in place rewrites them */
+	key		= 9;
+	value	= -1;
+	dictionary_build_predicate(&predicate, predicate_equality, &key);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 200, dictionary_update(&dictionary, &key, &value).count);
+	bpptreehandler_posting_values(tc, &dictionary, 9, -1, 200);
+	cursor->destroy(&cursor);
+
+	key = 7;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1100, dictionary_update(&dictionary, &key, &value).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_get(&dictionary, &key, &value).error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, value);
+
+	/* freed blocks are reused, also after a reopen */
+	size = ion_fend(bpptree->postings.file_handle);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1100, dictionary_delete(&dictionary, &key).count);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 14, key_type_numeric_signed, sizeof(int), sizeof(int), -1));
+	bpptree = (ion_bpptree_t *) dictionary.instance;
+
+	for (i = 0; i < 1000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &i).error);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, ion_fend(bpptree->postings.file_handle) == size);
+	bpptreehandler_posting_values(tc, &dictionary, 7, 999, 1000);
+	bpptreehandler_posting_values(tc, &dictionary, 9, -1, 200);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+}
+
 planck_unit_suite_t *
 bpptreehandler_get_suite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, run_bpptreehandler_generic_test_set_1);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_bulk_load);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_prefixed);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_sector_size);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_buffer_pool);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_inline_values);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_free_space);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_snapshot_cursor);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_bpptreehandler_posting_lists);
 
 	return suite;
 }
@@ -140,12 +140,12 @@ ftest_insert(
 
 		ion_byte_t read_buffer[flat_file->row_size];
 
-		fseek(flat_file->data_file, flat_file->start_of_data, SEEK_SET);
+		ion_fseek(flat_file->data_file, flat_file->start_of_data, ION_FILE_START);
 
 		ion_fpos_t cur_index = 0;
 
 		while (boolean_true) {
-			if (1 != fread(read_buffer, flat_file->row_size, 1, flat_file->data_file)) {
+			if (err_ok != ion_fread(flat_file->data_file, flat_file->row_size, read_buffer)) {
 				break;
 			}
 
@@ -654,6 +654,59 @@ test_flat_file_sort_get_many_exist_duplicates(
 	ftest_takedown(tc, &flat_file);
 }
 
+/**
+@brief		Tests a multi-key sorted get, where lookups are served both from the loaded
+			region and by binary search. Each result must match a single get.
+*/
+void
+test_flat_file_sort_get_multiple_keys(
+	planck_unit_test_t *tc
+) {
+	ion_flat_file_t flat_file;
+	ion_key_t		keys[12];
+	ion_value_t		values[12];
+	ion_status_t	statuses[12];
+	int				key_data[12]	= { 61, 0, 30, 30, 101, -5, 32, 2, 31, 78, 44, 30 };
+	int				value_data[12]	= { 0 };
+	int				expected;
+	int				i;
+
+	ftest_setup_sorted(tc, &flat_file);
+
+	for (i = 0; i < 80; i += 2) {
+		ftest_insert(tc, &flat_file, IONIZE(i, int), IONIZE(i * 3, int), err_ok, 1, boolean_false);
+
+		/* A run of duplicates that straddles a buffer boundary. */
+		if (30 == i) {
+			ftest_insert(tc, &flat_file, IONIZE(i, int), IONIZE(-1, int), err_ok, 1, boolean_false);
+			ftest_insert(tc, &flat_file, IONIZE(i, int), IONIZE(-2, int), err_ok, 1, boolean_false);
+		}
+	}
+
+	for (i = 0; i < 12; i++) {
+		keys[i]		= &key_data[i];
+		values[i]	= &value_data[i];
+	}
+
+	ion_status_t status = flat_file_get_many(&flat_file, keys, 12, values, statuses);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8, status.count);
+
+	for (i = 0; i < 12; i++) {
+		ion_status_t single = flat_file_get(&flat_file, keys[i], &expected);
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, single.error, statuses[i].error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, single.count, statuses[i].count);
+
+		if (err_ok == single.error) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, expected, value_data[i]);
+		}
+	}
+
+	ftest_takedown(tc, &flat_file);
+}
+
 /**
 @brief		Tests a sorted update on an empty store.
 */
@@ -797,6 +850,7 @@ flat_file_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_get_many_nonexist);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_get_many_exist);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_get_many_exist_duplicates);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_get_multiple_keys);
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_update_empty);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_flat_file_sort_update_single_nonexist);
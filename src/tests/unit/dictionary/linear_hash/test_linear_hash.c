@@ -38,6 +38,12 @@
 #include "../../../../key_value/kv_system.h"
 #include <time.h>
 
+#if defined(ARDUINO)
+#define TEST_LINEAR_HASH_IS_OPEN(file) (NULL != (file).file)
+#else
+#define TEST_LINEAR_HASH_IS_OPEN(file) (ION_NOFILE != (file))
+#endif
+
 /**
 @brief		Initializes a test flatfile instance and does a few sanity checks.
 */
@@ -48,20 +54,21 @@ test_linear_hash_create(
 	ion_key_type_t			key_type,
 	ion_key_size_t			key_size,
 	ion_value_size_t		value_size,
-	ion_dictionary_size_t	dictionary_size
+	ion_dictionary_size_t	dictionary_size,
+	linear_hash_hash_t		hash
 ) {
 	/* TODO create and destroy a linear_hash in every file */
 
 	int			initial_size		= 2;
 	int			split_threshold		= 85;
 	int			records_per_bucket	= 4;
-	ion_err_t	err					= linear_hash_init(1, dictionary_size, key_type, key_size, value_size, initial_size, split_threshold, records_per_bucket, linear_hash);
+	ion_err_t	err					= linear_hash_init_hash(1, dictionary_size, key_type, key_size, value_size, initial_size, split_threshold, records_per_bucket, hash, ION_LINEAR_HASH_SEED, linear_hash);
 
 	linear_hash->super.compare = dictionary_compare_signed_value;
 
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
-	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != linear_hash->database);
-	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != linear_hash->state);
+	PLANCK_UNIT_ASSERT_TRUE(tc, TEST_LINEAR_HASH_IS_OPEN(linear_hash->database));
+	PLANCK_UNIT_ASSERT_TRUE(tc, TEST_LINEAR_HASH_IS_OPEN(linear_hash->state));
 	PLANCK_UNIT_ASSERT_TRUE(tc, initial_size == linear_hash->num_buckets);
 	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == linear_hash->num_records);
 	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == err);
@@ -78,7 +85,7 @@ test_linear_hash_destroy(
 	ion_err_t err = linear_hash_destroy(linear_hash);
 
 	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, err);
-	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == linear_hash->database);
+	PLANCK_UNIT_ASSERT_TRUE(tc, !TEST_LINEAR_HASH_IS_OPEN(linear_hash->database));
 
 	free(linear_hash);
 }
@@ -91,7 +98,8 @@ test_linear_hash_setup(
 	planck_unit_test_t	*tc,
 	linear_hash_table_t *linear_hash
 ) {
-	test_linear_hash_create(tc, linear_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 4);
+	/* the bucket arithmetic of these tests is worked out for the polynomial hash */
+	test_linear_hash_create(tc, linear_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 4, linear_hash_hash_polynomial);
 }
 
 /**
@@ -258,7 +266,7 @@ test_linear_hash_bucket_map_head_updates(
 	ion_fpos_t total_record_size = linear_hash->super.record.key_size + linear_hash->super.record.value_size + sizeof(ion_byte_t);
 
 	/* test that the new head of 0 index bucket is at the correct location */
-	expected_bucket_head = fseek(linear_hash->database, -4 * total_record_size - sizeof(linear_hash_bucket_t), SEEK_END);
+	expected_bucket_head = ion_fend(linear_hash->database) - 4 * total_record_size - sizeof(linear_hash_bucket_t);
 	PLANCK_UNIT_ASSERT_TRUE(tc, expected_bucket_head != array_list_get(0, linear_hash->bucket_map));
 
 	test_linear_hash_takedown(tc, linear_hash);
@@ -459,6 +467,293 @@ test_linear_hash_local_record_increments_decrements(
 	test_linear_hash_takedown(tc, linear_hash);
 }
 
+/**
+@brief		Tests that the seeded hash spreads keys the polynomial hash
+			cannot tell apart, and that every key is still found.
+*/
+void
+test_linear_hash_seeded_hash(
+	planck_unit_test_t *tc
+) {
+	linear_hash_table_t *linear_hash = malloc(sizeof(linear_hash_table_t));
+
+	test_linear_hash_create(tc, linear_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 4, linear_hash_hash_wyhash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_hash_wyhash == linear_hash->hash);
+
+	/* multiples of 256 all hash to even values under the polynomial hash */
+	int			key;
+	int			odd		= 0;
+	uint64_t	hash	= linear_hash_key_hash((ion_byte_t *) IONIZE(256, int), linear_hash);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, hash == linear_hash_key_hash((ion_byte_t *) IONIZE(256, int), linear_hash));
+
+	for (key = 0; key < 64 * 256; key += 256) {
+		odd += linear_hash_key_hash((ion_byte_t *) IONIZE(key, int), linear_hash) & 1;
+		test_linear_hash_insert(tc, IONIZE(key, int), IONIZE(key, int), err_ok, 1, boolean_true, linear_hash);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 < odd && odd < 64);
+
+	for (key = 0; key < 64 * 256; key += 256) {
+		test_linear_hash_get(tc, IONIZE(key, int), err_ok, 1, IONIZE(key, int), linear_hash);
+	}
+
+	/* another seed gives other hashes */
+	linear_hash->seed++;
+	PLANCK_UNIT_ASSERT_TRUE(tc, hash != linear_hash_key_hash((ion_byte_t *) IONIZE(256, int), linear_hash));
+	linear_hash->seed--;
+
+	test_linear_hash_takedown(tc, linear_hash);
+}
+
+/**
+@brief		Tests that after many splits every record is found, once, in
+			the chain of the bucket it hashes to.
+*/
+void
+test_linear_hash_split_placement(
+	planck_unit_test_t *tc
+) {
+	linear_hash_table_t *linear_hash = malloc(sizeof(linear_hash_table_t));
+
+	test_linear_hash_create(tc, linear_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 4, linear_hash_hash_wyhash);
+
+	int			i, idx, seen = 0;
+	ion_byte_t	status;
+	int			key, value;
+
+	/* two records a key, so some chains run past one bucket */
+	for (i = 0; i < 200; i++) {
+		test_linear_hash_insert(tc, IONIZE(i / 2, int), IONIZE(i, int), err_ok, 1, boolean_false, linear_hash);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 200 == linear_hash->num_records);
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash->num_buckets > 4);
+
+	for (idx = 0; idx < linear_hash->num_buckets; idx++) {
+		linear_hash_bucket_t	bucket;
+		ion_fpos_t				bucket_loc = bucket_idx_to_ion_fpos_t(idx, linear_hash);
+
+		while (linear_hash_end_of_list != bucket_loc) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_bucket(bucket_loc, &bucket, linear_hash));
+			PLANCK_UNIT_ASSERT_TRUE(tc, idx == bucket.idx);
+
+			for (i = 0; i < bucket.record_count; i++) {
+				PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_record(bucket_loc + sizeof(linear_hash_bucket_t) + i * linear_hash->record_total_size, (ion_byte_t *) &key, (ion_byte_t *) &value, &status, linear_hash));
+				PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_record_status_full == status);
+				PLANCK_UNIT_ASSERT_TRUE(tc, key == value / 2);
+
+				int bucket_idx = insert_hash_to_bucket((ion_byte_t *) &key, linear_hash);
+
+				if (bucket_idx < linear_hash->next_split) {
+					bucket_idx = hash_to_bucket((ion_byte_t *) &key, linear_hash);
+				}
+
+				PLANCK_UNIT_ASSERT_TRUE(tc, idx == bucket_idx);
+				seen++;
+			}
+
+			bucket_loc = bucket.overflow_location;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, 200 == seen);
+
+	test_linear_hash_takedown(tc, linear_hash);
+}
+
+/**
+@brief		Tests that lookups of hot keys are served by the bucket cache,
+			and that buckets pushed out of it are written back.
+*/
+void
+test_linear_hash_bucket_cache(
+	planck_unit_test_t *tc
+) {
+	linear_hash_table_t *linear_hash = malloc(sizeof(linear_hash_table_t));
+
+	test_linear_hash_setup(tc, linear_hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_LINEAR_HASH_CACHE_BUCKETS == linear_hash->buckets.frames);
+
+	int i;
+
+	test_linear_hash_insert(tc, IONIZE(7, int), IONIZE(70, int), err_ok, 1, boolean_true, linear_hash);
+	linear_hash->buckets.misses = 0;
+
+	for (i = 0; i < 10; i++) {
+		test_linear_hash_get(tc, IONIZE(7, int), err_ok, 1, IONIZE(70, int), linear_hash);
+	}
+
+	if (ION_LINEAR_HASH_CACHE_BUCKETS > 0) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 == linear_hash->buckets.misses);
+		PLANCK_UNIT_ASSERT_TRUE(tc, 0 < linear_hash->buckets.hits);
+	}
+
+	/* enough buckets that most are written back as they leave the cache */
+	for (i = 0; i < 8 * ION_LINEAR_HASH_CACHE_BUCKETS * linear_hash->records_per_bucket; i++) {
+		test_linear_hash_insert(tc, IONIZE(1000 + i, int), IONIZE(i, int), err_ok, 1, boolean_false, linear_hash);
+	}
+
+	for (i = 0; i < 8 * ION_LINEAR_HASH_CACHE_BUCKETS * linear_hash->records_per_bucket; i++) {
+		test_linear_hash_get(tc, IONIZE(1000 + i, int), err_ok, 1, IONIZE(i, int), linear_hash);
+	}
+
+	/* once synced, the file agrees with the cache */
+	linear_hash_bucket_t	cached, stored;
+	ion_fpos_t				bucket_loc = array_list_get(0, linear_hash->bucket_map);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_sync(linear_hash));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_bucket(bucket_loc, &cached, linear_hash));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(linear_hash->database, bucket_loc, sizeof(stored), (ion_byte_t *) &stored));
+	PLANCK_UNIT_ASSERT_TRUE(tc, cached.record_count == stored.record_count);
+	PLANCK_UNIT_ASSERT_TRUE(tc, cached.overflow_location == stored.overflow_location);
+
+	test_linear_hash_takedown(tc, linear_hash);
+}
+
+/**
+@brief		Tests that a closed table opens again with its records, its
+			hash and its buckets, reading its bucket map as it goes.
+*/
+void
+test_linear_hash_reopen(
+	planck_unit_test_t *tc
+) {
+	linear_hash_table_t *linear_hash = malloc(sizeof(linear_hash_table_t));
+
+	test_linear_hash_create(tc, linear_hash, key_type_numeric_signed, sizeof(int), sizeof(int), 4, linear_hash_hash_wyhash);
+
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		test_linear_hash_insert(tc, IONIZE(i, int), IONIZE(i * 3, int), err_ok, 1, boolean_false, linear_hash);
+	}
+
+	int num_buckets = linear_hash->num_buckets;
+	int next_split	= linear_hash->next_split;
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_close(linear_hash));
+
+	/* the stored hash and sizes win over the ones asked for */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_init_hash(1, 4, key_type_numeric_signed, sizeof(int), sizeof(int), 2, 85, 4, linear_hash_hash_polynomial, 0, linear_hash));
+	linear_hash->super.compare = dictionary_compare_signed_value;
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_hash_wyhash == linear_hash->hash);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_LINEAR_HASH_SEED == linear_hash->seed);
+	PLANCK_UNIT_ASSERT_TRUE(tc, 100 == linear_hash->num_records);
+	PLANCK_UNIT_ASSERT_TRUE(tc, num_buckets == linear_hash->num_buckets);
+	PLANCK_UNIT_ASSERT_TRUE(tc, next_split == linear_hash->next_split);
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_map_unread == linear_hash->bucket_map->data[0]);
+
+	for (i = 0; i < 100; i++) {
+		test_linear_hash_get(tc, IONIZE(i, int), err_ok, 1, IONIZE(i * 3, int), linear_hash);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_map_unread != linear_hash->bucket_map->data[0]);
+
+	/* and goes on growing */
+	for (i = 100; i < 200; i++) {
+		test_linear_hash_insert(tc, IONIZE(i, int), IONIZE(i * 3, int), err_ok, 1, boolean_true, linear_hash);
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, num_buckets < linear_hash->num_buckets);
+
+	test_linear_hash_takedown(tc, linear_hash);
+}
+
+/**
+@brief		Tests that the filter of each bucket chain covers the keys in it
+			through inserts and swap-on-delete, that a key missing from it is
+			found absent without reading past the head of the chain, and that
+			it keeps ruling out most missing keys as the chain grows long.
+*/
+void
+test_linear_hash_key_filter(
+	planck_unit_test_t *tc
+) {
+	linear_hash_table_t *linear_hash = malloc(sizeof(linear_hash_table_t));
+
+	/* a threshold never reached keeps every record in long chains */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_init_hash(1, 4, key_type_numeric_signed, sizeof(int), sizeof(int), 2, 10000, 4, linear_hash_hash_wyhash, ION_LINEAR_HASH_SEED, linear_hash));
+	linear_hash->super.compare = dictionary_compare_signed_value;
+
+	linear_hash_bucket_t	bucket;
+	unsigned long			reads;
+	int						i, key, passed;
+
+	for (i = 0; i < 24; i++) {
+		test_linear_hash_insert(tc, IONIZE(i, int), IONIZE(i * 2, int), err_ok, 1, boolean_false, linear_hash);
+	}
+
+	/* deletes swap records from the head down the chain */
+	for (i = 0; i < 24; i += 3) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_delete((ion_byte_t *) IONIZE(i, int), linear_hash).error);
+	}
+
+	for (i = 0; i < 24; i++) {
+		key = i;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_bucket(bucket_idx_to_ion_fpos_t(insert_hash_to_bucket((ion_byte_t *) &key, linear_hash), linear_hash), &bucket, linear_hash));
+		PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_chain_may_hold(&bucket, (ion_byte_t *) &key, linear_hash));
+
+		if (0 == i % 3) {
+			test_linear_hash_get(tc, IONIZE(i, int), err_item_not_found, 0, NULL, linear_hash);
+		}
+		else {
+			test_linear_hash_get(tc, IONIZE(i, int), err_ok, 1, IONIZE(i * 2, int), linear_hash);
+		}
+	}
+
+	/* a missing key the filter rules out costs one read of the head */
+	for (key = 1000;; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_bucket(bucket_idx_to_ion_fpos_t(insert_hash_to_bucket((ion_byte_t *) &key, linear_hash), linear_hash), &bucket, linear_hash));
+
+		if (!linear_hash_chain_may_hold(&bucket, (ion_byte_t *) &key, linear_hash)) {
+			break;
+		}
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_end_of_list != bucket.overflow_location);
+
+	reads = linear_hash->buckets.hits + linear_hash->buckets.misses;
+	test_linear_hash_get(tc, IONIZE(key, int), err_item_not_found, 0, NULL, linear_hash);
+
+	if (ION_LINEAR_HASH_CACHE_BUCKETS > 0) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, reads + 1 == linear_hash->buckets.hits + linear_hash->buckets.misses);
+	}
+
+	/* chains of about 25 buckets take more words of filter, rebuilt from what they hold */
+	for (i = 24; i < 200; i++) {
+		test_linear_hash_insert(tc, IONIZE(i, int), IONIZE(i * 2, int), err_ok, 1, boolean_false, linear_hash);
+	}
+
+	for (key = 0; key < 200; key++) {
+		if ((key < 24) && (0 == key % 3)) {
+			continue;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_bucket(bucket_idx_to_ion_fpos_t(insert_hash_to_bucket((ion_byte_t *) &key, linear_hash), linear_hash), &bucket, linear_hash));
+		PLANCK_UNIT_ASSERT_TRUE(tc, linear_hash_chain_may_hold(&bucket, (ion_byte_t *) &key, linear_hash));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ION_LINEAR_HASH_CHAIN_FILTER_WORDS, bucket.chain_words);
+	}
+
+	passed = 0;
+
+	for (key = 1000; key < 2000; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, linear_hash_get_bucket(bucket_idx_to_ion_fpos_t(insert_hash_to_bucket((ion_byte_t *) &key, linear_hash), linear_hash), &bucket, linear_hash));
+
+		if (linear_hash_chain_may_hold(&bucket, (ion_byte_t *) &key, linear_hash)) {
+			passed++;
+		}
+	}
+
+	/* a single word would let nearly every miss through chains this long */
+	if (ION_LINEAR_HASH_CHAIN_FILTER_WORDS >= 8) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, passed < 250);
+	}
+
+	test_linear_hash_takedown(tc, linear_hash);
+}
+
 /**
 @brief		Tests some basic creation and destruction stuff for the flat file.
 */
@@ -485,6 +780,11 @@ linear_hash_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_correct_bucket_after_split);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_global_record_increments_decrements);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_local_record_increments_decrements);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_seeded_hash);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_bucket_cache);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_split_placement);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_reopen);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_linear_hash_key_filter);
 	return suite;
 }
 
@@ -54,7 +54,7 @@ check_file_map(
 	int i;
 	int bucket_size = map->super.record.key_size + map->super.record.value_size + sizeof(char);
 
-	frewind(map->file);
+	ion_fseek(map->file, 0, ION_FILE_START);
 
 	ion_hash_bucket_t *record;
 
@@ -66,7 +66,7 @@ check_file_map(
 
 		int j;
 
-		DUMP((int) fread(record, bucket_size, 1, map->file), "%d");
+		DUMP((int) ion_fread(map->file, bucket_size, (ion_byte_t *) record), "%d");
 		printf("reading\n");
 		fflush(stdout);
 
@@ -216,7 +216,7 @@ test_open_address_file_hashmap_find_item_location(
 	int bucket_size = sizeof(char) + record.key_size + record.value_size;
 
 	/* rewind */
-	frewind(map.file);
+	ion_fseek(map.file, 0, ION_FILE_START);
 
 	for (offset = 0; offset < map.map_size; offset++) {
 		/* apply continual offsets */
@@ -228,7 +228,7 @@ test_open_address_file_hashmap_find_item_location(
 
 		/* printf("writing to %i\n",(offset*bucket_size)%(map.map_size*bucket_size)); */
 
-		fseek(map.file, (offset * bucket_size) % (map.map_size * bucket_size), SEEK_SET);
+		ion_fseek(map.file, (offset * bucket_size) % (map.map_size * bucket_size), ION_FILE_START);
 
 		for (i = 0; i < map.map_size; i++) {
 			item_ptr->status = ION_IN_USE;
@@ -243,10 +243,10 @@ test_open_address_file_hashmap_find_item_location(
 
 			/* memcpy(pos_ptr, item_ptr, bucket_size); */
 
-			fwrite(item_ptr, bucket_size, 1, map.file);
+			ion_fwrite(map.file, bucket_size, (ion_byte_t *) item_ptr);
 			/* printf("Moving to position %i\n", ((((i+1+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))); */
 			/* pos_ptr = map.entry + ((((i+1+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size)); */
-			fseek(map.file, ((((i + 1 + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), SEEK_SET);
+			ion_fseek(map.file, ((((i + 1 + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), ION_FILE_START);
 			/* printf("current file pos: %i\n",(int)	ftell(map.file)); */
 		}
 
@@ -289,7 +289,7 @@ test_open_address_file_hashmap_simple_insert(
 	int bucket_size				= sizeof(char) + record.key_size + record.value_size;
 
 	/* rewind */
-	frewind(map.file);
+	ion_fseek(map.file, 0, ION_FILE_START);
 
 	for (offset = 0; offset < map.map_size; offset++) {
 		for (i = 0; i < map.map_size; i++) {
@@ -307,15 +307,15 @@ test_open_address_file_hashmap_simple_insert(
 
 		for (i = 0; i < map.map_size; i++) {
 			/* set the position in the file */
-			fseek(map.file, ((((i + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), SEEK_SET);
+			ion_fseek(map.file, ((((i + offset) % map.map_size) * bucket_size) % (map.map_size * bucket_size)), ION_FILE_START);
 
 			ion_record_status_t record_status;	/* = ((ion_hash_bucket_t *)(map.entry + ((((i+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))))->status; */
 			int					key;	/* = *(int *)(((ion_hash_bucket_t *)(map.entry + ((((i+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))))->data ); */
 			ion_byte_t			value[10];		/* = (((ion_hash_bucket_t *)(map.entry + ((((i+offset)%map.map_size)*bucket_size )%(map.map_size*bucket_size))))->data + sizeof(int)); */
 
-			fread(&record_status, SIZEOF(STATUS), 1, map.file);
-			fread(&key, map.super.record.key_size, 1, map.file);
-			fread(value, map.super.record.value_size, 1, map.file);
+			ion_fread(map.file, SIZEOF(STATUS), (ion_byte_t *) &record_status);
+			ion_fread(map.file, map.super.record.key_size, (ion_byte_t *) &key);
+			ion_fread(map.file, map.super.record.value_size, (ion_byte_t *) value);
 
 			/* build up expected value */
 			char str[10];
@@ -157,7 +157,7 @@ test_dictionary_creation(
 	ion_skiplist_t *skiplist = (ion_skiplist_t *) dict.instance;
 
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->key_type == key_type_numeric_signed);
-	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->compare == dictionary_compare_signed_value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->compare == dictionary_switch_compare(key_type_numeric_signed, sizeof(int)));
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->record.key_size == sizeof(int));
 	PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->record.value_size == 10);
 	PLANCK_UNIT_ASSERT_TRUE(tc, skiplist != NULL);
@@ -483,6 +483,61 @@ test_slhandler_cursor_range_exact_results(
 	dictionary_delete_dictionary(&dict);
 }
 
+/**
+@brief		Tests a range cursor read in place with @ref dictionary_next_ref. The
+			references must point into the skiplist nodes rather than at copies.
+@param	  tc
+				Test case.
+*/
+void
+test_slhandler_cursor_next_ref(
+	planck_unit_test_t *tc
+) {
+	PRINT_HEADER();
+
+	ion_dictionary_t			dict;
+	ion_dictionary_handler_t	handler;
+
+	create_test_dictionary_std_conditions(&dict, &handler);
+
+	int extra_keys[]	= { 503, 504, 504, 509, 542 };
+	int num_extra		= sizeof(extra_keys) / sizeof(int);
+
+	int i;
+
+	for (i = 0; i < num_extra; i++) {
+		ion_status_t status = dictionary_insert(&dict, &extra_keys[i], "test");
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	ion_dict_cursor_t	*cursor;
+	ion_predicate_t		predicate;
+
+	dictionary_build_predicate(&predicate, predicate_range, IONIZE(500, int), IONIZE(600, int));
+
+	ion_err_t status = dictionary_find(&dict, &predicate, &cursor);
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok == status);
+
+	ion_record_ref_t	ref;
+	int					key_idx = 0;
+
+	while (cs_cursor_active == dictionary_next_ref(cursor, &ref)) {
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ref.copy);
+		PLANCK_UNIT_ASSERT_TRUE(tc, dict.instance->compare(ref.key, &extra_keys[key_idx], dict.instance->record.key_size) == 0);
+		PLANCK_UNIT_ASSERT_TRUE(tc, memcmp(ref.value, (char *) { "test" }, dict.instance->record.value_size) == 0);
+		dictionary_release_ref(&ref);
+		key_idx++;
+	}
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, cs_end_of_results == cursor->status);
+	PLANCK_UNIT_ASSERT_TRUE(tc, key_idx == num_extra);
+
+	cursor->destroy(&cursor);
+	dictionary_delete_dictionary(&dict);
+}
+
 /**
 @brief	  Creates the suite to test using PlanckUnit test cases.
 @return	 Pointer to a PlanckUnit test suite.
@@ -505,6 +560,7 @@ skiplist_handler_getsuite(
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_with_results);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_lower_missing);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_range_exact_results);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_slhandler_cursor_next_ref);
 
 	return suite;
 }
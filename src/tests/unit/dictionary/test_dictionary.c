@@ -36,6 +36,12 @@
 
 #include "test_dictionary.h"
 
+#if !defined(ARDUINO)
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#endif
+
 void
 test_dictionary_compare_numerics(
 	planck_unit_test_t *tc
@@ -177,6 +183,60 @@ test_dictionary_compare_numerics(
 	}
 }
 
+/**
+@brief		Checks that a width specialized comparator agrees with the
+			byte-wise one on every pair of the given keys.
+*/
+static void
+test_dictionary_compare_width(
+	planck_unit_test_t			*tc,
+	ion_key_type_t				key_type,
+	ion_key_size_t				key_size,
+	ion_byte_t					*keys,
+	int							count,
+	ion_dictionary_compare_t	generic
+) {
+	ion_dictionary_compare_t	compare = dictionary_switch_compare(key_type, key_size);
+	int							i;
+	int							j;
+
+	PLANCK_UNIT_ASSERT_TRUE(tc, generic != compare);
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < count; j++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, generic(keys + i * key_size, keys + j * key_size, key_size), compare(keys + i * key_size, keys + j * key_size, key_size));
+		}
+	}
+}
+
+void
+test_dictionary_compare_specialized(
+	planck_unit_test_t *tc
+) {
+	int8_t		s8[]	= { 0, 1, -1, 2, -2, 127, -128, 64, -65 };
+	uint8_t		u8[]	= { 0, 1, 2, 127, 128, 254, 255 };
+	int16_t		s16[]	= { 0, 1, -1, 255, 256, -256, -257, 32767, -32768 };
+	uint16_t	u16[]	= { 0, 1, 255, 256, 32767, 32768, 65535 };
+	int32_t		s32[]	= { 0, 1, -1, 65536, -65536, 16777216, INT32_MAX, INT32_MIN, -16777217 };
+	uint32_t	u32[]	= { 0, 1, 255, 256, 65536, 2147483648U, UINT32_MAX };
+	int64_t		s64[]	= { 0, 1, -1, 4294967296LL, -4294967296LL, INT64_MAX, INT64_MIN, 255 };
+	uint64_t	u64[]	= { 0, 1, 255, 4294967296ULL, 9223372036854775808ULL, UINT64_MAX };
+	ion_byte_t	odd[]	= { 0x01, 0x02, 0x03 };
+
+	test_dictionary_compare_width(tc, key_type_numeric_signed, 1, (ion_byte_t *) s8, sizeof(s8) / sizeof(s8[0]), dictionary_compare_signed_value);
+	test_dictionary_compare_width(tc, key_type_numeric_unsigned, 1, (ion_byte_t *) u8, sizeof(u8) / sizeof(u8[0]), dictionary_compare_unsigned_value);
+	test_dictionary_compare_width(tc, key_type_numeric_signed, 2, (ion_byte_t *) s16, sizeof(s16) / sizeof(s16[0]), dictionary_compare_signed_value);
+	test_dictionary_compare_width(tc, key_type_numeric_unsigned, 2, (ion_byte_t *) u16, sizeof(u16) / sizeof(u16[0]), dictionary_compare_unsigned_value);
+	test_dictionary_compare_width(tc, key_type_numeric_signed, 4, (ion_byte_t *) s32, sizeof(s32) / sizeof(s32[0]), dictionary_compare_signed_value);
+	test_dictionary_compare_width(tc, key_type_numeric_unsigned, 4, (ion_byte_t *) u32, sizeof(u32) / sizeof(u32[0]), dictionary_compare_unsigned_value);
+	test_dictionary_compare_width(tc, key_type_numeric_signed, 8, (ion_byte_t *) s64, sizeof(s64) / sizeof(s64[0]), dictionary_compare_signed_value);
+	test_dictionary_compare_width(tc, key_type_numeric_unsigned, 8, (ion_byte_t *) u64, sizeof(u64) / sizeof(u64[0]), dictionary_compare_unsigned_value);
+
+	/* Other widths keep the byte-wise comparators. */
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_compare_signed_value == dictionary_switch_compare(key_type_numeric_signed, sizeof(odd)));
+	PLANCK_UNIT_ASSERT_TRUE(tc, dictionary_compare_unsigned_value == dictionary_switch_compare(key_type_numeric_unsigned, sizeof(odd)));
+}
+
 void
 test_dictionary_master_table(
 	planck_unit_test_t *tc
@@ -326,13 +386,904 @@ test_dictionary_master_table(
 	/**************/
 }
 
+#if !defined(ARDUINO)
+
+/**
+@brief		Counts the records a dictionary holds under a key.
+*/
+static int
+test_dictionary_count_key(
+	ion_dictionary_t	*dictionary,
+	int					key
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					found_key;
+	int					value;
+	int					count	= 0;
+
+	record.key		= &found_key;
+	record.value	= &value;
+	dictionary_build_predicate(&predicate, predicate_equality, &key);
+
+	if (err_ok != dictionary_find(dictionary, &predicate, &cursor)) {
+		return -1;
+	}
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	return count;
+}
+
+void
+test_dictionary_write_ahead_log(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_wal_t					*wal;
+	ion_wal_stats_t				stats;
+	ion_status_t				status;
+	FILE						*file;
+	int							key;
+	int							value;
+
+	fremove("test.wal");
+	ffdict_init(&handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 90, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 0, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	for (key = 0; key < 20; key++) {
+		value	= key * 3;
+		status	= dictionary_insert(&dictionary, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+	}
+
+	key		= 4;
+	value	= -4;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_update(&dictionary, &key, &value).error);
+	key		= 5;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete(&dictionary, &key).error);
+
+	ion_wal_get_stats(wal, &stats);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 22, stats.commits);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.syncs <= stats.commits);
+
+	/* Lose the dictionary without telling the log, as a crash would. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+	dictionary.wal = NULL;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+
+	/* Attaching a fresh dictionary replays the log into it. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 90, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 0, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	for (key = 0; key < 20; key++) {
+		status = dictionary_get(&dictionary, &key, &value);
+
+		if (5 == key) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_item_not_found, status.error);
+			continue;
+		}
+
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4 == key ? -4 : key * 3, value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1, test_dictionary_count_key(&dictionary, key));
+	}
+
+	/* Closing detaches the dictionary, after which the log is emptied. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+
+	file = fopen("test.wal", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	fseek(file, 0, SEEK_END);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ftell(file));
+	fclose(file);
+
+	dictionary_destroy_dictionary(&handler, 90);
+	fremove("test.wal");
+}
+
+/**
+@brief		Tests that changes a dictionary refuses stay out of the log, so
+			that replaying it does not fail on them.
+*/
+void
+test_dictionary_write_ahead_log_failures(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_wal_t					*wal;
+	ion_record_t				records[6];
+	ion_status_t				status;
+	int							keys[6];
+	int							key;
+	int							value;
+
+	fremove("test.wal");
+	oafdict_init(&handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 93, key_type_numeric_signed, sizeof(int), sizeof(int), 4));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 0, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	/* the table fills after four records, so the batch stops part way */
+	for (key = 0; key < 6; key++) {
+		keys[key]			= key;
+		records[key].key	= &keys[key];
+		records[key].value	= &keys[key];
+	}
+
+	status = dictionary_insert_batch(&dictionary, records, 6);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != status.error);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 4, status.count);
+
+	key		= 6;
+	value	= 6;
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != dictionary_insert(&dictionary, &key, &value).error);
+
+	/* Lose the dictionary without telling the log, as a crash would. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+	dictionary.wal = NULL;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 93, key_type_numeric_signed, sizeof(int), sizeof(int), 4));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 0, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	for (key = 0; key < 4; key++) {
+		status = dictionary_get(&dictionary, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+	dictionary_destroy_dictionary(&handler, 93);
+	fremove("test.wal");
+}
+
+/**
+@brief		Tests that a dictionary left with records in the log, and not
+			attached again, does not keep the log from being checkpointed,
+			and still finds its records when it is attached.
+*/
+void
+test_dictionary_write_ahead_log_pending(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_t			other;
+	ion_wal_t					*wal;
+	ion_wal_stats_t				stats;
+	ion_status_t				status;
+	FILE						*file;
+	int							key;
+	int							value;
+
+	fremove("test.wal");
+	ffdict_init(&handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 94, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 0, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	for (key = 0; key < 10; key++) {
+		value = key * 5;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &value).error);
+	}
+
+	/* Lose the dictionary without telling the log, as a crash would. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+	dictionary.wal = NULL;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&dictionary));
+
+	/* Another dictionary checkpoints the log while the first is away. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 1024, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &other, 95, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&other, wal));
+
+	for (key = 0; key < 200; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&other, &key, &key).error);
+	}
+
+	ion_wal_get_stats(wal, &stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.checkpoints > 0);
+
+	file = fopen("test.wal", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	fseek(file, 0, SEEK_END);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ftell(file) < 2048);
+	fclose(file);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&other));
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 94, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	for (key = 0; key < 10; key++) {
+		status = dictionary_get(&dictionary, &key, &value);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, status.error);
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key * 5, value);
+	}
+
+	/* With every dictionary attached again, closing empties the log. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+
+	file = fopen("test.wal", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	fseek(file, 0, SEEK_END);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ftell(file));
+	fclose(file);
+
+	dictionary_destroy_dictionary(&handler, 94);
+	dictionary_destroy_dictionary(&handler, 95);
+	fremove("test.wal");
+}
+
+/**
+@brief		Tests that a checkpoint started while a cursor holds one of the
+			dictionaries passes it over, rather than waiting for the cursor,
+			whose thread may be the one writing.
+*/
+void
+test_dictionary_write_ahead_log_cursor(
+	planck_unit_test_t *tc
+) {
+	ion_dictionary_handler_t	handler;
+	ion_dictionary_t			dictionary;
+	ion_dictionary_t			other;
+	ion_wal_t					*wal;
+	ion_wal_stats_t				stats;
+	ion_predicate_t				predicate;
+	ion_dict_cursor_t			*cursor = NULL;
+	ion_record_t				record;
+	FILE						*file;
+	int							key;
+	int							value;
+	int							count	= 0;
+
+	fremove("test.wal");
+	ffdict_init(&handler);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 512, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &dictionary, 96, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &other, 97, key_type_numeric_signed, sizeof(int), sizeof(int), 10));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_concurrency(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_concurrency(&other));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&other, wal));
+
+	for (key = 0; key < 5; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&dictionary, &key, &key).error);
+	}
+
+	/* The cursor holds the first dictionary's lock while the second fills the log. */
+	dictionary_build_predicate(&predicate, predicate_all_records);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_find(&dictionary, &predicate, &cursor));
+
+	for (key = 0; key < 50; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_insert(&other, &key, &key).error);
+	}
+
+	ion_wal_get_stats(wal, &stats);
+	PLANCK_UNIT_ASSERT_TRUE(tc, stats.checkpoints > 0);
+
+	record.key		= &key;
+	record.value	= &value;
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, key, value);
+		count++;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5, count);
+	cursor->destroy(&cursor);
+
+	/* Once the cursor is gone the first dictionary is synced, and the log emptied. */
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_checkpoint(wal));
+
+	file = fopen("test.wal", "rb");
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != file);
+	fseek(file, 0, SEEK_END);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ftell(file));
+	fclose(file);
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&other));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+	dictionary_destroy_dictionary(&handler, 96);
+	dictionary_destroy_dictionary(&handler, 97);
+	fremove("test.wal");
+}
+
+/**
+@brief		Applies one round of changes to a dictionary. The first fills it
+			past the point where a linear hash splits and gives some keys
+			more than one record; the later ones change what it left.
+*/
+static void
+test_dictionary_crash_round(
+	ion_dictionary_t	*dictionary,
+	int					round
+) {
+	int key;
+	int value;
+
+	if (0 == round) {
+		for (key = 0; key < 300; key++) {
+			value = key * 3;
+			dictionary_insert(dictionary, &key, &value);
+		}
+
+		key		= 1;
+		value	= 10;
+		dictionary_insert(dictionary, &key, &value);
+		value	= 20;
+		dictionary_insert(dictionary, &key, &value);
+		key		= 7;
+		value	= 70;
+		dictionary_insert(dictionary, &key, &value);
+		dictionary_insert(dictionary, &key, &value);
+		key		= 4;
+		value	= -4;
+		dictionary_update(dictionary, &key, &value);
+		key		= 5;
+		dictionary_delete(dictionary, &key);
+		return;
+	}
+
+	for (key = 300 + 40 * (round - 1); key < 300 + 40 * round; key++) {
+		value = key + round;
+		dictionary_insert(dictionary, &key, &value);
+	}
+
+	key		= 1;
+	value	= 30 + round;
+	dictionary_insert(dictionary, &key, &value);
+	key		= 5 + round;
+	dictionary_delete(dictionary, &key);
+	key		= 20 + round;
+	value	= -round;
+	dictionary_update(dictionary, &key, &value);
+}
+
+/**
+@brief		Counts and sums the values a dictionary holds under a key,
+			through a get when the dictionary cannot find.
+*/
+static int
+test_dictionary_total_key(
+	ion_dictionary_t	*dictionary,
+	int					key,
+	long				*sum
+) {
+	ion_predicate_t		predicate;
+	ion_dict_cursor_t	*cursor = NULL;
+	ion_record_t		record;
+	int					found_key;
+	int					value;
+	int					count	= 0;
+
+	*sum = 0;
+
+	if (NULL == dictionary->handler->find) {
+		if (err_ok != dictionary_get(dictionary, &key, &value).error) {
+			return 0;
+		}
+
+		*sum = value;
+		return 1;
+	}
+
+	record.key		= &found_key;
+	record.value	= &value;
+	dictionary_build_predicate(&predicate, predicate_equality, &key);
+
+	if (err_ok != dictionary_find(dictionary, &predicate, &cursor)) {
+		return -1;
+	}
+
+	while (cs_cursor_active == cursor->next(cursor, &record)) {
+		*sum += value;
+		count++;
+	}
+
+	cursor->destroy(&cursor);
+	return count;
+}
+
+/**
+@brief		Writes a dictionary back through its log, then puts its files
+			back as they were before, as a crash before any page reached
+			them would leave them.
+*/
+static ion_err_t
+test_dictionary_tear_write_back(
+	ion_dictionary_t *dictionary
+) {
+	ion_file_writeback_t	*writeback = &dictionary->writeback;
+	ion_byte_t				*saved[8];
+	long					sizes[8];
+	FILE					*file;
+	ion_err_t				error;
+	int						i;
+
+	error = dictionary->handler->sync(dictionary);
+
+	for (i = 0; err_ok == error && i < writeback->count && i < 8; i++) {
+		file		= fopen(writeback->files[i]->name, "rb");
+		saved[i]	= NULL;
+		fseek(file, 0, SEEK_END);
+		sizes[i]	= ftell(file);
+		saved[i]	= malloc(sizes[i] + 1);
+		fseek(file, 0, SEEK_SET);
+
+		if ((0 != sizes[i]) && (1 != fread(saved[i], sizes[i], 1, file))) {
+			error = err_file_read_error;
+		}
+
+		fclose(file);
+	}
+
+	if (err_ok == error) {
+		error = ion_wal_write_back(dictionary->wal, dictionary->instance->id, writeback);
+	}
+
+	for (i = 0; err_ok == error && i < writeback->count && i < 8; i++) {
+		file = fopen(writeback->files[i]->name, "wb");
+
+		if ((0 != sizes[i]) && (1 != fwrite(saved[i], sizes[i], 1, file))) {
+			error = err_file_write_error;
+		}
+
+		fclose(file);
+		free(saved[i]);
+	}
+
+	return error;
+}
+
+/**
+@brief		Runs one round of changes in a child process with the log
+			attached, then ends the child without closing anything, the way
+			a crash would. The first round creates the dictionary; later ones
+			open what the previous child left, which replays its log. The
+			last crashes while the dictionary is written back.
+*/
+static void
+test_dictionary_crash_child(
+	ion_dictionary_handler_t		*handler,
+	ion_dictionary_config_info_t	*config,
+	int								round,
+	long							checkpoint_bytes
+) {
+	ion_dictionary_t	dictionary;
+	ion_wal_t			*wal;
+	ion_err_t			error;
+
+	/* the log repairs the files before they are opened */
+	error = ion_wal_open("test.wal", checkpoint_bytes, &wal);
+
+	if ((err_ok == error) && (0 == round)) {
+		error = dictionary_create(handler, &dictionary, config->id, config->type, config->key_size, config->value_size, config->dictionary_size);
+	}
+	else if (err_ok == error) {
+		error = dictionary_open(handler, &dictionary, config);
+	}
+
+	if (err_ok == error) {
+		error = dictionary_enable_wal(&dictionary, wal);
+	}
+
+	if (err_ok == error) {
+		test_dictionary_crash_round(&dictionary, round);
+	}
+
+	if ((err_ok == error) && (3 == round)) {
+		error = test_dictionary_tear_write_back(&dictionary);
+	}
+
+	_exit(err_ok == error ? 0 : 1);
+}
+
+/**
+@brief		Crashes a dictionary of one type four times with the log
+			attached, then checks the files it left, once the log is replayed
+			into them, against a dictionary given the same changes without a
+			log. The second crash happens after replaying the first without a
+			checkpoint; the third after checkpoints; the fourth part way
+			through a write back.
+*/
+static void
+test_dictionary_write_ahead_log_crash_type(
+	planck_unit_test_t	*tc,
+	void (*init)(
+		ion_dictionary_handler_t *
+	)
+) {
+	ion_dictionary_handler_t		handler;
+	ion_dictionary_t				dictionary;
+	ion_dictionary_t				reference;
+	ion_dictionary_config_info_t	config = {
+		91, 0, key_type_numeric_signed, sizeof(int), sizeof(int), 512
+	};
+	ion_wal_t						*wal;
+	pid_t							pid;
+	int								status;
+	int								round;
+	int								key;
+	long							sum;
+	long							reference_sum;
+
+	init(&handler);
+	dictionary_destroy_dictionary(&handler, 91);
+	dictionary_destroy_dictionary(&handler, 92);
+	fremove("test.wal");
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_create(&handler, &reference, 92, config.type, config.key_size, config.value_size, config.dictionary_size));
+
+	for (round = 0; round < 4; round++) {
+		fflush(stdout);
+		pid = fork();
+		PLANCK_UNIT_ASSERT_TRUE(tc, -1 != pid);
+
+		if (0 == pid) {
+			test_dictionary_crash_child(&handler, &config, round, 2 == round ? 2048 : 0);
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, pid == waitpid(pid, &status, 0));
+		PLANCK_UNIT_ASSERT_TRUE(tc, WIFEXITED(status));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, WEXITSTATUS(status));
+		test_dictionary_crash_round(&reference, round);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_open("test.wal", 0, &wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_open(&handler, &dictionary, &config));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_enable_wal(&dictionary, wal));
+
+	for (key = 0; key < 440; key++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, test_dictionary_total_key(&reference, key, &reference_sum), test_dictionary_total_key(&dictionary, key, &sum));
+		PLANCK_UNIT_ASSERT_TRUE(tc, reference_sum == sum);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_close(&dictionary));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_wal_close(wal));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, dictionary_delete_dictionary(&reference));
+	dictionary_destroy_dictionary(&handler, 91);
+	fremove("test.wal");
+}
+
+/**
+@brief		Tests that the log recovers each file-backed dictionary from the
+			files a crashed process left behind.
+*/
+void
+test_dictionary_write_ahead_log_crash(
+	planck_unit_test_t *tc
+) {
+	test_dictionary_write_ahead_log_crash_type(tc, ffdict_init);
+	test_dictionary_write_ahead_log_crash_type(tc, bpptree_init);
+	test_dictionary_write_ahead_log_crash_type(tc, oafdict_init);
+	test_dictionary_write_ahead_log_crash_type(tc, linear_hash_dict_init);
+}
+
+/**
+@brief		Tests that a mapped file grows as it is written past its end,
+			reads back in place, and keeps its bytes once closed.
+*/
+void
+test_dictionary_mapped_file(
+	planck_unit_test_t *tc
+) {
+	ion_file_handle_t	file;
+	ion_byte_t			*bytes;
+	ion_file_offset_t	offset;
+	int					value;
+	int					i;
+
+	fremove("test.map");
+	file = ion_fopen_backend("test.map", ion_file_mapped);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_file_mapped, file->backend);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_fend(file));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_fmap_at(file, 0, 1));
+
+	/* well past the first mapping, so the file is remapped as it grows */
+	for (i = 0; i < 50000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, sizeof(i), (ion_byte_t *) &i));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 50000 * sizeof(int), ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 1234 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1234, value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != ion_fread_at(file, 50000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+
+	bytes = ion_fmap_at(file, 49999 * sizeof(int), sizeof(int));
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL != bytes);
+	memcpy(&value, bytes, sizeof(value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 49999, value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_fmap_at(file, 49999 * sizeof(int), 2 * sizeof(int)));
+
+	/* a write past the end leaves a hole of zeroes */
+	offset	= 60000 * sizeof(int);
+	value	= -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, offset, sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, offset + sizeof(int), ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fsync(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+
+	/* the same bytes are seen through stdio */
+	file = ion_fopen_backend("test.map", ion_file_stdio);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, offset + sizeof(int), ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 49999 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 49999, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 55000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_fmap_at(file, 0, 1));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+
+	fremove("test.map");
+}
+
+/**
+@brief		Reads integers scattered over the pages of a positional file,
+			counting those that don't hold their own index.
+*/
+static void *
+test_dictionary_positional_reader(
+	void *file
+) {
+	intptr_t		wrong	= 0;
+	unsigned int	seed	= (unsigned int) (uintptr_t) &wrong;
+	int				index;
+	int				value;
+	int				i;
+
+	for (i = 0; i < 20000; i++) {
+		seed	= seed * 1103515245 + 12345;
+		index	= 2048 + (seed >> 16) % (10000 - 2048);
+
+		if ((err_ok != ion_fread_at(file, index * sizeof(int), sizeof(value), (ion_byte_t *) &value)) || (value != index)) {
+			wrong++;
+		}
+	}
+
+	return (void *) wrong;
+}
+
+/**
+@brief		Tests that positional files buffer writes within a page, read
+			across pages, that two handles on one file don't share a
+			position, and that threads may read one handle at once.
+*/
+void
+test_dictionary_positional_file(
+	planck_unit_test_t *tc
+) {
+	ion_file_handle_t	file;
+	ion_file_handle_t	other;
+	ion_byte_t			row[3 * ION_FILE_PAGE_SIZE / 2];
+	ion_byte_t			back[sizeof(row)];
+	pthread_t			readers[4];
+	void				*wrong;
+	int					value;
+	int					i;
+
+	fremove("test.pio");
+	file = ion_fopen_backend("test.pio", ion_file_positional);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_file_positional, file->backend);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, ion_fend(file));
+
+	for (i = 0; i < 10000; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, sizeof(i), (ion_byte_t *) &i));
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10000 * sizeof(int), ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 10000 * sizeof(int), ion_ftell(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 9999 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 9999, value);
+	PLANCK_UNIT_ASSERT_TRUE(tc, err_ok != ion_fread_at(file, 10000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+
+	/* a write spanning pages goes straight to the file, over a buffered page */
+	for (i = 0; i < (int) sizeof(row); i++) {
+		row[i] = (ion_byte_t) i;
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, ION_FILE_PAGE_SIZE / 2, sizeof(row), row));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, ION_FILE_PAGE_SIZE / 2, sizeof(back), back));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(row, back, sizeof(row)));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, ION_FILE_PAGE_SIZE, sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_TRUE(tc, 0 == memcmp(&value, row + ION_FILE_PAGE_SIZE / 2, sizeof(value)));
+
+	/* a write past the end leaves a hole of zeroes */
+	value = -1;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 20000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20001 * sizeof(int), ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 19999 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fsync(file));
+
+	/* a second handle reads without moving the first one's position */
+	other = ion_fopen_backend("test.pio", ion_file_positional);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != other);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fseek(file, 5000 * sizeof(int), ION_FILE_START));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(other, 20000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -1, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread(file, sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 5000, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(other));
+
+	/* readers sharing a handle load its one page in turn */
+	for (i = 0; i < 4; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_create(&readers[i], NULL, test_dictionary_positional_reader, file));
+	}
+
+	for (i = 0; i < 4; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, pthread_join(readers[i], &wrong));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 0, (intptr_t) wrong);
+	}
+
+	/* buffered writes reach the file when it is closed */
+	value = 42;
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 9000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+
+	file = ion_fopen_backend("test.pio", ion_file_stdio);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 20001 * sizeof(int), ion_fend(file));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 9000 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 42, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fread_at(file, 8999 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 8999, value);
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+
+	fremove("test.pio");
+}
+
+/**
+@brief		Waits a while for a queued read to land.
+@return		The bytes read, or NULL if the read didn't land.
+*/
+static ion_byte_t *
+test_dictionary_readahead_wait(
+	ion_readahead_t		*readahead,
+	ion_file_offset_t	offset,
+	unsigned int		num_bytes
+) {
+	time_t		start = time(NULL);
+	ion_byte_t	*bytes;
+
+	while (NULL == (bytes = ion_readahead_peek(readahead, offset, num_bytes)) && (time(NULL) - start < 5)) {}
+
+	return bytes;
+}
+
+/**
+@brief		Tests that reads queued with either engine land with the bytes
+			of the file, including bytes written but not yet synced, and
+			are taken once and dropped by writes.
+*/
+void
+test_dictionary_readahead(
+	planck_unit_test_t *tc
+) {
+	ion_readahead_engine_t	engines[]	= { ion_readahead_io_uring, ion_readahead_threads };
+	ion_file_handle_t		file;
+	ion_readahead_t			*readahead;
+	ion_byte_t				*bytes;
+	int						value;
+	int						e;
+	int						i;
+
+	fremove("test.rah");
+	file = ion_fopen_backend("test.rah", ion_file_positional);
+	PLANCK_UNIT_ASSERT_TRUE(tc, ION_NOFILE != file);
+
+	for (i = 0; i < 1024; i++) {
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite(file, sizeof(i), (ion_byte_t *) &i));
+	}
+
+	for (e = 0; e < (int) (sizeof(engines) / sizeof(engines[0])); e++) {
+		readahead = ion_readahead_open_engine(file, 4, 4 * sizeof(int), engines[e]);
+
+		/* not every kernel has an io_uring, but the pool is always there */
+		if (NULL == readahead) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, ion_readahead_io_uring, engines[e]);
+			continue;
+		}
+
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_readahead_peek(readahead, 0, 1));
+
+		for (i = 0; i < 4; i++) {
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_readahead_queue(readahead, i * 100 * sizeof(int)));
+		}
+
+		for (i = 0; i < 4; i++) {
+			bytes = test_dictionary_readahead_wait(readahead, i * 100 * sizeof(int), 4 * sizeof(int));
+			PLANCK_UNIT_ASSERT_TRUE(tc, NULL != bytes);
+			memcpy(&value, bytes + 3 * sizeof(int), sizeof(value));
+			PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, i * 100 + 3, value);
+		}
+
+		/* queueing a landed read again keeps it */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_readahead_queue(readahead, 200 * sizeof(int)));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ion_readahead_peek(readahead, 200 * sizeof(int), 4 * sizeof(int)));
+
+		/* a read near the end lands short, and the oldest read gives up its buffer */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_readahead_queue(readahead, 1022 * sizeof(int)));
+		bytes = test_dictionary_readahead_wait(readahead, 1022 * sizeof(int), 2 * sizeof(int));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != bytes);
+		memcpy(&value, bytes + sizeof(int), sizeof(value));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1023, value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_readahead_peek(readahead, 1022 * sizeof(int), 3 * sizeof(int)));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_readahead_peek(readahead, 0, 1));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != ion_readahead_peek(readahead, 100 * sizeof(int), 1));
+
+		/* reads past the end never land */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_readahead_queue(readahead, 4096 * sizeof(int)));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_readahead_peek(readahead, 4096 * sizeof(int), 1));
+
+		/* a landed read is taken once, freeing its buffer */
+		PLANCK_UNIT_ASSERT_TRUE(tc, ion_readahead_take(readahead, 1022 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, 1022, value);
+		PLANCK_UNIT_ASSERT_TRUE(tc, !ion_readahead_take(readahead, 1022 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+
+		/* a write drops the reads it covers, and is seen by the next */
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_readahead_queue(readahead, 300 * sizeof(int)));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != test_dictionary_readahead_wait(readahead, 300 * sizeof(int), 4 * sizeof(int)));
+		value = -301;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 301 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+		ion_readahead_drop(readahead, 301 * sizeof(int), sizeof(value));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL == ion_readahead_peek(readahead, 300 * sizeof(int), 1));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_readahead_queue(readahead, 300 * sizeof(int)));
+		bytes = test_dictionary_readahead_wait(readahead, 300 * sizeof(int), 4 * sizeof(int));
+		PLANCK_UNIT_ASSERT_TRUE(tc, NULL != bytes);
+		memcpy(&value, bytes + sizeof(int), sizeof(value));
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, -301, value);
+		value = 301;
+		PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fwrite_at(file, 301 * sizeof(int), sizeof(value), (ion_byte_t *) &value));
+
+		ion_readahead_close(readahead);
+	}
+
+	PLANCK_UNIT_ASSERT_INT_ARE_EQUAL(tc, err_ok, ion_fclose(file));
+	fremove("test.rah");
+}
+
+#endif
+
 planck_unit_suite_t *
 dictionary_getsuite(
 ) {
 	planck_unit_suite_t *suite = planck_unit_new_suite();
 
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_compare_numerics);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_compare_specialized);
 	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_master_table);
+#if !defined(ARDUINO)
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_write_ahead_log);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_write_ahead_log_failures);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_write_ahead_log_pending);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_write_ahead_log_cursor);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_write_ahead_log_crash);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_mapped_file);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_positional_file);
+	PLANCK_UNIT_ADD_TO_SUITE(suite, test_dictionary_readahead);
+#endif
 
 	return suite;
 }
@@ -40,10 +40,13 @@
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "../../planck-unit/src/planck_unit.h"
 #include "../../../dictionary/dictionary_types.h"
 #include "./../../../dictionary/dictionary.h"
 #include "./../../../dictionary/ion_master_table.h"
+#include "./../../../file/ion_file.h"
+#include "./../../../file/ion_readahead.h"
 
 #ifdef  __cplusplus
 extern "C" {
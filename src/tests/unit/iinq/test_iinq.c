@@ -67,6 +67,8 @@ iinq_test_create_open_source(
 	fremove(cleanup_name);
 	sprintf(cleanup_name, "%d.val", (int) id);
 	fremove(cleanup_name);
+	sprintf(cleanup_name, "%d.pst", (int) id);
+	fremove(cleanup_name);
 	sprintf(cleanup_name, "%d.bpt", (int) id);
 	fremove(schema_file_name);
 }
@@ -290,12 +292,17 @@ run_all_tests_iinq(
 	fremove(ION_MASTER_TABLE_FILENAME);
 	fremove("1.bpt");
 	fremove("1.val");
+	fremove("1.pst");
 	fremove("2.bpt");
 	fremove("2.val");
+	fremove("2.pst");
 	fremove("3.bpt");
 	fremove("3.val");
+	fremove("3.pst");
 	fremove("4.bpt");
 	fremove("4.val");
+	fremove("4.pst");
 	fremove("5.bpt");
 	fremove("5.val");
+	fremove("5.pst");
 }